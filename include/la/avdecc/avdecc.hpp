@@ -67,7 +67,7 @@ namespace avdecc
 * (either added, removed or signature modification).
 * Any other change (including templates, inline methods, defines, typedefs, ...) are considered a modification of the interface.
 */
-constexpr std::uint32_t InterfaceVersion = 207;
+constexpr std::uint32_t InterfaceVersion = 214;
 
 /**
 * @brief Checks if the library is compatible with specified interface version.
@@ -36,7 +36,9 @@
 #include <cstdint>
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <mutex>
+#include <chrono>
 
 namespace la
 {
@@ -51,7 +53,7 @@ namespace controller
 * (either added, removed or signature modification).
 * Any other change (including templates, inline methods, defines, typedefs, ...) are considered a modification of the interface.
 */
-constexpr std::uint32_t InterfaceVersion = 206;
+constexpr std::uint32_t InterfaceVersion = 218;
 
 /**
 * @brief Checks if the library is compatible with specified interface version.
@@ -144,6 +146,16 @@ public:
 		Error const _error{ Error::NoError };
 	};
 
+	enum class NetworkSnapshotError
+	{
+		NoError = 0,
+		CannotOpenFile = 1, /**< The file cannot be opened for reading or writing. */
+		InvalidFormat = 2, /**< The file is not a network snapshot, or is corrupted. */
+		UnsupportedVersion = 3, /**< The network snapshot has been written by a more recent version of the library. */
+		CannotReplaceFile = 4, /**< The network snapshot has been written to a temporary file, but it cannot replace the file (the previous snapshot is kept intact). */
+		InternalError = 99, /**< Internal error, please report the issue. */
+	};
+
 	enum class QueryCommandError
 	{
 		EntityDescriptor,
@@ -190,6 +202,167 @@ public:
 		ClockDomainSourceIndex,
 	};
 
+	/** How notifications are delivered to an Observer */
+	enum class NotificationMode
+	{
+		Immediate = 0, /**< All notifications are delivered as soon as the event occurs (default) */
+		Batched = 1, /**< State change notifications are coalesced per (entity, descriptor, kind) and delivered in batches from a dedicated thread, when notifications batching is enabled on the controller. Other notifications are still delivered immediately. */
+	};
+
+	/** Statistics about batched notifications */
+	struct NotificationsStatistics
+	{
+		std::uint64_t queuedEvents{ 0u }; /**< Number of state change events queued for Batched observers */
+		std::uint64_t coalescedEvents{ 0u }; /**< Number of queued events that replaced a pending event for the same (entity, descriptor, kind) */
+		std::uint64_t deliveredEvents{ 0u }; /**< Number of events delivered to Batched observers (counted once, whatever the number of Batched observers) */
+		std::uint64_t deliveredBatches{ 0u }; /**< Number of batches delivered to Batched observers */
+	};
+
+	/** Kind of descriptor counters periodically polled by the controller */
+	enum class CountersKind : std::uint8_t
+	{
+		AvbInterface = 0, /**< GET_COUNTERS on AVB_INTERFACE descriptors */
+		ClockDomain = 1, /**< GET_COUNTERS on CLOCK_DOMAIN descriptors */
+		StreamInput = 2, /**< GET_COUNTERS on STREAM_INPUT descriptors */
+	};
+
+	/** Statistics about counters polling */
+	struct CountersPollingStatistics
+	{
+		std::uint64_t sentQueries{ 0u }; /**< Number of GET_COUNTERS commands sent by the polling scheduler */
+		std::uint64_t postponedQueries{ 0u }; /**< Number of polls postponed because the entity sent unsolicited counters for the descriptor */
+	};
+
+	/** Priority lane of AECP commands. Commands sent by the user are Interactive by default, enumeration and counters polling commands use the lower Enumeration and Background priorities */
+	using CommandPriority = protocol::AecpCommandPriority;
+	/** Changes the priority of all commands sent by the calling thread while the guard is alive */
+	using CommandPriorityGuard = entity::ControllerEntity::CommandPriorityGuard;
+	using AecpCommandsStatistics = protocol::AecpCommandsStatistics;
+
+	/** Estimated memory held by the controller, in bytes */
+	struct MemoryFootprint
+	{
+		std::unordered_map<UniqueIdentifier, ControlledEntity::MemoryFootprint, UniqueIdentifier::hash> entities{}; /**< Per ControlledEntity (including the ones still being enumerated) */
+		ControlledEntity::MemoryFootprint entitiesTotal{}; /**< Sum of all the entities, per category */
+		size_t entityModelCache{ 0u }; /**< EntityModel cache, its trees being evenly split with the entities sharing them */
+		size_t stateMachineQueues{ 0u }; /**< Queues of the state machine of the ProtocolInterface (discovered entities, inflight and queued commands) */
+
+		size_t total() const noexcept
+		{
+			return entitiesTotal.total() + entityModelCache + stateMachineQueues;
+		}
+	};
+
+	/** When the STRINGS descriptors of the selected locale are loaded */
+	enum class LocalizedStringsLoading
+	{
+		Enumeration = 0, /**< Loaded during enumeration, the entity is declared online once all strings are loaded (default) */
+		Background = 1, /**< Loaded with Background priority right after the entity is declared online */
+		OnDemand = 2, /**< Only loaded when requested using loadLocalizedStrings */
+	};
+
+	/** Statistics about the EntityModel cache, for the entities enumerated while the cache was enabled. Durations are from the discovery of the entity to it being declared online. */
+	struct EntityModelCacheStatistics
+	{
+		std::uint64_t hits{ 0u }; /**< Number of entities using a cached static model without verification */
+		std::uint64_t verifiedHits{ 0u }; /**< Number of entities using a cached static model, after the descriptors read for verification matched it */
+		std::uint64_t verificationFailures{ 0u }; /**< Number of entities which descriptors read for verification did not match the cached static model, then fully enumerated */
+		std::uint64_t misses{ 0u }; /**< Number of entities fully enumerated, their static model not being in the cache */
+		std::chrono::microseconds hitsDuration{ 0 }; /**< Total enumeration duration of the hits */
+		std::chrono::microseconds verifiedHitsDuration{ 0 }; /**< Total enumeration duration of the verified hits */
+		std::chrono::microseconds verificationFailuresDuration{ 0 }; /**< Total enumeration duration of the verification failures */
+		std::chrono::microseconds missesDuration{ 0 }; /**< Total enumeration duration of the misses */
+	};
+
+	/** Statistics about enumeration queries */
+	struct QueriesStatistics
+	{
+		std::uint64_t sentQueries{ 0u }; /**< Number of enumeration queries sent */
+		std::uint64_t deduplicatedQueries{ 0u }; /**< Number of enumeration queries never sent because an identical query was inflight (sharing its result) */
+	};
+
+	/** Stream connection operation, for batchStreamConnections */
+	struct StreamConnectionOperation
+	{
+		enum class Action : std::uint8_t
+		{
+			Connect = 0, /**< CONNECT_RX_COMMAND (same as connectStream) */
+			Disconnect = 1, /**< DISCONNECT_RX_COMMAND (same as disconnectStream) */
+		};
+		entity::model::StreamIdentification talkerStream{};
+		entity::model::StreamIdentification listenerStream{};
+		Action action{ Action::Connect };
+	};
+	using StreamConnectionOperations = std::vector<StreamConnectionOperation>;
+
+	/** Result of a StreamConnectionOperation */
+	struct StreamConnectionOperationResult
+	{
+		entity::ControllerEntity::ControlStatus status{ entity::ControllerEntity::ControlStatus::InternalError };
+		std::chrono::milliseconds duration{ 0 }; /**< Time between sending the operation and getting its result */
+	};
+	using StreamConnectionOperationResults = std::vector<StreamConnectionOperationResult>; /**< In the same order than the StreamConnectionOperations */
+
+	/** AEM SET command operation, for executeAemOperations */
+	struct AemOperation
+	{
+		enum class Type : std::uint8_t
+		{
+			SetConfiguration = 0, /**< Same as setConfiguration (uses configurationIndex) */
+			SetStreamInputFormat = 1, /**< Same as setStreamInputFormat (uses descriptorIndex and streamFormat) */
+			SetStreamOutputFormat = 2, /**< Same as setStreamOutputFormat (uses descriptorIndex and streamFormat) */
+			SetEntityName = 3, /**< Same as setEntityName (uses name) */
+			SetEntityGroupName = 4, /**< Same as setEntityGroupName (uses name) */
+			SetConfigurationName = 5, /**< Same as setConfigurationName (uses configurationIndex and name) */
+			SetAudioUnitName = 6, /**< Same as setAudioUnitName (uses configurationIndex, descriptorIndex and name) */
+			SetStreamInputName = 7, /**< Same as setStreamInputName (uses configurationIndex, descriptorIndex and name) */
+			SetStreamOutputName = 8, /**< Same as setStreamOutputName (uses configurationIndex, descriptorIndex and name) */
+			SetAvbInterfaceName = 9, /**< Same as setAvbInterfaceName (uses configurationIndex, descriptorIndex and name) */
+			SetClockSourceName = 10, /**< Same as setClockSourceName (uses configurationIndex, descriptorIndex and name) */
+			SetMemoryObjectName = 11, /**< Same as setMemoryObjectName (uses configurationIndex, descriptorIndex and name) */
+			SetAudioClusterName = 12, /**< Same as setAudioClusterName (uses configurationIndex, descriptorIndex and name) */
+			SetClockDomainName = 13, /**< Same as setClockDomainName (uses configurationIndex, descriptorIndex and name) */
+			SetAudioUnitSamplingRate = 14, /**< Same as setAudioUnitSamplingRate (uses descriptorIndex and samplingRate) */
+			SetClockSource = 15, /**< Same as setClockSource (uses descriptorIndex as ClockDomainIndex, and clockSourceIndex) */
+		};
+		UniqueIdentifier targetEntityID{};
+		Type type{ Type::SetEntityName };
+		entity::model::ConfigurationIndex configurationIndex{ 0u };
+		entity::model::DescriptorIndex descriptorIndex{ 0u };
+		entity::model::AvdeccFixedString name{};
+		entity::model::SamplingRate samplingRate{ entity::model::getNullSamplingRate() };
+		entity::model::StreamFormat streamFormat{ entity::model::getNullStreamFormat() };
+		entity::model::ClockSourceIndex clockSourceIndex{ 0u };
+	};
+	using AemOperations = std::vector<AemOperation>;
+
+	/** Step executed on each target entity before its first AemOperation (and reverted after its last one) */
+	enum class AemOperationsPreStep : std::uint8_t
+	{
+		None = 0, /**< Operations are sent directly */
+		Acquire = 1, /**< Entity is acquired before its operations, and released after them (unless it was already acquired by this controller) */
+		Lock = 2, /**< Entity is locked before its operations, and unlocked after them */
+	};
+
+	/** Result of an AemOperation */
+	struct AemOperationResult
+	{
+		entity::ControllerEntity::AemCommandStatus status{ entity::ControllerEntity::AemCommandStatus::InternalError }; /**< Status of the command, or status of the failed pre-step (in which case the command is not sent) */
+		std::chrono::milliseconds duration{ 0 }; /**< Time between sending the operation and getting its result */
+	};
+	using AemOperationResults = std::vector<AemOperationResult>; /**< In the same order than the AemOperations */
+
+	/** Aggregated statistics of executeAemOperations */
+	struct AemOperationsStatistics
+	{
+		size_t succeededOperations{ 0u };
+		size_t failedOperations{ 0u };
+		std::chrono::milliseconds minDuration{ 0 }; /**< Minimum duration of the operations that were sent */
+		std::chrono::milliseconds maxDuration{ 0 }; /**< Maximum duration of the operations that were sent */
+		std::chrono::milliseconds averageDuration{ 0 }; /**< Average duration of the operations that were sent */
+		std::chrono::milliseconds elapsed{ 0 }; /**< Total time of the whole batch, including pre and post steps */
+	};
+
 	/**
 	* @brief Observer for entity state and query results. All handlers are guaranteed to be mutually exclusively called.
 	* @warning For all handlers, the la::avdecc::controller::ControlledEntity parameter should not be copied, since there
@@ -199,12 +372,24 @@ public:
 	class Observer : public la::avdecc::Observer<Controller>
 	{
 	public:
+		/** Returns how this observer wants to receive notifications. Must not change while the observer is registered. */
+		virtual NotificationMode getNotificationMode() const noexcept
+		{
+			return NotificationMode::Immediate;
+		}
+
+		/* Batched notifications (only called for observers in NotificationMode::Batched) */
+		virtual void onNotificationsBatchBegin(la::avdecc::controller::Controller const* const /*controller*/) noexcept {}
+		virtual void onNotificationsBatchEnd(la::avdecc::controller::Controller const* const /*controller*/) noexcept {}
+
 		// Global notifications
 		virtual void onTransportError(la::avdecc::controller::Controller const* const /*controller*/) noexcept {}
 		virtual void onEntityQueryError(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/, la::avdecc::controller::Controller::QueryCommandError const /*error*/) noexcept {} // Might trigger even if entity is not "online" // Triggered when the controller failed to query all information it needs for an entity to be declared as Online
 		// Discovery notifications (ADP)
 		virtual void onEntityOnline(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/) noexcept {}
 		virtual void onEntityOffline(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/) noexcept {}
+		virtual void onEntityRevalidated(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/) noexcept {} // A stale entity (restored from a network snapshot) has been rediscovered and its dynamic state refreshed
+		virtual void onEntityLocalizedStringsLoaded(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/) noexcept {} // Localized strings not loaded during enumeration (see LocalizedStringsLoading) are now available
 		virtual void onGptpChanged(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/, la::avdecc::entity::model::AvbInterfaceIndex const /*avbInterfaceIndex*/, la::avdecc::UniqueIdentifier const /*grandMasterID*/, std::uint8_t const /*grandMasterDomain*/) noexcept {}
 		// Connection notifications (ACMP)
 		virtual void onStreamConnectionChanged(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::model::StreamConnectionState const& /*state*/, bool const /*changedByOther*/) noexcept {}
@@ -283,6 +468,10 @@ public:
 	using DisconnectStreamHandler = std::function<void(la::avdecc::controller::ControlledEntity const* const listenerEntity, la::avdecc::entity::model::StreamIndex const listenerStreamIndex, la::avdecc::entity::ControllerEntity::ControlStatus const status)>;
 	using DisconnectTalkerStreamHandler = std::function<void(la::avdecc::entity::ControllerEntity::ControlStatus const status)>;
 	using GetListenerStreamStateHandler = std::function<void(la::avdecc::controller::ControlledEntity const* const talkerEntity, la::avdecc::controller::ControlledEntity const* const listenerEntity, la::avdecc::entity::model::StreamIndex const talkerStreamIndex, la::avdecc::entity::model::StreamIndex const listenerStreamIndex, uint16_t const connectionCount, la::avdecc::entity::ConnectionFlags const flags, la::avdecc::entity::ControllerEntity::ControlStatus const status)>;
+	using BatchStreamConnectionsHandler = std::function<void(la::avdecc::controller::Controller::StreamConnectionOperationResults const& results, std::chrono::milliseconds const elapsed)>;
+	/* Bulk AEM operations handlers */
+	using AemOperationsProgressHandler = std::function<void(size_t const completedOperations, size_t const totalOperations)>;
+	using AemOperationsHandler = std::function<void(la::avdecc::controller::Controller::AemOperationResults const& results, la::avdecc::controller::Controller::AemOperationsStatistics const& statistics)>;
 
 	/**
 	* @brief Factory method to create a new Controller.
@@ -295,7 +484,7 @@ public:
 	* @param[in] progID ID that will be used to generate the #UniqueIdentifier for this controller.
 	* @param[in] entityModelID EntityModelID to publish for this controller. You can use entity::model::makeEntityModelID to create this value.
 	* @param[in] preferedLocale ISO 639-1 locale code of the prefered locale to use when querying entity information.
-	*                           If the specified locale is not found on the entity, then english is used.
+	*                           If the specified locale is not found on the entity, then a locale of the same language is used, then english, then the first locale of the entity.
 	* @return A new Controller as a Controller::UniquePointer.
 	* @note Throws Exception if interfaceName is invalid or inaccessible, or if progID is already used on the local computer.
 	*/
@@ -320,6 +509,50 @@ public:
 	virtual void enableEntityModelCache() noexcept = 0;
 	/** Disables the EntityModel cache */
 	virtual void disableEntityModelCache() noexcept = 0;
+	/** Enables the verification of cached EntityModels: before using a cached model, the CONFIGURATION descriptor and up to streamDescriptorsCount STREAM_INPUT and STREAM_OUTPUT descriptors (spread over all streams) are read and compared to the cache. The entity is fully enumerated if they do not match. */
+	virtual void enableEntityModelCacheVerification(std::uint16_t const streamDescriptorsCount) noexcept = 0;
+	/** Disables the verification of cached EntityModels, which are then trusted (default) */
+	virtual void disableEntityModelCacheVerification() noexcept = 0;
+	/** Gets statistics about the EntityModel cache (hits, verifications and misses) */
+	virtual EntityModelCacheStatistics getEntityModelCacheStatistics() const noexcept = 0;
+	/** Enables notifications batching for observers in NotificationMode::Batched. State change events are coalesced during the specified window, then delivered from a dedicated thread. */
+	virtual void enableNotificationsBatching(std::chrono::milliseconds const window) noexcept = 0;
+	/** Disables notifications batching. Pending events are flushed, then all observers are notified immediately. */
+	virtual void disableNotificationsBatching() noexcept = 0;
+	/** Gets statistics about batched notifications */
+	virtual NotificationsStatistics getNotificationsStatistics() const noexcept = 0;
+	/** Enables periodic polling of the counters of all online entities. GET_COUNTERS commands are evenly spread over time, never exceeding maxQueriesPerSecond (all entities combined). */
+	virtual void enableCountersPolling(std::uint32_t const maxQueriesPerSecond) noexcept = 0;
+	/** Disables periodic polling of counters. */
+	virtual void disableCountersPolling() noexcept = 0;
+	/** Sets the polling interval of a kind of counters (default is 10 seconds). An interval of 0 disables the polling of this kind of counters. */
+	virtual void setCountersPollingInterval(CountersKind const kind, std::chrono::milliseconds const interval) noexcept = 0;
+	/** Overrides the polling interval of a kind of counters for the specified entity (kept if the entity goes offline). An interval of 0 disables the polling of this kind of counters for this entity. */
+	virtual void setCountersPollingInterval(UniqueIdentifier const entityID, CountersKind const kind, std::chrono::milliseconds const interval) noexcept = 0;
+	/** Removes all the polling intervals overrides of the specified entity. */
+	virtual void clearCountersPollingIntervals(UniqueIdentifier const entityID) noexcept = 0;
+	/** Flags the specified entity as watched (or not). Counters of watched entities are polled before the counters of other entities when the budget is exceeded. An entity that sends unsolicited counters is polled less often, whether watched or not. */
+	virtual void setCountersPollingWatchedEntity(UniqueIdentifier const entityID, bool const isWatched) noexcept = 0;
+	/** Gets statistics about counters polling */
+	virtual CountersPollingStatistics getCountersPollingStatistics() const noexcept = 0;
+	/** Sets when the STRINGS descriptors of the selected locale are loaded (default is LocalizedStringsLoading::Enumeration). Only applies to entities enumerated afterwards. */
+	virtual void setLocalizedStringsLoading(LocalizedStringsLoading const loading) noexcept = 0;
+
+	/* Enumeration queries methods */
+	/** Gets statistics about enumeration queries (including how many identical inflight queries were not sent again) */
+	virtual QueriesStatistics getQueriesStatistics() const noexcept = 0;
+	/** Gets statistics about sent AECP commands, per priority lane (CommandPriority) */
+	virtual AecpCommandsStatistics getAecpCommandsStatistics() const noexcept = 0;
+	/** Gets an estimation of the memory held by the controller, per entity and category */
+	virtual MemoryFootprint getMemoryFootprint() const noexcept = 0;
+	/** Loads the localized strings not loaded during the enumeration of the specified entity (see LocalizedStringsLoading::OnDemand), using Background priority. Observer::onEntityLocalizedStringsLoaded is triggered once they are available. */
+	virtual void loadLocalizedStrings(UniqueIdentifier const entityID) noexcept = 0;
+
+	/* Network snapshot methods */
+	/** Saves the state of all enumerated entities (models, connections and acquire state) to a versioned binary file. */
+	virtual NetworkSnapshotError saveNetworkSnapshot(std::string const& filePath) const noexcept = 0;
+	/** Loads a network snapshot. Entities not already online are immediately declared online as stale (see ControlledEntity::isStale), then revalidated when discovered again, or declared offline if not discovered within their ADP valid time. */
+	virtual NetworkSnapshotError loadNetworkSnapshot(std::string const& filePath) noexcept = 0;
 
 	/* Enumeration and Control Protocol (AECP) AEM. WARNING: The completion handler will not be called if the controller is destroyed while the query is inflight. Otherwise it will always be called. */
 	virtual void acquireEntity(UniqueIdentifier const targetEntityID, bool const isPersistent, AcquireEntityHandler const& handler) const noexcept = 0;
@@ -355,6 +588,8 @@ public:
 	virtual void startUploadMemoryObjectOperation(UniqueIdentifier const targetEntityID, entity::model::DescriptorIndex const descriptorIndex, std::uint64_t const dataLength, StartMemoryObjectOperationHandler const& handler) const noexcept = 0;
 	virtual void abortOperation(UniqueIdentifier const targetEntityID, entity::model::DescriptorType const descriptorType, entity::model::DescriptorIndex const descriptorIndex, entity::model::OperationID const operationID, AbortOperationHandler const& handler) const noexcept = 0;
 	virtual void setMemoryObjectLength(UniqueIdentifier const targetEntityID, entity::model::ConfigurationIndex const configurationIndex, entity::model::MemoryObjectIndex const memoryObjectIndex, std::uint64_t const length, SetMemoryObjectLengthHandler const& handler) const noexcept = 0;
+	/** Sends many AEM SET commands at once, optionally acquiring or locking each target entity first. At most maxInflightOperations commands are sent concurrently, and at most one per target entity at a time (operations of the same entity are sent in order, while different entities are pipelined). The progressHandler is called each time an operation completes, the handler once all operations completed. */
+	virtual void executeAemOperations(AemOperations const& operations, AemOperationsPreStep const preStep, std::uint32_t const maxInflightOperations, AemOperationsProgressHandler const& progressHandler, AemOperationsHandler const& handler) const noexcept = 0;
 
 	/* Enumeration and Control Protocol (AECP) AA. WARNING: The completion handler will not be called if the controller is destroyed while the query is inflight. Otherwise it will always be called. */
 	virtual void readDeviceMemory(UniqueIdentifier const targetEntityID, std::uint64_t const address, std::uint64_t const length, ReadDeviceMemoryProgressHandler const& progressHandler, ReadDeviceMemoryCompletionHandler const& completionHandler) const noexcept = 0;
@@ -366,6 +601,8 @@ public:
 	/** Sends a DisconnectTX message directly to the talker, spoofing the listener. Should only be used to forcefully disconnect a ghost connection on the talker. */
 	virtual void disconnectTalkerStream(entity::model::StreamIdentification const& talkerStream, entity::model::StreamIdentification const& listenerStream, DisconnectTalkerStreamHandler const& handler) const noexcept = 0;
 	virtual void getListenerStreamState(entity::model::StreamIdentification const& listenerStream, GetListenerStreamStateHandler const& handler) const noexcept = 0;
+	/** Sends many connectStream/disconnectStream operations at once. At most maxInflightOperations are sent concurrently, and at most one per listener entity at a time (operations of the same listener are sent in order, while different listeners are pipelined). The handler is called once all operations completed. */
+	virtual void batchStreamConnections(StreamConnectionOperations const& operations, std::uint32_t const maxInflightOperations, BatchStreamConnectionsHandler const& handler) const noexcept = 0;
 
 	/** Gets a lock guarded ControlledEntity. While the returned object is in the scope, you are guaranteed to have exclusive access on the ControlledEntity. The returned guard should not be kept. */
 	virtual ControlledEntityGuard getControlledEntity(UniqueIdentifier const entityID) const noexcept = 0;
@@ -80,9 +80,28 @@ public:
 		Milan, /** MILAN compatible entity */
 	};
 
+	/** Estimated memory held by a ControlledEntity, in bytes. Memory shared with other entities (static model, localized strings) is evenly split between them. */
+	struct MemoryFootprint
+	{
+		size_t entity{ 0u }; /**< The ControlledEntity object itself */
+		size_t staticModel{ 0u }; /**< Static model (descriptors) */
+		size_t dynamicModel{ 0u }; /**< Dynamic model, except counters and dynamic audio mappings */
+		size_t counters{ 0u }; /**< Descriptor counters */
+		size_t audioMappings{ 0u }; /**< Dynamic audio mappings of the stream ports */
+		size_t localizedStrings{ 0u }; /**< Localized strings tables */
+		size_t modelGraph{ 0u }; /**< Model graph (EntityNode and its children) */
+		size_t enumerationState{ 0u }; /**< Expected queries and deferred STRINGS queries of the enumeration */
+
+		size_t total() const noexcept
+		{
+			return entity + staticModel + dynamicModel + counters + audioMappings + localizedStrings + modelGraph + enumerationState;
+		}
+	};
+
 	// Getters
 	virtual Compatibility getCompatibility() const noexcept = 0;
 	virtual bool gotFatalEnumerationError() const noexcept = 0; // True if the controller had a fatal error during entity information retrieval (leading to Exception::Type::EnumerationError if any throwing method is called).
+	virtual bool isStale() const noexcept = 0; // True if the entity has been restored from a network snapshot and not yet revalidated (its state might be outdated).
 	virtual bool isAcquired() const noexcept = 0; // Is entity acquired by the controller it's attached to
 	virtual bool isAcquiring() const noexcept = 0; // Is the attached controller trying to acquire the entity
 	virtual bool isAcquiredByOther() const noexcept = 0; // Is entity acquired by another controller
@@ -108,7 +127,7 @@ public:
 	//virtual model::AudioMapNode const& getAudioMapNode(entity::model::ConfigurationIndex const configurationIndex, entity::model::MapIndex const mapIndex) const = 0; // Throws Exception::NotSupported if EM not supported by the Entity // Throws Exception::InvalidConfigurationIndex if configurationIndex do not exist // Throws Exception::InvalidDescriptorIndex if audioUnitIndex, streamPortIndex or MapIndex do not exist
 	virtual model::ClockDomainNode const& getClockDomainNode(entity::model::ConfigurationIndex const configurationIndex, entity::model::ClockDomainIndex const clockDomainIndex) const = 0; // Throws Exception::NotSupported if EM not supported by the Entity // Throws Exception::InvalidConfigurationIndex if configurationIndex do not exist // Throws Exception::InvalidDescriptorIndex if clockDomainIndex do not exist
 
-	virtual model::LocaleNodeStaticModel const* findLocaleNode(entity::model::ConfigurationIndex const configurationIndex, std::string const& locale) const = 0; // Throws Exception::NotSupported if EM not supported by the Entity // Throws Exception::InvalidConfigurationIndex if configurationIndex do not exist
+	virtual model::LocaleNodeStaticModel const* findLocaleNode(entity::model::ConfigurationIndex const configurationIndex, std::string const& locale) const = 0; // Returns the locale matching 'locale' ("en-US", "en_US" and "en" forms, case insensitive), or a locale with the same language, or nullptr if none // Throws Exception::InvalidLocaleName if the configuration has no locale // Throws Exception::NotSupported if EM not supported by the Entity // Throws Exception::InvalidConfigurationIndex if configurationIndex do not exist
 	virtual entity::model::AvdeccFixedString const& getLocalizedString(entity::model::LocalizedStringReference const stringReference) const noexcept = 0; // Get localized string or empty string if not found, in current configuration descriptor
 	virtual entity::model::AvdeccFixedString const& getLocalizedString(entity::model::ConfigurationIndex const configurationIndex, entity::model::LocalizedStringReference const stringReference) const noexcept = 0; // Get localized string or empty string if not found // Throws Exception::InvalidConfigurationIndex if configurationIndex do not exist
 
@@ -120,6 +139,9 @@ public:
 	/** Get connections information about a talker's stream */
 	virtual model::StreamConnections const& getStreamOutputConnections(entity::model::StreamIndex const streamIndex) const = 0; // Throws Exception::InvalidDescriptorIndex if streamIndex do not exist
 
+	/** Get an estimation of the memory held by this entity */
+	virtual MemoryFootprint getMemoryFootprint() const noexcept = 0;
+
 	// Visitor method
 	virtual void accept(model::EntityModelVisitor* const visitor) const noexcept = 0;
 
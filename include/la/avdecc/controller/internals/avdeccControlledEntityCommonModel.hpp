@@ -74,6 +74,7 @@ using RedundantStreams = std::set<entity::model::StreamIndex>;
 #endif // ENABLE_AVDECC_FEATURE_REDUNDANCY
 using SamplingRates = std::set<entity::model::SamplingRate>;
 using AvdeccFixedStrings = std::array<entity::model::AvdeccFixedString, 7>;
+using LocalizedStrings = std::vector<entity::model::AvdeccFixedString>; /** Localized strings of a configuration, indexed by global offset (StringsIndex * 7 + string index in the STRINGS descriptor) */
 using ClockSources = std::vector<entity::model::ClockSourceIndex>;
 using DescriptorCounts = std::unordered_map<entity::model::DescriptorType, std::uint16_t, la::avdecc::EnumClassHash>;
 
@@ -31,6 +31,7 @@
 #include <unordered_map>
 #include <cstdint>
 #include <map>
+#include <memory>
 
 namespace la
 {
@@ -123,7 +124,7 @@ struct ConfigurationNodeDynamicModel
 {
 	entity::model::AvdeccFixedString objectName{};
 	entity::model::StringsIndex selectedLocaleBaseIndex{ entity::model::StringsIndex{ 0u } }; /** Base StringIndex for the selected locale */
-	std::unordered_map<entity::model::StringsIndex, entity::model::AvdeccFixedString> localizedStrings{}; /** Aggregated copy of all loaded localized strings */
+	std::shared_ptr<LocalizedStrings const> localizedStrings{}; /** Aggregated copy of all loaded localized strings (not yet loaded ones are empty), shared by all entities with the same EntityModelID */
 	bool isActiveConfiguration{ false };
 };
 
@@ -0,0 +1,114 @@
+/*
+* Copyright (C) 2016-2018, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be usefu_state,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file clock.hpp
+* @author Christophe Calmejane
+* @brief Monotonic time source used for all protocol timings.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <atomic>
+
+namespace la
+{
+namespace avdecc
+{
+/**
+* @brief Source of time for protocol timings (timeouts, retries, advertising).
+* @details Must be monotonic, so timings are not affected by system time changes (NTP, user).
+*          The default clock is std::chrono::steady_clock, other clocks can be provided to drive time (tests).
+*/
+class Clock
+{
+public:
+	using duration = std::chrono::steady_clock::duration;
+	using time_point = std::chrono::steady_clock::time_point;
+
+	/** Returns the current time */
+	virtual time_point now() const noexcept = 0;
+
+	/** Returns true if the clock only advances when told to. Components using such a clock do not run timing threads, their checkTimers method has to be called after advancing the clock */
+	virtual bool isManual() const noexcept
+	{
+		return false;
+	}
+
+	/** Returns the default clock, based on std::chrono::steady_clock */
+	static Clock const& getDefaultClock() noexcept;
+
+	/** Destructor */
+	virtual ~Clock() noexcept = default;
+};
+
+/**
+* @brief std::chrono::steady_clock based Clock.
+*/
+class SteadyClock final : public Clock
+{
+public:
+	virtual time_point now() const noexcept override
+	{
+		return std::chrono::steady_clock::now();
+	}
+};
+
+inline Clock const& Clock::getDefaultClock() noexcept
+{
+	static SteadyClock const s_Instance{};
+
+	return s_Instance;
+}
+
+/**
+* @brief Clock only advancing when told to.
+* @details Starts at the current time of the default clock. Thread safe.
+*/
+class ManualClock final : public Clock
+{
+public:
+	ManualClock() noexcept
+		: _now(Clock::getDefaultClock().now().time_since_epoch().count())
+	{
+	}
+
+	virtual time_point now() const noexcept override
+	{
+		return time_point{ duration{ _now.load() } };
+	}
+
+	virtual bool isManual() const noexcept override
+	{
+		return true;
+	}
+
+	/** Advances the clock by the specified (positive) duration */
+	void advance(duration const elapsed) noexcept
+	{
+		_now += elapsed.count();
+	}
+
+private:
+	std::atomic<duration::rep> _now{ 0 };
+};
+
+} // namespace avdecc
+} // namespace la
@@ -29,12 +29,14 @@
 #include "entity.hpp"
 #include "entityModel.hpp"
 #include "entityAddressAccessTypes.hpp"
+#include "protocolAecpdu.hpp"
 #include "exports.hpp"
 #include <thread>
 #include <unordered_map>
 #include <string>
 #include <vector>
 #include <functional>
+#include <chrono>
 
 namespace la
 {
@@ -343,6 +345,12 @@ public:
 	using LocalEntity::enableEntityAdvertising; // From LocalEntity
 	/** Disables entity advertising. */
 	using LocalEntity::disableEntityAdvertising; // From LocalEntity
+	/** Sets the delay between 2 automatic ENTITY_DISCOVER messages broadcast (defaults to 10 seconds). A delay of 0 disables automatic discovery. */
+	virtual void setAutomaticDiscoveryDelay(std::chrono::milliseconds const delay) noexcept = 0;
+	/** Immediately broadcasts an ENTITY_DISCOVER message (for example when the network link goes up), and restarts the automatic discovery delay. */
+	virtual void discoverRemoteEntities() noexcept = 0;
+	/** Runs the automatic discovery if due. Only required for an entity created with a manual Clock (see EndStation::addControllerEntity), to be called after advancing the clock. */
+	virtual void checkTimers() noexcept = 0;
 
 	/* Enumeration and Control Protocol (AECP) AEM */
 	virtual void acquireEntity(UniqueIdentifier const targetEntityID, bool const isPersistent, model::DescriptorType const descriptorType, model::DescriptorIndex const descriptorIndex, AcquireEntityHandler const& handler) const noexcept = 0;
@@ -446,12 +454,45 @@ public:
 
 	/* Other methods */
 	virtual void setDelegate(Delegate* const delegate) noexcept = 0;
+	/** Returns statistics about the AECP commands sent through the ProtocolInterface of this controller, per priority lane. */
+	virtual protocol::AecpCommandsStatistics getAecpCommandsStatistics() const noexcept = 0;
+	/** Returns an estimation of the memory held by the queues of the state machine of the ProtocolInterface of this controller, in bytes. */
+	virtual size_t getStateMachineMemoryFootprint() const noexcept = 0;
 
 	/* Utility methods */
 	static LA_AVDECC_API std::string LA_AVDECC_CALL_CONVENTION statusToString(ControllerEntity::AemCommandStatus const status);
 	static LA_AVDECC_API std::string LA_AVDECC_CALL_CONVENTION statusToString(ControllerEntity::AaCommandStatus const status);
 	static LA_AVDECC_API std::string LA_AVDECC_CALL_CONVENTION statusToString(ControllerEntity::MvuCommandStatus const status);
 	static LA_AVDECC_API std::string LA_AVDECC_CALL_CONVENTION statusToString(ControllerEntity::ControlStatus const status);
+	/** Sets the priority of the AECP commands sent by the calling thread (Interactive by default). Prefer using a CommandPriorityGuard. */
+	static LA_AVDECC_API void LA_AVDECC_CALL_CONVENTION setThreadCommandPriority(protocol::AecpCommandPriority const priority) noexcept;
+	/** Returns the priority of the AECP commands sent by the calling thread. */
+	static LA_AVDECC_API protocol::AecpCommandPriority LA_AVDECC_CALL_CONVENTION getThreadCommandPriority() noexcept;
+
+	/** Sets the priority of the AECP commands sent by the calling thread while the guard is alive, restoring the previous priority upon destruction. */
+	class CommandPriorityGuard final
+	{
+	public:
+		explicit CommandPriorityGuard(protocol::AecpCommandPriority const priority) noexcept
+			: _previousPriority(getThreadCommandPriority())
+		{
+			setThreadCommandPriority(priority);
+		}
+
+		~CommandPriorityGuard() noexcept
+		{
+			setThreadCommandPriority(_previousPriority);
+		}
+
+		// Deleted compiler auto-generated methods
+		CommandPriorityGuard(CommandPriorityGuard&&) = delete;
+		CommandPriorityGuard(CommandPriorityGuard const&) = delete;
+		CommandPriorityGuard& operator=(CommandPriorityGuard const&) = delete;
+		CommandPriorityGuard& operator=(CommandPriorityGuard&&) = delete;
+
+	private:
+		protocol::AecpCommandPriority const _previousPriority{ protocol::AecpCommandPriority::Interactive };
+	};
 
 	// Deleted compiler auto-generated methods
 	ControllerEntity(ControllerEntity&&) = delete;
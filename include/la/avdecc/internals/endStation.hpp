@@ -30,6 +30,7 @@
 #include "protocolInterface.hpp"
 #include "exports.hpp"
 #include "exception.hpp"
+#include "clock.hpp"
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -100,6 +101,18 @@ public:
 	*/
 	virtual entity::ControllerEntity* addControllerEntity(std::uint16_t const progID, UniqueIdentifier const entityModelID, entity::ControllerEntity::Delegate* const delegate) = 0;
 
+	/**
+	* @brief Create and attach a controller entity to the EndStation, its automatic discovery being based on the specified clock.
+	* @details Same as addControllerEntity, for a manual Clock the entity does not run a timing thread and its ControllerEntity::checkTimers method has to be called after advancing the clock.
+	* @param[in] progID ID that will be used to generate the #UniqueIdentifier for the controller.
+	* @param[in] entityModelID The EntityModelID value for the controller. You can use entity::model::makeEntityModelID to create this value.
+	* @param[in] delegate The Delegate to be called whenever a controller related notification occurs.
+	* @param[in] clock The Clock the automatic discovery is based on. Must outlive the EndStation.
+	* @return A weak pointer to the newly created ControllerEntity.
+	* @note Might throw an Exception.
+	*/
+	virtual entity::ControllerEntity* addControllerEntity(std::uint16_t const progID, UniqueIdentifier const entityModelID, entity::ControllerEntity::Delegate* const delegate, Clock const& clock) = 0;
+
 	// Deleted compiler auto-generated methods
 	EndStation(EndStation&&) = delete;
 	EndStation(EndStation const&) = delete;
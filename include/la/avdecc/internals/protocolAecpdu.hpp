@@ -26,6 +26,8 @@
 
 #include "protocolAvtpdu.hpp"
 #include <memory>
+#include <array>
+#include <chrono>
 
 namespace la
 {
@@ -33,6 +35,25 @@ namespace avdecc
 {
 namespace protocol
 {
+/** Priority lane of an AECP command. When the maximum number of inflight commands for a target entity is reached, queued commands of a higher priority lane are sent first. */
+enum class AecpCommandPriority : std::uint8_t
+{
+	Interactive = 0, /**< Commands initiated by the user (default) */
+	Enumeration = 1, /**< Commands sent to enumerate an entity */
+	Background = 2, /**< Commands periodically sent in the background (counters polling, ...) */
+};
+static constexpr size_t AecpCommandPrioritiesCount = 3;
+
+/** Statistics of a priority lane of AECP commands */
+struct AecpCommandsLaneStatistics
+{
+	std::uint64_t sentCommands{ 0u }; /**< Number of commands sent (not counting retries) */
+	std::uint64_t queuedCommands{ 0u }; /**< Number of commands that had to wait in the queue before being sent */
+	std::uint64_t promotedCommands{ 0u }; /**< Number of queued commands sent before higher priority ones, because they had been waiting for too long (starvation protection) */
+	std::chrono::milliseconds maxQueueDuration{ 0 }; /**< Longest time a command waited in the queue */
+};
+using AecpCommandsStatistics = std::array<AecpCommandsLaneStatistics, AecpCommandPrioritiesCount>; /**< Indexed by AecpCommandPriority */
+
 /** Aecpdu common header */
 class Aecpdu : public AvtpduControl
 {
@@ -145,6 +145,12 @@ public:
 	/** Returns the Mac Address associated with the network interface name. */
 	virtual networkInterface::MacAddress const& getMacAddress() const noexcept;
 
+	/** Returns statistics about the AECP commands sent through this interface, per priority lane (not supported by all kinds of ProtocolInterface, all values are 0 in that case). */
+	virtual AecpCommandsStatistics getAecpCommandsStatistics() const noexcept;
+
+	/** Returns an estimation of the memory held by the queues of the state machine of this interface, in bytes (not supported by all kinds of ProtocolInterface, 0 is returned in that case). */
+	virtual size_t getStateMachineMemoryFootprint() const noexcept;
+
 	// Virtual interface
 	/** Shuts down the interface, stopping all active communications. This method blocks the current thread until all pending messages are processed. This is automatically called during destructor. */
 	virtual void shutdown() noexcept = 0;
@@ -156,9 +162,9 @@ public:
 	virtual Error enableEntityAdvertising(entity::LocalEntity const& entity) noexcept = 0;
 	/** Disables entity advertising on the network. */
 	virtual Error disableEntityAdvertising(entity::LocalEntity& entity) noexcept = 0;
-	/** Requests a remote entities discovery. */
+	/** Requests a remote entities discovery. The message might be sent after a small delay, in which case a sending failure is only logged (the returned error only covers the immediate checks). */
 	virtual Error discoverRemoteEntities() const noexcept = 0;
-	/** Requests a targetted remote entity discovery. */
+	/** Requests a targetted remote entity discovery. The message might be sent after a small delay, in which case a sending failure is only logged (the returned error only covers the immediate checks). */
 	virtual Error discoverRemoteEntity(UniqueIdentifier const entityID) const noexcept = 0;
 	/** Sends an ADP message directly on the network (not supported by all kinds of ProtocolInterface). */
 	virtual Error sendAdpMessage(Adpdu::UniquePointer&& adpdu) const noexcept = 0;
@@ -168,6 +174,8 @@ public:
 	virtual Error sendAcmpMessage(Acmpdu::UniquePointer&& acmpdu) const noexcept = 0;
 	/** Sends an AECP command message. */
 	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, networkInterface::MacAddress const& macAddress, AecpCommandResultHandler const& onResult) const noexcept = 0;
+	/** Sends an AECP command message. If too many commands are inflight for the target entity, the command is queued in the lane of the specified priority (not supported by all kinds of ProtocolInterface, the priority is ignored in that case). */
+	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, networkInterface::MacAddress const& macAddress, AecpCommandResultHandler const& onResult, AecpCommandPriority const priority) const noexcept;
 	/** Sends an AECP response message. */
 	virtual Error sendAecpResponse(Aecpdu::UniquePointer&& aecpdu, networkInterface::MacAddress const& macAddress) const noexcept = 0;
 	/** Sends an ACMP command message. */
@@ -37,6 +37,10 @@
 #include <stdexcept> // out_of_range
 #include <set>
 #include <mutex>
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <algorithm>
 #include "internals/exports.hpp"
 #include "internals/uniqueIdentifier.hpp"
 
@@ -767,9 +771,11 @@ public:
 	EmptyLock& operator=(EmptyLock&&) noexcept = default;
 };
 
-// Forward declare Subject template class
+// Forward declare Subject template classes
 template<class Derived, class Mut>
 class Subject;
+template<class Derived, class Mut>
+class CopyOnWriteSubject;
 // Forward declare ObserverGuard template class
 template<class ObserverType>
 class ObserverGuard;
@@ -838,6 +844,7 @@ public:
 
 private:
 	friend class Subject<Observable, mutex_type>;
+	friend class CopyOnWriteSubject<Observable, mutex_type>;
 	template<class ObserverType>
 	friend class ObserverGuard;
 
@@ -1235,6 +1242,409 @@ private:
 };
 
 
+/**
+* @brief A Subject base class with lock-free notifications.
+* @details Alternative to the Subject class, with the same interface and the same removal guarantees, for subjects that notify
+*          often and rarely change their observers. The observers are stored in an immutable array which is copied and atomically
+*          swapped when an observer is registered or unregistered. Notifying observers neither takes a lock nor allocates memory.<BR>
+*          Removal guarantees:
+*           - An observer unregistered during a notification is not called anymore during that notification
+*           - Once unregisterObserver returns, the observer is not being called by another thread and will not be called anymore
+*             (if unregisterObserver is called from an event handler of this Subject, this is true once the outermost notification on
+*              this thread returns, the same way the Subject class defers the removal until the end of the notification)
+* @note Contrary to the Subject class, the template mutex only protects changes of the observers list (and the lock/unlock methods),
+*       it is not taken during notifications. As a consequence, observers might be called concurrently if notifications are
+*       triggered from different threads.<BR>
+*       Subject and Observer classes use CRTP pattern.
+* @warning Not catching std::system_error from mutex, which will cause std::terminate() to be called if a critical system error occurs
+*/
+template<class Derived, class Mut>
+class CopyOnWriteSubject
+{
+public:
+	using mutex_type = Mut;
+	using observer_type = Observer<Derived>;
+
+	void registerObserver(observer_type* const observer) const
+	{
+		if (observer == nullptr)
+			throw std::invalid_argument("Observer cannot be nullptr");
+
+		{
+			// Lock observers changes
+			std::lock_guard<decltype(_mutex)> const lg(_mutex);
+			auto const* const observers = _observers.load();
+			// Search if observer already registered
+			if (std::find(observers->begin(), observers->end(), observer) != observers->end())
+				throw std::invalid_argument("Observer already registered");
+			// Register to the observer
+			try
+			{
+				observer->registerSubject(self());
+			}
+			catch (std::invalid_argument const&)
+			{
+				// Already registered
+			}
+			// Add observer
+			auto newObservers = *observers;
+			newObservers.push_back(observer);
+			publishObservers(std::move(newObservers));
+		}
+
+		// Reclaim the previous array
+		synchronize();
+
+		// Inform the subject that a new observer has registered
+		try
+		{
+			const_cast<CopyOnWriteSubject*>(this)->onObserverRegistered(observer);
+		}
+		catch (...)
+		{
+			// Ignore exceptions in handler
+		}
+	}
+
+	/**
+	* @brief Unregisters an observer.
+	* @details Unregisters an observer from the subject.
+	* @param[in] observer The observer to remove from the list.
+	* @note If the observer has never been registered, or has already been
+	*       unregistered, this method will throw an std::invalid_argument.
+	*/
+	void unregisterObserver(observer_type* const observer) const
+	{
+		if (observer == nullptr)
+			throw std::invalid_argument("Observer cannot be nullptr");
+
+		// Unregister from the observer
+		try
+		{
+			observer->unregisterSubject(self());
+		}
+		catch (std::invalid_argument const&)
+		{
+			// Already unregistered, but we continue so the removeObserver method will throw to the user
+		}
+		catch (...) // Catch mutex errors (or any other)
+		{
+			// Rethrow the last exception without trying to remove the observer
+			throw;
+		}
+		// Remove observer
+		try
+		{
+			removeObserver(observer);
+		}
+		catch (std::invalid_argument const&)
+		{
+			// Already unregistered, rethrow to the user
+			throw;
+		}
+		catch (...) // Catch mutex errors (or any other)
+		{
+			// Restore the state by re-registering to the observer, then rethraw
+			observer->registerSubject(self());
+			throw;
+		}
+	}
+
+	/** BasicLockable concept 'lock' method for changes of the observers list (does not prevent notifications) */
+	void lock() noexcept
+	{
+		_mutex.lock();
+	}
+
+	/** BasicLockable concept 'unlock' method for changes of the observers list */
+	void unlock() noexcept
+	{
+		_mutex.unlock();
+	}
+
+	/**
+	* @brief Gets the count of currently registered observers.
+	* @return The count of currently registered observers.
+	*/
+	size_t countObservers() const noexcept
+	{
+		// Lock observers changes, so the array cannot be reclaimed while we read it
+		std::lock_guard<decltype(_mutex)> const lg(_mutex);
+		return _observers.load()->size();
+	}
+
+	/**
+	* @brief Checks if specified observer is currently registered
+	* @param[in] observer Observer to check for
+	* @return Returns true if the specified observer is currently registered, false otherwise.
+	*/
+	bool isObserverRegistered(observer_type* const observer) const noexcept
+	{
+		// Lock observers changes, so the array cannot be reclaimed while we read it
+		std::lock_guard<decltype(_mutex)> const lg(_mutex);
+		auto const* const observers = _observers.load();
+		return std::find(observers->begin(), observers->end(), observer) != observers->end();
+	}
+
+	virtual ~CopyOnWriteSubject() noexcept
+	{
+		removeAllObservers();
+
+		// No more notification can be in progress, free all arrays
+		delete _observers.load();
+		for (auto const* observers : _retiredObservers)
+		{
+			delete observers;
+		}
+	}
+
+	// Defaulted compiler auto-generated methods
+	CopyOnWriteSubject() = default;
+
+	// Deleted compiler auto-generated methods (the observers array is owned)
+	CopyOnWriteSubject(CopyOnWriteSubject&&) = delete;
+	CopyOnWriteSubject(CopyOnWriteSubject const&) = delete;
+	CopyOnWriteSubject& operator=(CopyOnWriteSubject const&) = delete;
+	CopyOnWriteSubject& operator=(CopyOnWriteSubject&&) = delete;
+
+protected:
+#ifdef DEBUG
+	mutex_type& getMutex() noexcept
+	{
+		return _mutex;
+	}
+
+	mutex_type const& getMutex() const noexcept
+	{
+		return _mutex;
+	}
+#endif // DEBUG
+
+	/**
+	* @brief Convenience method to notify all observers.
+	* @details Convenience method to notify all observers in a thread-safe way, without taking any lock.
+	* @param[in] evt An std::function to be called for each registered observer.
+	*/
+	template<class DerivedObserver>
+	void notifyObservers(std::function<void(DerivedObserver* obs)> const& evt) const noexcept
+	{
+		forEachObserver(
+			[&evt](observer_type* const obs)
+			{
+				evt(static_cast<DerivedObserver*>(obs));
+			});
+	}
+
+	/**
+	* @brief Convenience method to notify all observers.
+	* @details Convenience method to notify all observers in a thread-safe way, without taking any lock.
+	* @param[in] method The Observer method to be called. The first parameter of the method should always be self().
+	* @param[in] params Variadic parameters to be forwarded to the method for each observer.
+	*/
+	template<class DerivedObserver, typename Method, typename... Parameters>
+	void notifyObserversMethod(Method&& method, Parameters&&... params) const noexcept
+	{
+		if (method != nullptr)
+		{
+			forEachObserver(
+				[&method, &params...](observer_type* const obs)
+				{
+					(static_cast<DerivedObserver*>(obs)->*method)(std::forward<Parameters>(params)...);
+				});
+		}
+	}
+
+	/** Remove all observers from the subject. */
+	void removeAllObservers() noexcept
+	{
+		{
+			// Lock observers changes
+			std::lock_guard<decltype(_mutex)> const lg(_mutex);
+			// Unregister from all the observers
+			for (auto const obs : *_observers.load())
+			{
+				try
+				{
+					obs->unregisterSubject(self());
+				}
+				catch (std::invalid_argument const&)
+				{
+					// Ignore error
+				}
+			}
+			publishObservers(Observers{});
+		}
+
+		// Wait for pending notifications and reclaim the previous array
+		synchronize();
+	}
+
+	/** Allow the Subject to be informed when a new observer has registered. */
+	virtual void onObserverRegistered(observer_type* const /*observer*/) noexcept {}
+
+	/** Convenience method to return this as the real Derived class type */
+	Derived* self() noexcept
+	{
+		return static_cast<Derived*>(this);
+	}
+
+	/** Convenience method to return this as the real const Derived class type */
+	Derived const* self() const noexcept
+	{
+		return static_cast<Derived const*>(this);
+	}
+
+private:
+	friend class Observer<Derived>;
+	using Observers = std::vector<observer_type*>;
+
+	/** A notification in progress on the current thread */
+	struct NotificationContext
+	{
+		void const* subject{ nullptr };
+		bool shouldSynchronize{ false }; // An observer was removed during this notification, synchronize when it completes
+	};
+	using NotificationContexts = std::vector<NotificationContext>;
+
+	static NotificationContexts& getThreadNotificationContexts() noexcept
+	{
+		static thread_local NotificationContexts s_contexts{};
+		return s_contexts;
+	}
+
+	template<typename Handler>
+	void forEachObserver(Handler const& handler) const noexcept
+	{
+		// Enter the notification: count ourself as a reader of the current epoch (retry if the epoch changed in between, so a writer always waits for us if we can see the array it replaced)
+		auto epoch = _epoch.load();
+		for (;;)
+		{
+			++_activeNotifications[epoch & 1u];
+			auto const currentEpoch = _epoch.load();
+			if (currentEpoch == epoch)
+				break;
+			--_activeNotifications[epoch & 1u];
+			epoch = currentEpoch;
+		}
+
+		auto& contexts = getThreadNotificationContexts();
+		try
+		{
+			contexts.push_back(NotificationContext{ this, false });
+		}
+		catch (...)
+		{
+			// Cannot track this notification, do not notify
+			--_activeNotifications[epoch & 1u];
+			return;
+		}
+
+		// Call each observer
+		auto const* const observers = _observers.load();
+		for (auto* const obs : *observers)
+		{
+			// Do not call an observer removed during this notification (the array is immutable, the current one has to be checked if it changed)
+			auto const* const currentObservers = _observers.load();
+			if (currentObservers != observers && std::find(currentObservers->begin(), currentObservers->end(), obs) == currentObservers->end())
+				continue;
+			// Using try-catch to protect ourself from errors in the handler
+			try
+			{
+				handler(obs);
+			}
+			catch (...)
+			{
+			}
+		}
+
+		// Leave the notification
+		auto const shouldSynchronize = contexts.back().shouldSynchronize;
+		contexts.pop_back();
+		--_activeNotifications[epoch & 1u];
+
+		// An observer was removed during the notification, now is the time to wait for other threads to stop using it
+		if (shouldSynchronize)
+			synchronize();
+	}
+
+	void removeObserver(observer_type* const observer) const
+	{
+		{
+			// Lock observers changes
+			std::lock_guard<decltype(_mutex)> const lg(_mutex);
+			auto const* const observers = _observers.load();
+			// Search if observer is registered
+			auto const it = std::find(observers->begin(), observers->end(), observer);
+			if (it == observers->end())
+				throw std::invalid_argument("Observer not registered");
+			// Remove observer
+			auto newObservers = Observers{};
+			newObservers.reserve(observers->size() - 1);
+			newObservers.insert(newObservers.end(), observers->begin(), it);
+			newObservers.insert(newObservers.end(), std::next(it), observers->end());
+			publishObservers(std::move(newObservers));
+		}
+
+		// Wait for notifications using the previous array to complete
+		synchronize();
+	}
+
+	// Must be called with _mutex taken
+	void publishObservers(Observers&& observers) const
+	{
+		auto* const newObservers = new Observers(std::move(observers));
+		_retiredObservers.push_back(_observers.exchange(newObservers));
+	}
+
+	/** Waits for all notifications that might be using a retired array to complete, then reclaims those arrays. */
+	void synchronize() const noexcept
+	{
+		// Called from a notification of this subject, we cannot wait for ourself: defer until the outermost notification completes
+		auto& contexts = getThreadNotificationContexts();
+		auto const contextIt = std::find_if(contexts.begin(), contexts.end(),
+			[this](auto const& context)
+			{
+				return context.subject == this;
+			});
+		if (contextIt != contexts.end())
+		{
+			contextIt->shouldSynchronize = true;
+			return;
+		}
+
+		// Only one grace period at a time
+		std::lock_guard<decltype(_synchronizeMutex)> const lg(_synchronizeMutex);
+
+		// Get the arrays retired so far, they are no longer visible to new notifications
+		auto retiredObservers = decltype(_retiredObservers){};
+		{
+			// Lock observers changes
+			std::lock_guard<decltype(_mutex)> const lgObs(_mutex);
+			retiredObservers.swap(_retiredObservers);
+		}
+
+		// Switch to the next epoch, then wait for the notifications of the previous epoch to complete (notifications of older epochs have been waited for by previous grace periods)
+		auto const previousEpoch = _epoch++;
+		while (_activeNotifications[previousEpoch & 1u] != 0u)
+		{
+			std::this_thread::yield();
+		}
+
+		for (auto const* observers : retiredObservers)
+		{
+			delete observers;
+		}
+	}
+
+	// Private variables
+	mutable Mut _mutex{}; // Protects changes of the observers list
+	mutable std::mutex _synchronizeMutex{};
+	mutable std::atomic<Observers*> _observers{ new Observers{} };
+	mutable std::vector<Observers const*> _retiredObservers{}; // Arrays no longer published but possibly still used by a notification, protected by _mutex
+	mutable std::atomic<std::uint64_t> _epoch{ 0u };
+	mutable std::atomic<size_t> _activeNotifications[2]{};
+};
+
 /**
 * @brief A Subject derived template class with tag dispatching.
 * @details Subject derived template class publicly exposing notifyObservers and notifyObserversMethod.<BR>
@@ -1251,6 +1661,20 @@ public:
 	using Subject<TypedSubject<Tag, Mut>, Mut>::removeAllObservers;
 };
 
+/**
+* @brief A CopyOnWriteSubject derived template class with tag dispatching.
+* @details Same as TypedSubject, with lock-free notifications.
+*          Ex: using MySubject = TypedCopyOnWriteSubject<struct MySubjectTag, std::mutex>;
+*/
+template<typename Tag, class Mut>
+class TypedCopyOnWriteSubject : public CopyOnWriteSubject<TypedCopyOnWriteSubject<Tag, Mut>, Mut>
+{
+public:
+	using CopyOnWriteSubject<TypedCopyOnWriteSubject<Tag, Mut>, Mut>::notifyObservers;
+	using CopyOnWriteSubject<TypedCopyOnWriteSubject<Tag, Mut>, Mut>::notifyObserversMethod;
+	using CopyOnWriteSubject<TypedCopyOnWriteSubject<Tag, Mut>, Mut>::removeAllObservers;
+};
+
 #define DECLARE_AVDECC_OBSERVER_GUARD_NAME(selfClassType, variableName) \
 	friend class la::avdecc::ObserverGuard<selfClassType>; \
 	la::avdecc::ObserverGuard<selfClassType> variableName \
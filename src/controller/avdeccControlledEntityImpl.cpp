@@ -24,8 +24,11 @@
 
 #include "avdeccControlledEntityImpl.hpp"
 #include "avdeccControllerLogHelper.hpp"
+#include "avdeccLocalizedStringsRegistry.hpp"
+#include "avdeccMemoryFootprint.hpp"
 #include <algorithm>
 #include <cassert>
+#include <cctype>
 #include <typeindex>
 #include <unordered_map>
 
@@ -61,6 +64,11 @@ bool ControlledEntityImpl::gotFatalEnumerationError() const noexcept
 	return _gotFatalEnumerateError;
 }
 
+bool ControlledEntityImpl::isStale() const noexcept
+{
+	return _stale;
+}
+
 bool ControlledEntityImpl::isAcquired() const noexcept
 {
 	return _acquireState == model::AcquireState::Acquired;
@@ -277,16 +285,57 @@ model::ClockDomainNode const& ControlledEntityImpl::getClockDomainNode(entity::m
 	return it->second;
 }
 
-model::LocaleNodeStaticModel const* ControlledEntityImpl::findLocaleNode(entity::model::ConfigurationIndex const configurationIndex, std::string const& /*locale*/) const
+/** Splits a locale identifier ("en-US", "en_US", "en") into its lower case language and country parts */
+static std::pair<std::string, std::string> splitLocale(std::string const& locale) noexcept
+{
+	auto language = std::string{};
+	auto country = std::string{};
+	auto* part = &language;
+
+	for (auto const c : locale)
+	{
+		if (c == '-' || c == '_')
+		{
+			// Ignore anything after the country (script, variant)
+			if (part == &country)
+				break;
+			part = &country;
+			continue;
+		}
+		part->push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+	}
+
+	return std::make_pair(std::move(language), std::move(country));
+}
+
+model::LocaleNodeStaticModel const* ControlledEntityImpl::findLocaleNode(entity::model::ConfigurationIndex const configurationIndex, std::string const& locale) const
 {
 	auto const& configStaticTree = getConfigurationStaticTree(configurationIndex);
 
 	if (configStaticTree.localeStaticModels.empty())
 		throw Exception(Exception::Type::InvalidLocaleName, "Entity has no locale");
 
-#pragma message("TODO: Parse 'locale' parameter and find best match")
-	// Right now, return the first locale
-	return &configStaticTree.localeStaticModels.at(0);
+	auto const [language, country] = splitLocale(locale);
+	model::LocaleNodeStaticModel const* languageMatch{ nullptr };
+
+	for (auto const& localeKV : configStaticTree.localeStaticModels)
+	{
+		auto const& localeStaticModel = localeKV.second;
+		auto const [localeLanguage, localeCountry] = splitLocale(localeStaticModel.localeID.str());
+
+		if (localeLanguage != language)
+			continue;
+
+		// Exact match
+		if (localeCountry == country)
+			return &localeStaticModel;
+
+		// Same language, keep the first one in case there is no exact match
+		if (languageMatch == nullptr)
+			languageMatch = &localeStaticModel;
+	}
+
+	return languageMatch;
 }
 
 entity::model::AvdeccFixedString const& ControlledEntityImpl::getLocalizedString(entity::model::LocalizedStringReference const stringReference) const noexcept
@@ -297,24 +346,25 @@ entity::model::AvdeccFixedString const& ControlledEntityImpl::getLocalizedString
 entity::model::AvdeccFixedString const& ControlledEntityImpl::getLocalizedString(entity::model::ConfigurationIndex const configurationIndex, entity::model::LocalizedStringReference const stringReference) const noexcept
 {
 	static entity::model::AvdeccFixedString s_noLocalizationString{};
-	try
-	{
-		// Special value meaning NO_STRING
-		if (stringReference == entity::model::getNullLocalizedStringReference())
-			return s_noLocalizationString;
 
-		auto const offset = stringReference >> 3;
-		auto const index = stringReference & 0x0007;
-		auto const globalOffset = ((offset * 7u) + index) & 0xFFFF;
+	// Special value meaning NO_STRING
+	if (stringReference == entity::model::getNullLocalizedStringReference() || _gotFatalEnumerateError)
+		return s_noLocalizationString;
+
+	auto const offset = stringReference >> 3;
+	auto const index = stringReference & 0x0007;
+	auto const globalOffset = static_cast<size_t>(((offset * 7u) + index) & 0xFFFF);
 
-		auto const& configDynamicModel = getConfigurationNodeDynamicModel(configurationIndex);
+	// Called for each displayed descriptor, don't use the throwing getters
+	auto const configIt = _entityDynamicTree.configurationDynamicTrees.find(configurationIndex);
+	if (configIt == _entityDynamicTree.configurationDynamicTrees.end())
+		return s_noLocalizationString;
 
-		return configDynamicModel.localizedStrings.at(entity::model::StringsIndex(globalOffset));
-	}
-	catch (...)
-	{
+	auto const& localizedStrings = configIt->second.dynamicModel.localizedStrings;
+	if (!localizedStrings || globalOffset >= localizedStrings->size())
 		return s_noLocalizationString;
-	}
+
+	return (*localizedStrings)[globalOffset];
 }
 
 model::StreamConnectionState const& ControlledEntityImpl::getConnectedSinkState(entity::model::StreamIndex const streamIndex) const
@@ -361,6 +411,65 @@ model::StreamConnections const& ControlledEntityImpl::getStreamOutputConnections
 	return dynamicModel.connections;
 }
 
+ControlledEntityImpl::MemoryFootprint ControlledEntityImpl::getMemoryFootprint() const noexcept
+{
+	auto footprint = MemoryFootprint{};
+
+	footprint.entity = sizeof(*this);
+
+	// Static model, evenly split between the entities sharing it (and the EntityModelCache)
+	footprint.staticModel = memoryFootprint::totalSize(*_entityStaticTree);
+	if (isEntityStaticTreeShared())
+	{
+		footprint.staticModel /= static_cast<size_t>(_entityStaticTree.use_count());
+	}
+
+	// Dynamic model (the tree itself is part of this object)
+	for (auto const& configKV : _entityDynamicTree.configurationDynamicTrees)
+	{
+		auto const& configDynamicTree = configKV.second;
+		for (auto const& modelKV : configDynamicTree.streamInputDynamicModels)
+		{
+			footprint.counters += memoryFootprint::heapSize(modelKV.second.counters);
+		}
+		for (auto const& modelKV : configDynamicTree.avbInterfaceDynamicModels)
+		{
+			footprint.counters += memoryFootprint::heapSize(modelKV.second.counters);
+		}
+		for (auto const& modelKV : configDynamicTree.clockDomainDynamicModels)
+		{
+			footprint.counters += memoryFootprint::heapSize(modelKV.second.counters);
+		}
+		for (auto const& modelKV : configDynamicTree.streamPortInputDynamicModels)
+		{
+			footprint.audioMappings += memoryFootprint::heapSize(modelKV.second.dynamicAudioMap);
+		}
+		for (auto const& modelKV : configDynamicTree.streamPortOutputDynamicModels)
+		{
+			footprint.audioMappings += memoryFootprint::heapSize(modelKV.second.dynamicAudioMap);
+		}
+
+		// Localized strings, a table being loaded is owned by this entity (and also referenced by _ownedLocalizedStrings), otherwise it is evenly split between the entities sharing it
+		auto const& localizedStrings = configDynamicTree.dynamicModel.localizedStrings;
+		if (localizedStrings)
+		{
+			auto const ownedIt = _ownedLocalizedStrings.find(configKV.first);
+			auto const isOwned = ownedIt != _ownedLocalizedStrings.end() && ownedIt->second == localizedStrings;
+			footprint.localizedStrings += memoryFootprint::totalSize(*localizedStrings) / (isOwned ? 1u : static_cast<size_t>(localizedStrings.use_count()));
+		}
+	}
+	footprint.dynamicModel = memoryFootprint::heapSize(_entityDynamicTree) - footprint.counters - footprint.audioMappings;
+	footprint.localizedStrings += memoryFootprint::heapSize(_ownedLocalizedStrings);
+
+	// Model graph (the EntityNode itself is part of this object)
+	footprint.modelGraph = memoryFootprint::heapSize(_entityNode);
+
+	// Enumeration
+	footprint.enumerationState = memoryFootprint::heapSize(_expectedDescriptors) + memoryFootprint::heapSize(_expectedDynamicInfo) + memoryFootprint::heapSize(_expectedDescriptorDynamicInfo) + memoryFootprint::heapSize(_deferredStringsQueries);
+
+	return footprint;
+}
+
 // Visitor method
 void ControlledEntityImpl::accept(model::EntityModelVisitor* const visitor) const noexcept
 {
@@ -576,7 +685,7 @@ model::EntityStaticTree const& ControlledEntityImpl::getEntityStaticTree() const
 	if (!hasFlag(_entity.getEntityCapabilities(), entity::EntityCapabilities::AemSupported))
 		throw Exception(Exception::Type::NotSupported, "EM not supported by the entity");
 
-	return _entityStaticTree;
+	return *_entityStaticTree;
 }
 
 model::EntityDynamicTree const& ControlledEntityImpl::getEntityDynamicTree() const
@@ -639,7 +748,16 @@ model::ConfigurationNodeDynamicModel const& ControlledEntityImpl::getConfigurati
 // Non-const Tree getters
 model::EntityStaticTree& ControlledEntityImpl::getEntityStaticTree() noexcept
 {
-	return _entityStaticTree;
+	// Shared trees are immutable, modify a copy of the tree
+	if (!_ownedEntityStaticTree)
+	{
+		_ownedEntityStaticTree = std::make_shared<model::EntityStaticTree>(*_entityStaticTree);
+		_entityStaticTree = _ownedEntityStaticTree;
+
+		// The model graph points to the shared tree, it will have to be built again
+		_entityNode = {};
+	}
+	return *_ownedEntityStaticTree;
 }
 
 model::EntityDynamicTree& ControlledEntityImpl::getEntityDynamicTree() noexcept
@@ -650,13 +768,13 @@ model::EntityDynamicTree& ControlledEntityImpl::getEntityDynamicTree() noexcept
 model::ConfigurationStaticTree& ControlledEntityImpl::getConfigurationStaticTree(entity::model::ConfigurationIndex const configurationIndex) noexcept
 {
 	auto& entityStaticTree = getEntityStaticTree();
-	return entityStaticTree.configurationStaticTrees[configurationIndex];
+	return getOrCreateNodeModel(entityStaticTree.configurationStaticTrees, configurationIndex);
 }
 
 model::ConfigurationDynamicTree& ControlledEntityImpl::getConfigurationDynamicTree(entity::model::ConfigurationIndex const configurationIndex) noexcept
 {
 	auto& entityDynamicTree = getEntityDynamicTree();
-	return entityDynamicTree.configurationDynamicTrees[configurationIndex];
+	return getOrCreateNodeModel(entityDynamicTree.configurationDynamicTrees, configurationIndex);
 }
 
 // Non-const NodeModel getters
@@ -947,6 +1065,11 @@ model::StreamInputCounters& ControlledEntityImpl::getStreamInputCounters(entity:
 }
 
 // Setters (of the model, not the physical entity)
+model::AcquireState ControlledEntityImpl::getAcquireState() const noexcept
+{
+	return _acquireState;
+}
+
 void ControlledEntityImpl::setEntity(entity::Entity const& entity) noexcept
 {
 	_entity = entity;
@@ -964,18 +1087,18 @@ void ControlledEntityImpl::setOwningController(UniqueIdentifier const controller
 
 // Setters of the Model from AEM Descriptors (including DescriptorDynamic info)
 
-bool ControlledEntityImpl::setCachedEntityStaticTree(model::EntityStaticTree const& cachedStaticTree, entity::model::EntityDescriptor const& descriptor) noexcept
+bool ControlledEntityImpl::setCachedEntityStaticTree(std::shared_ptr<model::EntityStaticTree const> const& cachedStaticTree, entity::model::EntityDescriptor const& descriptor) noexcept
 {
 	// Check if static information in EntityDescriptor are identical
-	auto const& cachedDescriptor = cachedStaticTree.staticModel;
+	auto const& cachedDescriptor = cachedStaticTree->staticModel;
 	if (cachedDescriptor.vendorNameString != descriptor.vendorNameString || cachedDescriptor.modelNameString != descriptor.modelNameString)
 	{
 		LOG_CONTROLLER_WARN(_entity.getEntityID(), "EntityModelID provided by this Entity has inconsistent data in it's EntityDescriptor, not using cached AEM");
 		return false;
 	}
 
-	// Ok the static information from EntityDescriptor are identical, we cannot check more than this so we have to assume it's correct, copy the whole model
-	_entityStaticTree = cachedStaticTree;
+	// Ok the static information from EntityDescriptor are identical, we cannot check more than this so we have to assume it's correct, share the whole model
+	useCachedEntityStaticTree(cachedStaticTree);
 
 	// And override with the EntityDescriptor so this entity's specific fields are copied
 	setEntityDescriptor(descriptor);
@@ -983,12 +1106,22 @@ bool ControlledEntityImpl::setCachedEntityStaticTree(model::EntityStaticTree con
 	return true;
 }
 
+void ControlledEntityImpl::useCachedEntityStaticTree(std::shared_ptr<model::EntityStaticTree const> const& cachedStaticTree) noexcept
+{
+	_entityStaticTree = cachedStaticTree;
+	_ownedEntityStaticTree.reset();
+
+	// The model graph points to the previous tree
+	_entityNode = {};
+}
+
 void ControlledEntityImpl::setEntityDescriptor(entity::model::EntityDescriptor const& descriptor) noexcept
 {
 	if (!AVDECC_ASSERT_WITH_RET(!_advertised, "EntityDescriptor should never be set twice on an entity. Only the dynamic part should be set again."))
 	{
 		// Wipe everything and set as enumeration error
-		_entityStaticTree = {};
+		_ownedEntityStaticTree = std::make_shared<model::EntityStaticTree>();
+		_entityStaticTree = _ownedEntityStaticTree;
 		_entityDynamicTree = {};
 		_entityNode = {};
 		_gotFatalEnumerateError = true;
@@ -996,9 +1129,15 @@ void ControlledEntityImpl::setEntityDescriptor(entity::model::EntityDescriptor c
 		return;
 	}
 
-	// Copy static model
+	// Configurations will be stored contiguously
+	_entityDynamicTree.configurationDynamicTrees.reserve(descriptor.configurationsCount);
+
+	// Copy static model (a shared tree comes from setCachedEntityStaticTree, which already checked the static fields)
+	if (!isEntityStaticTreeShared())
 	{
-		auto& m = _entityStaticTree.staticModel;
+		auto& entityStaticTree = getEntityStaticTree();
+		entityStaticTree.configurationStaticTrees.reserve(descriptor.configurationsCount);
+		auto& m = entityStaticTree.staticModel;
 		m.vendorNameString = descriptor.vendorNameString;
 		m.modelNameString = descriptor.modelNameString;
 	}
@@ -1028,6 +1167,9 @@ void ControlledEntityImpl::setConfigurationDescriptor(entity::model::Configurati
 		m.descriptorCounts = descriptor.descriptorCounts;
 	}
 
+	// Descriptors of this configuration will be stored contiguously
+	reserveNodeModels(configurationIndex, descriptor.descriptorCounts);
+
 	// Copy dynamic model
 	{
 		// Get or create a new model::ConfigurationDynamicTree for this entity
@@ -1256,7 +1398,8 @@ void ControlledEntityImpl::setLocaleDescriptor(entity::model::LocaleDescriptor c
 
 void ControlledEntityImpl::setStringsDescriptor(entity::model::StringsDescriptor const& descriptor, entity::model::ConfigurationIndex const configurationIndex, entity::model::StringsIndex const stringsIndex) noexcept
 {
-	// Copy static model
+	// Copy static model (a shared tree is immutable, STRINGS loaded after it was shared are only kept in the localized strings)
+	if (!isEntityStaticTreeShared())
 	{
 		// Get or create a new model::StringsNodeStaticModel
 		auto& m = getNodeStaticModel(configurationIndex, stringsIndex, &model::ConfigurationStaticTree::stringsStaticModels);
@@ -1270,12 +1413,141 @@ void ControlledEntityImpl::setStringsDescriptor(entity::model::StringsDescriptor
 void ControlledEntityImpl::setLocalizedStrings(entity::model::ConfigurationIndex const configurationIndex, entity::model::StringsIndex const stringsIndex, model::AvdeccFixedStrings const& strings) noexcept
 {
 	auto& configDynamicModel = getConfigurationNodeDynamicModel(configurationIndex);
+
+	// Shared tables are immutable, strings are loaded into a table owned by this entity until shareLocalizedStrings is called
+	auto& ownedStrings = _ownedLocalizedStrings[configurationIndex];
+	if (!ownedStrings)
+	{
+		ownedStrings = configDynamicModel.localizedStrings ? std::make_shared<model::LocalizedStrings>(*configDynamicModel.localizedStrings) : std::make_shared<model::LocalizedStrings>();
+		configDynamicModel.localizedStrings = ownedStrings;
+	}
+
+	// Only the strings of the selected locale are stored, LocalizedStringReference offsets being relative to its first STRINGS descriptor
+	if (stringsIndex < configDynamicModel.selectedLocaleBaseIndex)
+		return;
+
 	// Copy the strings to the ConfigurationDynamicModel for a quick access
-	for (auto strIndex = 0u; strIndex < strings.size(); ++strIndex)
+	auto const baseOffset = static_cast<size_t>(stringsIndex - configDynamicModel.selectedLocaleBaseIndex) * strings.size();
+	if (ownedStrings->size() < baseOffset + strings.size())
+	{
+		ownedStrings->resize(baseOffset + strings.size());
+	}
+	std::copy(strings.begin(), strings.end(), ownedStrings->begin() + baseOffset);
+}
+
+void ControlledEntityImpl::deferStringsDescriptorQuery(entity::model::ConfigurationIndex const configurationIndex, entity::model::StringsIndex const stringsIndex) noexcept
+{
+	_deferredStringsQueries.emplace_back(configurationIndex, stringsIndex);
+}
+
+ControlledEntityImpl::DeferredStringsQueries ControlledEntityImpl::takeDeferredStringsDescriptorQueries() noexcept
+{
+	auto queries = DeferredStringsQueries{};
+	queries.swap(_deferredStringsQueries);
+	return queries;
+}
+
+void ControlledEntityImpl::shareLocalizedStrings() noexcept
+{
+	auto& registry = LocalizedStringsRegistry::getInstance();
+	for (auto const& ownedKV : _ownedLocalizedStrings)
 	{
-		auto localizedStringIndex = entity::model::StringsIndex(stringsIndex * strings.size() + strIndex);
-		configDynamicModel.localizedStrings[localizedStringIndex] = strings.at(strIndex);
+		auto const configurationIndex = ownedKV.first;
+		auto& configDynamicModel = getConfigurationNodeDynamicModel(configurationIndex);
+		configDynamicModel.localizedStrings = registry.share(_entity.getEntityModelID(), configurationIndex, ownedKV.second);
 	}
+	_ownedLocalizedStrings.clear();
+}
+
+std::shared_ptr<model::EntityStaticTree const> ControlledEntityImpl::shareEntityStaticTree() noexcept
+{
+	// The tree itself is not moved, the model graph is still valid
+	_ownedEntityStaticTree.reset();
+	return _entityStaticTree;
+}
+
+bool ControlledEntityImpl::isEntityStaticTreeShared() const noexcept
+{
+	return !_ownedEntityStaticTree;
+}
+
+void ControlledEntityImpl::setEntityStaticTreeToVerify(std::shared_ptr<model::EntityStaticTree const> const& cachedStaticTree) noexcept
+{
+	_entityStaticTreeToVerify = cachedStaticTree;
+	_entityStaticTreeVerificationReadFailed = false;
+}
+
+std::shared_ptr<model::EntityStaticTree const> ControlledEntityImpl::takeEntityStaticTreeToVerify() noexcept
+{
+	auto cachedStaticTree = std::shared_ptr<model::EntityStaticTree const>{};
+	cachedStaticTree.swap(_entityStaticTreeToVerify);
+	return cachedStaticTree;
+}
+
+bool ControlledEntityImpl::isVerifyingEntityStaticTree() const noexcept
+{
+	return !!_entityStaticTreeToVerify;
+}
+
+void ControlledEntityImpl::setEntityStaticTreeVerificationReadFailed() noexcept
+{
+	_entityStaticTreeVerificationReadFailed = true;
+}
+
+static bool isSameStreamStaticModel(model::StreamNodeStaticModel const& lhs, model::StreamNodeStaticModel const& rhs) noexcept
+{
+	return lhs.localizedDescription == rhs.localizedDescription && lhs.clockDomainIndex == rhs.clockDomainIndex && lhs.streamFlags == rhs.streamFlags && lhs.avbInterfaceIndex == rhs.avbInterfaceIndex && lhs.bufferLength == rhs.bufferLength && lhs.formats == rhs.formats;
+}
+
+bool ControlledEntityImpl::isMatchingCachedEntityStaticTree(model::EntityStaticTree const& cachedStaticTree, entity::model::ConfigurationIndex const configurationIndex) const noexcept
+{
+	// A descriptor could not be read (fewer streams for example)
+	if (_entityStaticTreeVerificationReadFailed)
+		return false;
+
+	auto const& entityStaticTree = *_entityStaticTree;
+
+	// ENTITY descriptor
+	if (entityStaticTree.staticModel.vendorNameString != cachedStaticTree.staticModel.vendorNameString || entityStaticTree.staticModel.modelNameString != cachedStaticTree.staticModel.modelNameString)
+		return false;
+
+	// CONFIGURATION descriptor
+	auto const configIt = entityStaticTree.configurationStaticTrees.find(configurationIndex);
+	auto const cachedConfigIt = cachedStaticTree.configurationStaticTrees.find(configurationIndex);
+	if (configIt == entityStaticTree.configurationStaticTrees.end() || cachedConfigIt == cachedStaticTree.configurationStaticTrees.end())
+		return false;
+	auto const& configStaticTree = configIt->second;
+	auto const& cachedConfigStaticTree = cachedConfigIt->second;
+	if (configStaticTree.staticModel.localizedDescription != cachedConfigStaticTree.staticModel.localizedDescription || configStaticTree.staticModel.descriptorCounts != cachedConfigStaticTree.staticModel.descriptorCounts)
+		return false;
+
+	// STREAM descriptors that have been read
+	auto const isMatchingStreams = [](auto const& streamStaticModels, auto const& cachedStreamStaticModels)
+	{
+		for (auto const& streamKV : streamStaticModels)
+		{
+			auto const cachedIt = cachedStreamStaticModels.find(streamKV.first);
+			if (cachedIt == cachedStreamStaticModels.end() || !isSameStreamStaticModel(streamKV.second, cachedIt->second))
+				return false;
+		}
+		return true;
+	};
+	return isMatchingStreams(configStaticTree.streamInputStaticModels, cachedConfigStaticTree.streamInputStaticModels) && isMatchingStreams(configStaticTree.streamOutputStaticModels, cachedConfigStaticTree.streamOutputStaticModels);
+}
+
+ControlledEntityImpl::EntityModelCacheResult ControlledEntityImpl::getEntityModelCacheResult() const noexcept
+{
+	return _entityModelCacheResult;
+}
+
+void ControlledEntityImpl::setEntityModelCacheResult(EntityModelCacheResult const result) noexcept
+{
+	_entityModelCacheResult = result;
+}
+
+std::chrono::steady_clock::time_point ControlledEntityImpl::getEnumerationStartTime() const noexcept
+{
+	return _enumerationStartTime;
 }
 
 void ControlledEntityImpl::setStreamPortInputDescriptor(entity::model::StreamPortDescriptor const& descriptor, entity::model::ConfigurationIndex const configurationIndex, entity::model::StreamPortIndex const streamPortIndex) noexcept
@@ -1596,7 +1868,115 @@ void ControlledEntityImpl::setAdvertised(bool const wasAdvertised) noexcept
 	_advertised = wasAdvertised;
 }
 
+void ControlledEntityImpl::setStale(bool const isStale) noexcept
+{
+	_stale = isStale;
+}
+
+void ControlledEntityImpl::buildEntityModelGraph() noexcept
+{
+	if (gotFatalEnumerationError() || !hasFlag(_entity.getEntityCapabilities(), entity::EntityCapabilities::AemSupported))
+		return;
+
+	// Lock during possible modification of the model
+	std::lock_guard<decltype(_lock)> const lg(_lock);
+
+	checkAndBuildEntityModelGraph();
+}
+
 // Private methods
+void ControlledEntityImpl::reserveNodeModels(entity::model::ConfigurationIndex const configurationIndex, model::DescriptorCounts const& descriptorCounts) noexcept
+{
+	auto& configStaticTree = getConfigurationStaticTree(configurationIndex);
+	auto& configDynamicTree = getConfigurationDynamicTree(configurationIndex);
+
+	auto const reserve = [&descriptorCounts](entity::model::DescriptorType const descriptorType, auto&... nodeModels)
+	{
+		auto const countIt = descriptorCounts.find(descriptorType);
+		if (countIt != descriptorCounts.end())
+		{
+			(nodeModels.reserve(countIt->second), ...);
+		}
+	};
+
+	reserve(entity::model::DescriptorType::AudioUnit, configStaticTree.audioUnitStaticModels, configDynamicTree.audioUnitDynamicModels);
+	reserve(entity::model::DescriptorType::StreamInput, configStaticTree.streamInputStaticModels, configDynamicTree.streamInputDynamicModels);
+	reserve(entity::model::DescriptorType::StreamOutput, configStaticTree.streamOutputStaticModels, configDynamicTree.streamOutputDynamicModels);
+	reserve(entity::model::DescriptorType::AvbInterface, configStaticTree.avbInterfaceStaticModels, configDynamicTree.avbInterfaceDynamicModels);
+	reserve(entity::model::DescriptorType::ClockSource, configStaticTree.clockSourceStaticModels, configDynamicTree.clockSourceDynamicModels);
+	reserve(entity::model::DescriptorType::MemoryObject, configStaticTree.memoryObjectStaticModels, configDynamicTree.memoryObjectDynamicModels);
+	reserve(entity::model::DescriptorType::Locale, configStaticTree.localeStaticModels);
+	reserve(entity::model::DescriptorType::Strings, configStaticTree.stringsStaticModels);
+	reserve(entity::model::DescriptorType::StreamPortInput, configStaticTree.streamPortInputStaticModels, configDynamicTree.streamPortInputDynamicModels);
+	reserve(entity::model::DescriptorType::StreamPortOutput, configStaticTree.streamPortOutputStaticModels, configDynamicTree.streamPortOutputDynamicModels);
+	reserve(entity::model::DescriptorType::AudioCluster, configStaticTree.audioClusterStaticModels, configDynamicTree.audioClusterDynamicModels);
+	reserve(entity::model::DescriptorType::AudioMap, configStaticTree.audioMapStaticModels);
+	reserve(entity::model::DescriptorType::ClockDomain, configStaticTree.clockDomainStaticModels, configDynamicTree.clockDomainDynamicModels);
+}
+
+void ControlledEntityImpl::createReferencedNodeModels() noexcept
+{
+	// A shared tree already contains the models it references (created before it was shared)
+	if (!isEntityStaticTreeShared())
+	{
+		for (auto const& configKV : _ownedEntityStaticTree->configurationStaticTrees)
+		{
+			auto const configIndex = configKV.first;
+			auto const& configStaticTree = configKV.second;
+
+			// Stream ports, clusters and maps referenced by the audio units
+			auto const createStreamPortModels = [this, configIndex](auto const staticField, std::uint16_t const numberOfStreamPorts, entity::model::StreamPortIndex const baseStreamPort)
+			{
+				for (auto streamPortIndexCounter = entity::model::StreamPortIndex(0); streamPortIndexCounter < numberOfStreamPorts; ++streamPortIndexCounter)
+				{
+					auto const streamPortIndex = entity::model::StreamPortIndex(streamPortIndexCounter + baseStreamPort);
+					auto const& streamPortStaticModel = getNodeStaticModel(configIndex, streamPortIndex, staticField);
+					for (auto clusterIndexCounter = entity::model::ClusterIndex(0); clusterIndexCounter < streamPortStaticModel.numberOfClusters; ++clusterIndexCounter)
+					{
+						getNodeStaticModel(configIndex, entity::model::ClusterIndex(clusterIndexCounter + streamPortStaticModel.baseCluster), &model::ConfigurationStaticTree::audioClusterStaticModels);
+					}
+					for (auto mapIndexCounter = entity::model::MapIndex(0); mapIndexCounter < streamPortStaticModel.numberOfMaps; ++mapIndexCounter)
+					{
+						getNodeStaticModel(configIndex, entity::model::MapIndex(mapIndexCounter + streamPortStaticModel.baseMap), &model::ConfigurationStaticTree::audioMapStaticModels);
+					}
+				}
+			};
+			for (auto const& audioUnitKV : configStaticTree.audioUnitStaticModels)
+			{
+				auto const& audioUnitStaticModel = audioUnitKV.second;
+				createStreamPortModels(&model::ConfigurationStaticTree::streamPortInputStaticModels, audioUnitStaticModel.numberOfStreamInputPorts, audioUnitStaticModel.baseStreamInputPort);
+				createStreamPortModels(&model::ConfigurationStaticTree::streamPortOutputStaticModels, audioUnitStaticModel.numberOfStreamOutputPorts, audioUnitStaticModel.baseStreamOutputPort);
+			}
+		}
+	}
+
+	// Dynamic part of each static model
+	for (auto const& configKV : _entityStaticTree->configurationStaticTrees)
+	{
+		auto const configIndex = configKV.first;
+		auto const& configStaticTree = configKV.second;
+		getConfigurationDynamicTree(configIndex);
+
+		auto const createDynamicModels = [this, configIndex](auto const& staticModels, auto const dynamicField)
+		{
+			for (auto const& staticKV : staticModels)
+			{
+				getNodeDynamicModel(configIndex, staticKV.first, dynamicField);
+			}
+		};
+		createDynamicModels(configStaticTree.audioUnitStaticModels, &model::ConfigurationDynamicTree::audioUnitDynamicModels);
+		createDynamicModels(configStaticTree.streamInputStaticModels, &model::ConfigurationDynamicTree::streamInputDynamicModels);
+		createDynamicModels(configStaticTree.streamOutputStaticModels, &model::ConfigurationDynamicTree::streamOutputDynamicModels);
+		createDynamicModels(configStaticTree.avbInterfaceStaticModels, &model::ConfigurationDynamicTree::avbInterfaceDynamicModels);
+		createDynamicModels(configStaticTree.clockSourceStaticModels, &model::ConfigurationDynamicTree::clockSourceDynamicModels);
+		createDynamicModels(configStaticTree.memoryObjectStaticModels, &model::ConfigurationDynamicTree::memoryObjectDynamicModels);
+		createDynamicModels(configStaticTree.streamPortInputStaticModels, &model::ConfigurationDynamicTree::streamPortInputDynamicModels);
+		createDynamicModels(configStaticTree.streamPortOutputStaticModels, &model::ConfigurationDynamicTree::streamPortOutputDynamicModels);
+		createDynamicModels(configStaticTree.audioClusterStaticModels, &model::ConfigurationDynamicTree::audioClusterDynamicModels);
+		createDynamicModels(configStaticTree.clockDomainStaticModels, &model::ConfigurationDynamicTree::clockDomainDynamicModels);
+	}
+}
+
 void ControlledEntityImpl::checkAndBuildEntityModelGraph() const noexcept
 {
 	try
@@ -1604,13 +1984,16 @@ void ControlledEntityImpl::checkAndBuildEntityModelGraph() const noexcept
 #pragma message("TODO: Use a std::optional when available, instead of detecting the non-initialized value from configurations count (xcode clang is still missing optional as of this date)")
 		if (_entityNode.configurations.size() == 0)
 		{
+			// Models referenced by the graph but never received (misbehaving entity) are created first, so building the graph does not move the models already referenced
+			const_cast<ControlledEntityImpl*>(this)->createReferencedNodeModels();
+
 			// Build root node (EntityNode)
 			initNode(_entityNode, entity::model::DescriptorType::Entity, 0, model::AcquireState::Undefined);
-			_entityNode.staticModel = &_entityStaticTree.staticModel;
+			_entityNode.staticModel = &_entityStaticTree->staticModel;
 			_entityNode.dynamicModel = &_entityDynamicTree.dynamicModel;
 
 			// Build configuration nodes (ConfigurationNode)
-			for (auto& configKV : _entityStaticTree.configurationStaticTrees)
+			for (auto const& configKV : _entityStaticTree->configurationStaticTrees)
 			{
 				auto const configIndex = configKV.first;
 				auto const& configStaticTree = configKV.second;
@@ -1634,7 +2017,7 @@ void ControlledEntityImpl::checkAndBuildEntityModelGraph() const noexcept
 					audioUnitNode.dynamicModel = &audioUnitDynamicModel;
 
 					// Build stream port inputs and outputs (StreamPortNode)
-					auto processStreamPorts = [entity = const_cast<ControlledEntityImpl*>(this), &audioUnitNode, configIndex](entity::model::DescriptorType const descriptorType, std::uint16_t const numberOfStreamPorts, entity::model::StreamPortIndex const baseStreamPort)
+					auto processStreamPorts = [this, entity = const_cast<ControlledEntityImpl*>(this), &audioUnitNode, configIndex](entity::model::DescriptorType const descriptorType, std::uint16_t const numberOfStreamPorts, entity::model::StreamPortIndex const baseStreamPort)
 					{
 						for (auto streamPortIndexCounter = entity::model::StreamPortIndex(0); streamPortIndexCounter < numberOfStreamPorts; ++streamPortIndexCounter)
 						{
@@ -1646,13 +2029,13 @@ void ControlledEntityImpl::checkAndBuildEntityModelGraph() const noexcept
 							if (descriptorType == entity::model::DescriptorType::StreamPortInput)
 							{
 								streamPortNode = &audioUnitNode.streamPortInputs[streamPortIndex];
-								streamPortStaticModel = &entity->getNodeStaticModel(configIndex, streamPortIndex, &model::ConfigurationStaticTree::streamPortInputStaticModels);
+								streamPortStaticModel = &getNodeStaticModel(configIndex, streamPortIndex, &model::ConfigurationStaticTree::streamPortInputStaticModels);
 								streamPortDynamicModel = &entity->getNodeDynamicModel(configIndex, streamPortIndex, &model::ConfigurationDynamicTree::streamPortInputDynamicModels);
 							}
 							else
 							{
 								streamPortNode = &audioUnitNode.streamPortOutputs[streamPortIndex];
-								streamPortStaticModel = &entity->getNodeStaticModel(configIndex, streamPortIndex, &model::ConfigurationStaticTree::streamPortOutputStaticModels);
+								streamPortStaticModel = &getNodeStaticModel(configIndex, streamPortIndex, &model::ConfigurationStaticTree::streamPortOutputStaticModels);
 								streamPortDynamicModel = &entity->getNodeDynamicModel(configIndex, streamPortIndex, &model::ConfigurationDynamicTree::streamPortOutputDynamicModels);
 							}
 
@@ -1667,7 +2050,7 @@ void ControlledEntityImpl::checkAndBuildEntityModelGraph() const noexcept
 								auto& audioClusterNode = streamPortNode->audioClusters[clusterIndex];
 								initNode(audioClusterNode, entity::model::DescriptorType::AudioCluster, clusterIndex, model::AcquireState::Undefined);
 
-								auto const& audioClusterStaticModel = entity->getNodeStaticModel(configIndex, clusterIndex, &model::ConfigurationStaticTree::audioClusterStaticModels);
+								auto const& audioClusterStaticModel = getNodeStaticModel(configIndex, clusterIndex, &model::ConfigurationStaticTree::audioClusterStaticModels);
 								auto& audioClusterDynamicModel = entity->getNodeDynamicModel(configIndex, clusterIndex, &model::ConfigurationDynamicTree::audioClusterDynamicModels);
 								audioClusterNode.staticModel = &audioClusterStaticModel;
 								audioClusterNode.dynamicModel = &audioClusterDynamicModel;
@@ -1680,7 +2063,7 @@ void ControlledEntityImpl::checkAndBuildEntityModelGraph() const noexcept
 								auto& audioMapNode = streamPortNode->audioMaps[mapIndex];
 								initNode(audioMapNode, entity::model::DescriptorType::AudioMap, mapIndex, model::AcquireState::Undefined);
 
-								auto const& audioMapStaticModel = entity->getNodeStaticModel(configIndex, mapIndex, &model::ConfigurationStaticTree::audioMapStaticModels);
+								auto const& audioMapStaticModel = getNodeStaticModel(configIndex, mapIndex, &model::ConfigurationStaticTree::audioMapStaticModels);
 								audioMapNode.staticModel = &audioMapStaticModel;
 							}
 						}
@@ -29,6 +29,8 @@
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
+#include <memory>
 #include <bitset>
 #include <functional>
 #include <chrono>
@@ -110,11 +112,22 @@ public:
 		ClockDomainSourceIndex, // CLOCK_DOMAIN.clock_source_index -> GET_CLOCK_SOURCE (7.4.24)
 	};
 
+	/** How the static model has been retrieved, when the EntityModel cache is enabled */
+	enum class EntityModelCacheResult : std::uint8_t
+	{
+		NotUsed, // Cache disabled
+		Miss, // Not in cache, fully enumerated
+		Hit, // Cached model used without verification
+		VerifiedHit, // Cached model used after the descriptors read for verification matched it
+		VerificationFailure, // Descriptors read for verification did not match the cached model, fully enumerated
+	};
+
 	using DescriptorKey = std::uint32_t;
 	static_assert(sizeof(DescriptorKey) >= sizeof(entity::model::DescriptorType) + sizeof(entity::model::DescriptorIndex), "DescriptorKey size must be greater or equal to DescriptorType + DescriptorIndex");
 	using DynamicInfoKey = std::uint64_t;
 	static_assert(sizeof(DynamicInfoKey) >= sizeof(DynamicInfoType) + sizeof(entity::model::DescriptorIndex) + sizeof(std::uint16_t), "DynamicInfoKey size must be greater or equal to DynamicInfoType + DescriptorIndex + std::uint16_t");
 	using DescriptorDynamicInfoKey = std::uint64_t;
+	using DeferredStringsQueries = std::vector<std::pair<entity::model::ConfigurationIndex, entity::model::StringsIndex>>;
 	static_assert(sizeof(DescriptorDynamicInfoKey) >= sizeof(DescriptorDynamicInfoType) + sizeof(entity::model::DescriptorIndex), "DescriptorDynamicInfoKey size must be greater or equal to DescriptorDynamicInfoType + DescriptorIndex");
 
 	/** Constructor */
@@ -124,6 +137,7 @@ public:
 	// Getters
 	virtual Compatibility getCompatibility() const noexcept override;
 	virtual bool gotFatalEnumerationError() const noexcept override;
+	virtual bool isStale() const noexcept override;
 	virtual bool isAcquired() const noexcept override;
 	virtual bool isAcquiring() const noexcept override;
 	virtual bool isAcquiredByOther() const noexcept override;
@@ -149,10 +163,12 @@ public:
 	//virtual model::AudioMapNode const& getAudioMapNode(entity::model::ConfigurationIndex const configurationIndex, entity::model::MapIndex const mapIndex) const override;
 	virtual model::ClockDomainNode const& getClockDomainNode(entity::model::ConfigurationIndex const configurationIndex, entity::model::ClockDomainIndex const clockDomainIndex) const override;
 
-	virtual model::LocaleNodeStaticModel const* findLocaleNode(entity::model::ConfigurationIndex const configurationIndex, std::string const& locale) const override; // Throws Exception::NotSupported if EM not supported by the Entity // Throws Exception::InvalidConfigurationIndex if configurationIndex do not exist
+	virtual model::LocaleNodeStaticModel const* findLocaleNode(entity::model::ConfigurationIndex const configurationIndex, std::string const& locale) const override; // Returns the locale matching 'locale' ("en-US", "en_US" and "en" forms, case insensitive), or a locale with the same language, or nullptr if none // Throws Exception::InvalidLocaleName if the configuration has no locale // Throws Exception::NotSupported if EM not supported by the Entity // Throws Exception::InvalidConfigurationIndex if configurationIndex do not exist
 	virtual entity::model::AvdeccFixedString const& getLocalizedString(entity::model::LocalizedStringReference const stringReference) const noexcept override;
 	virtual entity::model::AvdeccFixedString const& getLocalizedString(entity::model::ConfigurationIndex const configurationIndex, entity::model::LocalizedStringReference const stringReference) const noexcept override; // Get localized string or empty string if not found // Throws Exception::InvalidConfigurationIndex if configurationIndex do not exist
 
+	virtual MemoryFootprint getMemoryFootprint() const noexcept override;
+
 	// Visitor method
 	virtual void accept(model::EntityModelVisitor* const visitor) const noexcept override;
 
@@ -203,7 +219,7 @@ public:
 		return it->second;
 	}
 
-	// Non-const Tree getters
+	// Non-const Tree getters (a shared EntityStaticTree is copied first, read-only accesses have to use the const getters)
 	model::EntityStaticTree& getEntityStaticTree() noexcept;
 	model::EntityDynamicTree& getEntityDynamicTree() noexcept;
 	model::ConfigurationStaticTree& getConfigurationStaticTree(entity::model::ConfigurationIndex const configurationIndex) noexcept;
@@ -221,7 +237,7 @@ public:
 		std::lock_guard<decltype(_lock)> const lg(_lock);
 
 		auto& configStaticTree = getConfigurationStaticTree(configurationIndex);
-		return (configStaticTree.*Field)[index];
+		return getOrCreateNodeModel(configStaticTree.*Field, index);
 	}
 	template<typename FieldPointer, typename DescriptorIndexType>
 	typename std::remove_pointer_t<FieldPointer>::mapped_type& getNodeDynamicModel(entity::model::ConfigurationIndex const configurationIndex, DescriptorIndexType const index, FieldPointer model::ConfigurationDynamicTree::*Field) noexcept
@@ -230,7 +246,7 @@ public:
 		std::lock_guard<decltype(_lock)> const lg(_lock);
 
 		auto& configDynamicTree = getConfigurationDynamicTree(configurationIndex);
-		return (configDynamicTree.*Field)[index];
+		return getOrCreateNodeModel(configDynamicTree.*Field, index);
 	}
 
 	// Setters of the DescriptorDynamic info, all throw Exception::NotSupported if EM not supported by the Entity, Exception::InvalidConfigurationIndex if configurationIndex do not exist, Exception::InvalidDescriptorIndex if descriptorIndex is invalid
@@ -267,13 +283,17 @@ public:
 	model::ClockDomainCounters& getClockDomainCounters(entity::model::ClockDomainIndex const clockDomainIndex) noexcept;
 	model::StreamInputCounters& getStreamInputCounters(entity::model::StreamIndex const streamIndex) noexcept;
 
+	// Other const getters
+	model::AcquireState getAcquireState() const noexcept;
+
 	// Setters (of the model, not the physical entity)
 	void setEntity(entity::Entity const& entity) noexcept;
 	void setAcquireState(model::AcquireState const state) noexcept;
 	void setOwningController(UniqueIdentifier const controllerID) noexcept;
 
 	// Setters of the Model from AEM Descriptors (including DescriptorDynamic info)
-	bool setCachedEntityStaticTree(model::EntityStaticTree const& cachedStaticTree, entity::model::EntityDescriptor const& descriptor) noexcept; // Returns true if the cached EntityStaticTree is accepted (and set) for this entity
+	bool setCachedEntityStaticTree(std::shared_ptr<model::EntityStaticTree const> const& cachedStaticTree, entity::model::EntityDescriptor const& descriptor) noexcept; // Returns true if the cached EntityStaticTree is accepted (and shared) by this entity
+	void useCachedEntityStaticTree(std::shared_ptr<model::EntityStaticTree const> const& cachedStaticTree) noexcept; // Shares the cached EntityStaticTree instead of the model read from the entity
 	void setEntityDescriptor(entity::model::EntityDescriptor const& descriptor) noexcept;
 	void setConfigurationDescriptor(entity::model::ConfigurationDescriptor const& descriptor, entity::model::ConfigurationIndex const configurationIndex) noexcept;
 	void setAudioUnitDescriptor(entity::model::AudioUnitDescriptor const& descriptor, entity::model::ConfigurationIndex const configurationIndex, entity::model::AudioUnitIndex const audioUnitIndex) noexcept;
@@ -320,6 +340,21 @@ public:
 	void setGetFatalEnumerationError() noexcept;
 	bool wasAdvertised() const noexcept;
 	void setAdvertised(bool const wasAdvertised) noexcept;
+	void setStale(bool const isStale) noexcept;
+	void deferStringsDescriptorQuery(entity::model::ConfigurationIndex const configurationIndex, entity::model::StringsIndex const stringsIndex) noexcept; // Flags a STRINGS descriptor of the selected locale to be queried after enumeration
+	DeferredStringsQueries takeDeferredStringsDescriptorQueries() noexcept; // Returns (and clears) the STRINGS descriptors not queried during enumeration
+	void shareLocalizedStrings() noexcept; // Shares the loaded localized strings with the entities of the same EntityModelID (see LocalizedStringsRegistry)
+	std::shared_ptr<model::EntityStaticTree const> shareEntityStaticTree() noexcept; // Makes the EntityStaticTree immutable so it can be shared with the entities of the same EntityModelID (see EntityModelCache), a later modification being done on a copy
+	bool isEntityStaticTreeShared() const noexcept;
+	void setEntityStaticTreeToVerify(std::shared_ptr<model::EntityStaticTree const> const& cachedStaticTree) noexcept; // Cached EntityStaticTree to verify against the descriptors read from the entity, before using it
+	std::shared_ptr<model::EntityStaticTree const> takeEntityStaticTreeToVerify() noexcept; // Returns (and clears) the cached EntityStaticTree to verify
+	bool isVerifyingEntityStaticTree() const noexcept;
+	void setEntityStaticTreeVerificationReadFailed() noexcept; // A descriptor read to verify the cached EntityStaticTree failed (the entity does not match it)
+	bool isMatchingCachedEntityStaticTree(model::EntityStaticTree const& cachedStaticTree, entity::model::ConfigurationIndex const configurationIndex) const noexcept; // Returns true if the ENTITY, CONFIGURATION and STREAM descriptors read from the entity are identical in cachedStaticTree
+	EntityModelCacheResult getEntityModelCacheResult() const noexcept;
+	void setEntityModelCacheResult(EntityModelCacheResult const result) noexcept;
+	std::chrono::steady_clock::time_point getEnumerationStartTime() const noexcept;
+	void buildEntityModelGraph() noexcept; // Builds the model graph now instead of during the first getEntityNode() call, so the first user of the entity does not pay for it
 
 	// Other usefull manipulation methods
 	constexpr static bool isStreamRunningFlag(entity::StreamInfoFlags const flags) noexcept
@@ -378,6 +413,18 @@ protected:
 	}
 
 private:
+	template<typename NodeModels, typename DescriptorIndexType>
+	typename NodeModels::mapped_type& getOrCreateNodeModel(NodeModels& nodeModels, DescriptorIndexType const index) noexcept
+	{
+		// Appending a model beyond the reserved capacity moves the models of this type, the model graph (which points to them) will have to be built again (out of range indexes are stored sparsely and do not move them)
+		if (nodeModels.createMovesModels(index))
+		{
+			_entityNode = {};
+		}
+		return nodeModels[index];
+	}
+	void reserveNodeModels(entity::model::ConfigurationIndex const configurationIndex, model::DescriptorCounts const& descriptorCounts) noexcept;
+	void createReferencedNodeModels() noexcept;
 	void checkAndBuildEntityModelGraph() const noexcept;
 #ifdef ENABLE_AVDECC_FEATURE_REDUNDANCY
 	void buildRedundancyNodes(model::ConfigurationNode& configNode) const noexcept;
@@ -388,6 +435,8 @@ private:
 	std::uint32_t _lockedCount{ 0u }; // DEBUG status for _lock mutex
 	std::thread::id _lockingThreadID{}; // DEBUG status for _lock mutex
 	bool _ignoreCachedEntityModel{ false };
+	EntityModelCacheResult _entityModelCacheResult{ EntityModelCacheResult::NotUsed };
+	std::chrono::steady_clock::time_point _enumerationStartTime{ std::chrono::steady_clock::now() }; // Entities are created when discovered, right before being enumerated
 	std::uint16_t _queryDescriptorRetryCount{ 0u };
 	std::uint16_t _queryDynamicInfoRetryCount{ 0u };
 	std::uint16_t _queryDescriptorDynamicInfoRetryCount{ 0u };
@@ -395,6 +444,7 @@ private:
 	Compatibility _compatibility{ Compatibility::IEEE17221 }; // Entity compatibility type
 	bool _gotFatalEnumerateError{ false }; // Have we got a fatal error during entity enumeration
 	bool _advertised{ false }; // Has the entity been advertised to the observers
+	bool _stale{ false }; // Has the entity been restored from a network snapshot, and not yet revalidated
 	std::unordered_map<entity::model::ConfigurationIndex, std::unordered_set<DescriptorKey>> _expectedDescriptors{};
 	std::unordered_map<entity::model::ConfigurationIndex, std::unordered_set<DynamicInfoKey>> _expectedDynamicInfo{};
 	std::unordered_map<entity::model::ConfigurationIndex, std::unordered_set<DescriptorDynamicInfoKey>> _expectedDescriptorDynamicInfo{};
@@ -403,8 +453,13 @@ private:
 	// Entity variables
 	ModifiableEntity _entity; // No NSMI, Entity has no default constructor but it has to be passed to the only constructor of this class anyway
 	// Entity Model
-	mutable model::EntityStaticTree _entityStaticTree{}; // Static part of the model as represented by the AVDECC protocol
+	std::shared_ptr<model::EntityStaticTree> _ownedEntityStaticTree{ std::make_shared<model::EntityStaticTree>() }; // Same tree than _entityStaticTree while not shared, nullptr once shared
+	std::shared_ptr<model::EntityStaticTree const> _entityStaticTree{ _ownedEntityStaticTree }; // Static part of the model as represented by the AVDECC protocol, possibly shared with the entities of the same EntityModelID (see EntityModelCache)
+	std::shared_ptr<model::EntityStaticTree const> _entityStaticTreeToVerify{}; // Cached tree waiting for the descriptors read to verify it
+	bool _entityStaticTreeVerificationReadFailed{ false };
 	mutable model::EntityDynamicTree _entityDynamicTree{}; // Dynamic part of the model as represented by the AVDECC protocol
+	std::unordered_map<entity::model::ConfigurationIndex, std::shared_ptr<model::LocalizedStrings>> _ownedLocalizedStrings{}; // Tables being loaded, not shared yet
+	DeferredStringsQueries _deferredStringsQueries{}; // STRINGS descriptors of the selected locale, not queried during enumeration
 	mutable model::EntityNode _entityNode{}; // Model as represented by the ControlledEntity (tree of references to the model::EntityDescriptor and model::EntityDynamicInfo)
 };
 
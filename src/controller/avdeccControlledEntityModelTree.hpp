@@ -27,8 +27,14 @@
 
 #include "la/avdecc/controller/internals/avdeccControlledEntityStaticModel.hpp"
 #include "la/avdecc/controller/internals/avdeccControlledEntityDynamicModel.hpp"
+#include <vector>
 #include <map>
-#include <set>
+#include <optional>
+#include <utility>
+#include <iterator>
+#include <type_traits>
+#include <stdexcept>
+#include <cstddef>
 
 namespace la
 {
@@ -38,25 +44,294 @@ namespace controller
 {
 namespace model
 {
+/**
+* @brief Models indexed by descriptor index, stored in a single contiguous vector.
+* @details Descriptor indexes are 0-based and dense (IEEE1722.1 clause 7.2), so each model is stored at its index instead of in a separately allocated std::map node.
+*          Same interface as the std::map it replaces (iteration in index order yielding key/value pairs, find, at, operator[]), with O(1) lookup.
+*          - Models not received yet (enumeration is not ordered) are empty slots, skipped during iteration and not counted in size()
+*          - Indexes beyond capacity() that do not directly follow the last slot (out of range indexes from a faulty entity) are stored sparsely, so they never grow the slots
+*          - References to models are only invalidated by reserve, or when operator[] appends a slot beyond capacity() (see createMovesModels)
+*/
+template<typename IndexType, typename ModelType>
+class DenseIndexMap final
+{
+	using Slots = std::vector<std::optional<std::pair<IndexType, ModelType>>>;
+	using SparseModels = std::map<IndexType, std::pair<IndexType, ModelType>>;
+
+public:
+	using key_type = IndexType;
+	using mapped_type = ModelType;
+	using value_type = std::pair<IndexType, ModelType>;
+	using size_type = size_t;
+
+	/** Iterates the slots then the sparse models, all sparse indexes being greater than the slot indexes */
+	template<typename SlotIterator, typename SparseIterator, typename Value>
+	class Iterator final
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = std::remove_const_t<Value>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = Value*;
+		using reference = Value&;
+
+		Iterator(SlotIterator const current, SlotIterator const end, SparseIterator const sparseCurrent) noexcept
+			: _current(current)
+			, _end(end)
+			, _sparseCurrent(sparseCurrent)
+		{
+			skipEmptySlots();
+		}
+
+		reference operator*() const noexcept
+		{
+			if (_current != _end)
+			{
+				return **_current;
+			}
+			return _sparseCurrent->second;
+		}
+
+		pointer operator->() const noexcept
+		{
+			return &**this;
+		}
+
+		Iterator& operator++() noexcept
+		{
+			if (_current != _end)
+			{
+				++_current;
+				skipEmptySlots();
+			}
+			else
+			{
+				++_sparseCurrent;
+			}
+			return *this;
+		}
+
+		Iterator operator++(int) noexcept
+		{
+			auto const it = *this;
+			++(*this);
+			return it;
+		}
+
+		bool operator==(Iterator const& other) const noexcept
+		{
+			return _current == other._current && _sparseCurrent == other._sparseCurrent;
+		}
+
+		bool operator!=(Iterator const& other) const noexcept
+		{
+			return !(*this == other);
+		}
+
+	private:
+		void skipEmptySlots() noexcept
+		{
+			while (_current != _end && !_current->has_value())
+			{
+				++_current;
+			}
+		}
+
+		SlotIterator _current{};
+		SlotIterator _end{};
+		SparseIterator _sparseCurrent{};
+	};
+	using iterator = Iterator<typename Slots::iterator, typename SparseModels::iterator, value_type>;
+	using const_iterator = Iterator<typename Slots::const_iterator, typename SparseModels::const_iterator, value_type const>;
+
+	iterator begin() noexcept
+	{
+		return iterator{ _slots.begin(), _slots.end(), _sparseModels.begin() };
+	}
+
+	const_iterator begin() const noexcept
+	{
+		return const_iterator{ _slots.begin(), _slots.end(), _sparseModels.begin() };
+	}
+
+	iterator end() noexcept
+	{
+		return iterator{ _slots.end(), _slots.end(), _sparseModels.end() };
+	}
+
+	const_iterator end() const noexcept
+	{
+		return const_iterator{ _slots.end(), _slots.end(), _sparseModels.end() };
+	}
+
+	/** Number of models (empty slots are not counted) */
+	size_type size() const noexcept
+	{
+		return _size + _sparseModels.size();
+	}
+
+	bool empty() const noexcept
+	{
+		return size() == 0u;
+	}
+
+	/** Number of slots that can be created without moving the existing models */
+	size_type capacity() const noexcept
+	{
+		return _slots.capacity();
+	}
+
+	/** Number of models stored sparsely, beyond capacity() */
+	size_type sparseSize() const noexcept
+	{
+		return _sparseModels.size();
+	}
+
+	/** Reserves slots for indexes up to count (excluded), usually the descriptor count of the configuration so models are allocated once */
+	void reserve(size_type const count)
+	{
+		_slots.reserve(count);
+		moveSparseModelsToSlots();
+	}
+
+	void clear() noexcept
+	{
+		_slots.clear();
+		_sparseModels.clear();
+		_size = 0u;
+	}
+
+	iterator find(key_type const index) noexcept
+	{
+		if (containsSlot(index))
+			return iterator{ _slots.begin() + index, _slots.end(), _sparseModels.begin() };
+		auto const sparseIt = _sparseModels.find(index);
+		if (sparseIt == _sparseModels.end())
+			return end();
+		return iterator{ _slots.end(), _slots.end(), sparseIt };
+	}
+
+	const_iterator find(key_type const index) const noexcept
+	{
+		if (containsSlot(index))
+			return const_iterator{ _slots.begin() + index, _slots.end(), _sparseModels.begin() };
+		auto const sparseIt = _sparseModels.find(index);
+		if (sparseIt == _sparseModels.end())
+			return end();
+		return const_iterator{ _slots.end(), _slots.end(), sparseIt };
+	}
+
+	size_type count(key_type const index) const noexcept
+	{
+		return (containsSlot(index) || _sparseModels.count(index) != 0u) ? 1u : 0u;
+	}
+
+	/** Throws std::out_of_range if there is no model for the index */
+	mapped_type& at(key_type const index)
+	{
+		if (containsSlot(index))
+			return _slots[index]->second;
+		return _sparseModels.at(index).second;
+	}
+
+	/** Throws std::out_of_range if there is no model for the index */
+	mapped_type const& at(key_type const index) const
+	{
+		if (containsSlot(index))
+			return _slots[index]->second;
+		return _sparseModels.at(index).second;
+	}
+
+	/** Returns true if creating a model for the index with operator[] moves the existing models (invalidating references to them) */
+	bool createMovesModels(key_type const index) const noexcept
+	{
+		auto const slotIndex = static_cast<size_t>(index);
+		return slotIndex == _slots.size() && slotIndex >= _slots.capacity() && _sparseModels.count(index) == 0u;
+	}
+
+	/** Returns the model for the index, default constructing it if there is none */
+	mapped_type& operator[](key_type const index)
+	{
+		auto const slotIndex = static_cast<size_t>(index);
+		if (slotIndex >= _slots.size())
+		{
+			if (auto const sparseIt = _sparseModels.find(index); sparseIt != _sparseModels.end())
+			{
+				return sparseIt->second.second;
+			}
+			// Neither within the reserved slots nor directly following the last one: store sparsely instead of growing the slots up to the index
+			if (slotIndex > _slots.size() && slotIndex >= _slots.capacity())
+			{
+				return _sparseModels.try_emplace(index, index, ModelType{}).first->second.second;
+			}
+			auto const previousCapacity = _slots.capacity();
+			_slots.resize(slotIndex + 1u);
+			if (_slots.capacity() != previousCapacity)
+			{
+				moveSparseModelsToSlots();
+			}
+		}
+		auto& slot = _slots[slotIndex];
+		if (!slot)
+		{
+			slot.emplace(index, ModelType{});
+			++_size;
+		}
+		return slot->second;
+	}
+
+private:
+	bool containsSlot(key_type const index) const noexcept
+	{
+		auto const slotIndex = static_cast<size_t>(index);
+		return slotIndex < _slots.size() && _slots[slotIndex].has_value();
+	}
+
+	/** Moves the sparse models now within capacity() to their slot, so that sparse indexes are always beyond the slots */
+	void moveSparseModelsToSlots()
+	{
+		while (!_sparseModels.empty())
+		{
+			auto const sparseIt = _sparseModels.begin();
+			auto const slotIndex = static_cast<size_t>(sparseIt->first);
+			if (slotIndex >= _slots.capacity())
+			{
+				break;
+			}
+			if (slotIndex >= _slots.size())
+			{
+				_slots.resize(slotIndex + 1u);
+			}
+			_slots[slotIndex].emplace(std::move(sparseIt->second));
+			++_size;
+			_sparseModels.erase(sparseIt);
+		}
+	}
+
+	Slots _slots{};
+	SparseModels _sparseModels{};
+	size_type _size{ 0u };
+};
+
 struct ConfigurationDynamicTree
 {
 	// Children
-	std::map<entity::model::AudioUnitIndex, AudioUnitNodeDynamicModel> audioUnitDynamicModels{};
-	std::map<entity::model::StreamIndex, StreamInputNodeDynamicModel> streamInputDynamicModels{};
-	std::map<entity::model::StreamIndex, StreamOutputNodeDynamicModel> streamOutputDynamicModels{};
-	//std::map<entity::model::JackIndex, JackNodeDynamicModel> jackInputDynamicModels{};
-	//std::map<entity::model::JackIndex, JackNodeDynamicModel> jackOutputDynamicModels{};
-	std::map<entity::model::AvbInterfaceIndex, AvbInterfaceNodeDynamicModel> avbInterfaceDynamicModels{};
-	std::map<entity::model::ClockSourceIndex, ClockSourceNodeDynamicModel> clockSourceDynamicModels{};
-	std::map<entity::model::MemoryObjectIndex, MemoryObjectNodeDynamicModel> memoryObjectDynamicModels{};
-	std::map<entity::model::StreamPortIndex, StreamPortNodeDynamicModel> streamPortInputDynamicModels{};
-	std::map<entity::model::StreamPortIndex, StreamPortNodeDynamicModel> streamPortOutputDynamicModels{};
-	//std::map<entity::model::ExternalPortIndex, ExternalPortNodeDynamicModel> externalPortInputDynamicModels{};
-	//std::map<entity::model::ExternalPortIndex, ExternalPortNodeDynamicModel> externalPortOutputDynamicModels{};
-	//std::map<entity::model::InternalPortIndex, InternalPortNodeDynamicModel> internalPortInputDynamicModels{};
-	//std::map<entity::model::InternalPortIndex, InternalPortNodeDynamicModel> internalPortOutputDynamicModels{};
-	std::map<entity::model::ClusterIndex, AudioClusterNodeDynamicModel> audioClusterDynamicModels{};
-	std::map<entity::model::ClockDomainIndex, ClockDomainNodeDynamicModel> clockDomainDynamicModels{};
+	DenseIndexMap<entity::model::AudioUnitIndex, AudioUnitNodeDynamicModel> audioUnitDynamicModels{};
+	DenseIndexMap<entity::model::StreamIndex, StreamInputNodeDynamicModel> streamInputDynamicModels{};
+	DenseIndexMap<entity::model::StreamIndex, StreamOutputNodeDynamicModel> streamOutputDynamicModels{};
+	//DenseIndexMap<entity::model::JackIndex, JackNodeDynamicModel> jackInputDynamicModels{};
+	//DenseIndexMap<entity::model::JackIndex, JackNodeDynamicModel> jackOutputDynamicModels{};
+	DenseIndexMap<entity::model::AvbInterfaceIndex, AvbInterfaceNodeDynamicModel> avbInterfaceDynamicModels{};
+	DenseIndexMap<entity::model::ClockSourceIndex, ClockSourceNodeDynamicModel> clockSourceDynamicModels{};
+	DenseIndexMap<entity::model::MemoryObjectIndex, MemoryObjectNodeDynamicModel> memoryObjectDynamicModels{};
+	DenseIndexMap<entity::model::StreamPortIndex, StreamPortNodeDynamicModel> streamPortInputDynamicModels{};
+	DenseIndexMap<entity::model::StreamPortIndex, StreamPortNodeDynamicModel> streamPortOutputDynamicModels{};
+	//DenseIndexMap<entity::model::ExternalPortIndex, ExternalPortNodeDynamicModel> externalPortInputDynamicModels{};
+	//DenseIndexMap<entity::model::ExternalPortIndex, ExternalPortNodeDynamicModel> externalPortOutputDynamicModels{};
+	//DenseIndexMap<entity::model::InternalPortIndex, InternalPortNodeDynamicModel> internalPortInputDynamicModels{};
+	//DenseIndexMap<entity::model::InternalPortIndex, InternalPortNodeDynamicModel> internalPortOutputDynamicModels{};
+	DenseIndexMap<entity::model::ClusterIndex, AudioClusterNodeDynamicModel> audioClusterDynamicModels{};
+	DenseIndexMap<entity::model::ClockDomainIndex, ClockDomainNodeDynamicModel> clockDomainDynamicModels{};
 
 	// AEM Dynamic info
 	ConfigurationNodeDynamicModel dynamicModel;
@@ -65,7 +340,7 @@ struct ConfigurationDynamicTree
 struct EntityDynamicTree
 {
 	// Children
-	std::map<entity::model::ConfigurationIndex, ConfigurationDynamicTree> configurationDynamicTrees{};
+	DenseIndexMap<entity::model::ConfigurationIndex, ConfigurationDynamicTree> configurationDynamicTrees{};
 
 	// AEM Dynamic info
 	EntityNodeDynamicModel dynamicModel;
@@ -74,25 +349,25 @@ struct EntityDynamicTree
 struct ConfigurationStaticTree
 {
 	// Children
-	std::map<entity::model::AudioUnitIndex, AudioUnitNodeStaticModel> audioUnitStaticModels{};
-	std::map<entity::model::StreamIndex, StreamNodeStaticModel> streamInputStaticModels{};
-	std::map<entity::model::StreamIndex, StreamNodeStaticModel> streamOutputStaticModels{};
-	//std::map<entity::model::JackIndex, JackNodeStaticModel> jackInputStaticModels{};
-	//std::map<entity::model::JackIndex, JackNodeStaticModel> jackOutputStaticModels{};
-	std::map<entity::model::AvbInterfaceIndex, AvbInterfaceNodeStaticModel> avbInterfaceStaticModels{};
-	std::map<entity::model::ClockSourceIndex, ClockSourceNodeStaticModel> clockSourceStaticModels{};
-	std::map<entity::model::MemoryObjectIndex, MemoryObjectNodeStaticModel> memoryObjectStaticModels{};
-	std::map<entity::model::LocaleIndex, LocaleNodeStaticModel> localeStaticModels{};
-	std::map<entity::model::StringsIndex, StringsNodeStaticModel> stringsStaticModels{};
-	std::map<entity::model::StreamPortIndex, StreamPortNodeStaticModel> streamPortInputStaticModels{};
-	std::map<entity::model::StreamPortIndex, StreamPortNodeStaticModel> streamPortOutputStaticModels{};
-	//std::map<entity::model::ExternalPortIndex, ExternalPortNodeStaticModel> externalPortInputStaticModels{};
-	//std::map<entity::model::ExternalPortIndex, ExternalPortNodeStaticModel> externalPortOutputStaticModels{};
-	//std::map<entity::model::InternalPortIndex, InternalPortNodeStaticModel> internalPortInputStaticModels{};
-	//std::map<entity::model::InternalPortIndex, InternalPortNodeStaticModel> internalPortOutputStaticModels{};
-	std::map<entity::model::ClusterIndex, AudioClusterNodeStaticModel> audioClusterStaticModels{};
-	std::map<entity::model::MapIndex, AudioMapNodeStaticModel> audioMapStaticModels{};
-	std::map<entity::model::ClockDomainIndex, ClockDomainNodeStaticModel> clockDomainStaticModels{};
+	DenseIndexMap<entity::model::AudioUnitIndex, AudioUnitNodeStaticModel> audioUnitStaticModels{};
+	DenseIndexMap<entity::model::StreamIndex, StreamNodeStaticModel> streamInputStaticModels{};
+	DenseIndexMap<entity::model::StreamIndex, StreamNodeStaticModel> streamOutputStaticModels{};
+	//DenseIndexMap<entity::model::JackIndex, JackNodeStaticModel> jackInputStaticModels{};
+	//DenseIndexMap<entity::model::JackIndex, JackNodeStaticModel> jackOutputStaticModels{};
+	DenseIndexMap<entity::model::AvbInterfaceIndex, AvbInterfaceNodeStaticModel> avbInterfaceStaticModels{};
+	DenseIndexMap<entity::model::ClockSourceIndex, ClockSourceNodeStaticModel> clockSourceStaticModels{};
+	DenseIndexMap<entity::model::MemoryObjectIndex, MemoryObjectNodeStaticModel> memoryObjectStaticModels{};
+	DenseIndexMap<entity::model::LocaleIndex, LocaleNodeStaticModel> localeStaticModels{};
+	DenseIndexMap<entity::model::StringsIndex, StringsNodeStaticModel> stringsStaticModels{};
+	DenseIndexMap<entity::model::StreamPortIndex, StreamPortNodeStaticModel> streamPortInputStaticModels{};
+	DenseIndexMap<entity::model::StreamPortIndex, StreamPortNodeStaticModel> streamPortOutputStaticModels{};
+	//DenseIndexMap<entity::model::ExternalPortIndex, ExternalPortNodeStaticModel> externalPortInputStaticModels{};
+	//DenseIndexMap<entity::model::ExternalPortIndex, ExternalPortNodeStaticModel> externalPortOutputStaticModels{};
+	//DenseIndexMap<entity::model::InternalPortIndex, InternalPortNodeStaticModel> internalPortInputStaticModels{};
+	//DenseIndexMap<entity::model::InternalPortIndex, InternalPortNodeStaticModel> internalPortOutputStaticModels{};
+	DenseIndexMap<entity::model::ClusterIndex, AudioClusterNodeStaticModel> audioClusterStaticModels{};
+	DenseIndexMap<entity::model::MapIndex, AudioMapNodeStaticModel> audioMapStaticModels{};
+	DenseIndexMap<entity::model::ClockDomainIndex, ClockDomainNodeStaticModel> clockDomainStaticModels{};
 
 	// AEM Static info
 	ConfigurationNodeStaticModel staticModel;
@@ -101,7 +376,7 @@ struct ConfigurationStaticTree
 struct EntityStaticTree
 {
 	// Children
-	std::map<entity::model::ConfigurationIndex, ConfigurationStaticTree> configurationStaticTrees{};
+	DenseIndexMap<entity::model::ConfigurationIndex, ConfigurationStaticTree> configurationStaticTrees{};
 
 	// AEM Static info
 	EntityNodeStaticModel staticModel;
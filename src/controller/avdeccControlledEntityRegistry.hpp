@@ -0,0 +1,182 @@
+/*
+* Copyright (C) 2016-2018, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be usefu_state,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file avdeccControlledEntityRegistry.hpp
+* @author Christophe Calmejane
+*/
+
+#pragma once
+
+#include "avdeccControlledEntityImpl.hpp"
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <array>
+#include <cstdint>
+
+namespace la
+{
+namespace avdecc
+{
+namespace controller
+{
+/**
+* @brief Registry of online ControlledEntities.
+* @details Read-mostly concurrent map of the online entities, sharded by entityID hash.
+*          Each shard has its own reader/writer lock: lookups only take a shared lock on the shard of the looked up entity,
+*          so they never wait for each other, and only wait for a writer modifying that same shard (entity online/offline, which is rare).
+*          There is no lock common to all entities anymore.
+*
+*          Online/Offline semantics:
+*           - An entity is online from the moment 'insert' returns true, until the moment 'erase' returns it
+*           - A lookup racing with 'insert' or 'erase' either sees the entity or not, never a partially constructed state
+*           - A lookup returns a shared ownership of the entity, which stays valid (but offline) if 'erase' is called afterwards
+*/
+class ControlledEntityRegistry final
+{
+public:
+	using OnlineControlledEntity = std::shared_ptr<ControlledEntityImpl>;
+	using Entities = std::unordered_map<UniqueIdentifier, OnlineControlledEntity, UniqueIdentifier::hash>;
+
+	static constexpr size_t ShardsCount = 16; // Must be a power of 2
+
+	ControlledEntityRegistry() noexcept = default;
+
+	/** Returns the ControlledEntity if online, or an empty pointer. */
+	OnlineControlledEntity find(UniqueIdentifier const entityID) const noexcept
+	{
+		auto const& shard = getShard(entityID);
+
+		// Shared lock, concurrent lookups are allowed
+		std::shared_lock<decltype(shard.lock)> const lg(shard.lock);
+
+		auto const entityIt = shard.entities.find(entityID);
+		if (entityIt != shard.entities.end())
+		{
+			return entityIt->second;
+		}
+		return OnlineControlledEntity{};
+	}
+
+	/** Adds the ControlledEntity to the registry. Returns false (and do not replace it) if an entity with the same entityID is already online. */
+	bool insert(UniqueIdentifier const entityID, OnlineControlledEntity const& controlledEntity) noexcept
+	{
+		auto& shard = getShard(entityID);
+
+		// Exclusive lock, only for this shard
+		std::lock_guard<decltype(shard.lock)> const lg(shard.lock);
+
+		return shard.entities.insert(std::make_pair(entityID, controlledEntity)).second;
+	}
+
+	/** Removes the ControlledEntity from the registry. Returns the removed entity, or an empty pointer if it was not online. */
+	OnlineControlledEntity erase(UniqueIdentifier const entityID) noexcept
+	{
+		auto controlledEntity = OnlineControlledEntity{};
+		auto& shard = getShard(entityID);
+
+		{
+			// Exclusive lock, only for this shard
+			std::lock_guard<decltype(shard.lock)> const lg(shard.lock);
+
+			auto const entityIt = shard.entities.find(entityID);
+			if (entityIt == shard.entities.end())
+				return OnlineControlledEntity{};
+
+			controlledEntity = std::move(entityIt->second);
+			shard.entities.erase(entityIt);
+		}
+
+		return controlledEntity;
+	}
+
+	/** Removes all ControlledEntities from the registry, returning them. */
+	Entities clear() noexcept
+	{
+		auto entities = Entities{};
+
+		for (auto& shard : _shards)
+		{
+			// Exclusive lock, only for this shard
+			std::lock_guard<decltype(shard.lock)> const lg(shard.lock);
+
+			entities.insert(shard.entities.begin(), shard.entities.end());
+			shard.entities.clear();
+		}
+
+		return entities;
+	}
+
+	/** Returns a copy of all online ControlledEntities. Each shard is consistent, but the whole registry is not a single atomic snapshot. */
+	Entities getAll() const noexcept
+	{
+		auto entities = Entities{};
+
+		for (auto const& shard : _shards)
+		{
+			// Shared lock, concurrent lookups are allowed
+			std::shared_lock<decltype(shard.lock)> const lg(shard.lock);
+
+			entities.insert(shard.entities.begin(), shard.entities.end());
+		}
+
+		return entities;
+	}
+
+	// Deleted compiler auto-generated methods
+	ControlledEntityRegistry(ControlledEntityRegistry&&) = delete;
+	ControlledEntityRegistry(ControlledEntityRegistry const&) = delete;
+	ControlledEntityRegistry& operator=(ControlledEntityRegistry const&) = delete;
+	ControlledEntityRegistry& operator=(ControlledEntityRegistry&&) = delete;
+
+private:
+	static_assert((ShardsCount & (ShardsCount - 1)) == 0, "ShardsCount must be a power of 2");
+
+	// Each shard on its own cache line, so lookups in different shards do not interfere
+	struct alignas(64) Shard
+	{
+		mutable std::shared_mutex lock{};
+		Entities entities{};
+	};
+
+	Shard& getShard(UniqueIdentifier const entityID) noexcept
+	{
+		return _shards[getShardIndex(entityID)];
+	}
+
+	Shard const& getShard(UniqueIdentifier const entityID) const noexcept
+	{
+		return _shards[getShardIndex(entityID)];
+	}
+
+	static size_t getShardIndex(UniqueIdentifier const entityID) noexcept
+	{
+		// Fold the whole EID, entities from the same vendor usually only differ by a few bytes (not always the lowest ones)
+		auto const value = entityID.getValue();
+		return static_cast<size_t>(value ^ (value >> 24) ^ (value >> 48)) & (ShardsCount - 1);
+	}
+
+	std::array<Shard, ShardsCount> _shards{};
+};
+
+} // namespace controller
+} // namespace avdecc
+} // namespace la
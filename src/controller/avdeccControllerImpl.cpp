@@ -25,6 +25,8 @@
 #include "avdeccControllerImpl.hpp"
 #include "avdeccControllerLogHelper.hpp"
 #include "avdeccEntityModelCache.hpp"
+#include <algorithm>
+#include <utility>
 
 namespace la
 {
@@ -129,7 +131,7 @@ void ControllerImpl::updateStreamInputFormat(ControlledEntityImpl& controlledEnt
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onStreamInputFormatChanged, this, &controlledEntity, streamIndex, streamFormat);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::StreamInput, streamIndex, NotificationKind::StreamFormat }, controlledEntity, &Controller::Observer::onStreamInputFormatChanged, streamIndex, streamFormat);
 	}
 }
 
@@ -140,7 +142,7 @@ void ControllerImpl::updateStreamOutputFormat(ControlledEntityImpl& controlledEn
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onStreamOutputFormatChanged, this, &controlledEntity, streamIndex, streamFormat);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::StreamOutput, streamIndex, NotificationKind::StreamFormat }, controlledEntity, &Controller::Observer::onStreamOutputFormatChanged, streamIndex, streamFormat);
 	}
 }
 
@@ -152,7 +154,7 @@ void ControllerImpl::updateStreamInputInfo(ControlledEntityImpl& controlledEntit
 	// Entity was advertised to the user, notify observers (check if info actually changed, in case it's a change in StreamingWait and the entity sent both Unsol)
 	if (controlledEntity.wasAdvertised() && previousInfo != info)
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onStreamInputInfoChanged, this, &controlledEntity, streamIndex, info);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::StreamInput, streamIndex, NotificationKind::StreamInfo }, controlledEntity, &Controller::Observer::onStreamInputInfoChanged, streamIndex, info);
 
 		// Check if Running Status changed (since it's a separate Controller event)
 		auto const previousRunning = ControlledEntityImpl::isStreamRunningFlag(previousInfo.streamInfoFlags);
@@ -162,9 +164,9 @@ void ControllerImpl::updateStreamInputInfo(ControlledEntityImpl& controlledEntit
 		if (previousRunning != isRunning)
 		{
 			if (isRunning)
-				notifyObserversMethod<Controller::Observer>(&Controller::Observer::onStreamInputStarted, this, &controlledEntity, streamIndex);
+				notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::StreamInput, streamIndex, NotificationKind::StreamRunning }, controlledEntity, &Controller::Observer::onStreamInputStarted, streamIndex);
 			else
-				notifyObserversMethod<Controller::Observer>(&Controller::Observer::onStreamInputStopped, this, &controlledEntity, streamIndex);
+				notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::StreamInput, streamIndex, NotificationKind::StreamRunning }, controlledEntity, &Controller::Observer::onStreamInputStopped, streamIndex);
 		}
 	}
 }
@@ -177,7 +179,7 @@ void ControllerImpl::updateStreamOutputInfo(ControlledEntityImpl& controlledEnti
 	// Entity was advertised to the user, notify observers (check if info actually changed, in case it's a change in StreamingWait and the entity sent both Unsol)
 	if (controlledEntity.wasAdvertised() && previousInfo != info)
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onStreamOutputInfoChanged, this, &controlledEntity, streamIndex, info);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::StreamOutput, streamIndex, NotificationKind::StreamInfo }, controlledEntity, &Controller::Observer::onStreamOutputInfoChanged, streamIndex, info);
 
 		// Check if Running Status changed (since it's a separate Controller event)
 		auto const previousRunning = ControlledEntityImpl::isStreamRunningFlag(previousInfo.streamInfoFlags);
@@ -187,9 +189,9 @@ void ControllerImpl::updateStreamOutputInfo(ControlledEntityImpl& controlledEnti
 		if (previousRunning != isRunning)
 		{
 			if (isRunning)
-				notifyObserversMethod<Controller::Observer>(&Controller::Observer::onStreamOutputStarted, this, &controlledEntity, streamIndex);
+				notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::StreamOutput, streamIndex, NotificationKind::StreamRunning }, controlledEntity, &Controller::Observer::onStreamOutputStarted, streamIndex);
 			else
-				notifyObserversMethod<Controller::Observer>(&Controller::Observer::onStreamOutputStopped, this, &controlledEntity, streamIndex);
+				notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::StreamOutput, streamIndex, NotificationKind::StreamRunning }, controlledEntity, &Controller::Observer::onStreamOutputStopped, streamIndex);
 		}
 	}
 }
@@ -201,7 +203,7 @@ void ControllerImpl::updateEntityName(ControlledEntityImpl& controlledEntity, en
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onEntityNameChanged, this, &controlledEntity, entityName);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), 0u, entity::model::DescriptorType::Entity, 0u, NotificationKind::Name }, controlledEntity, &Controller::Observer::onEntityNameChanged, entityName);
 	}
 }
 
@@ -212,7 +214,7 @@ void ControllerImpl::updateEntityGroupName(ControlledEntityImpl& controlledEntit
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onEntityGroupNameChanged, this, &controlledEntity, entityGroupName);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), 0u, entity::model::DescriptorType::Entity, 0u, NotificationKind::GroupName }, controlledEntity, &Controller::Observer::onEntityGroupNameChanged, entityGroupName);
 	}
 }
 
@@ -223,7 +225,7 @@ void ControllerImpl::updateConfigurationName(ControlledEntityImpl& controlledEnt
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onConfigurationNameChanged, this, &controlledEntity, configurationIndex, configurationName);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), configurationIndex, entity::model::DescriptorType::Configuration, configurationIndex, NotificationKind::Name }, controlledEntity, &Controller::Observer::onConfigurationNameChanged, configurationIndex, configurationName);
 	}
 }
 
@@ -234,7 +236,7 @@ void ControllerImpl::updateAudioUnitName(ControlledEntityImpl& controlledEntity,
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onAudioUnitNameChanged, this, &controlledEntity, configurationIndex, audioUnitIndex, audioUnitName);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), configurationIndex, entity::model::DescriptorType::AudioUnit, audioUnitIndex, NotificationKind::Name }, controlledEntity, &Controller::Observer::onAudioUnitNameChanged, configurationIndex, audioUnitIndex, audioUnitName);
 	}
 }
 
@@ -245,7 +247,7 @@ void ControllerImpl::updateStreamInputName(ControlledEntityImpl& controlledEntit
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onStreamInputNameChanged, this, &controlledEntity, configurationIndex, streamIndex, streamInputName);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), configurationIndex, entity::model::DescriptorType::StreamInput, streamIndex, NotificationKind::Name }, controlledEntity, &Controller::Observer::onStreamInputNameChanged, configurationIndex, streamIndex, streamInputName);
 	}
 }
 
@@ -256,7 +258,7 @@ void ControllerImpl::updateStreamOutputName(ControlledEntityImpl& controlledEnti
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onStreamOutputNameChanged, this, &controlledEntity, configurationIndex, streamIndex, streamOutputName);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), configurationIndex, entity::model::DescriptorType::StreamOutput, streamIndex, NotificationKind::Name }, controlledEntity, &Controller::Observer::onStreamOutputNameChanged, configurationIndex, streamIndex, streamOutputName);
 	}
 }
 
@@ -267,7 +269,7 @@ void ControllerImpl::updateAvbInterfaceName(ControlledEntityImpl& controlledEnti
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onAvbInterfaceNameChanged, this, &controlledEntity, configurationIndex, avbInterfaceIndex, avbInterfaceName);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), configurationIndex, entity::model::DescriptorType::AvbInterface, avbInterfaceIndex, NotificationKind::Name }, controlledEntity, &Controller::Observer::onAvbInterfaceNameChanged, configurationIndex, avbInterfaceIndex, avbInterfaceName);
 	}
 }
 
@@ -278,7 +280,7 @@ void ControllerImpl::updateClockSourceName(ControlledEntityImpl& controlledEntit
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onClockSourceNameChanged, this, &controlledEntity, configurationIndex, clockSourceIndex, clockSourceName);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), configurationIndex, entity::model::DescriptorType::ClockSource, clockSourceIndex, NotificationKind::Name }, controlledEntity, &Controller::Observer::onClockSourceNameChanged, configurationIndex, clockSourceIndex, clockSourceName);
 	}
 }
 
@@ -289,7 +291,7 @@ void ControllerImpl::updateMemoryObjectName(ControlledEntityImpl& controlledEnti
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onMemoryObjectNameChanged, this, &controlledEntity, configurationIndex, memoryObjectIndex, memoryObjectName);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), configurationIndex, entity::model::DescriptorType::MemoryObject, memoryObjectIndex, NotificationKind::Name }, controlledEntity, &Controller::Observer::onMemoryObjectNameChanged, configurationIndex, memoryObjectIndex, memoryObjectName);
 	}
 }
 
@@ -300,7 +302,7 @@ void ControllerImpl::updateAudioClusterName(ControlledEntityImpl& controlledEnti
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onAudioClusterNameChanged, this, &controlledEntity, configurationIndex, audioClusterIndex, audioClusterName);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), configurationIndex, entity::model::DescriptorType::AudioCluster, audioClusterIndex, NotificationKind::Name }, controlledEntity, &Controller::Observer::onAudioClusterNameChanged, configurationIndex, audioClusterIndex, audioClusterName);
 	}
 }
 
@@ -311,7 +313,7 @@ void ControllerImpl::updateClockDomainName(ControlledEntityImpl& controlledEntit
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onClockDomainNameChanged, this, &controlledEntity, configurationIndex, clockDomainIndex, clockDomainName);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), configurationIndex, entity::model::DescriptorType::ClockDomain, clockDomainIndex, NotificationKind::Name }, controlledEntity, &Controller::Observer::onClockDomainNameChanged, configurationIndex, clockDomainIndex, clockDomainName);
 	}
 }
 
@@ -322,7 +324,7 @@ void ControllerImpl::updateAudioUnitSamplingRate(ControlledEntityImpl& controlle
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onAudioUnitSamplingRateChanged, this, &controlledEntity, audioUnitIndex, samplingRate);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::AudioUnit, audioUnitIndex, NotificationKind::SamplingRate }, controlledEntity, &Controller::Observer::onAudioUnitSamplingRateChanged, audioUnitIndex, samplingRate);
 	}
 }
 
@@ -333,7 +335,7 @@ void ControllerImpl::updateClockSource(ControlledEntityImpl& controlledEntity, e
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onClockSourceChanged, this, &controlledEntity, clockDomainIndex, clockSourceIndex);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::ClockDomain, clockDomainIndex, NotificationKind::ClockSource }, controlledEntity, &Controller::Observer::onClockSourceChanged, clockDomainIndex, clockSourceIndex);
 	}
 }
 
@@ -382,12 +384,12 @@ void ControllerImpl::updateAvbInfo(ControlledEntityImpl& controlledEntity, entit
 	// Entity was advertised to the user, notify observers (check if info actually changed)
 	if (controlledEntity.wasAdvertised() && previousInfo != info)
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onAvbInfoChanged, this, &controlledEntity, avbInterfaceIndex, info);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::AvbInterface, avbInterfaceIndex, NotificationKind::AvbInfo }, controlledEntity, &Controller::Observer::onAvbInfoChanged, avbInterfaceIndex, info);
 
 		// Check if gPTP changed (since it's a separate Controller event)
 		if (previousInfo.gptpGrandmasterID != info.gptpGrandmasterID || previousInfo.gptpDomainNumber != info.gptpDomainNumber)
 		{
-			notifyObserversMethod<Controller::Observer>(&Controller::Observer::onGptpChanged, this, &controlledEntity, avbInterfaceIndex, info.gptpGrandmasterID, info.gptpDomainNumber);
+			notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::AvbInterface, avbInterfaceIndex, NotificationKind::Gptp }, controlledEntity, &Controller::Observer::onGptpChanged, avbInterfaceIndex, info.gptpGrandmasterID, info.gptpDomainNumber);
 		}
 	}
 }
@@ -406,7 +408,7 @@ void ControllerImpl::updateAvbInterfaceCounters(ControlledEntityImpl& controlled
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onAvbInterfaceCountersChanged, this, &controlledEntity, avbInterfaceIndex, avbInterfaceCounters);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::AvbInterface, avbInterfaceIndex, NotificationKind::Counters }, controlledEntity, &Controller::Observer::onAvbInterfaceCountersChanged, avbInterfaceIndex, avbInterfaceCounters);
 	}
 }
 
@@ -424,7 +426,7 @@ void ControllerImpl::updateClockDomainCounters(ControlledEntityImpl& controlledE
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onClockDomainCountersChanged, this, &controlledEntity, clockDomainIndex, clockDomainCounters);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::ClockDomain, clockDomainIndex, NotificationKind::Counters }, controlledEntity, &Controller::Observer::onClockDomainCountersChanged, clockDomainIndex, clockDomainCounters);
 	}
 }
 
@@ -442,7 +444,7 @@ void ControllerImpl::updateStreamInputCounters(ControlledEntityImpl& controlledE
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onStreamInputCountersChanged, this, &controlledEntity, streamIndex, streamCounters);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::StreamInput, streamIndex, NotificationKind::Counters }, controlledEntity, &Controller::Observer::onStreamInputCountersChanged, streamIndex, streamCounters);
 	}
 }
 
@@ -453,7 +455,7 @@ void ControllerImpl::updateMemoryObjectLength(ControlledEntityImpl& controlledEn
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onMemoryObjectLengthChanged, this, &controlledEntity, configurationIndex, memoryObjectIndex, length);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), configurationIndex, entity::model::DescriptorType::MemoryObject, memoryObjectIndex, NotificationKind::MemoryObjectLength }, controlledEntity, &Controller::Observer::onMemoryObjectLengthChanged, configurationIndex, memoryObjectIndex, length);
 	}
 }
 
@@ -464,7 +466,7 @@ void ControllerImpl::updateStreamPortInputAudioMappingsAdded(ControlledEntityImp
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onStreamPortInputAudioMappingsChanged, this, &controlledEntity, streamPortIndex);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::StreamPortInput, streamPortIndex, NotificationKind::AudioMappings }, controlledEntity, &Controller::Observer::onStreamPortInputAudioMappingsChanged, streamPortIndex);
 	}
 }
 
@@ -475,7 +477,7 @@ void ControllerImpl::updateStreamPortInputAudioMappingsRemoved(ControlledEntityI
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onStreamPortInputAudioMappingsChanged, this, &controlledEntity, streamPortIndex);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::StreamPortInput, streamPortIndex, NotificationKind::AudioMappings }, controlledEntity, &Controller::Observer::onStreamPortInputAudioMappingsChanged, streamPortIndex);
 	}
 }
 
@@ -486,7 +488,7 @@ void ControllerImpl::updateStreamPortOutputAudioMappingsAdded(ControlledEntityIm
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onStreamPortOutputAudioMappingsChanged, this, &controlledEntity, streamPortIndex);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::StreamPortOutput, streamPortIndex, NotificationKind::AudioMappings }, controlledEntity, &Controller::Observer::onStreamPortOutputAudioMappingsChanged, streamPortIndex);
 	}
 }
 
@@ -497,7 +499,7 @@ void ControllerImpl::updateStreamPortOutputAudioMappingsRemoved(ControlledEntity
 	// Entity was advertised to the user, notify observers
 	if (controlledEntity.wasAdvertised())
 	{
-		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onStreamPortOutputAudioMappingsChanged, this, &controlledEntity, streamPortIndex);
+		notifyObserversCoalescable(NotificationKey{ controlledEntity.getEntity().getEntityID(), controlledEntity.getCurrentConfigurationIndex(), entity::model::DescriptorType::StreamPortOutput, streamPortIndex, NotificationKind::AudioMappings }, controlledEntity, &Controller::Observer::onStreamPortOutputAudioMappingsChanged, streamPortIndex);
 	}
 }
 
@@ -538,159 +540,899 @@ void ControllerImpl::updateOperationStatus(ControlledEntityImpl& controlledEntit
 /* Private methods                                              */
 /* ************************************************************ */
 void ControllerImpl::addDelayedQuery(std::chrono::milliseconds const delay, UniqueIdentifier const entityID, DelayedQueryHandler&& queryHandler) noexcept
+{
+	auto isNextQuery = false;
+	{
+		// Lock to protect _delayedQueries
+		std::lock_guard<decltype(_lock)> const lg(_lock);
+
+		auto const key = DelayedQueryKey{ _clock.now() + delay, _delayedQueriesCounter++ };
+		_delayedQueries.emplace(key, DelayedQuery{ entityID, std::move(queryHandler) });
+		_delayedQueriesPerEntity[entityID].insert(key);
+
+		// Only wake up the thread if it has to wait less than before
+		isNextQuery = _delayedQueries.begin()->first == key;
+	}
+	if (isNextQuery)
+		_delayedQueriesCondVar.notify_one();
+}
+
+void ControllerImpl::popDueDelayedQueries(Clock::time_point const currentTime, std::vector<DelayedQuery>& queries) noexcept
+{
+	for (auto it = _delayedQueries.begin(); it != _delayedQueries.end() && it->first.first <= currentTime; it = _delayedQueries.erase(it))
+	{
+		auto const entityIt = _delayedQueriesPerEntity.find(it->second.entityID);
+		if (entityIt != _delayedQueriesPerEntity.end())
+		{
+			entityIt->second.erase(it->first);
+			if (entityIt->second.empty())
+				_delayedQueriesPerEntity.erase(entityIt);
+		}
+		queries.emplace_back(std::move(it->second));
+	}
+}
+
+void ControllerImpl::sendDelayedQueries(std::vector<DelayedQuery> const& queries) noexcept
+{
+	for (auto const& query : queries)
+	{
+		if (_shouldTerminate)
+			break;
+
+		auto controlledEntity = getControlledEntityImpl(query.entityID);
+
+		// Entity still online
+		if (controlledEntity)
+		{
+			// Send the query
+			invokeProtectedHandler(query.queryHandler, _controller);
+		}
+	}
+}
+
+void ControllerImpl::removeDelayedQueries(UniqueIdentifier const entityID) noexcept
 {
 	// Lock to protect _delayedQueries
 	std::lock_guard<decltype(_lock)> const lg(_lock);
 
-	_delayedQueries.emplace_back(DelayedQuery{ std::chrono::system_clock::now() + delay, entityID, std::move(queryHandler) });
+	auto const entityIt = _delayedQueriesPerEntity.find(entityID);
+	if (entityIt == _delayedQueriesPerEntity.end())
+		return;
+
+	for (auto const& key : entityIt->second)
+	{
+		_delayedQueries.erase(key);
+	}
+	_delayedQueriesPerEntity.erase(entityIt);
+
+	// No need to wake up the thread, it will just wake up earlier than needed if the first query was removed
 }
 
-void ControllerImpl::chooseLocale(ControlledEntityImpl* const entity, entity::model::ConfigurationIndex const configurationIndex) noexcept
+void ControllerImpl::sendQuery(InflightQueriesRegistry::Key const& key, std::chrono::milliseconds const delayQuery, DelayedQueryHandler&& queryHandler) noexcept
 {
-	model::LocaleNodeStaticModel const* localeNode{ nullptr };
-	localeNode = entity->findLocaleNode(configurationIndex, _preferedLocale);
-	if (localeNode == nullptr)
+	if (!queryHandler)
 	{
-#pragma message("TODO: Split _preferedLocale into language/country, then if findLocaleDescriptor fails and language is not 'en', try to find a locale for 'en'")
-		localeNode = entity->findLocaleNode(configurationIndex, "en");
+		return;
+	}
+
+	// Enumeration queries must not delay user commands (nor be promoted if requested with a lower priority)
+	auto const priority = std::max(entity::ControllerEntity::getThreadCommandPriority(), CommandPriority::Enumeration);
+	auto const triggerTime = InflightQueriesRegistry::Clock::now();
+
+	// Check for an identical inflight query right before sending (a delayed query might become a duplicate while waiting)
+	auto sendHandler = [this, key, priority, triggerTime, queryHandler = std::move(queryHandler)](entity::ControllerEntity* const controller)
+	{
+		auto shouldSend = false;
+		{
+			// Lock to protect _inflightQueries
+			std::lock_guard<decltype(_inflightQueriesLock)> const lg(_inflightQueriesLock);
+			shouldSend = _inflightQueries.registerQuery(key, InflightQueriesRegistry::Clock::now(), triggerTime, queryHandler);
+		}
+
+		if (shouldSend)
+		{
+			auto const priorityGuard = entity::ControllerEntity::CommandPriorityGuard{ priority };
+			queryHandler(controller);
+		}
+		else
+		{
+			LOG_CONTROLLER_TRACE(key.entityID, "Identical query already inflight (Kind={} Type={} ConfigurationIndex={} DescriptorIndex={} SubIndex={})", to_integral(key.kind), key.type, key.configurationIndex, key.descriptorIndex, key.subIndex);
+		}
+	};
+
+	// Not delayed, call now
+	if (delayQuery == std::chrono::milliseconds{ 0 })
+	{
+		sendHandler(_controller);
+	}
+	else
+	{
+		addDelayedQuery(delayQuery, key.entityID, std::move(sendHandler));
+	}
+}
+
+void ControllerImpl::completeInflightQuery(InflightQueriesRegistry::Key const& key) noexcept
+{
+	auto resendHandler = InflightQueriesRegistry::QueryHandler{};
+	{
+		// Lock to protect _inflightQueries
+		std::lock_guard<decltype(_inflightQueriesLock)> const lg(_inflightQueriesLock);
+
+		resendHandler = _inflightQueries.completeQuery(key);
+	}
+
+	// An identical dynamic query was triggered after this one was sent, its result might predate the change that triggered the new query
+	if (resendHandler)
+	{
+		sendQuery(key, std::chrono::milliseconds{ 0 }, std::move(resendHandler));
+	}
+}
+
+void ControllerImpl::removeInflightQueries(UniqueIdentifier const entityID) noexcept
+{
+	// Lock to protect _inflightQueries
+	std::lock_guard<decltype(_inflightQueriesLock)> const lg(_inflightQueriesLock);
+
+	_inflightQueries.removeQueries(entityID);
+}
+
+void ControllerImpl::queueBatchedNotification(NotificationKey const& key, BatchedNotificationHandler&& handler) const noexcept
+{
+	// Lock to protect _batchedNotifications
+	std::lock_guard<decltype(_notificationsLock)> const lg(_notificationsLock);
+
+	++_notificationsStatistics.queuedEvents;
+
+	// Coalesce with the pending event of the same kind for the same descriptor (keeping its position in the batch, but using the latest values)
+	auto const indexIt = _batchedNotificationsIndexes.find(key);
+	if (indexIt != _batchedNotificationsIndexes.end())
+	{
+		_batchedNotifications[indexIt->second].handler = std::move(handler);
+		++_notificationsStatistics.coalescedEvents;
+		return;
+	}
+
+	_batchedNotificationsIndexes.emplace(key, _batchedNotifications.size());
+	_batchedNotifications.emplace_back(BatchedNotification{ key, std::move(handler) });
+
+	// Wake up the dispatcher if this is the first event of the batch (it starts the batching window)
+	if (_batchedNotifications.size() == 1u)
+	{
+		_notificationsBatchStartTime = _clock.now();
+		_notificationsCondVar.notify_all();
+	}
+}
+
+void ControllerImpl::purgeBatchedNotifications(UniqueIdentifier const entityID) noexcept
+{
+	// Lock to protect _batchedNotifications
+	std::lock_guard<decltype(_notificationsLock)> const lg(_notificationsLock);
+
+	if (_batchedNotifications.empty())
+		return;
+
+	// Remove all pending events for this entity, and rebuild the indexes
+	auto const isSameEntity = [entityID](auto const& notification)
+	{
+		return notification.key.entityID == entityID;
+	};
+	_batchedNotifications.erase(std::remove_if(_batchedNotifications.begin(), _batchedNotifications.end(), isSameEntity), _batchedNotifications.end());
+	_batchedNotificationsIndexes.clear();
+	for (auto index = size_t{ 0u }; index < _batchedNotifications.size(); ++index)
+	{
+		_batchedNotificationsIndexes.emplace(_batchedNotifications[index].key, index);
+	}
+}
+
+void ControllerImpl::dispatchBatchedNotifications() noexcept
+{
+	auto notifications = BatchedNotifications{};
+
+	// Get all pending events
+	{
+		// Lock to protect _batchedNotifications
+		std::lock_guard<decltype(_notificationsLock)> const lg(_notificationsLock);
+
+		if (_batchedNotifications.empty())
+			return;
+
+		notifications.swap(_batchedNotifications);
+		_batchedNotificationsIndexes.clear();
+		_notificationsStatistics.deliveredEvents += notifications.size();
+		++_notificationsStatistics.deliveredBatches;
 	}
-	if (localeNode != nullptr)
+
+	// Deliver the batch with the controller locked, the same way notifications are delivered from the ControllerEntity::Delegate
+	std::lock_guard<entity::ControllerEntity> const lg(*_controller);
+
+	notifyObservers<Controller::Observer>(
+		[this, &notifications](Controller::Observer* obs)
+		{
+			if (obs->getNotificationMode() != NotificationMode::Batched)
+				return;
+
+			obs->onNotificationsBatchBegin(this);
+			for (auto const& notification : notifications)
+			{
+				// Only deliver if the entity is still online and advertised (it might have gone offline and online again since the event was queued, in which case pending events were purged)
+				auto const controlledEntity = getControlledEntityImpl(notification.key.entityID);
+				if (controlledEntity && controlledEntity->wasAdvertised())
+				{
+					notification.handler(obs, controlledEntity.get());
+				}
+			}
+			obs->onNotificationsBatchEnd(this);
+		});
+}
+
+void ControllerImpl::stopNotificationsDispatcher() noexcept
+{
+	{
+		// Lock to protect the dispatcher state
+		std::lock_guard<decltype(_notificationsLock)> const lg(_notificationsLock);
+		_shouldTerminateDispatcher = true;
+	}
+	_notificationsCondVar.notify_all();
+
+	// Wait for the thread to flush pending events
+	if (_notificationsDispatcherThread.joinable())
+		_notificationsDispatcherThread.join();
+
+	// No dispatcher thread for a manual clock, flush pending events now
+	dispatchBatchedNotifications();
+
+	_shouldTerminateDispatcher = false;
+}
+
+void ControllerImpl::addCountersPollingEntity(ControlledEntityImpl const& controlledEntity) noexcept
+{
+	auto const& e = controlledEntity.getEntity();
+	// Only AEM entities have counters
+	if (!hasFlag(e.getEntityCapabilities(), entity::EntityCapabilities::AemSupported))
+		return;
+
+	try
+	{
+		auto const& configStaticTree = controlledEntity.getConfigurationStaticTree(controlledEntity.getCurrentConfigurationIndex());
+		auto descriptorsCount = CountersPollingScheduler::DescriptorsCount{};
+		descriptorsCount[static_cast<size_t>(CountersKind::AvbInterface)] = static_cast<std::uint16_t>(configStaticTree.avbInterfaceStaticModels.size());
+		descriptorsCount[static_cast<size_t>(CountersKind::ClockDomain)] = static_cast<std::uint16_t>(configStaticTree.clockDomainStaticModels.size());
+		descriptorsCount[static_cast<size_t>(CountersKind::StreamInput)] = static_cast<std::uint16_t>(configStaticTree.streamInputStaticModels.size());
+
+		{
+			// Lock to protect _countersPollingScheduler
+			std::lock_guard<decltype(_countersPollingLock)> const lg(_countersPollingLock);
+			_countersPollingScheduler.addEntity(e.getEntityID(), descriptorsCount, _clock.now());
+		}
+		_countersPollingCondVar.notify_all();
+	}
+	catch (ControlledEntity::Exception const&)
+	{
+		// Current configuration not found, nothing to poll
+	}
+}
+
+void ControllerImpl::removeCountersPollingEntity(UniqueIdentifier const entityID) noexcept
+{
+	// Lock to protect _countersPollingScheduler
+	std::lock_guard<decltype(_countersPollingLock)> const lg(_countersPollingLock);
+	_countersPollingScheduler.removeEntity(entityID);
+}
+
+void ControllerImpl::postponeCountersPolling(UniqueIdentifier const entityID, CountersKind const kind, entity::model::DescriptorIndex const descriptorIndex) noexcept
+{
+	// Lock to protect _countersPollingScheduler
+	std::lock_guard<decltype(_countersPollingLock)> const lg(_countersPollingLock);
+	_countersPollingScheduler.onUnsolicitedCounters(entityID, kind, descriptorIndex, _clock.now());
+}
+
+void ControllerImpl::onPolledCountersNotSupported(UniqueIdentifier const entityID, CountersKind const kind, entity::ControllerEntity::AemCommandStatus const status) noexcept
+{
+	// Stop polling this kind of counters if the entity will never answer, don't waste the budget
+	if (getFailureAction(status) == FailureAction::NotSupported)
+	{
+		LOG_CONTROLLER_INFO(entityID, "Counters polling stopped for CountersKind={}: {}", to_integral(kind), entity::ControllerEntity::statusToString(status));
+
+		// Lock to protect _countersPollingScheduler
+		std::lock_guard<decltype(_countersPollingLock)> const lg(_countersPollingLock);
+		_countersPollingScheduler.onQueryNotSupported(entityID, kind);
+	}
+}
+
+void ControllerImpl::sendCountersPollingQuery(CountersPollingScheduler::Query const& query) noexcept
+{
+	auto const entityID = query.entityID;
+	auto const descriptorIndex = query.descriptorIndex;
+
+	// Polled counters are sent after user commands and enumeration queries
+	auto const priorityGuard = entity::ControllerEntity::CommandPriorityGuard{ CommandPriority::Background };
+
+	switch (query.kind)
+	{
+		case CountersKind::AvbInterface:
+			LOG_CONTROLLER_TRACE(entityID, "Polling getAvbInterfaceCounters (AvbInterfaceIndex={})", descriptorIndex);
+			_controller->getAvbInterfaceCounters(entityID, descriptorIndex, std::bind(&ControllerImpl::onPolledAvbInterfaceCountersResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+			break;
+		case CountersKind::ClockDomain:
+			LOG_CONTROLLER_TRACE(entityID, "Polling getClockDomainCounters (ClockDomainIndex={})", descriptorIndex);
+			_controller->getClockDomainCounters(entityID, descriptorIndex, std::bind(&ControllerImpl::onPolledClockDomainCountersResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+			break;
+		case CountersKind::StreamInput:
+			LOG_CONTROLLER_TRACE(entityID, "Polling getStreamInputCounters (StreamIndex={})", descriptorIndex);
+			_controller->getStreamInputCounters(entityID, descriptorIndex, std::bind(&ControllerImpl::onPolledStreamInputCountersResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+			break;
+		default:
+			AVDECC_ASSERT(false, "Unhandled CountersKind");
+			break;
+	}
+}
+
+void ControllerImpl::sendNextStreamConnectionsBatchOperations(std::shared_ptr<StreamConnectionsBatchContext> const& context) const noexcept
+{
+	{
+		// Lock to protect context->isSending and context->sendRequested
+		std::lock_guard<decltype(context->lock)> const lg(context->lock);
+
+		// Already sending (result handler called synchronously, or from another thread while sending), let the running loop send the next operations instead of recursing
+		if (context->isSending)
+		{
+			context->sendRequested = true;
+			return;
+		}
+		context->isSending = true;
+	}
+
+	auto indexes = std::vector<size_t>{};
+	while (true)
 	{
-		auto const& configStaticTree = entity->getConfigurationStaticTree(configurationIndex);
+		// Get all operations we can send right now
+		{
+			// Lock to protect context->scheduler
+			std::lock_guard<decltype(context->lock)> const lg(context->lock);
+
+			auto const now = OperationsBatchScheduler::Clock::now();
+			while (auto const index = context->scheduler.popNextOperation(now))
+			{
+				indexes.push_back(*index);
+			}
+		}
 
-		entity->setSelectedLocaleBaseIndex(configurationIndex, localeNode->baseStringDescriptorIndex);
-		for (auto index = entity::model::StringsIndex(0); index < localeNode->numberOfStringDescriptors; ++index)
+		// Send them outside the lock (the result handler might be called synchronously)
+		for (auto const index : indexes)
 		{
-			// Check if we already have the Strings descriptor
-			auto const stringsIndex = static_cast<decltype(index)>(localeNode->baseStringDescriptorIndex + index);
-			auto const stringsStaticModelIt = configStaticTree.stringsStaticModels.find(stringsIndex);
-			if (stringsStaticModelIt != configStaticTree.stringsStaticModels.end())
+			auto const& operation = context->operations[index];
+
+			auto const onResult = [this, context, index](entity::ControllerEntity::ControlStatus const status)
+			{
+				auto isComplete = false;
+				{
+					// Lock to protect context->scheduler and context->results
+					std::lock_guard<decltype(context->lock)> const lg(context->lock);
+					auto const duration = context->scheduler.completeOperation(index, OperationsBatchScheduler::Clock::now());
+					context->results[index] = StreamConnectionOperationResult{ status, duration };
+					isComplete = context->scheduler.isComplete();
+				}
+
+				if (isComplete)
+				{
+					invokeProtectedHandler(context->handler, context->results, context->scheduler.getElapsedTime(OperationsBatchScheduler::Clock::now()));
+				}
+				else
+				{
+					sendNextStreamConnectionsBatchOperations(context);
+				}
+			};
+
+			if (operation.action == StreamConnectionOperation::Action::Connect)
 			{
-				// Already in cache, no need to query (just have to copy strings to Configuration for quick access)
-				auto const& stringsStaticModel = stringsStaticModelIt->second;
-				entity->setLocalizedStrings(configurationIndex, stringsIndex, stringsStaticModel.strings);
+				connectStream(operation.talkerStream, operation.listenerStream,
+					[onResult](ControlledEntity const* const /*talkerEntity*/, ControlledEntity const* const /*listenerEntity*/, entity::model::StreamIndex const /*talkerStreamIndex*/, entity::model::StreamIndex const /*listenerStreamIndex*/, entity::ControllerEntity::ControlStatus const status)
+					{
+						onResult(status);
+					});
 			}
 			else
 			{
-				queryInformation(entity, configurationIndex, entity::model::DescriptorType::Strings, stringsIndex);
+				disconnectStream(operation.talkerStream, operation.listenerStream,
+					[onResult](ControlledEntity const* const /*listenerEntity*/, entity::model::StreamIndex const /*listenerStreamIndex*/, entity::ControllerEntity::ControlStatus const status)
+					{
+						onResult(status);
+					});
+			}
+		}
+		indexes.clear();
+
+		// Loop as long as operations completed while sending
+		{
+			// Lock to protect context->isSending and context->sendRequested
+			std::lock_guard<decltype(context->lock)> const lg(context->lock);
+			if (!context->sendRequested)
+			{
+				context->isSending = false;
+				return;
 			}
+			context->sendRequested = false;
 		}
 	}
 }
 
+void ControllerImpl::sendNextAemOperations(std::shared_ptr<AemOperationsBatchContext> const& context) const noexcept
+{
+	using Step = AemOperationsBatchContext::Step;
+
+	{
+		// Lock to protect context->isSending and context->sendRequested
+		std::lock_guard<decltype(context->lock)> const lg(context->lock);
+
+		// Already sending (step result reported synchronously, or from another thread while sending), let the running loop send the next steps instead of recursing
+		if (context->isSending)
+		{
+			context->sendRequested = true;
+			return;
+		}
+		context->isSending = true;
+	}
+
+	auto stepIndexes = std::vector<std::pair<size_t, std::optional<entity::ControllerEntity::AemCommandStatus>>>{}; // Step index, and its status if it must not be sent
+	while (true)
+	{
+		// Get all steps we can send right now
+		{
+			// Lock to protect context->scheduler, context->failedPreSteps and context->skippedPostSteps
+			std::lock_guard<decltype(context->lock)> const lg(context->lock);
+
+			auto const now = OperationsBatchScheduler::Clock::now();
+			while (auto const stepIndex = context->scheduler.popNextOperation(now))
+			{
+				auto const& step = context->steps[*stepIndex];
+				auto skippedStatus = std::optional<entity::ControllerEntity::AemCommandStatus>{};
+				if (step.kind == Step::Kind::Operation)
+				{
+					if (auto const failedIt = context->failedPreSteps.find(step.entityID); failedIt != context->failedPreSteps.end())
+					{
+						skippedStatus = failedIt->second;
+					}
+				}
+				else if (step.kind == Step::Kind::PostStep)
+				{
+					if (context->skippedPostSteps.count(step.entityID) != 0)
+					{
+						skippedStatus = entity::ControllerEntity::AemCommandStatus::Success;
+					}
+				}
+				stepIndexes.emplace_back(*stepIndex, skippedStatus);
+			}
+		}
+
+		// Send them outside the lock (the result handler might be called synchronously)
+		for (auto const& [stepIndex, skippedStatus] : stepIndexes)
+		{
+			auto const& step = context->steps[stepIndex];
+
+			auto const onResult = [this, context, stepIndex = stepIndex](entity::ControllerEntity::AemCommandStatus const status)
+			{
+				onAemOperationsStepResult(context, stepIndex, status);
+			};
+			auto const onAemResult = [onResult](ControlledEntity const* const /*entity*/, entity::ControllerEntity::AemCommandStatus const status)
+			{
+				onResult(status);
+			};
+
+			if (skippedStatus)
+			{
+				onResult(*skippedStatus);
+				continue;
+			}
+
+			switch (step.kind)
+			{
+				case Step::Kind::PreStep:
+				{
+					if (context->preStep == AemOperationsPreStep::Acquire)
+					{
+						auto const controlledEntity = getControlledEntityImpl(step.entityID);
+						// Already acquired by us, don't release it once done
+						if (controlledEntity && controlledEntity->isAcquired())
+						{
+							{
+								// Lock to protect context->skippedPostSteps
+								std::lock_guard<decltype(context->lock)> const lg(context->lock);
+								context->skippedPostSteps.insert(step.entityID);
+							}
+							onResult(entity::ControllerEntity::AemCommandStatus::Success);
+						}
+						// acquireEntity does nothing while an acquire is in progress
+						else if (controlledEntity && controlledEntity->isAcquiring())
+						{
+							onResult(entity::ControllerEntity::AemCommandStatus::InProgress);
+						}
+						else
+						{
+							acquireEntity(step.entityID, false,
+								[onResult](ControlledEntity const* const /*entity*/, entity::ControllerEntity::AemCommandStatus const status, UniqueIdentifier const /*owningEntity*/)
+								{
+									onResult(status);
+								});
+						}
+					}
+					else
+					{
+						_controller->lockEntity(step.entityID,
+							[onResult](entity::ControllerEntity const* const /*controller*/, UniqueIdentifier const /*entityID*/, entity::ControllerEntity::AemCommandStatus const status, UniqueIdentifier const /*owningEntity*/)
+							{
+								onResult(status);
+							});
+					}
+					break;
+				}
+				case Step::Kind::PostStep:
+				{
+					if (context->preStep == AemOperationsPreStep::Acquire)
+					{
+						releaseEntity(step.entityID,
+							[onResult](ControlledEntity const* const /*entity*/, entity::ControllerEntity::AemCommandStatus const status, UniqueIdentifier const /*owningEntity*/)
+							{
+								onResult(status);
+							});
+					}
+					else
+					{
+						_controller->unlockEntity(step.entityID,
+							[onResult](entity::ControllerEntity const* const /*controller*/, UniqueIdentifier const /*entityID*/, entity::ControllerEntity::AemCommandStatus const status)
+							{
+								onResult(status);
+							});
+					}
+					break;
+				}
+				case Step::Kind::Operation:
+				{
+					auto const& operation = context->operations[step.operationIndex];
+					switch (operation.type)
+					{
+						case AemOperation::Type::SetConfiguration:
+							setConfiguration(operation.targetEntityID, operation.configurationIndex, onAemResult);
+							break;
+						case AemOperation::Type::SetStreamInputFormat:
+							setStreamInputFormat(operation.targetEntityID, operation.descriptorIndex, operation.streamFormat, onAemResult);
+							break;
+						case AemOperation::Type::SetStreamOutputFormat:
+							setStreamOutputFormat(operation.targetEntityID, operation.descriptorIndex, operation.streamFormat, onAemResult);
+							break;
+						case AemOperation::Type::SetEntityName:
+							setEntityName(operation.targetEntityID, operation.name, onAemResult);
+							break;
+						case AemOperation::Type::SetEntityGroupName:
+							setEntityGroupName(operation.targetEntityID, operation.name, onAemResult);
+							break;
+						case AemOperation::Type::SetConfigurationName:
+							setConfigurationName(operation.targetEntityID, operation.configurationIndex, operation.name, onAemResult);
+							break;
+						case AemOperation::Type::SetAudioUnitName:
+							setAudioUnitName(operation.targetEntityID, operation.configurationIndex, operation.descriptorIndex, operation.name, onAemResult);
+							break;
+						case AemOperation::Type::SetStreamInputName:
+							setStreamInputName(operation.targetEntityID, operation.configurationIndex, operation.descriptorIndex, operation.name, onAemResult);
+							break;
+						case AemOperation::Type::SetStreamOutputName:
+							setStreamOutputName(operation.targetEntityID, operation.configurationIndex, operation.descriptorIndex, operation.name, onAemResult);
+							break;
+						case AemOperation::Type::SetAvbInterfaceName:
+							setAvbInterfaceName(operation.targetEntityID, operation.configurationIndex, operation.descriptorIndex, operation.name, onAemResult);
+							break;
+						case AemOperation::Type::SetClockSourceName:
+							setClockSourceName(operation.targetEntityID, operation.configurationIndex, operation.descriptorIndex, operation.name, onAemResult);
+							break;
+						case AemOperation::Type::SetMemoryObjectName:
+							setMemoryObjectName(operation.targetEntityID, operation.configurationIndex, operation.descriptorIndex, operation.name, onAemResult);
+							break;
+						case AemOperation::Type::SetAudioClusterName:
+							setAudioClusterName(operation.targetEntityID, operation.configurationIndex, operation.descriptorIndex, operation.name, onAemResult);
+							break;
+						case AemOperation::Type::SetClockDomainName:
+							setClockDomainName(operation.targetEntityID, operation.configurationIndex, operation.descriptorIndex, operation.name, onAemResult);
+							break;
+						case AemOperation::Type::SetAudioUnitSamplingRate:
+							setAudioUnitSamplingRate(operation.targetEntityID, operation.descriptorIndex, operation.samplingRate, onAemResult);
+							break;
+						case AemOperation::Type::SetClockSource:
+							setClockSource(operation.targetEntityID, operation.descriptorIndex, operation.clockSourceIndex, onAemResult);
+							break;
+						default:
+							AVDECC_ASSERT(false, "Unhandled AemOperation::Type");
+							onResult(entity::ControllerEntity::AemCommandStatus::InternalError);
+							break;
+					}
+					break;
+				}
+				default:
+					AVDECC_ASSERT(false, "Unhandled Step::Kind");
+					break;
+			}
+		}
+		stepIndexes.clear();
+
+		// Loop as long as steps completed while sending
+		{
+			// Lock to protect context->isSending and context->sendRequested
+			std::lock_guard<decltype(context->lock)> const lg(context->lock);
+			if (!context->sendRequested)
+			{
+				context->isSending = false;
+				return;
+			}
+			context->sendRequested = false;
+		}
+	}
+}
+
+void ControllerImpl::onAemOperationsStepResult(std::shared_ptr<AemOperationsBatchContext> const& context, size_t const stepIndex, entity::ControllerEntity::AemCommandStatus const status) const noexcept
+{
+	using Step = AemOperationsBatchContext::Step;
+
+	auto isComplete = false;
+	auto isOperation = false;
+	auto completedOperations = size_t{ 0u };
+	auto statistics = AemOperationsStatistics{};
+	{
+		// Lock to protect all context fields
+		std::lock_guard<decltype(context->lock)> const lg(context->lock);
+
+		auto const now = OperationsBatchScheduler::Clock::now();
+		auto const duration = context->scheduler.completeOperation(stepIndex, now);
+		auto const& step = context->steps[stepIndex];
+
+		switch (step.kind)
+		{
+			case Step::Kind::PreStep:
+				if (!status)
+				{
+					LOG_CONTROLLER_DEBUG(step.entityID, "executeAemOperations pre-step failed, operations on this entity are not sent: {}", entity::ControllerEntity::statusToString(status));
+					context->failedPreSteps.emplace(step.entityID, status);
+					context->skippedPostSteps.insert(step.entityID);
+				}
+				break;
+			case Step::Kind::Operation:
+			{
+				auto const wasSent = context->failedPreSteps.count(step.entityID) == 0;
+				context->results[step.operationIndex] = AemOperationResult{ status, wasSent ? duration : std::chrono::milliseconds{ 0 } };
+				isOperation = true;
+				completedOperations = ++context->completedOperations;
+				break;
+			}
+			case Step::Kind::PostStep:
+				if (!status)
+				{
+					LOG_CONTROLLER_WARN(step.entityID, "executeAemOperations post-step failed: {}", entity::ControllerEntity::statusToString(status));
+				}
+				break;
+			default:
+				break;
+		}
+
+		isComplete = context->scheduler.isComplete();
+		if (isComplete)
+		{
+			// Aggregate results, durations only account for operations that were actually sent
+			auto sentOperations = size_t{ 0u };
+			auto totalDuration = std::chrono::milliseconds{ 0 };
+			for (auto index = size_t{ 0u }; index < context->operations.size(); ++index)
+			{
+				auto const& result = context->results[index];
+				if (!!result.status)
+				{
+					++statistics.succeededOperations;
+				}
+				else
+				{
+					++statistics.failedOperations;
+				}
+
+				if (context->failedPreSteps.count(context->operations[index].targetEntityID) == 0)
+				{
+					statistics.minDuration = sentOperations == 0u ? result.duration : std::min(statistics.minDuration, result.duration);
+					statistics.maxDuration = std::max(statistics.maxDuration, result.duration);
+					totalDuration += result.duration;
+					++sentOperations;
+				}
+			}
+			if (sentOperations != 0u)
+			{
+				statistics.averageDuration = totalDuration / sentOperations;
+			}
+			statistics.elapsed = context->scheduler.getElapsedTime(now);
+		}
+	}
+
+	if (isOperation)
+	{
+		invokeProtectedHandler(context->progressHandler, completedOperations, context->operations.size());
+	}
+
+	if (isComplete)
+	{
+		invokeProtectedHandler(context->handler, context->results, statistics);
+	}
+	else
+	{
+		sendNextAemOperations(context);
+	}
+}
+
+void ControllerImpl::chooseLocale(ControlledEntityImpl* const entity, entity::model::ConfigurationIndex const configurationIndex) noexcept
+{
+	// Read-only access to the static model, which might be shared
+	auto const& configStaticTree = std::as_const(*entity).getConfigurationStaticTree(configurationIndex);
+	if (configStaticTree.localeStaticModels.empty())
+		return;
+
+	// Prefered locale (or same language), then english, then the first locale of the entity
+	auto const* localeNode = entity->findLocaleNode(configurationIndex, _preferedLocale);
+	if (localeNode == nullptr)
+	{
+		localeNode = entity->findLocaleNode(configurationIndex, "en");
+	}
+	if (localeNode == nullptr)
+	{
+		localeNode = &configStaticTree.localeStaticModels.begin()->second;
+	}
+
+	auto const deferQueries = _localizedStringsLoading != LocalizedStringsLoading::Enumeration;
+
+	entity->setSelectedLocaleBaseIndex(configurationIndex, localeNode->baseStringDescriptorIndex);
+	for (auto index = entity::model::StringsIndex(0); index < localeNode->numberOfStringDescriptors; ++index)
+	{
+		// Check if we already have the Strings descriptor
+		auto const stringsIndex = static_cast<decltype(index)>(localeNode->baseStringDescriptorIndex + index);
+		auto const stringsStaticModelIt = configStaticTree.stringsStaticModels.find(stringsIndex);
+		if (stringsStaticModelIt != configStaticTree.stringsStaticModels.end())
+		{
+			// Already in cache, no need to query (just have to copy strings to Configuration for quick access)
+			auto const& stringsStaticModel = stringsStaticModelIt->second;
+			entity->setLocalizedStrings(configurationIndex, stringsIndex, stringsStaticModel.strings);
+		}
+		else if (deferQueries)
+		{
+			// Don't delay the entity being declared online, query it later
+			entity->deferStringsDescriptorQuery(configurationIndex, stringsIndex);
+		}
+		else
+		{
+			queryInformation(entity, configurationIndex, entity::model::DescriptorType::Strings, stringsIndex);
+		}
+	}
+}
+
+void ControllerImpl::queryDeferredStrings(ControlledEntityImpl* const entity) noexcept
+{
+	auto const queries = entity->takeDeferredStringsDescriptorQueries();
+	if (queries.empty())
+		return;
+
+	LOG_CONTROLLER_TRACE(entity->getEntity().getEntityID(), "Querying {} deferred STRINGS descriptors", queries.size());
+
+	// Not required for the entity to be usable, don't delay user commands nor the enumeration of other entities
+	auto const priorityGuard = entity::ControllerEntity::CommandPriorityGuard{ CommandPriority::Background };
+	for (auto const& [configurationIndex, stringsIndex] : queries)
+	{
+		queryInformation(entity, configurationIndex, entity::model::DescriptorType::Strings, stringsIndex);
+	}
+}
+
 void ControllerImpl::queryInformation(ControlledEntityImpl* const entity, entity::model::ConfigurationIndex const configurationIndex, entity::model::DescriptorType const descriptorType, entity::model::DescriptorIndex const descriptorIndex, std::chrono::milliseconds const delayQuery) noexcept
 {
 	// Immediately set as expected
 	entity->setDescriptorExpected(configurationIndex, descriptorType, descriptorIndex);
 
 	auto const entityID = entity->getEntity().getEntityID();
+	auto const key = InflightQueriesRegistry::Key{ entityID, InflightQueriesRegistry::QueryKind::Descriptor, static_cast<std::uint16_t>(descriptorType), configurationIndex, descriptorIndex, 0u };
 	std::function<void(entity::ControllerEntity*)> queryFunc{};
 
 	switch (descriptorType)
 	{
 		case entity::model::DescriptorType::Entity:
-			queryFunc = [this, entityID](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "readEntityDescriptor ()");
-				controller->readEntityDescriptor(entityID, std::bind(&ControllerImpl::onEntityDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4));
+				controller->readEntityDescriptor(entityID, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onEntityDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4)));
 			};
 			break;
 		case entity::model::DescriptorType::Configuration:
-			queryFunc = [this, entityID, configurationIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "readConfigurationDescriptor (ConfigurationIndex={})", configurationIndex);
-				controller->readConfigurationDescriptor(entityID, configurationIndex, std::bind(&ControllerImpl::onConfigurationDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5));
+				controller->readConfigurationDescriptor(entityID, configurationIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onConfigurationDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5)));
 			};
 			break;
 		case entity::model::DescriptorType::AudioUnit:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "readAudioUnitDescriptor (ConfigurationIndex={} AudioUnitIndex={})", configurationIndex, descriptorIndex);
-				controller->readAudioUnitDescriptor(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onAudioUnitDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->readAudioUnitDescriptor(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onAudioUnitDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case entity::model::DescriptorType::StreamInput:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "readStreamInputDescriptor (ConfigurationIndex={} StreamIndex={})", configurationIndex, descriptorIndex);
-				controller->readStreamInputDescriptor(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onStreamInputDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->readStreamInputDescriptor(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onStreamInputDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case entity::model::DescriptorType::StreamOutput:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "readStreamOutputDescriptor (ConfigurationIndex={} StreamIndex={})", configurationIndex, descriptorIndex);
-				controller->readStreamOutputDescriptor(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onStreamOutputDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->readStreamOutputDescriptor(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onStreamOutputDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case entity::model::DescriptorType::AvbInterface:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "readAvbInterfaceDescriptor (ConfigurationIndex={}, AvbInterfaceIndex={})", configurationIndex, descriptorIndex);
-				controller->readAvbInterfaceDescriptor(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onAvbInterfaceDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->readAvbInterfaceDescriptor(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onAvbInterfaceDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case entity::model::DescriptorType::ClockSource:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "readClockSourceDescriptor (ConfigurationIndex={} ClockSourceIndex={})", configurationIndex, descriptorIndex);
-				controller->readClockSourceDescriptor(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onClockSourceDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->readClockSourceDescriptor(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onClockSourceDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case entity::model::DescriptorType::MemoryObject:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "readMemoryObjectDescriptor (ConfigurationIndex={}, MemoryObjectIndex={})", configurationIndex, descriptorIndex);
-				controller->readMemoryObjectDescriptor(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onMemoryObjectDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->readMemoryObjectDescriptor(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onMemoryObjectDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case entity::model::DescriptorType::Locale:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "readLocaleDescriptor (ConfigurationIndex={} LocaleIndex={})", configurationIndex, descriptorIndex);
-				controller->readLocaleDescriptor(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onLocaleDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->readLocaleDescriptor(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onLocaleDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case entity::model::DescriptorType::Strings:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "readStringsDescriptor (ConfigurationIndex={} StringsIndex={})", configurationIndex, descriptorIndex);
-				controller->readStringsDescriptor(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onStringsDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->readStringsDescriptor(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onStringsDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case entity::model::DescriptorType::StreamPortInput:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "readStreamPortInputDescriptor (ConfigurationIndex={}, StreamPortIndex={})", configurationIndex, descriptorIndex);
-				controller->readStreamPortInputDescriptor(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onStreamPortInputDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->readStreamPortInputDescriptor(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onStreamPortInputDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case entity::model::DescriptorType::StreamPortOutput:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "readStreamPortOutputDescriptor (ConfigurationIndex={} StreamPortIndex={})", configurationIndex, descriptorIndex);
-				controller->readStreamPortOutputDescriptor(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onStreamPortOutputDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->readStreamPortOutputDescriptor(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onStreamPortOutputDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case entity::model::DescriptorType::AudioCluster:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "readAudioClusterDescriptor (ConfigurationIndex={} ClusterIndex={})", configurationIndex, descriptorIndex);
-				controller->readAudioClusterDescriptor(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onAudioClusterDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->readAudioClusterDescriptor(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onAudioClusterDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case entity::model::DescriptorType::AudioMap:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "readAudioMapDescriptor (ConfigurationIndex={} MapIndex={})", configurationIndex, descriptorIndex);
-				controller->readAudioMapDescriptor(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onAudioMapDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->readAudioMapDescriptor(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onAudioMapDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case entity::model::DescriptorType::ClockDomain:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "readClockDomainDescriptor (ConfigurationIndex={}, ClockDomainIndex={})", configurationIndex, descriptorIndex);
-				controller->readClockDomainDescriptor(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onClockDomainDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->readClockDomainDescriptor(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onClockDomainDescriptorResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		default:
@@ -698,18 +1440,7 @@ void ControllerImpl::queryInformation(ControlledEntityImpl* const entity, entity
 			break;
 	}
 
-	// Not delayed, call now
-	if (delayQuery == std::chrono::milliseconds{ 0 })
-	{
-		if (queryFunc)
-		{
-			queryFunc(_controller);
-		}
-	}
-	else
-	{
-		addDelayedQuery(delayQuery, entityID, std::move(queryFunc));
-	}
+	sendQuery(key, delayQuery, std::move(queryFunc));
 }
 
 void ControllerImpl::queryInformation(ControlledEntityImpl* const entity, entity::model::ConfigurationIndex const configurationIndex, ControlledEntityImpl::DynamicInfoType const dynamicInfoType, entity::model::DescriptorIndex const descriptorIndex, std::uint16_t const subIndex, std::chrono::milliseconds const delayQuery) noexcept
@@ -718,69 +1449,70 @@ void ControllerImpl::queryInformation(ControlledEntityImpl* const entity, entity
 	entity->setDynamicInfoExpected(configurationIndex, dynamicInfoType, descriptorIndex, subIndex);
 
 	auto const entityID = entity->getEntity().getEntityID();
+	auto const key = InflightQueriesRegistry::Key{ entityID, InflightQueriesRegistry::QueryKind::DynamicInfo, static_cast<std::uint16_t>(dynamicInfoType), configurationIndex, descriptorIndex, subIndex };
 	std::function<void(entity::ControllerEntity*)> queryFunc{};
 
 	switch (dynamicInfoType)
 	{
 		case ControlledEntityImpl::DynamicInfoType::AcquiredState:
-			queryFunc = [this, entityID](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID](entity::ControllerEntity* const controller) noexcept
 			{
 				// Send an ACQUIRE command with the RELEASE flag to detect the current acquired state of the entity
 				// It won't change the current acquired state except if we were the acquiring controller, which doesn't matter anyway because having to enumerate the device again means we got interrupted in the middle of something and it's best to start over
 				LOG_CONTROLLER_TRACE(entityID, "releaseEntity (ReleaseFlag)");
-				controller->releaseEntity(entityID, entity::model::DescriptorType::Entity, 0u, std::bind(&ControllerImpl::onGetAcquiredStateResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4));
+				controller->releaseEntity(entityID, entity::model::DescriptorType::Entity, 0u, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onGetAcquiredStateResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4)));
 			};
 			break;
 		case ControlledEntityImpl::DynamicInfoType::InputStreamAudioMappings:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex, subIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex, subIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getStreamPortInputAudioMap (StreamPortIndex={})", descriptorIndex);
-				controller->getStreamPortInputAudioMap(entityID, descriptorIndex, subIndex, std::bind(&ControllerImpl::onGetStreamPortInputAudioMapResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, std::placeholders::_7, configurationIndex));
+				controller->getStreamPortInputAudioMap(entityID, descriptorIndex, subIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onGetStreamPortInputAudioMapResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, std::placeholders::_7, configurationIndex)));
 			};
 			break;
 		case ControlledEntityImpl::DynamicInfoType::OutputStreamAudioMappings:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex, subIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex, subIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getStreamPortOutputAudioMap (StreamPortIndex={})", descriptorIndex);
-				controller->getStreamPortOutputAudioMap(entityID, descriptorIndex, subIndex, std::bind(&ControllerImpl::onGetStreamPortOutputAudioMapResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, std::placeholders::_7, configurationIndex));
+				controller->getStreamPortOutputAudioMap(entityID, descriptorIndex, subIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onGetStreamPortOutputAudioMapResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, std::placeholders::_7, configurationIndex)));
 			};
 			break;
 		case ControlledEntityImpl::DynamicInfoType::InputStreamState:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getListenerStreamState (StreamIndex={})", descriptorIndex);
-				controller->getListenerStreamState({ entityID, descriptorIndex }, std::bind(&ControllerImpl::onGetListenerStreamStateResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, configurationIndex));
+				controller->getListenerStreamState({ entityID, descriptorIndex }, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onGetListenerStreamStateResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, configurationIndex)));
 			};
 			break;
 		case ControlledEntityImpl::DynamicInfoType::OutputStreamState:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getTalkerStreamState (StreamIndex={})", descriptorIndex);
-				controller->getTalkerStreamState({ entityID, descriptorIndex }, std::bind(&ControllerImpl::onGetTalkerStreamStateResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, configurationIndex));
+				controller->getTalkerStreamState({ entityID, descriptorIndex }, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onGetTalkerStreamStateResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, configurationIndex)));
 			};
 			break;
 		case ControlledEntityImpl::DynamicInfoType::OutputStreamConnection:
 			AVDECC_ASSERT(false, "Another overload of this method should be called for this DynamicInfoType");
 			break;
 		case ControlledEntityImpl::DynamicInfoType::InputStreamInfo:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getStreamInputInfo (StreamIndex={})", descriptorIndex);
-				controller->getStreamInputInfo(entityID, descriptorIndex, std::bind(&ControllerImpl::onGetStreamInputInfoResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, configurationIndex));
+				controller->getStreamInputInfo(entityID, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onGetStreamInputInfoResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, configurationIndex)));
 			};
 			break;
 		case ControlledEntityImpl::DynamicInfoType::OutputStreamInfo:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getStreamOutputInfo (StreamIndex={})", descriptorIndex);
-				controller->getStreamOutputInfo(entityID, descriptorIndex, std::bind(&ControllerImpl::onGetStreamOutputInfoResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, configurationIndex));
+				controller->getStreamOutputInfo(entityID, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onGetStreamOutputInfoResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, configurationIndex)));
 			};
 			break;
 		case ControlledEntityImpl::DynamicInfoType::GetAvbInfo:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getAvbInfo (AvbInterfaceIndex={})", descriptorIndex);
-				controller->getAvbInfo(entityID, descriptorIndex, std::bind(&ControllerImpl::onGetAvbInfoResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, configurationIndex));
+				controller->getAvbInfo(entityID, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onGetAvbInfoResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, configurationIndex)));
 			};
 			break;
 		case ControlledEntityImpl::DynamicInfoType::GetAsPath:
@@ -790,24 +1522,24 @@ void ControllerImpl::queryInformation(ControlledEntityImpl* const entity, entity
 			assert(false && "Todo");
 			break;
 		case ControlledEntityImpl::DynamicInfoType::GetAvbInterfaceCounters:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getAvbInterfaceCounters (AvbInterfaceIndex={})", descriptorIndex);
-				controller->getAvbInterfaceCounters(entityID, descriptorIndex, std::bind(&ControllerImpl::onGetAvbInterfaceCountersResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, configurationIndex));
+				controller->getAvbInterfaceCounters(entityID, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onGetAvbInterfaceCountersResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, configurationIndex)));
 			};
 			break;
 		case ControlledEntityImpl::DynamicInfoType::GetClockDomainCounters:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getClockDomainCounters (ClockDomainIndex={})", descriptorIndex);
-				controller->getClockDomainCounters(entityID, descriptorIndex, std::bind(&ControllerImpl::onGetClockDomainCountersResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, configurationIndex));
+				controller->getClockDomainCounters(entityID, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onGetClockDomainCountersResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, configurationIndex)));
 			};
 			break;
 		case ControlledEntityImpl::DynamicInfoType::GetStreamInputCounters:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getStreamInputCounters (StreamIndex={})", descriptorIndex);
-				controller->getStreamInputCounters(entityID, descriptorIndex, std::bind(&ControllerImpl::onGetStreamInputCountersResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, configurationIndex));
+				controller->getStreamInputCounters(entityID, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onGetStreamInputCountersResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, configurationIndex)));
 			};
 			break;
 		default:
@@ -815,18 +1547,7 @@ void ControllerImpl::queryInformation(ControlledEntityImpl* const entity, entity
 			break;
 	}
 
-	// Not delayed, call now
-	if (delayQuery == std::chrono::milliseconds{ 0 })
-	{
-		if (queryFunc)
-		{
-			queryFunc(_controller);
-		}
-	}
-	else
-	{
-		addDelayedQuery(delayQuery, entityID, std::move(queryFunc));
-	}
+	sendQuery(key, delayQuery, std::move(queryFunc));
 }
 
 void ControllerImpl::queryInformation(ControlledEntityImpl* const entity, entity::model::ConfigurationIndex const configurationIndex, ControlledEntityImpl::DynamicInfoType const dynamicInfoType, entity::model::StreamIdentification const& talkerStream, std::uint16_t const subIndex, std::chrono::milliseconds const delayQuery) noexcept
@@ -840,26 +1561,16 @@ void ControllerImpl::queryInformation(ControlledEntityImpl* const entity, entity
 	entity->setDynamicInfoExpected(configurationIndex, dynamicInfoType, talkerStream.streamIndex, subIndex);
 
 	auto const entityID = entity->getEntity().getEntityID();
+	auto const key = InflightQueriesRegistry::Key{ entityID, InflightQueriesRegistry::QueryKind::DynamicInfo, static_cast<std::uint16_t>(dynamicInfoType), configurationIndex, talkerStream.streamIndex, subIndex };
 	std::function<void(entity::ControllerEntity*)> queryFunc{};
 
-	queryFunc = [this, configurationIndex, talkerStream, subIndex](entity::ControllerEntity* const controller) noexcept
+	queryFunc = [this, key, configurationIndex, talkerStream, subIndex](entity::ControllerEntity* const controller) noexcept
 	{
 		LOG_CONTROLLER_TRACE(UniqueIdentifier::getNullUniqueIdentifier(), "getTalkerStreamConnection (TalkerID={} TalkerIndex={} SubIndex={})", toHexString(talkerStream.entityID, true), talkerStream.streamIndex, subIndex);
-		controller->getTalkerStreamConnection(talkerStream, subIndex, std::bind(&ControllerImpl::onGetTalkerStreamConnectionResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, configurationIndex, subIndex));
+		controller->getTalkerStreamConnection(talkerStream, subIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onGetTalkerStreamConnectionResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, configurationIndex, subIndex)));
 	};
 
-	// Not delayed, call now
-	if (delayQuery == std::chrono::milliseconds{ 0 })
-	{
-		if (queryFunc)
-		{
-			queryFunc(_controller);
-		}
-	}
-	else
-	{
-		addDelayedQuery(delayQuery, entityID, std::move(queryFunc));
-	}
+	sendQuery(key, delayQuery, std::move(queryFunc));
 }
 
 void ControllerImpl::queryInformation(ControlledEntityImpl* const entity, entity::model::ConfigurationIndex const configurationIndex, ControlledEntityImpl::DescriptorDynamicInfoType const descriptorDynamicInfoType, entity::model::DescriptorIndex const descriptorIndex, std::chrono::milliseconds const delayQuery) noexcept
@@ -868,106 +1579,107 @@ void ControllerImpl::queryInformation(ControlledEntityImpl* const entity, entity
 	entity->setDescriptorDynamicInfoExpected(configurationIndex, descriptorDynamicInfoType, descriptorIndex);
 
 	auto const entityID = entity->getEntity().getEntityID();
+	auto const key = InflightQueriesRegistry::Key{ entityID, InflightQueriesRegistry::QueryKind::DescriptorDynamicInfo, static_cast<std::uint16_t>(descriptorDynamicInfoType), configurationIndex, descriptorIndex, 0u };
 	std::function<void(entity::ControllerEntity*)> queryFunc{};
 
 	switch (descriptorDynamicInfoType)
 	{
 		case ControlledEntityImpl::DescriptorDynamicInfoType::ConfigurationName:
-			queryFunc = [this, entityID, configurationIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getConfigurationName (ConfigurationIndex={})", configurationIndex);
-				controller->getConfigurationName(entityID, configurationIndex, std::bind(&ControllerImpl::onConfigurationNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5));
+				controller->getConfigurationName(entityID, configurationIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onConfigurationNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5)));
 			};
 			break;
 		case ControlledEntityImpl::DescriptorDynamicInfoType::AudioUnitName:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getAudioUnitName (ConfigurationIndex={} AudioUnitIndex={})", configurationIndex, descriptorIndex);
-				controller->getAudioUnitName(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onAudioUnitNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->getAudioUnitName(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onAudioUnitNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case ControlledEntityImpl::DescriptorDynamicInfoType::AudioUnitSamplingRate:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getAudioUnitSamplingRate (ConfigurationIndex={} AudioUnitIndex={})", configurationIndex, descriptorIndex);
-				controller->getAudioUnitSamplingRate(entityID, descriptorIndex, std::bind(&ControllerImpl::onAudioUnitSamplingRateResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, configurationIndex));
+				controller->getAudioUnitSamplingRate(entityID, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onAudioUnitSamplingRateResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, configurationIndex)));
 			};
 			break;
 		case ControlledEntityImpl::DescriptorDynamicInfoType::InputStreamName:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getStreamInputName (ConfigurationIndex={} StreamIndex={})", configurationIndex, descriptorIndex);
-				controller->getStreamInputName(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onInputStreamNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->getStreamInputName(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onInputStreamNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case ControlledEntityImpl::DescriptorDynamicInfoType::InputStreamFormat:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getStreamInputFormat (ConfigurationIndex={} StreamIndex={})", configurationIndex, descriptorIndex);
-				controller->getStreamInputFormat(entityID, descriptorIndex, std::bind(&ControllerImpl::onInputStreamFormatResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, configurationIndex));
+				controller->getStreamInputFormat(entityID, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onInputStreamFormatResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, configurationIndex)));
 			};
 			break;
 		case ControlledEntityImpl::DescriptorDynamicInfoType::OutputStreamName:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getStreamOutputName (ConfigurationIndex={} StreamIndex={})", configurationIndex, descriptorIndex);
-				controller->getStreamOutputName(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onOutputStreamNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->getStreamOutputName(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onOutputStreamNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case ControlledEntityImpl::DescriptorDynamicInfoType::OutputStreamFormat:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getStreamOutputFormat (ConfigurationIndex={} StreamIndex={})", configurationIndex, descriptorIndex);
-				controller->getStreamOutputFormat(entityID, descriptorIndex, std::bind(&ControllerImpl::onOutputStreamFormatResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, configurationIndex));
+				controller->getStreamOutputFormat(entityID, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onOutputStreamFormatResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, configurationIndex)));
 			};
 			break;
 		case ControlledEntityImpl::DescriptorDynamicInfoType::AvbInterfaceName:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getAvbInterfaceName (ConfigurationIndex={} AvbInterfaceIndex={})", configurationIndex, descriptorIndex);
-				controller->getAvbInterfaceName(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onAvbInterfaceNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->getAvbInterfaceName(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onAvbInterfaceNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case ControlledEntityImpl::DescriptorDynamicInfoType::ClockSourceName:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getClockSourceName (ConfigurationIndex={} ClockSourceIndex={})", configurationIndex, descriptorIndex);
-				controller->getClockSourceName(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onClockSourceNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->getClockSourceName(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onClockSourceNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case ControlledEntityImpl::DescriptorDynamicInfoType::MemoryObjectName:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getMemoryObjectName (ConfigurationIndex={} MemoryObjectIndex={})", configurationIndex, descriptorIndex);
-				controller->getMemoryObjectName(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onMemoryObjectNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->getMemoryObjectName(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onMemoryObjectNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case ControlledEntityImpl::DescriptorDynamicInfoType::MemoryObjectLength:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getMemoryObjectLength (ConfigurationIndex={} MemoryObjectIndex={})", configurationIndex, descriptorIndex);
-				controller->getMemoryObjectLength(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onMemoryObjectLengthResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->getMemoryObjectLength(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onMemoryObjectLengthResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case ControlledEntityImpl::DescriptorDynamicInfoType::AudioClusterName:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getAudioClusterName (ConfigurationIndex={} AudioClusterIndex={})", configurationIndex, descriptorIndex);
-				controller->getAudioClusterName(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onAudioClusterNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->getAudioClusterName(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onAudioClusterNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case ControlledEntityImpl::DescriptorDynamicInfoType::ClockDomainName:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getClockDomainName (ConfigurationIndex={} ClockDomainIndex={})", configurationIndex, descriptorIndex);
-				controller->getClockDomainName(entityID, configurationIndex, descriptorIndex, std::bind(&ControllerImpl::onClockDomainNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6));
+				controller->getClockDomainName(entityID, configurationIndex, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onClockDomainNameResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6)));
 			};
 			break;
 		case ControlledEntityImpl::DescriptorDynamicInfoType::ClockDomainSourceIndex:
-			queryFunc = [this, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
+			queryFunc = [this, key, entityID, configurationIndex, descriptorIndex](entity::ControllerEntity* const controller) noexcept
 			{
 				LOG_CONTROLLER_TRACE(entityID, "getClockSource (ConfigurationIndex={} ClockDomainIndex={})", configurationIndex, descriptorIndex);
-				controller->getClockSource(entityID, descriptorIndex, std::bind(&ControllerImpl::onClockDomainSourceIndexResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, configurationIndex));
+				controller->getClockSource(entityID, descriptorIndex, makeInflightQueryHandler(key, std::bind(&ControllerImpl::onClockDomainSourceIndexResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, configurationIndex)));
 			};
 			break;
 		default:
@@ -975,18 +1687,7 @@ void ControllerImpl::queryInformation(ControlledEntityImpl* const entity, entity
 			break;
 	}
 
-	// Not delayed, call now
-	if (delayQuery == std::chrono::milliseconds{ 0 })
-	{
-		if (queryFunc)
-		{
-			queryFunc(_controller);
-		}
-	}
-	else
-	{
-		addDelayedQuery(delayQuery, entityID, std::move(queryFunc));
-	}
+	sendQuery(key, delayQuery, std::move(queryFunc));
 }
 
 void ControllerImpl::getMilanVersion(ControlledEntityImpl* const entity) noexcept
@@ -1005,6 +1706,7 @@ void ControllerImpl::registerUnsol(ControlledEntityImpl* const entity) noexcept
 
 	// Register for unsolicited notifications
 	LOG_CONTROLLER_TRACE(entityID, "registerUnsolicitedNotifications ()");
+	auto const priorityGuard = entity::ControllerEntity::CommandPriorityGuard{ CommandPriority::Enumeration };
 	_controller->registerUnsolicitedNotifications(entityID, std::bind(&ControllerImpl::onRegisterUnsolicitedNotificationsResult, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
 }
 
@@ -1014,6 +1716,85 @@ void ControllerImpl::getStaticModel(ControlledEntityImpl* const entity) noexcept
 	queryInformation(entity, 0, entity::model::DescriptorType::Entity, 0);
 }
 
+void ControllerImpl::queryEntityModelCacheVerification(ControlledEntityImpl* const entity, entity::model::ConfigurationIndex const configurationIndex, model::EntityStaticTree const& cachedStaticTree) noexcept
+{
+	// Only read the CONFIGURATION descriptor, the remaining of the static model is not queried while verifying the cache
+	queryInformation(entity, configurationIndex, entity::model::DescriptorType::Configuration, 0u);
+
+	auto const configIt = cachedStaticTree.configurationStaticTrees.find(configurationIndex);
+	if (configIt == cachedStaticTree.configurationStaticTrees.end())
+		return;
+	auto const& cachedConfigStaticTree = configIt->second;
+
+	// Read a few STREAM descriptors, spread over all streams
+	auto const queryStreams = [this, entity, configurationIndex, sampleCount = static_cast<size_t>(_entityModelCacheVerificationStreamsCount)](entity::model::DescriptorType const descriptorType, size_t const streamsCount)
+	{
+		auto const count = std::min(sampleCount, streamsCount);
+		for (auto sample = size_t{ 0u }; sample < count; ++sample)
+		{
+			queryInformation(entity, configurationIndex, descriptorType, static_cast<entity::model::StreamIndex>(sample * streamsCount / count));
+		}
+	};
+	queryStreams(entity::model::DescriptorType::StreamInput, cachedConfigStaticTree.streamInputStaticModels.size());
+	queryStreams(entity::model::DescriptorType::StreamOutput, cachedConfigStaticTree.streamOutputStaticModels.size());
+}
+
+void ControllerImpl::verifyCachedEntityStaticTree(ControlledEntityImpl* const entity) noexcept
+{
+	auto const cachedStaticTree = entity->takeEntityStaticTreeToVerify();
+
+	// Descriptors read from the entity match the cache, use it and proceed with EnumerationSteps::GetDescriptorDynamicInfo
+	if (entity->isMatchingCachedEntityStaticTree(*cachedStaticTree, entity->getCurrentConfigurationIndex()))
+	{
+		entity->useCachedEntityStaticTree(cachedStaticTree);
+		entity->setEntityModelCacheResult(ControlledEntityImpl::EntityModelCacheResult::VerifiedHit);
+		entity->addEnumerationSteps(ControlledEntityImpl::EnumerationSteps::GetDescriptorDynamicInfo);
+	}
+	// Fallback to full StaticModel enumeration
+	else
+	{
+		entity->setIgnoreCachedEntityModel();
+		entity->setEntityModelCacheResult(ControlledEntityImpl::EntityModelCacheResult::VerificationFailure);
+		entity->addEnumerationSteps(ControlledEntityImpl::EnumerationSteps::GetStaticModel);
+		LOG_CONTROLLER_WARN(entity->getEntity().getEntityID(), "Cached EntityModel does not match the descriptors read from the entity, falling back to full StaticModel enumeration");
+	}
+}
+
+void ControllerImpl::updateEntityModelCacheStatistics(ControlledEntityImpl const* const entity) noexcept
+{
+	auto const result = entity->getEntityModelCacheResult();
+	if (result == ControlledEntityImpl::EntityModelCacheResult::NotUsed)
+		return;
+
+	auto const duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - entity->getEnumerationStartTime());
+
+	// Lock to protect _entityModelCacheStatistics
+	std::lock_guard<decltype(_entityModelCacheStatisticsLock)> const lg(_entityModelCacheStatisticsLock);
+
+	auto& stats = _entityModelCacheStatistics;
+	switch (result)
+	{
+		case ControlledEntityImpl::EntityModelCacheResult::Miss:
+			++stats.misses;
+			stats.missesDuration += duration;
+			break;
+		case ControlledEntityImpl::EntityModelCacheResult::Hit:
+			++stats.hits;
+			stats.hitsDuration += duration;
+			break;
+		case ControlledEntityImpl::EntityModelCacheResult::VerifiedHit:
+			++stats.verifiedHits;
+			stats.verifiedHitsDuration += duration;
+			break;
+		case ControlledEntityImpl::EntityModelCacheResult::VerificationFailure:
+			++stats.verificationFailures;
+			stats.verificationFailuresDuration += duration;
+			break;
+		default:
+			break;
+	}
+}
+
 void ControllerImpl::getDynamicInfo(ControlledEntityImpl* const entity) noexcept
 {
 	auto const caps = entity->getEntity().getEntityCapabilities();
@@ -1021,7 +1802,8 @@ void ControllerImpl::getDynamicInfo(ControlledEntityImpl* const entity) noexcept
 	if (hasFlag(caps, entity::EntityCapabilities::AemSupported))
 	{
 		auto const configurationIndex = entity->getCurrentConfigurationIndex();
-		auto const& configStaticTree = entity->getConfigurationStaticTree(configurationIndex);
+		// Read-only access to the static model, which might be shared
+		auto const& configStaticTree = std::as_const(*entity).getConfigurationStaticTree(configurationIndex);
 
 		// Get AcquiredState
 		{
@@ -1085,7 +1867,7 @@ void ControllerImpl::getDynamicInfo(ControlledEntityImpl* const entity) noexcept
 			auto const count = configStaticTree.streamPortInputStaticModels.size();
 			for (auto index = entity::model::StreamPortIndex(0); index < count; ++index)
 			{
-				auto const& staticModel = entity->getNodeStaticModel(configurationIndex, index, &model::ConfigurationStaticTree::streamPortInputStaticModels);
+				auto const& staticModel = std::as_const(*entity).getNodeStaticModel(configurationIndex, index, &model::ConfigurationStaticTree::streamPortInputStaticModels);
 				if (staticModel.numberOfMaps == 0)
 				{
 					// TODO: Clause 7.4.44.3 recommands to Lock or Acquire the entity before getting the dynamic audio map
@@ -1099,7 +1881,7 @@ void ControllerImpl::getDynamicInfo(ControlledEntityImpl* const entity) noexcept
 			auto const count = configStaticTree.streamPortOutputStaticModels.size();
 			for (auto index = entity::model::StreamPortIndex(0); index < count; ++index)
 			{
-				auto const& staticModel = entity->getNodeStaticModel(configurationIndex, index, &model::ConfigurationStaticTree::streamPortOutputStaticModels);
+				auto const& staticModel = std::as_const(*entity).getNodeStaticModel(configurationIndex, index, &model::ConfigurationStaticTree::streamPortOutputStaticModels);
 				if (staticModel.numberOfMaps == 0)
 				{
 					// TODO: Clause 7.4.44.3 recommands to Lock or Acquire the entity before getting the dynamic audio map
@@ -1124,13 +1906,14 @@ void ControllerImpl::getDescriptorDynamicInfo(ControlledEntityImpl* const entity
 	// Check if AEM is supported by this entity
 	if (hasFlag(caps, entity::EntityCapabilities::AemSupported))
 	{
-		auto const& entityStaticTree = entity->getEntityStaticTree();
+		// Read-only access to the static model, which might be shared
+		auto const& entityStaticTree = std::as_const(*entity).getEntityStaticTree();
 		auto const currentConfigurationIndex = entity->getCurrentConfigurationIndex();
 
 		// Get DynamicModel for each Configuration descriptors
 		for (auto configurationIndex = entity::model::ConfigurationIndex(0u); configurationIndex < entityStaticTree.configurationStaticTrees.size(); ++configurationIndex)
 		{
-			auto const& configStaticTree = entity->getConfigurationStaticTree(configurationIndex);
+			auto const& configStaticTree = std::as_const(*entity).getConfigurationStaticTree(configurationIndex);
 			auto& configDynamicModel = entity->getConfigurationNodeDynamicModel(configurationIndex);
 
 			// We can set the currentConfiguration value right now, we know it
@@ -1259,6 +2042,12 @@ void ControllerImpl::checkEnumerationSteps(ControlledEntityImpl* const entity) n
 		getStaticModel(entity);
 		return;
 	}
+	if (entity->isVerifyingEntityStaticTree())
+	{
+		verifyCachedEntityStaticTree(entity);
+		checkEnumerationSteps(entity);
+		return;
+	}
 	if (hasFlag(steps, ControlledEntityImpl::EnumerationSteps::GetDescriptorDynamicInfo))
 	{
 		getDescriptorDynamicInfo(entity);
@@ -1275,12 +2064,49 @@ void ControllerImpl::checkEnumerationSteps(ControlledEntityImpl* const entity) n
 	{
 		if (!entity->gotFatalEnumerationError())
 		{
-			// Store EntityModel in the cache for later use
-			EntityModelCache::getInstance().cacheEntityStaticTree(entity->getEntity().getEntityID(), entity->getCurrentConfigurationIndex(), entity->getEntityStaticTree());
+			// Use the same localized strings than the other entities of this model
+			entity->shareLocalizedStrings();
+
+			// Build the model graph now, on this thread, rather than in the first observer or user thread to access it
+			entity->buildEntityModelGraph();
+
+			// Store EntityModel in the cache for later use, once the graph has created all the referenced models (the tree is then shared with the entities of this model)
+			auto& entityModelCache = EntityModelCache::getInstance();
+			if (entityModelCache.isCacheEnabled())
+			{
+				entityModelCache.cacheEntityStaticTree(entity->getEntity().getEntityModelID(), entity->getCurrentConfigurationIndex(), entity->shareEntityStaticTree());
+			}
+
+			// Time spent to enumerate the entity, depending on the EntityModel cache
+			updateEntityModelCacheStatistics(entity);
 
 			// Advertise the entity
 			entity->setAdvertised(true);
 			notifyObserversMethod<Controller::Observer>(&Controller::Observer::onEntityOnline, this, entity);
+
+			// Start polling its counters
+			addCountersPollingEntity(*entity);
+
+			// Load the strings not queried during enumeration
+			if (_localizedStringsLoading == LocalizedStringsLoading::Background)
+			{
+				queryDeferredStrings(entity);
+			}
+		}
+	}
+	// Entity restored from a network snapshot, now revalidated
+	else if (entity->isStale() && !entity->gotFatalEnumerationError())
+	{
+		entity->setStale(false);
+		notifyObserversMethod<Controller::Observer>(&Controller::Observer::onEntityRevalidated, this, entity);
+
+		// Start polling its counters
+		addCountersPollingEntity(*entity);
+
+		// Load the strings not queried during enumeration
+		if (_localizedStringsLoading == LocalizedStringsLoading::Background)
+		{
+			queryDeferredStrings(entity);
 		}
 	}
 }
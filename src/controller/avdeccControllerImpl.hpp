@@ -26,14 +26,25 @@
 
 #include "la/avdecc/controller/avdeccController.hpp"
 #include "la/avdecc/memoryBuffer.hpp"
+#include "la/avdecc/internals/clock.hpp"
 #include "avdeccControlledEntityImpl.hpp"
+#include "avdeccControlledEntityRegistry.hpp"
+#include "avdeccCountersPollingScheduler.hpp"
+#include "avdeccInflightQueriesRegistry.hpp"
+#include "avdeccOperationsBatchScheduler.hpp"
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <functional>
 #include <mutex>
 #include <chrono>
-#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
 
 namespace la
 {
@@ -44,10 +55,16 @@ namespace controller
 class ControllerImpl final : public Controller, private entity::ControllerEntity::Delegate
 {
 public:
-	ControllerImpl(protocol::ProtocolInterface::Type const protocolInterfaceType, std::string const& interfaceName, std::uint16_t const progID, UniqueIdentifier const entityModelID, std::string const& preferedLocale);
+	ControllerImpl(protocol::ProtocolInterface::Type const protocolInterfaceType, std::string const& interfaceName, std::uint16_t const progID, UniqueIdentifier const entityModelID, std::string const& preferedLocale, Clock const& clock = Clock::getDefaultClock());
+
+	/** Creates a controller whose delayed queries, automatic discovery, counters polling and notifications batching are based on the specified clock (which must outlive the controller). For a manual Clock, no timing thread is run and checkTimers has to be called after advancing the clock. */
+	static UniquePointer create(protocol::ProtocolInterface::Type const protocolInterfaceType, std::string const& interfaceName, std::uint16_t const progID, UniqueIdentifier const entityModelID, std::string const& preferedLocale, Clock const& clock);
+
+	/** Sends the delayed queries and counters polling queries due at the current time of the clock, delivers the batched notifications whose window elapsed and runs the automatic discovery if due. Only required for a manual Clock. */
+	void checkTimers() noexcept;
 
 private:
-	using OnlineControlledEntity = std::shared_ptr<ControlledEntityImpl>;
+	using OnlineControlledEntity = ControlledEntityRegistry::OnlineControlledEntity;
 
 	virtual ~ControllerImpl() override;
 
@@ -63,6 +80,30 @@ private:
 	virtual void disableEntityAdvertising() noexcept override;
 	virtual void enableEntityModelCache() noexcept override;
 	virtual void disableEntityModelCache() noexcept override;
+	virtual void enableEntityModelCacheVerification(std::uint16_t const streamDescriptorsCount) noexcept override;
+	virtual void disableEntityModelCacheVerification() noexcept override;
+	virtual EntityModelCacheStatistics getEntityModelCacheStatistics() const noexcept override;
+	virtual void enableNotificationsBatching(std::chrono::milliseconds const window) noexcept override;
+	virtual void disableNotificationsBatching() noexcept override;
+	virtual NotificationsStatistics getNotificationsStatistics() const noexcept override;
+	virtual void enableCountersPolling(std::uint32_t const maxQueriesPerSecond) noexcept override;
+	virtual void disableCountersPolling() noexcept override;
+	virtual void setCountersPollingInterval(CountersKind const kind, std::chrono::milliseconds const interval) noexcept override;
+	virtual void setCountersPollingInterval(UniqueIdentifier const entityID, CountersKind const kind, std::chrono::milliseconds const interval) noexcept override;
+	virtual void clearCountersPollingIntervals(UniqueIdentifier const entityID) noexcept override;
+	virtual void setCountersPollingWatchedEntity(UniqueIdentifier const entityID, bool const isWatched) noexcept override;
+	virtual CountersPollingStatistics getCountersPollingStatistics() const noexcept override;
+	virtual void setLocalizedStringsLoading(LocalizedStringsLoading const loading) noexcept override;
+
+	/* Enumeration queries overrides */
+	virtual QueriesStatistics getQueriesStatistics() const noexcept override;
+	virtual AecpCommandsStatistics getAecpCommandsStatistics() const noexcept override;
+	virtual MemoryFootprint getMemoryFootprint() const noexcept override;
+	virtual void loadLocalizedStrings(UniqueIdentifier const entityID) noexcept override;
+
+	/* Network snapshot */
+	virtual NetworkSnapshotError saveNetworkSnapshot(std::string const& filePath) const noexcept override;
+	virtual NetworkSnapshotError loadNetworkSnapshot(std::string const& filePath) noexcept override;
 
 	/* Enumeration and Control Protocol (AECP) AEM */
 	virtual void acquireEntity(UniqueIdentifier const targetEntityID, bool const isPersistent, AcquireEntityHandler const& handler) const noexcept override;
@@ -98,6 +139,7 @@ private:
 	virtual void startUploadMemoryObjectOperation(UniqueIdentifier const targetEntityID, entity::model::DescriptorIndex const descriptorIndex, std::uint64_t const dataLength, StartMemoryObjectOperationHandler const& handler) const noexcept override;
 	virtual void abortOperation(UniqueIdentifier const targetEntityID, entity::model::DescriptorType const descriptorType, entity::model::DescriptorIndex const descriptorIndex, entity::model::OperationID const operationID, AbortOperationHandler const& handler) const noexcept override;
 	virtual void setMemoryObjectLength(UniqueIdentifier const targetEntityID, entity::model::ConfigurationIndex const configurationIndex, entity::model::MemoryObjectIndex const memoryObjectIndex, std::uint64_t const length, SetMemoryObjectLengthHandler const& handler) const noexcept override;
+	virtual void executeAemOperations(AemOperations const& operations, AemOperationsPreStep const preStep, std::uint32_t const maxInflightOperations, AemOperationsProgressHandler const& progressHandler, AemOperationsHandler const& handler) const noexcept override;
 
 	/* Enumeration and Control Protocol (AECP) AA */
 	virtual void readDeviceMemory(UniqueIdentifier const targetEntityID, std::uint64_t const address, std::uint64_t const length, ReadDeviceMemoryProgressHandler const& progressHandler, ReadDeviceMemoryCompletionHandler const& completionHandler) const noexcept override;
@@ -108,6 +150,7 @@ private:
 	virtual void disconnectStream(entity::model::StreamIdentification const& talkerStream, entity::model::StreamIdentification const& listenerStream, DisconnectStreamHandler const& handler) const noexcept override;
 	virtual void disconnectTalkerStream(entity::model::StreamIdentification const& talkerStream, entity::model::StreamIdentification const& listenerStream, DisconnectTalkerStreamHandler const& handler) const noexcept override;
 	virtual void getListenerStreamState(entity::model::StreamIdentification const& listenerStream, GetListenerStreamStateHandler const& handler) const noexcept override;
+	virtual void batchStreamConnections(StreamConnectionOperations const& operations, std::uint32_t const maxInflightOperations, BatchStreamConnectionsHandler const& handler) const noexcept override;
 
 	virtual ControlledEntityGuard getControlledEntity(UniqueIdentifier const entityID) const noexcept override;
 
@@ -144,6 +187,9 @@ private:
 	void onGetAvbInterfaceCountersResult(entity::ControllerEntity const* const controller, UniqueIdentifier const entityID, entity::ControllerEntity::AemCommandStatus const status, entity::model::AvbInterfaceIndex const avbInterfaceIndex, entity::AvbInterfaceCounterValidFlags const validCounters, entity::model::DescriptorCounters const& counters, entity::model::ConfigurationIndex const configurationIndex) noexcept;
 	void onGetClockDomainCountersResult(entity::ControllerEntity const* const controller, UniqueIdentifier const entityID, entity::ControllerEntity::AemCommandStatus const status, entity::model::ClockDomainIndex const clockDomainIndex, entity::ClockDomainCounterValidFlags const validCounters, entity::model::DescriptorCounters const& counters, entity::model::ConfigurationIndex const configurationIndex) noexcept;
 	void onGetStreamInputCountersResult(entity::ControllerEntity const* const controller, UniqueIdentifier const entityID, entity::ControllerEntity::AemCommandStatus const status, entity::model::StreamIndex const streamIndex, entity::StreamInputCounterValidFlags const validCounters, entity::model::DescriptorCounters const& counters, entity::model::ConfigurationIndex const configurationIndex) noexcept;
+	void onPolledAvbInterfaceCountersResult(entity::ControllerEntity const* const controller, UniqueIdentifier const entityID, entity::ControllerEntity::AemCommandStatus const status, entity::model::AvbInterfaceIndex const avbInterfaceIndex, entity::AvbInterfaceCounterValidFlags const validCounters, entity::model::DescriptorCounters const& counters) noexcept;
+	void onPolledClockDomainCountersResult(entity::ControllerEntity const* const controller, UniqueIdentifier const entityID, entity::ControllerEntity::AemCommandStatus const status, entity::model::ClockDomainIndex const clockDomainIndex, entity::ClockDomainCounterValidFlags const validCounters, entity::model::DescriptorCounters const& counters) noexcept;
+	void onPolledStreamInputCountersResult(entity::ControllerEntity const* const controller, UniqueIdentifier const entityID, entity::ControllerEntity::AemCommandStatus const status, entity::model::StreamIndex const streamIndex, entity::StreamInputCounterValidFlags const validCounters, entity::model::DescriptorCounters const& counters) noexcept;
 	void onConfigurationNameResult(entity::ControllerEntity const* const controller, UniqueIdentifier const entityID, entity::ControllerEntity::AemCommandStatus const status, entity::model::ConfigurationIndex const configurationIndex, entity::model::AvdeccFixedString const& configurationName) noexcept;
 	void onAudioUnitNameResult(entity::ControllerEntity const* const controller, UniqueIdentifier const entityID, entity::ControllerEntity::AemCommandStatus const status, entity::model::ConfigurationIndex const configurationIndex, entity::model::AudioUnitIndex const audioUnitIndex, entity::model::AvdeccFixedString const& audioUnitName) noexcept;
 	void onAudioUnitSamplingRateResult(entity::ControllerEntity const* const controller, UniqueIdentifier const entityID, entity::ControllerEntity::AemCommandStatus const status, entity::model::AudioUnitIndex const audioUnitIndex, entity::model::SamplingRate const samplingRate, entity::model::ConfigurationIndex const configurationIndex) noexcept;
@@ -341,18 +387,141 @@ private:
 	using DelayedQueryHandler = std::function<void(entity::ControllerEntity*)>;
 	struct DelayedQuery
 	{
-		std::chrono::time_point<std::chrono::system_clock> sendTime{};
 		UniqueIdentifier entityID{ UniqueIdentifier::getUninitializedUniqueIdentifier() };
 		DelayedQueryHandler queryHandler{};
 	};
-	using DelayedQueries = std::deque<DelayedQuery>;
+	using DelayedQueryKey = std::pair<Clock::time_point, std::uint64_t>; // Send time, then insertion order for queries with the same send time
+	using DelayedQueries = std::map<DelayedQueryKey, DelayedQuery>; // Ordered by send time
+	using DelayedQueriesPerEntity = std::unordered_map<UniqueIdentifier, std::set<DelayedQueryKey>, UniqueIdentifier::hash>;
+	struct StreamConnectionsBatchContext
+	{
+		StreamConnectionsBatchContext(StreamConnectionOperations const& operations, std::vector<UniqueIdentifier> const& targetEntities, std::uint32_t const maxInflightOperations, BatchStreamConnectionsHandler const& handler) noexcept
+			: operations(operations)
+			, results(operations.size())
+			, scheduler(targetEntities, maxInflightOperations, OperationsBatchScheduler::Clock::now())
+			, handler(handler)
+		{
+		}
+		std::mutex lock{};
+		StreamConnectionOperations const operations{};
+		StreamConnectionOperationResults results{};
+		OperationsBatchScheduler scheduler;
+		BatchStreamConnectionsHandler handler{};
+		bool isSending{ false }; /**< A sendNextStreamConnectionsBatchOperations loop is running */
+		bool sendRequested{ false }; /**< An operation completed while isSending, the running loop has to check for operations to send again */
+	};
+	struct AemOperationsBatchContext
+	{
+		struct Step
+		{
+			enum class Kind : std::uint8_t
+			{
+				PreStep,
+				Operation,
+				PostStep,
+			};
+			Kind kind{ Kind::Operation };
+			size_t operationIndex{ 0u }; /**< Only valid for Kind::Operation */
+			UniqueIdentifier entityID{};
+		};
+		using Steps = std::vector<Step>;
+
+		AemOperationsBatchContext(AemOperations const& operations, AemOperationsPreStep const preStep, Steps&& steps, std::vector<UniqueIdentifier> const& targetEntities, std::uint32_t const maxInflightOperations, AemOperationsProgressHandler const& progressHandler, AemOperationsHandler const& handler) noexcept
+			: operations(operations)
+			, preStep(preStep)
+			, steps(std::move(steps))
+			, results(operations.size())
+			, scheduler(targetEntities, maxInflightOperations, OperationsBatchScheduler::Clock::now())
+			, progressHandler(progressHandler)
+			, handler(handler)
+		{
+		}
+		std::mutex lock{};
+		AemOperations const operations{};
+		AemOperationsPreStep const preStep{ AemOperationsPreStep::None };
+		Steps const steps{}; /**< Per target entity (in order of first appearance): PreStep, Operations, PostStep */
+		AemOperationResults results{};
+		std::unordered_map<UniqueIdentifier, entity::ControllerEntity::AemCommandStatus, UniqueIdentifier::hash> failedPreSteps{}; /**< Entities for which the PreStep failed, its Operations are not sent */
+		std::unordered_set<UniqueIdentifier, UniqueIdentifier::hash> skippedPostSteps{}; /**< Entities for which the PostStep must not be sent (PreStep failed, or the entity was already acquired) */
+		size_t completedOperations{ 0u };
+		OperationsBatchScheduler scheduler;
+		AemOperationsProgressHandler progressHandler{};
+		AemOperationsHandler handler{};
+		bool isSending{ false }; /**< A sendNextAemOperations loop is running */
+		bool sendRequested{ false }; /**< A step completed while isSending, the running loop has to check for steps to send again */
+	};
+	enum class NotificationKind : std::uint8_t
+	{
+		StreamFormat,
+		StreamInfo,
+		StreamRunning, /**< Started and Stopped share the same kind, only the last state is relevant */
+		Name,
+		GroupName,
+		SamplingRate,
+		ClockSource,
+		AvbInfo,
+		Gptp,
+		Counters,
+		MemoryObjectLength,
+		AudioMappings,
+	};
+	struct NotificationKey
+	{
+		UniqueIdentifier entityID{ UniqueIdentifier::getUninitializedUniqueIdentifier() };
+		entity::model::ConfigurationIndex configurationIndex{ 0u };
+		entity::model::DescriptorType descriptorType{ entity::model::DescriptorType::Invalid };
+		entity::model::DescriptorIndex descriptorIndex{ 0u };
+		NotificationKind kind{ NotificationKind::StreamFormat };
+
+		bool operator==(NotificationKey const& other) const noexcept
+		{
+			return entityID == other.entityID && configurationIndex == other.configurationIndex && descriptorType == other.descriptorType && descriptorIndex == other.descriptorIndex && kind == other.kind;
+		}
+
+		struct hash
+		{
+			std::size_t operator()(NotificationKey const& key) const noexcept
+			{
+				auto const descriptor = (static_cast<std::uint64_t>(key.configurationIndex) << 40) | (static_cast<std::uint64_t>(key.descriptorType) << 24) | (static_cast<std::uint64_t>(key.descriptorIndex) << 8) | static_cast<std::uint64_t>(key.kind);
+				return UniqueIdentifier::hash{}(key.entityID) ^ std::hash<std::uint64_t>{}(descriptor);
+			}
+		};
+	};
+	using BatchedNotificationHandler = std::function<void(Controller::Observer* const obs, ControlledEntity const* const entity)>;
+	struct BatchedNotification
+	{
+		NotificationKey key{};
+		BatchedNotificationHandler handler{};
+	};
+	using BatchedNotifications = std::vector<BatchedNotification>; // Ordered by first occurrence of each key
+	using BatchedNotificationsIndexes = std::unordered_map<NotificationKey, size_t, NotificationKey::hash>;
 	using StartOperationHandler = std::function<void(controller::ControlledEntity const* const entity, entity::ControllerEntity::AemCommandStatus const status, entity::model::OperationID const operationID, MemoryBuffer const& memoryBuffer)>;
 
 	/* ************************************************************ */
 	/* Private methods                                              */
 	/* ************************************************************ */
 	void addDelayedQuery(std::chrono::milliseconds const delay, UniqueIdentifier const entityID, DelayedQueryHandler&& queryHandler) noexcept;
+	/** Removes the delayed queries due at currentTime and appends them to queries. Must be called with _lock taken. */
+	void popDueDelayedQueries(Clock::time_point const currentTime, std::vector<DelayedQuery>& queries) noexcept;
+	/** Sends the specified delayed queries (to still online entities). Must be called without _lock taken. */
+	void sendDelayedQueries(std::vector<DelayedQuery> const& queries) noexcept;
+	void removeDelayedQueries(UniqueIdentifier const entityID) noexcept;
+	void sendQuery(InflightQueriesRegistry::Key const& key, std::chrono::milliseconds const delayQuery, DelayedQueryHandler&& queryHandler) noexcept;
+	void completeInflightQuery(InflightQueriesRegistry::Key const& key) noexcept;
+	void removeInflightQueries(UniqueIdentifier const entityID) noexcept;
+	/** Wraps a query result handler so the query is no longer flagged as inflight before the handler is called, and so the handler does not inherit the priority of the query when called synchronously. */
+	template<typename Handler>
+	auto makeInflightQueryHandler(InflightQueriesRegistry::Key const& key, Handler&& handler) noexcept
+	{
+		return [this, key, handler = std::forward<Handler>(handler)](auto&&... params)
+		{
+			auto const priorityGuard = entity::ControllerEntity::CommandPriorityGuard{ CommandPriority::Interactive };
+			completeInflightQuery(key);
+			handler(std::forward<decltype(params)>(params)...);
+		};
+	}
 	void chooseLocale(ControlledEntityImpl* const entity, entity::model::ConfigurationIndex const configurationIndex) noexcept;
+	void queryDeferredStrings(ControlledEntityImpl* const entity) noexcept;
 	void queryInformation(ControlledEntityImpl* const entity, entity::model::ConfigurationIndex const configurationIndex, entity::model::DescriptorType const descriptorType, entity::model::DescriptorIndex const descriptorIndex, std::chrono::milliseconds const delayQuery = std::chrono::milliseconds{ 0 }) noexcept;
 	void queryInformation(ControlledEntityImpl* const entity, entity::model::ConfigurationIndex const configurationIndex, ControlledEntityImpl::DynamicInfoType const dynamicInfoType, entity::model::DescriptorIndex const descriptorIndex, std::uint16_t const subIndex = std::uint16_t{ 0u }, std::chrono::milliseconds const delayQuery = std::chrono::milliseconds{ 0 }) noexcept;
 	void queryInformation(ControlledEntityImpl* const entity, entity::model::ConfigurationIndex const configurationIndex, ControlledEntityImpl::DynamicInfoType const dynamicInfoType, entity::model::StreamIdentification const& talkerStream, std::uint16_t const subIndex, std::chrono::milliseconds const delayQuery = std::chrono::milliseconds{ 0 }) noexcept;
@@ -360,6 +529,9 @@ private:
 	void getMilanVersion(ControlledEntityImpl* const entity) noexcept;
 	void registerUnsol(ControlledEntityImpl* const entity) noexcept;
 	void getStaticModel(ControlledEntityImpl* const entity) noexcept;
+	void queryEntityModelCacheVerification(ControlledEntityImpl* const entity, entity::model::ConfigurationIndex const configurationIndex, model::EntityStaticTree const& cachedStaticTree) noexcept;
+	void verifyCachedEntityStaticTree(ControlledEntityImpl* const entity) noexcept;
+	void updateEntityModelCacheStatistics(ControlledEntityImpl const* const entity) noexcept;
 	void getDynamicInfo(ControlledEntityImpl* const entity) noexcept;
 	void getDescriptorDynamicInfo(ControlledEntityImpl* const entity) noexcept;
 	void checkEnumerationSteps(ControlledEntityImpl* const entity) noexcept;
@@ -382,47 +554,112 @@ private:
 	void onUserWriteDeviceMemoryResult(UniqueIdentifier const targetEntityID, entity::ControllerEntity::AaCommandStatus const status, std::uint64_t const baseAddress, std::uint64_t const sentSize, WriteDeviceMemoryProgressHandler const& progressHandler, WriteDeviceMemoryCompletionHandler const& completionHandler, DeviceMemoryBuffer&& memoryBuffer) const noexcept;
 	void startOperation(UniqueIdentifier const targetEntityID, entity::model::DescriptorType const descriptorType, entity::model::DescriptorIndex const descriptorIndex, entity::model::MemoryObjectOperationType const operationType, MemoryBuffer const& memoryBuffer, StartOperationHandler const& handler) const noexcept;
 	void startMemoryObjectOperation(UniqueIdentifier const targetEntityID, entity::model::DescriptorIndex const descriptorIndex, entity::model::MemoryObjectOperationType const operationType, MemoryBuffer const& memoryBuffer, StartMemoryObjectOperationHandler const& handler) const noexcept;
+	void queueBatchedNotification(NotificationKey const& key, BatchedNotificationHandler&& handler) const noexcept;
+	void purgeBatchedNotifications(UniqueIdentifier const entityID) noexcept;
+	void dispatchBatchedNotifications() noexcept;
+	void stopNotificationsDispatcher() noexcept;
+	void addCountersPollingEntity(ControlledEntityImpl const& controlledEntity) noexcept;
+	void removeCountersPollingEntity(UniqueIdentifier const entityID) noexcept;
+	void postponeCountersPolling(UniqueIdentifier const entityID, CountersKind const kind, entity::model::DescriptorIndex const descriptorIndex) noexcept;
+	void onPolledCountersNotSupported(UniqueIdentifier const entityID, CountersKind const kind, entity::ControllerEntity::AemCommandStatus const status) noexcept;
+	void sendCountersPollingQuery(CountersPollingScheduler::Query const& query) noexcept;
+	void sendNextStreamConnectionsBatchOperations(std::shared_ptr<StreamConnectionsBatchContext> const& context) const noexcept;
+	void sendNextAemOperations(std::shared_ptr<AemOperationsBatchContext> const& context) const noexcept;
+	void onAemOperationsStepResult(std::shared_ptr<AemOperationsBatchContext> const& context, size_t const stepIndex, entity::ControllerEntity::AemCommandStatus const status) const noexcept;
+	/** Notifies Immediate observers right away, and queues the event for Batched observers if batching is enabled (else notifies them too). */
+	template<typename Method, typename... Parameters>
+	void notifyObserversCoalescable(NotificationKey const& key, ControlledEntityImpl const& controlledEntity, Method const method, Parameters const&... params) const noexcept
+	{
+		// Batching not enabled, notify everyone
+		if (!_notificationsBatchingEnabled)
+		{
+			notifyObserversMethod<Controller::Observer>(method, this, &controlledEntity, params...);
+			return;
+		}
+
+		auto hasBatchedObserver = false;
+		notifyObservers<Controller::Observer>(
+			[&hasBatchedObserver, this, &controlledEntity, method, &params...](Controller::Observer* obs)
+			{
+				if (obs->getNotificationMode() == NotificationMode::Batched)
+					hasBatchedObserver = true;
+				else
+					(obs->*method)(this, &controlledEntity, params...);
+			});
+
+		// Only queue the event once, whatever the number of Batched observers (params are copied, so the last values win when coalesced)
+		if (hasBatchedObserver)
+		{
+			queueBatchedNotification(key,
+				[this, method, params...](Controller::Observer* const obs, ControlledEntity const* const entity)
+				{
+					(obs->*method)(this, entity, params...);
+				});
+		}
+	}
 	constexpr Controller& getSelf() const noexcept
 	{
 		return *const_cast<Controller*>(static_cast<Controller const*>(this));
 	}
 	inline UnlockedControlledEntity getUnlockedControlledEntityImpl(UniqueIdentifier const entityID) const noexcept
 	{
-		// Lock to protect _controlledEntities
-		std::lock_guard<decltype(_lock)> const lg(_lock);
-
-		auto entityIt = _controlledEntities.find(entityID);
-		if (entityIt != _controlledEntities.end())
+		// No need to take _lock, _controlledEntities has its own sharded locking
+		auto controlledEntity = _controlledEntities.find(entityID);
+		if (controlledEntity)
 		{
-			return entityIt->second;
+			return controlledEntity;
 		}
 		return UnlockedControlledEntity{};
 	}
 	inline OnlineControlledEntity getControlledEntityImpl(UniqueIdentifier const entityID) const noexcept
 	{
-		// Lock to protect _controlledEntities
-		std::lock_guard<decltype(_lock)> const lg(_lock);
-
-		auto entityIt = _controlledEntities.find(entityID);
-		if (entityIt != _controlledEntities.end())
-		{
-			return entityIt->second;
-		}
-		return OnlineControlledEntity{};
+		// No need to take _lock, _controlledEntities has its own sharded locking
+		return _controlledEntities.find(entityID);
 	}
 
 	/* ************************************************************ */
 	/* Private members                                              */
 	/* ************************************************************ */
-	mutable std::mutex _lock{}; // A mutex to protect _controlledEntities and _delayedQueries
-	std::unordered_map<UniqueIdentifier, OnlineControlledEntity, UniqueIdentifier::hash> _controlledEntities;
+	Clock const& _clock; // Clock for the delayed queries, the automatic discovery, the counters polling and the notifications batching
+	mutable std::mutex _lock{}; // A mutex to protect _delayedQueries and _delayedQueriesPerEntity
+	ControlledEntityRegistry _controlledEntities{}; // Online entities, has its own internal synchronization
 	EndStation::UniquePointer _endStation{ nullptr, nullptr };
 	entity::ControllerEntity* _controller{ nullptr };
 	std::string _preferedLocale{ "en-US" };
+	std::atomic<LocalizedStringsLoading> _localizedStringsLoading{ LocalizedStringsLoading::Enumeration }; // Read without lock during enumeration
+	// EntityModel cache variables
+	std::atomic_bool _isEntityModelCacheVerificationEnabled{ false }; // Read without lock during enumeration
+	std::atomic<std::uint16_t> _entityModelCacheVerificationStreamsCount{ 0u }; // Read without lock during enumeration
+	mutable std::mutex _entityModelCacheStatisticsLock{}; // A mutex to protect _entityModelCacheStatistics
+	EntityModelCacheStatistics _entityModelCacheStatistics{};
 	// Delayed queries variables
-	bool _shouldTerminate{ false };
+	std::atomic_bool _shouldTerminate{ false }; // Also read without lock while sending queries
+	std::condition_variable _delayedQueriesCondVar{};
+	std::uint64_t _delayedQueriesCounter{ 0u };
 	DelayedQueries _delayedQueries{};
+	DelayedQueriesPerEntity _delayedQueriesPerEntity{}; // Keys of the pending queries of each entity, to cancel them when the entity goes offline
 	std::thread _delayedQueryThread{};
+	// Inflight queries variables
+	mutable std::mutex _inflightQueriesLock{}; // A mutex to protect _inflightQueries
+	InflightQueriesRegistry _inflightQueries{};
+	// Batched notifications variables
+	mutable std::mutex _notificationsLock{}; // A mutex to protect _batchedNotifications, _batchedNotificationsIndexes, _notificationsStatistics and the dispatcher state
+	mutable std::condition_variable _notificationsCondVar{};
+	std::atomic_bool _notificationsBatchingEnabled{ false }; // Read without lock on the notification path
+	bool _shouldTerminateDispatcher{ false };
+	std::chrono::milliseconds _notificationsWindow{ 0 };
+	mutable Clock::time_point _notificationsBatchStartTime{}; // Time the first event of the pending batch was queued
+	mutable BatchedNotifications _batchedNotifications{};
+	mutable BatchedNotificationsIndexes _batchedNotificationsIndexes{};
+	mutable NotificationsStatistics _notificationsStatistics{};
+	std::thread _notificationsDispatcherThread{};
+	// Counters polling variables
+	mutable std::mutex _countersPollingLock{}; // A mutex to protect _countersPollingScheduler and the polling thread state
+	std::condition_variable _countersPollingCondVar{};
+	bool _countersPollingEnabled{ false };
+	bool _shouldTerminateCountersPolling{ false };
+	CountersPollingScheduler _countersPollingScheduler{};
+	std::thread _countersPollingThread{};
 };
 
 } // namespace controller
@@ -57,23 +57,53 @@ void ControllerImpl::onEntityOnline(entity::ControllerEntity const* const contro
 		return;
 	}
 
+	// Entity restored from a network snapshot
+	{
+		auto staleEntity = getControlledEntityImpl(entityID);
+		if (staleEntity && staleEntity->isStale())
+		{
+			auto const& staleE = staleEntity->getEntity();
+			auto const isAemSupported = hasFlag(caps, entity::EntityCapabilities::AemSupported);
+			// Same model and no reboot since the snapshot (AvailableIndex still increasing), only refresh its dynamic information
+			if (staleE.getEntityModelID() == entity.getEntityModelID() && hasFlag(staleE.getEntityCapabilities(), entity::EntityCapabilities::AemSupported) == isAemSupported && entity.getAvailableIndex() > staleE.getAvailableIndex())
+			{
+				LOG_CONTROLLER_TRACE(entityID, "onEntityOnline: Revalidating entity restored from network snapshot");
+				updateEntity(*staleEntity, entity);
+
+				auto steps{ ControlledEntityImpl::EnumerationSteps::None };
+				if (isAemSupported)
+				{
+					steps |= ControlledEntityImpl::EnumerationSteps::RegisterUnsol | ControlledEntityImpl::EnumerationSteps::GetDescriptorDynamicInfo | ControlledEntityImpl::EnumerationSteps::GetDynamicInfo;
+				}
+				staleEntity->addEnumerationSteps(steps);
+				checkEnumerationSteps(staleEntity.get());
+				return;
+			}
+
+			// Entity changed since the snapshot, remove it and enumerate it again
+			LOG_CONTROLLER_TRACE(entityID, "onEntityOnline: Entity restored from network snapshot changed, enumerating it again");
+			onEntityOffline(controller, entityID);
+		}
+	}
+
 	OnlineControlledEntity controlledEntity{};
 
 	// Create and add the entity
 	{
-		// Lock to protect _controlledEntities
-		std::lock_guard<decltype(_lock)> const lg(_lock);
+		auto newEntity = std::make_shared<ControlledEntityImpl>(entity);
 
+		// The registry atomically checks the entity is not already online before adding it
+		if (_controlledEntities.insert(entityID, newEntity))
+		{
+			controlledEntity = std::move(newEntity);
+		}
 #ifdef DEBUG
-		// TODO: This happens if an Entity has 2 interfaces on the same network (and there is a loop in the network). We should handle this case and report a message to the user
-		AVDECC_ASSERT(_controlledEntities.find(entityID) == _controlledEntities.end(), "Entity already online");
-#endif
-
-		auto entityIt = _controlledEntities.find(entityID);
-		if (entityIt == _controlledEntities.end())
+		else
 		{
-			controlledEntity = _controlledEntities.insert(std::make_pair(entityID, std::make_shared<ControlledEntityImpl>(entity))).first->second;
+			// TODO: This happens if an Entity has 2 interfaces on the same network (and there is a loop in the network). We should handle this case and report a message to the user
+			AVDECC_ASSERT(false, "Entity already online");
 		}
+#endif
 	}
 
 	if (controlledEntity)
@@ -126,25 +156,23 @@ void ControllerImpl::onEntityOffline(entity::ControllerEntity const* const /*con
 {
 	LOG_CONTROLLER_TRACE(entityID, "onEntityOffline");
 
-	OnlineControlledEntity controlledEntity{};
-
-	// Cleanup and remove the entity
-	{
-		// Lock to protect _controlledEntities
-		std::lock_guard<decltype(_lock)> const lg(_lock);
-
-		auto entityIt = _controlledEntities.find(entityID);
-		if (entityIt != _controlledEntities.end())
-		{
-			controlledEntity = entityIt->second;
-			_controlledEntities.erase(entityIt);
-		}
-	}
+	// Cleanup and remove the entity (lookups from other threads will no longer find it, but the ones that already did keep a valid reference)
+	auto const controlledEntity = _controlledEntities.erase(entityID);
 
 	if (controlledEntity)
 	{
 		updateAcquiredState(*controlledEntity, UniqueIdentifier{}, entity::model::DescriptorType::Entity, 0u, true);
 
+		// Drop pending batched events for this entity, they must not be delivered after onEntityOffline
+		purgeBatchedNotifications(entityID);
+
+		// Stop polling its counters
+		removeCountersPollingEntity(entityID);
+
+		// Cancel its pending delayed queries, and forget its inflight ones
+		removeDelayedQueries(entityID);
+		removeInflightQueries(entityID);
+
 		// Entity was advertised to the user, notify observers
 		if (controlledEntity->wasAdvertised())
 		{
@@ -550,6 +578,9 @@ void ControllerImpl::onAvbInterfaceCountersChanged(entity::ControllerEntity cons
 		auto* const entity = controlledEntity.get();
 		updateAvbInterfaceCounters(*entity, avbInterfaceIndex, validCounters, counters);
 	}
+
+	// The entity sends unsolicited counters for this descriptor, no need to poll it as often
+	postponeCountersPolling(entityID, CountersKind::AvbInterface, avbInterfaceIndex);
 }
 
 void ControllerImpl::onClockDomainCountersChanged(entity::ControllerEntity const* const /*controller*/, UniqueIdentifier const entityID, entity::model::ClockDomainIndex const clockDomainIndex, entity::ClockDomainCounterValidFlags const validCounters, entity::model::DescriptorCounters const& counters) noexcept
@@ -562,6 +593,9 @@ void ControllerImpl::onClockDomainCountersChanged(entity::ControllerEntity const
 		auto* const entity = controlledEntity.get();
 		updateClockDomainCounters(*entity, clockDomainIndex, validCounters, counters);
 	}
+
+	// The entity sends unsolicited counters for this descriptor, no need to poll it as often
+	postponeCountersPolling(entityID, CountersKind::ClockDomain, clockDomainIndex);
 }
 
 void ControllerImpl::onStreamInputCountersChanged(entity::ControllerEntity const* const /*controller*/, UniqueIdentifier const entityID, entity::model::StreamIndex const streamIndex, entity::StreamInputCounterValidFlags const validCounters, entity::model::DescriptorCounters const& counters) noexcept
@@ -574,6 +608,9 @@ void ControllerImpl::onStreamInputCountersChanged(entity::ControllerEntity const
 		auto* const entity = controlledEntity.get();
 		updateStreamInputCounters(*entity, streamIndex, validCounters, counters);
 	}
+
+	// The entity sends unsolicited counters for this descriptor, no need to poll it as often
+	postponeCountersPolling(entityID, CountersKind::StreamInput, streamIndex);
 }
 
 void ControllerImpl::onMemoryObjectLengthChanged(entity::ControllerEntity const* const /*controller*/, UniqueIdentifier const entityID, entity::model::ConfigurationIndex const configurationIndex, entity::model::MemoryObjectIndex const memoryObjectIndex, std::uint64_t const length) noexcept
@@ -104,15 +104,29 @@ void ControllerImpl::onEntityDescriptorResult(entity::ControllerEntity const* co
 			if (!!status)
 			{
 				// Search in the AEM cache for the AEM of the active configuration (if not ignored)
-				auto const* const cachedStaticTree = controlledEntity->shouldIgnoreCachedEntityModel() ? nullptr : EntityModelCache::getInstance().getCachedEntityStaticTree(entityID, descriptor.currentConfiguration);
+				auto& entityModelCache = EntityModelCache::getInstance();
+				auto const useCache = entityModelCache.isCacheEnabled() && !controlledEntity->shouldIgnoreCachedEntityModel();
+				auto const cachedStaticTree = useCache ? entityModelCache.getCachedEntityStaticTree(controlledEntity->getEntity().getEntityModelID(), descriptor.currentConfiguration) : EntityModelCache::EntityStaticTree{};
 
+				// Already cached, only read a few descriptors to verify it before using it (see verifyCachedEntityStaticTree)
+				if (cachedStaticTree && _isEntityModelCacheVerificationEnabled)
+				{
+					controlledEntity->setEntityDescriptor(descriptor);
+					controlledEntity->setEntityStaticTreeToVerify(cachedStaticTree);
+					queryEntityModelCacheVerification(controlledEntity.get(), descriptor.currentConfiguration, *cachedStaticTree);
+				}
 				// Already cached, no need to get the remaining of EnumerationSteps::GetStaticModel, proceed with EnumerationSteps::GetDescriptorDynamicInfo
-				if (cachedStaticTree && controlledEntity->setCachedEntityStaticTree(*cachedStaticTree, descriptor))
+				else if (cachedStaticTree && controlledEntity->setCachedEntityStaticTree(cachedStaticTree, descriptor))
 				{
+					controlledEntity->setEntityModelCacheResult(ControlledEntityImpl::EntityModelCacheResult::Hit);
 					controlledEntity->addEnumerationSteps(ControlledEntityImpl::EnumerationSteps::GetDescriptorDynamicInfo);
 				}
 				else
 				{
+					if (useCache)
+					{
+						controlledEntity->setEntityModelCacheResult(ControlledEntityImpl::EntityModelCacheResult::Miss);
+					}
 					controlledEntity->setEntityDescriptor(descriptor);
 					for (auto index = entity::model::ConfigurationIndex(0u); index < descriptor.configurationsCount; ++index)
 					{
@@ -156,8 +170,13 @@ void ControllerImpl::onConfigurationDescriptorResult(entity::ControllerEntity co
 			{
 				controlledEntity->setConfigurationDescriptor(descriptor, configurationIndex);
 				auto const isCurrentConfiguration = configurationIndex == controlledEntity->getCurrentConfigurationIndex();
+				// Verifying a cached model, the other descriptors will come from the cache (see queryEntityModelCacheVerification)
+				if (controlledEntity->isVerifyingEntityStaticTree())
+				{
+					// Nothing more to get
+				}
 				// Only get full descriptors for active configuration
-				if (isCurrentConfiguration)
+				else if (isCurrentConfiguration)
 				{
 					// Get Locales as soon as possible
 					{
@@ -277,6 +296,11 @@ void ControllerImpl::onConfigurationDescriptorResult(entity::ControllerEntity co
 					}
 				}
 			}
+			// Verifying a cached model: the entity does not match it, it will be fully enumerated (and the failure processed then)
+			else if (controlledEntity->isVerifyingEntityStaticTree())
+			{
+				controlledEntity->setEntityStaticTreeVerificationReadFailed();
+			}
 			else
 			{
 				if (!processFailureStatus(status, controlledEntity.get(), 0, entity::model::DescriptorType::Configuration, configurationIndex))
@@ -370,6 +394,11 @@ void ControllerImpl::onStreamInputDescriptorResult(entity::ControllerEntity cons
 			{
 				controlledEntity->setStreamInputDescriptor(descriptor, configurationIndex, streamIndex);
 			}
+			// Verifying a cached model: the entity does not match it, it will be fully enumerated (and the failure processed then)
+			else if (controlledEntity->isVerifyingEntityStaticTree())
+			{
+				controlledEntity->setEntityStaticTreeVerificationReadFailed();
+			}
 			else
 			{
 				if (!processFailureStatus(status, controlledEntity.get(), configurationIndex, entity::model::DescriptorType::StreamInput, streamIndex))
@@ -406,6 +435,11 @@ void ControllerImpl::onStreamOutputDescriptorResult(entity::ControllerEntity con
 			{
 				controlledEntity->setStreamOutputDescriptor(descriptor, configurationIndex, streamIndex);
 			}
+			// Verifying a cached model: the entity does not match it, it will be fully enumerated (and the failure processed then)
+			else if (controlledEntity->isVerifyingEntityStaticTree())
+			{
+				controlledEntity->setEntityStaticTreeVerificationReadFailed();
+			}
 			else
 			{
 				if (!processFailureStatus(status, controlledEntity.get(), configurationIndex, entity::model::DescriptorType::StreamOutput, streamIndex))
@@ -593,6 +627,9 @@ void ControllerImpl::onStringsDescriptorResult(entity::ControllerEntity const* c
 
 	if (controlledEntity)
 	{
+		// Strings deferred after the entity has been declared online (see LocalizedStringsLoading)
+		auto const isDeferredQuery = controlledEntity->wasAdvertised() && !controlledEntity->isStale();
+
 		if (controlledEntity->checkAndClearExpectedDescriptor(configurationIndex, entity::model::DescriptorType::Strings, stringsIndex))
 		{
 			if (!!status)
@@ -603,15 +640,32 @@ void ControllerImpl::onStringsDescriptorResult(entity::ControllerEntity const* c
 			{
 				if (!processFailureStatus(status, controlledEntity.get(), configurationIndex, entity::model::DescriptorType::Strings, stringsIndex))
 				{
-					controlledEntity->setGetFatalEnumerationError();
-					notifyObserversMethod<Controller::Observer>(&Controller::Observer::onEntityQueryError, this, controlledEntity.get(), QueryCommandError::StringsDescriptor);
-					return;
+					// The entity is already usable, just keep the strings we got
+					if (isDeferredQuery)
+					{
+						LOG_CONTROLLER_WARN(entityID, "Failed to get deferred STRINGS descriptor {}: {}", stringsIndex, entity::ControllerEntity::statusToString(status));
+					}
+					else
+					{
+						controlledEntity->setGetFatalEnumerationError();
+						notifyObserversMethod<Controller::Observer>(&Controller::Observer::onEntityQueryError, this, controlledEntity.get(), QueryCommandError::StringsDescriptor);
+						return;
+					}
 				}
 			}
 		}
 
+		// Got all deferred strings
+		if (isDeferredQuery)
+		{
+			if (controlledEntity->gotAllExpectedDescriptors())
+			{
+				controlledEntity->shareLocalizedStrings();
+				notifyObserversMethod<Controller::Observer>(&Controller::Observer::onEntityLocalizedStringsLoaded, this, controlledEntity.get());
+			}
+		}
 		// Got all expected descriptors
-		if (controlledEntity->gotAllExpectedDescriptors())
+		else if (controlledEntity->gotAllExpectedDescriptors())
 		{
 			// Clear this enumeration step and check for next one
 			controlledEntity->clearEnumerationSteps(ControlledEntityImpl::EnumerationSteps::GetStaticModel);
@@ -1261,6 +1315,69 @@ void ControllerImpl::onGetStreamInputCountersResult(entity::ControllerEntity con
 	}
 }
 
+void ControllerImpl::onPolledAvbInterfaceCountersResult(entity::ControllerEntity const* const /*controller*/, UniqueIdentifier const entityID, entity::ControllerEntity::AemCommandStatus const status, entity::model::AvbInterfaceIndex const avbInterfaceIndex, entity::AvbInterfaceCounterValidFlags const validCounters, entity::model::DescriptorCounters const& counters) noexcept
+{
+	LOG_CONTROLLER_TRACE(entityID, "onPolledAvbInterfaceCountersResult (AvbInterfaceIndex={}): {}", avbInterfaceIndex, entity::ControllerEntity::statusToString(status));
+
+	if (!status)
+	{
+		onPolledCountersNotSupported(entityID, CountersKind::AvbInterface, status);
+		return;
+	}
+
+	// Take a copy of the ControlledEntity so we don't have to keep the lock
+	auto controlledEntity = getControlledEntityImpl(entityID);
+
+	// Only update an entity already advertised, this result is not part of the enumeration
+	if (controlledEntity && controlledEntity->wasAdvertised())
+	{
+		auto* const entity = controlledEntity.get();
+		updateAvbInterfaceCounters(*entity, avbInterfaceIndex, validCounters, counters);
+	}
+}
+
+void ControllerImpl::onPolledClockDomainCountersResult(entity::ControllerEntity const* const /*controller*/, UniqueIdentifier const entityID, entity::ControllerEntity::AemCommandStatus const status, entity::model::ClockDomainIndex const clockDomainIndex, entity::ClockDomainCounterValidFlags const validCounters, entity::model::DescriptorCounters const& counters) noexcept
+{
+	LOG_CONTROLLER_TRACE(entityID, "onPolledClockDomainCountersResult (ClockDomainIndex={}): {}", clockDomainIndex, entity::ControllerEntity::statusToString(status));
+
+	if (!status)
+	{
+		onPolledCountersNotSupported(entityID, CountersKind::ClockDomain, status);
+		return;
+	}
+
+	// Take a copy of the ControlledEntity so we don't have to keep the lock
+	auto controlledEntity = getControlledEntityImpl(entityID);
+
+	// Only update an entity already advertised, this result is not part of the enumeration
+	if (controlledEntity && controlledEntity->wasAdvertised())
+	{
+		auto* const entity = controlledEntity.get();
+		updateClockDomainCounters(*entity, clockDomainIndex, validCounters, counters);
+	}
+}
+
+void ControllerImpl::onPolledStreamInputCountersResult(entity::ControllerEntity const* const /*controller*/, UniqueIdentifier const entityID, entity::ControllerEntity::AemCommandStatus const status, entity::model::StreamIndex const streamIndex, entity::StreamInputCounterValidFlags const validCounters, entity::model::DescriptorCounters const& counters) noexcept
+{
+	LOG_CONTROLLER_TRACE(entityID, "onPolledStreamInputCountersResult (StreamIndex={}): {}", streamIndex, entity::ControllerEntity::statusToString(status));
+
+	if (!status)
+	{
+		onPolledCountersNotSupported(entityID, CountersKind::StreamInput, status);
+		return;
+	}
+
+	// Take a copy of the ControlledEntity so we don't have to keep the lock
+	auto controlledEntity = getControlledEntityImpl(entityID);
+
+	// Only update an entity already advertised, this result is not part of the enumeration
+	if (controlledEntity && controlledEntity->wasAdvertised())
+	{
+		auto* const entity = controlledEntity.get();
+		updateStreamInputCounters(*entity, streamIndex, validCounters, counters);
+	}
+}
+
 void ControllerImpl::onConfigurationNameResult(entity::ControllerEntity const* const /*controller*/, UniqueIdentifier const entityID, entity::ControllerEntity::AemCommandStatus const status, entity::model::ConfigurationIndex const configurationIndex, entity::model::AvdeccFixedString const& configurationName) noexcept
 {
 	LOG_CONTROLLER_TRACE(entityID, "onConfigurationNameResult (ConfigurationIndex={}): {}", configurationIndex, entity::ControllerEntity::statusToString(status));
@@ -25,8 +25,15 @@
 #include "avdeccControllerImpl.hpp"
 #include "avdeccControllerLogHelper.hpp"
 #include "avdeccEntityModelCache.hpp"
+#include "avdeccNetworkSnapshot.hpp"
 #include "la/avdecc/internals/serialization.hpp"
 #include <cstdlib> // free / malloc
+#include <cstdio> // rename / remove
+#include <fstream>
+#include <iterator>
+#ifdef _WIN32
+#	include <Windows.h> // MoveFileEx
+#endif // _WIN32
 
 namespace la
 {
@@ -34,16 +41,28 @@ namespace avdecc
 {
 namespace controller
 {
+/** Renames sourcePath to targetPath, atomically replacing targetPath if it exists */
+static bool replaceFile(std::string const& sourcePath, std::string const& targetPath) noexcept
+{
+#ifdef _WIN32
+	// rename fails if the target exists on Windows (narrow path, as given to std::ofstream)
+	return ::MoveFileExA(sourcePath.c_str(), targetPath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else // !_WIN32
+	return std::rename(sourcePath.c_str(), targetPath.c_str()) == 0;
+#endif // _WIN32
+}
+
 /* ************************************************************ */
 /* Controller overrides                                         */
 /* ************************************************************ */
-ControllerImpl::ControllerImpl(protocol::ProtocolInterface::Type const protocolInterfaceType, std::string const& interfaceName, std::uint16_t const progID, UniqueIdentifier const entityModelID, std::string const& preferedLocale)
-	: _preferedLocale(preferedLocale)
+ControllerImpl::ControllerImpl(protocol::ProtocolInterface::Type const protocolInterfaceType, std::string const& interfaceName, std::uint16_t const progID, UniqueIdentifier const entityModelID, std::string const& preferedLocale, Clock const& clock)
+	: _clock(clock)
+	, _preferedLocale(preferedLocale)
 {
 	try
 	{
 		_endStation = EndStation::create(protocolInterfaceType, interfaceName);
-		_controller = _endStation->addControllerEntity(progID, entityModelID, this);
+		_controller = _endStation->addControllerEntity(progID, entityModelID, this, _clock);
 	}
 	catch (EndStation::Exception const& e)
 	{
@@ -69,69 +88,119 @@ ControllerImpl::ControllerImpl(protocol::ProtocolInterface::Type const protocolI
 		throw Exception(Error::InternalError, e.what());
 	}
 
+	// A manual clock drives the delayed queries from checkTimers
+	if (_clock.isManual())
+	{
+		return;
+	}
+
 	// Create the delayed query thread
 	_delayedQueryThread = std::thread(
 		[this]
 		{
 			setCurrentThreadName("avdecc::controller::DelayedQueries");
-			decltype(_delayedQueries) queriesToSend{};
+			auto queriesToSend = std::vector<DelayedQuery>{};
+			std::unique_lock<decltype(_lock)> lock(_lock);
 			while (!_shouldTerminate)
 			{
-				// Check all delayed queries if we need to send any of them, and copy them so we can send outside the loop
+				// Wait for the first query to be due (or forever if there is none), a new first query or termination will wake us up
+				if (_delayedQueries.empty())
 				{
-					// Lock to protect _delayedQueries
-					std::lock_guard<decltype(_lock)> const lg(_lock);
-
-					// Get current time
-					std::chrono::time_point<std::chrono::system_clock> currentTime = std::chrono::system_clock::now();
-
-					for (auto it = _delayedQueries.begin(); it != _delayedQueries.end(); /* Iterate inside the loop */)
-					{
-						auto const& query = *it;
-						if (currentTime > query.sendTime)
-						{
-							// Move the query to the "to process" list
-							queriesToSend.emplace_back(std::move(*it));
-
-							// Remove the command from the list
-							it = _delayedQueries.erase(it);
-						}
-						else
-						{
-							++it;
-						}
-					}
+					_delayedQueriesCondVar.wait(lock);
+					continue;
+				}
+				auto const currentTime = _clock.now();
+				if (currentTime < _delayedQueries.begin()->first.first)
+				{
+					_delayedQueriesCondVar.wait_for(lock, _delayedQueries.begin()->first.first - currentTime);
+					continue;
 				}
 
+				// Move all due queries to the "to process" list, so we can send outside the lock
+				popDueDelayedQueries(currentTime, queriesToSend);
+
 				// Now actually send queries, outside the lock
-				while (!queriesToSend.empty() && !_shouldTerminate)
-				{
-					// Get first query from the list
-					auto const& query = queriesToSend.front();
+				lock.unlock();
+				sendDelayedQueries(queriesToSend);
+				queriesToSend.clear();
+				lock.lock();
+			}
+		});
+}
 
-					auto controlledEntity = getControlledEntityImpl(query.entityID);
+Controller::UniquePointer ControllerImpl::create(protocol::ProtocolInterface::Type const protocolInterfaceType, std::string const& interfaceName, std::uint16_t const progID, UniqueIdentifier const entityModelID, std::string const& preferedLocale, Clock const& clock)
+{
+	auto deleter = [](Controller* self)
+	{
+		static_cast<ControllerImpl*>(self)->destroy();
+	};
+	return UniquePointer(new ControllerImpl(protocolInterfaceType, interfaceName, progID, entityModelID, preferedLocale, clock), deleter);
+}
 
-					// Entity still online
-					if (controlledEntity)
-					{
-						// Send the query
-						invokeProtectedHandler(query.queryHandler, _controller);
-					}
+void ControllerImpl::checkTimers() noexcept
+{
+	auto queriesToSend = std::vector<DelayedQuery>{};
+	{
+		// Lock to protect _delayedQueries
+		std::lock_guard<decltype(_lock)> const lg(_lock);
+		popDueDelayedQueries(_clock.now(), queriesToSend);
+	}
+	sendDelayedQueries(queriesToSend);
 
-					// Remove the query from the list
-					queriesToSend.pop_front();
+	// Counters polling
+	{
+		auto pollingQueries = std::vector<CountersPollingScheduler::Query>{};
+		{
+			// Lock to protect _countersPollingScheduler
+			std::lock_guard<decltype(_countersPollingLock)> const lg(_countersPollingLock);
+			if (_countersPollingEnabled)
+			{
+				auto const now = _clock.now();
+				while (auto const query = _countersPollingScheduler.popNextQuery(now))
+				{
+					pollingQueries.push_back(*query);
 				}
-
-				// Wait a little bit so we don't burn the CPU
-				std::this_thread::sleep_for(std::chrono::milliseconds(10));
 			}
-		});
+		}
+		for (auto const& query : pollingQueries)
+		{
+			sendCountersPollingQuery(query);
+		}
+	}
+
+	// Batched notifications
+	{
+		auto isWindowElapsed = false;
+		{
+			// Lock to protect _batchedNotifications
+			std::lock_guard<decltype(_notificationsLock)> const lg(_notificationsLock);
+			isWindowElapsed = !_batchedNotifications.empty() && _clock.now() >= _notificationsBatchStartTime + _notificationsWindow;
+		}
+		if (isWindowElapsed)
+		{
+			dispatchBatchedNotifications();
+		}
+	}
+
+	// Automatic discovery
+	_controller->checkTimers();
 }
 
 ControllerImpl::~ControllerImpl()
 {
+	// Stop the counters polling thread
+	disableCountersPolling();
+
+	// Stop the batched notifications dispatcher (flushing pending events)
+	disableNotificationsBatching();
+
 	// Notify the thread we are shutting down
-	_shouldTerminate = true;
+	{
+		// Lock to protect _delayedQueries
+		std::lock_guard<decltype(_lock)> const lg(_lock);
+		_shouldTerminate = true;
+	}
+	_delayedQueriesCondVar.notify_all();
 
 	// Wait for the thread to complete its pending tasks
 	if (_delayedQueryThread.joinable())
@@ -140,14 +209,8 @@ ControllerImpl::~ControllerImpl()
 	// First, remove ourself from the controller's delegate, we don't want notifications anymore (even if one is coming before the end of the destructor, it's not a big deal, _controlledEntities will be empty)
 	_controller->setDelegate(nullptr);
 
-	decltype(_controlledEntities) controlledEntities;
-
-	// Move all controlled Entities (under lock), we don't want them to be accessible during destructor
-	{
-		// Lock to protect _controlledEntities
-		std::lock_guard<decltype(_lock)> const lg(_lock);
-		controlledEntities = std::move(_controlledEntities);
-	}
+	// Remove all controlled Entities from the registry, we don't want them to be accessible during destructor
+	auto const controlledEntities = _controlledEntities.clear();
 
 	// Notify all entities they are going offline
 	for (auto const& entityKV : controlledEntities)
@@ -210,6 +273,393 @@ void ControllerImpl::disableEntityModelCache() noexcept
 	LOG_CONTROLLER_INFO(_controller->getEntityID(), "AEM Cache disabled");
 }
 
+void ControllerImpl::enableEntityModelCacheVerification(std::uint16_t const streamDescriptorsCount) noexcept
+{
+	_entityModelCacheVerificationStreamsCount = streamDescriptorsCount;
+	_isEntityModelCacheVerificationEnabled = true;
+	LOG_CONTROLLER_INFO(_controller->getEntityID(), "AEM Cache verification enabled ({} stream descriptors)", streamDescriptorsCount);
+}
+
+void ControllerImpl::disableEntityModelCacheVerification() noexcept
+{
+	_isEntityModelCacheVerificationEnabled = false;
+	LOG_CONTROLLER_INFO(_controller->getEntityID(), "AEM Cache verification disabled");
+}
+
+ControllerImpl::EntityModelCacheStatistics ControllerImpl::getEntityModelCacheStatistics() const noexcept
+{
+	// Lock to protect _entityModelCacheStatistics
+	std::lock_guard<decltype(_entityModelCacheStatisticsLock)> const lg(_entityModelCacheStatisticsLock);
+
+	return _entityModelCacheStatistics;
+}
+
+void ControllerImpl::enableNotificationsBatching(std::chrono::milliseconds const window) noexcept
+{
+	AVDECC_ASSERT(window.count() > 0, "Notifications batching window should be greater than 0");
+
+	// Lock to protect the dispatcher state
+	std::lock_guard<decltype(_notificationsLock)> const lg(_notificationsLock);
+
+	_notificationsWindow = std::max(window, std::chrono::milliseconds{ 1 });
+	_notificationsBatchingEnabled = true;
+
+	// Create the dispatcher thread, if not already running (otherwise it will use the new window value upon next wake up). A manual clock drives the dispatching from checkTimers
+	if (!_clock.isManual() && !_notificationsDispatcherThread.joinable())
+	{
+		_notificationsDispatcherThread = std::thread(
+			[this]
+			{
+				setCurrentThreadName("avdecc::controller::NotificationsDispatcher");
+				auto shouldTerminate = false;
+				while (!shouldTerminate)
+				{
+					{
+						std::unique_lock<decltype(_notificationsLock)> lock(_notificationsLock);
+
+						// Sleep until an event is queued (or to be asked to terminate)
+						_notificationsCondVar.wait(lock,
+							[this]
+							{
+								return _shouldTerminateDispatcher || !_batchedNotifications.empty();
+							});
+
+						// Then wait for the batching window to elapse, so following events are batched together (or to be asked to terminate)
+						auto const remaining = _notificationsBatchStartTime + _notificationsWindow - _clock.now();
+						_notificationsCondVar.wait_for(lock, std::max(remaining, Clock::duration::zero()),
+							[this]
+							{
+								return _shouldTerminateDispatcher;
+							});
+						shouldTerminate = _shouldTerminateDispatcher;
+					}
+
+					// Deliver pending events (including when terminating, so nothing is lost)
+					dispatchBatchedNotifications();
+				}
+			});
+	}
+	LOG_CONTROLLER_INFO(_controller->getEntityID(), "Notifications batching enabled ({} msec window)", _notificationsWindow.count());
+}
+
+void ControllerImpl::disableNotificationsBatching() noexcept
+{
+	{
+		// Lock the controller so no notification is being processed while switching the mode (all notifications are generated with the controller locked)
+		std::lock_guard<entity::ControllerEntity> const lg(*_controller);
+		if (!_notificationsBatchingEnabled)
+			return;
+		_notificationsBatchingEnabled = false;
+	}
+
+	// Stop the dispatcher (must not hold the controller lock, the dispatcher needs it to flush pending events)
+	stopNotificationsDispatcher();
+	LOG_CONTROLLER_INFO(_controller->getEntityID(), "Notifications batching disabled");
+}
+
+ControllerImpl::NotificationsStatistics ControllerImpl::getNotificationsStatistics() const noexcept
+{
+	// Lock to protect _notificationsStatistics
+	std::lock_guard<decltype(_notificationsLock)> const lg(_notificationsLock);
+
+	return _notificationsStatistics;
+}
+
+void ControllerImpl::enableCountersPolling(std::uint32_t const maxQueriesPerSecond) noexcept
+{
+	AVDECC_ASSERT(maxQueriesPerSecond > 0, "Counters polling budget should be greater than 0");
+
+	{
+		// Lock to protect _countersPollingScheduler and the polling thread state
+		std::lock_guard<decltype(_countersPollingLock)> const lg(_countersPollingLock);
+
+		_countersPollingScheduler.setMaxQueriesPerSecond(maxQueriesPerSecond);
+		_countersPollingEnabled = true;
+
+		// Create the polling thread, if not already running (otherwise it will use the new budget upon next wake up). A manual clock drives the polling from checkTimers
+		if (!_clock.isManual() && !_countersPollingThread.joinable())
+		{
+			_shouldTerminateCountersPolling = false;
+			_countersPollingThread = std::thread(
+				[this]
+				{
+					setCurrentThreadName("avdecc::controller::CountersPolling");
+					std::unique_lock<decltype(_countersPollingLock)> lock(_countersPollingLock);
+					while (!_shouldTerminateCountersPolling)
+					{
+						// Send the next query if it's due and the budget allows it
+						auto const query = _countersPollingScheduler.popNextQuery(_clock.now());
+						if (query)
+						{
+							// Send outside the lock
+							lock.unlock();
+							sendCountersPollingQuery(*query);
+							lock.lock();
+							continue;
+						}
+
+						// Wait for the next query to be due (or for the schedule to change), but wake up at least every second
+						auto const now = _clock.now();
+						auto const wakeUpTime = std::min(_countersPollingScheduler.getNextWakeUpTime(), now + std::chrono::seconds{ 1 });
+						_countersPollingCondVar.wait_for(lock, wakeUpTime - now);
+					}
+				});
+		}
+	}
+	_countersPollingCondVar.notify_all();
+	LOG_CONTROLLER_INFO(_controller->getEntityID(), "Counters polling enabled ({} queries per second)", maxQueriesPerSecond);
+}
+
+void ControllerImpl::disableCountersPolling() noexcept
+{
+	{
+		// Lock to protect the polling thread state
+		std::lock_guard<decltype(_countersPollingLock)> const lg(_countersPollingLock);
+		if (!_countersPollingEnabled)
+			return;
+		_countersPollingEnabled = false;
+		_shouldTerminateCountersPolling = true;
+	}
+	_countersPollingCondVar.notify_all();
+
+	// Wait for the thread to complete (a query being sent is not cancelled, its result will still update the counters)
+	if (_countersPollingThread.joinable())
+		_countersPollingThread.join();
+	LOG_CONTROLLER_INFO(_controller->getEntityID(), "Counters polling disabled");
+}
+
+void ControllerImpl::setCountersPollingInterval(CountersKind const kind, std::chrono::milliseconds const interval) noexcept
+{
+	{
+		// Lock to protect _countersPollingScheduler
+		std::lock_guard<decltype(_countersPollingLock)> const lg(_countersPollingLock);
+		_countersPollingScheduler.setDefaultInterval(kind, interval, _clock.now());
+	}
+	_countersPollingCondVar.notify_all();
+}
+
+void ControllerImpl::setCountersPollingInterval(UniqueIdentifier const entityID, CountersKind const kind, std::chrono::milliseconds const interval) noexcept
+{
+	{
+		// Lock to protect _countersPollingScheduler
+		std::lock_guard<decltype(_countersPollingLock)> const lg(_countersPollingLock);
+		_countersPollingScheduler.setEntityInterval(entityID, kind, interval, _clock.now());
+	}
+	_countersPollingCondVar.notify_all();
+}
+
+void ControllerImpl::clearCountersPollingIntervals(UniqueIdentifier const entityID) noexcept
+{
+	{
+		// Lock to protect _countersPollingScheduler
+		std::lock_guard<decltype(_countersPollingLock)> const lg(_countersPollingLock);
+		_countersPollingScheduler.clearEntityIntervals(entityID, _clock.now());
+	}
+	_countersPollingCondVar.notify_all();
+}
+
+void ControllerImpl::setCountersPollingWatchedEntity(UniqueIdentifier const entityID, bool const isWatched) noexcept
+{
+	{
+		// Lock to protect _countersPollingScheduler
+		std::lock_guard<decltype(_countersPollingLock)> const lg(_countersPollingLock);
+		_countersPollingScheduler.setEntityWatched(entityID, isWatched);
+	}
+	_countersPollingCondVar.notify_all();
+}
+
+ControllerImpl::CountersPollingStatistics ControllerImpl::getCountersPollingStatistics() const noexcept
+{
+	// Lock to protect _countersPollingScheduler
+	std::lock_guard<decltype(_countersPollingLock)> const lg(_countersPollingLock);
+
+	return _countersPollingScheduler.getStatistics();
+}
+
+void ControllerImpl::setLocalizedStringsLoading(LocalizedStringsLoading const loading) noexcept
+{
+	_localizedStringsLoading = loading;
+}
+
+/* Enumeration queries */
+ControllerImpl::QueriesStatistics ControllerImpl::getQueriesStatistics() const noexcept
+{
+	// Lock to protect _inflightQueries
+	std::lock_guard<decltype(_inflightQueriesLock)> const lg(_inflightQueriesLock);
+
+	return _inflightQueries.getStatistics();
+}
+
+ControllerImpl::AecpCommandsStatistics ControllerImpl::getAecpCommandsStatistics() const noexcept
+{
+	return _controller->getAecpCommandsStatistics();
+}
+
+ControllerImpl::MemoryFootprint ControllerImpl::getMemoryFootprint() const noexcept
+{
+	auto footprint = MemoryFootprint{};
+
+	{
+		// Lock the controller so no entity is modified while computing (all entity changes are made with the controller locked)
+		std::lock_guard<entity::ControllerEntity> const lg(*_controller);
+
+		auto& total = footprint.entitiesTotal;
+		for (auto const& entityKV : _controlledEntities.getAll())
+		{
+			auto const entityFootprint = entityKV.second->getMemoryFootprint();
+			total.entity += entityFootprint.entity;
+			total.staticModel += entityFootprint.staticModel;
+			total.dynamicModel += entityFootprint.dynamicModel;
+			total.counters += entityFootprint.counters;
+			total.audioMappings += entityFootprint.audioMappings;
+			total.localizedStrings += entityFootprint.localizedStrings;
+			total.modelGraph += entityFootprint.modelGraph;
+			total.enumerationState += entityFootprint.enumerationState;
+			footprint.entities.emplace(entityKV.first, entityFootprint);
+		}
+	}
+
+	footprint.entityModelCache = EntityModelCache::getInstance().getMemoryFootprint();
+	footprint.stateMachineQueues = _controller->getStateMachineMemoryFootprint();
+
+	return footprint;
+}
+
+void ControllerImpl::loadLocalizedStrings(UniqueIdentifier const entityID) noexcept
+{
+	// Lock the controller, strings results are processed from the ControllerEntity::Delegate
+	std::lock_guard<entity::ControllerEntity> const lg(*_controller);
+
+	auto controlledEntity = getControlledEntityImpl(entityID);
+	if (controlledEntity && controlledEntity->wasAdvertised())
+	{
+		queryDeferredStrings(controlledEntity.get());
+	}
+}
+
+/* Network snapshot */
+ControllerImpl::NetworkSnapshotError ControllerImpl::saveNetworkSnapshot(std::string const& filePath) const noexcept
+{
+	auto buffer = std::vector<std::uint8_t>{};
+
+	{
+		// Lock the controller so no entity is modified while serializing (all entity changes are made with the controller locked)
+		std::lock_guard<entity::ControllerEntity> const lg(*_controller);
+
+		// Only save fully enumerated entities (the ones advertised to the user)
+		auto const controlledEntities = _controlledEntities.getAll();
+		auto entities = std::vector<ControlledEntityImpl const*>{};
+		entities.reserve(controlledEntities.size());
+		for (auto const& entityKV : controlledEntities)
+		{
+			auto const& controlledEntity = entityKV.second;
+			if (controlledEntity->wasAdvertised() && !controlledEntity->gotFatalEnumerationError())
+			{
+				entities.push_back(controlledEntity.get());
+			}
+		}
+
+		buffer = networkSnapshot::serialize(entities);
+	}
+
+	// Write the file outside the lock, to a temporary file first so an interrupted save never leaves a truncated snapshot
+	auto const tempFilePath = filePath + ".tmp";
+	{
+		auto file = std::ofstream{ tempFilePath, std::ios::binary | std::ios::trunc };
+		if (!file.is_open())
+		{
+			return NetworkSnapshotError::CannotOpenFile;
+		}
+		file.write(reinterpret_cast<char const*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+		file.flush();
+		file.close();
+		if (!file)
+		{
+			std::remove(tempFilePath.c_str());
+			return NetworkSnapshotError::InternalError;
+		}
+	}
+
+	// Then atomically replace the previous snapshot, which is kept intact if it fails
+	if (!replaceFile(tempFilePath, filePath))
+	{
+		std::remove(tempFilePath.c_str());
+		LOG_CONTROLLER_WARN(_controller->getEntityID(), "Failed to replace network snapshot {}", filePath);
+		return NetworkSnapshotError::CannotReplaceFile;
+	}
+
+	LOG_CONTROLLER_INFO(_controller->getEntityID(), "Network snapshot saved to {} ({} bytes)", filePath, buffer.size());
+	return NetworkSnapshotError::NoError;
+}
+
+ControllerImpl::NetworkSnapshotError ControllerImpl::loadNetworkSnapshot(std::string const& filePath) noexcept
+{
+	auto buffer = std::vector<std::uint8_t>{};
+
+	// Read the file
+	{
+		auto file = std::ifstream{ filePath, std::ios::binary };
+		if (!file.is_open())
+		{
+			return NetworkSnapshotError::CannotOpenFile;
+		}
+		buffer.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+	}
+
+	auto [error, entities] = networkSnapshot::deserialize(buffer.data(), buffer.size());
+	if (error != NetworkSnapshotError::NoError)
+	{
+		LOG_CONTROLLER_WARN(_controller->getEntityID(), "Failed to load network snapshot {}: {}", filePath, static_cast<int>(error));
+		return error;
+	}
+
+	{
+		// Lock the controller so entities are declared online the same way they are from the ControllerEntity::Delegate
+		std::lock_guard<entity::ControllerEntity> const lg(*_controller);
+
+		for (auto& controlledEntity : entities)
+		{
+			auto const entityID = controlledEntity->getEntity().getEntityID();
+
+			controlledEntity->setStale(true);
+
+			// Entity already online (discovered before loading the snapshot), keep the live one
+			if (!_controlledEntities.insert(entityID, controlledEntity))
+			{
+				continue;
+			}
+
+			// Advertise the stale entity right away
+			controlledEntity->buildEntityModelGraph();
+			controlledEntity->setAdvertised(true);
+			notifyObserversMethod<Controller::Observer>(&Controller::Observer::onEntityOnline, this, controlledEntity.get());
+
+			// If the entity is not discovered again within its ADP valid time, it's gone
+			auto const validDuration = std::chrono::seconds(std::max(1u, 2u * controlledEntity->getEntity().getValidTime()));
+			addDelayedQuery(validDuration, entityID,
+				[this, entityID](entity::ControllerEntity* const controller)
+				{
+					// Lock the controller, as if the offline notification came from the ControllerEntity::Delegate
+					std::lock_guard<entity::ControllerEntity> const lg(*controller);
+
+					auto controlledEntity = getControlledEntityImpl(entityID);
+					if (controlledEntity && controlledEntity->isStale() && controlledEntity->getEnumerationSteps() == ControlledEntityImpl::EnumerationSteps::None)
+					{
+						LOG_CONTROLLER_DEBUG(entityID, "Entity restored from network snapshot not discovered again, removing it");
+						onEntityOffline(controller, entityID);
+					}
+				});
+		}
+	}
+
+	LOG_CONTROLLER_INFO(_controller->getEntityID(), "Network snapshot loaded from {} ({} entities)", filePath, entities.size());
+
+	// Force a discovery, so stale entities are revalidated as soon as possible
+	_controller->discoverRemoteEntities();
+
+	return NetworkSnapshotError::NoError;
+}
+
 /* Enumeration and Control Protocol (AECP) */
 void ControllerImpl::acquireEntity(UniqueIdentifier const targetEntityID, bool const isPersistent, AcquireEntityHandler const& handler) const noexcept
 {
@@ -1237,6 +1687,60 @@ void ControllerImpl::setMemoryObjectLength(UniqueIdentifier const targetEntityID
 	}
 }
 
+void ControllerImpl::executeAemOperations(AemOperations const& operations, AemOperationsPreStep const preStep, std::uint32_t const maxInflightOperations, AemOperationsProgressHandler const& progressHandler, AemOperationsHandler const& handler) const noexcept
+{
+	LOG_CONTROLLER_TRACE(UniqueIdentifier::getNullUniqueIdentifier(), "User executeAemOperations (Operations={} PreStep={} MaxInflight={})", operations.size(), to_integral(preStep), maxInflightOperations);
+
+	if (operations.empty())
+	{
+		invokeProtectedHandler(handler, AemOperationResults{}, AemOperationsStatistics{});
+		return;
+	}
+
+	// Group operations per target entity (in order of first appearance), surrounded by the pre and post steps
+	auto operationsPerEntity = std::vector<std::pair<UniqueIdentifier, std::vector<size_t>>>{};
+	{
+		auto entityIndexes = std::unordered_map<UniqueIdentifier, size_t, UniqueIdentifier::hash>{};
+		for (auto index = size_t{ 0u }; index < operations.size(); ++index)
+		{
+			auto const entityID = operations[index].targetEntityID;
+			auto const entityIt = entityIndexes.emplace(entityID, operationsPerEntity.size()).first;
+			if (entityIt->second == operationsPerEntity.size())
+			{
+				operationsPerEntity.emplace_back(entityID, std::vector<size_t>{});
+			}
+			operationsPerEntity[entityIt->second].second.push_back(index);
+		}
+	}
+
+	using Step = AemOperationsBatchContext::Step;
+	auto const hasPreStep = preStep != AemOperationsPreStep::None;
+	auto steps = AemOperationsBatchContext::Steps{};
+	auto targetEntities = std::vector<UniqueIdentifier>{};
+	for (auto const& [entityID, operationIndexes] : operationsPerEntity)
+	{
+		if (hasPreStep)
+		{
+			steps.push_back(Step{ Step::Kind::PreStep, 0u, entityID });
+		}
+		for (auto const operationIndex : operationIndexes)
+		{
+			steps.push_back(Step{ Step::Kind::Operation, operationIndex, entityID });
+		}
+		if (hasPreStep)
+		{
+			steps.push_back(Step{ Step::Kind::PostStep, 0u, entityID });
+		}
+	}
+	targetEntities.reserve(steps.size());
+	for (auto const& step : steps)
+	{
+		targetEntities.push_back(step.entityID);
+	}
+
+	sendNextAemOperations(std::make_shared<AemOperationsBatchContext>(operations, preStep, std::move(steps), targetEntities, maxInflightOperations, progressHandler, handler));
+}
+
 entity::addressAccess::Tlv ControllerImpl::makeNextReadDeviceMemoryTlv(std::uint64_t const baseAddress, std::uint64_t const length, std::uint64_t const currentSize) const noexcept
 {
 	try
@@ -1696,6 +2200,27 @@ void ControllerImpl::getListenerStreamState(entity::model::StreamIdentification
 	}
 }
 
+void ControllerImpl::batchStreamConnections(StreamConnectionOperations const& operations, std::uint32_t const maxInflightOperations, BatchStreamConnectionsHandler const& handler) const noexcept
+{
+	LOG_CONTROLLER_TRACE(UniqueIdentifier::getNullUniqueIdentifier(), "User batchStreamConnections (Operations={} MaxInflight={})", operations.size(), maxInflightOperations);
+
+	if (operations.empty())
+	{
+		invokeProtectedHandler(handler, StreamConnectionOperationResults{}, std::chrono::milliseconds{ 0 });
+		return;
+	}
+
+	// Operations targeting a same listener are sent one after the other
+	auto targetEntities = std::vector<UniqueIdentifier>{};
+	targetEntities.reserve(operations.size());
+	for (auto const& operation : operations)
+	{
+		targetEntities.push_back(operation.listenerStream.entityID);
+	}
+
+	sendNextStreamConnectionsBatchOperations(std::make_shared<StreamConnectionsBatchContext>(operations, targetEntities, maxInflightOperations, handler));
+}
+
 ControlledEntityGuard ControllerImpl::getControlledEntity(UniqueIdentifier const entityID) const noexcept
 {
 	auto entity = getControlledEntityImpl(entityID);
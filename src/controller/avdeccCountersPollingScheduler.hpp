@@ -0,0 +1,423 @@
+/*
+* Copyright (C) 2016-2018, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be usefu_state,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file avdeccCountersPollingScheduler.hpp
+* @author Christophe Calmejane
+*/
+
+#pragma once
+
+#include "la/avdecc/controller/avdeccController.hpp"
+#include <unordered_map>
+#include <unordered_set>
+#include <set>
+#include <array>
+#include <chrono>
+#include <optional>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+
+namespace la
+{
+namespace avdecc
+{
+namespace controller
+{
+/**
+* @brief Scheduler of the periodic GET_COUNTERS queries.
+* @details Decides which counters to query, and when. Not thread safe, and does not send anything itself: the owner calls popNextQuery when
+*          getNextWakeUpTime is reached, and sends the returned query.
+*          - Each descriptor is polled at the interval of its kind, which can be overridden per entity (an interval of 0 disables the polling)
+*          - The first poll of each descriptor is randomly spread over its interval, so entities going online together are not polled together
+*          - Queries are paced by a global budget: two queries are never sent less than 1/maxQueriesPerSecond apart, whatever the number of entities
+*          - Counters received from an unsolicited notification postpone the next poll of the descriptor by BackOffFactor intervals
+*          - Due queries of watched entities are sent before due queries of other entities, but at most MaxWatchedQueriesInRow in a row, so other entities are never starved
+*/
+class CountersPollingScheduler final
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	using CountersKind = Controller::CountersKind;
+	using Statistics = Controller::CountersPollingStatistics;
+
+	static constexpr size_t CountersKindsCount = 3;
+	static constexpr auto DefaultInterval = std::chrono::milliseconds{ 10000 };
+	static constexpr auto DefaultMaxQueriesPerSecond = std::uint32_t{ 50u };
+	static constexpr auto BackOffFactor = 4;
+	static constexpr auto MaxWatchedQueriesInRow = std::uint32_t{ 4u }; // Starvation protection: a due query of a not watched entity is sent after at most this number of queries of watched entities
+
+	using DescriptorsCount = std::array<std::uint16_t, CountersKindsCount>; // Indexed by CountersKind
+
+	struct Query
+	{
+		UniqueIdentifier entityID{ UniqueIdentifier::getUninitializedUniqueIdentifier() };
+		CountersKind kind{ CountersKind::AvbInterface };
+		entity::model::DescriptorIndex descriptorIndex{ 0u };
+
+		bool operator==(Query const& other) const noexcept
+		{
+			return entityID == other.entityID && kind == other.kind && descriptorIndex == other.descriptorIndex;
+		}
+
+		bool operator<(Query const& other) const noexcept
+		{
+			if (entityID != other.entityID)
+				return entityID.getValue() < other.entityID.getValue();
+			if (kind != other.kind)
+				return kind < other.kind;
+			return descriptorIndex < other.descriptorIndex;
+		}
+
+		struct hash
+		{
+			std::size_t operator()(Query const& query) const noexcept
+			{
+				return UniqueIdentifier::hash{}(query.entityID) ^ std::hash<std::uint32_t>{}((static_cast<std::uint32_t>(query.kind) << 16) | query.descriptorIndex);
+			}
+		};
+	};
+
+	CountersPollingScheduler() noexcept
+	{
+		_defaultIntervals.fill(DefaultInterval);
+	}
+
+	/** Sets the global budget. */
+	void setMaxQueriesPerSecond(std::uint32_t const maxQueriesPerSecond) noexcept
+	{
+		_queriesPeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::seconds{ 1 }) / std::max(maxQueriesPerSecond, std::uint32_t{ 1u });
+	}
+
+	/** Sets the polling interval of a kind of counters, for all entities not overriding it. */
+	void setDefaultInterval(CountersKind const kind, std::chrono::milliseconds const interval, Clock::time_point const now) noexcept
+	{
+		_defaultIntervals[index(kind)] = interval;
+
+		for (auto const& entityKV : _entities)
+		{
+			auto const& entityID = entityKV.first;
+			if (!getEntityIntervalOverride(entityID, kind))
+			{
+				rescheduleEntity(entityID, kind, now);
+			}
+		}
+	}
+
+	/** Overrides the polling interval of a kind of counters for an entity. Persists while the entity is offline. */
+	void setEntityInterval(UniqueIdentifier const entityID, CountersKind const kind, std::chrono::milliseconds const interval, Clock::time_point const now) noexcept
+	{
+		_entityIntervals[entityID][index(kind)] = interval;
+		rescheduleEntity(entityID, kind, now);
+	}
+
+	/** Removes all the polling intervals overrides of an entity. */
+	void clearEntityIntervals(UniqueIdentifier const entityID, Clock::time_point const now) noexcept
+	{
+		if (_entityIntervals.erase(entityID) == 0)
+			return;
+
+		for (auto kindIndex = size_t{ 0u }; kindIndex < CountersKindsCount; ++kindIndex)
+		{
+			rescheduleEntity(entityID, static_cast<CountersKind>(kindIndex), now);
+		}
+	}
+
+	/** Marks an entity as watched (or not). Persists while the entity is offline. */
+	void setEntityWatched(UniqueIdentifier const entityID, bool const isWatched) noexcept
+	{
+		auto const wasWatched = isEntityWatched(entityID);
+		if (wasWatched == isWatched)
+			return;
+
+		if (isWatched)
+			_watchedEntities.insert(entityID);
+		else
+			_watchedEntities.erase(entityID);
+
+		// Move the scheduled queries of this entity to the other lane, keeping their time
+		auto const entityIt = _entities.find(entityID);
+		if (entityIt == _entities.end())
+			return;
+
+		auto& fromLane = wasWatched ? _watchedLane : _normalLane;
+		auto& toLane = isWatched ? _watchedLane : _normalLane;
+		forEachQuery(entityID, entityIt->second,
+			[this, &fromLane, &toLane](Query const& query)
+			{
+				auto const scheduleIt = _schedule.find(query);
+				if (scheduleIt != _schedule.end())
+				{
+					fromLane.erase(ScheduledQuery{ scheduleIt->second, query });
+					toLane.insert(ScheduledQuery{ scheduleIt->second, query });
+				}
+			});
+	}
+
+	/** Starts polling the counters of an entity (replacing previous descriptors if the entity was already known). */
+	void addEntity(UniqueIdentifier const entityID, DescriptorsCount const& descriptorsCount, Clock::time_point const now) noexcept
+	{
+		removeEntity(entityID);
+		_entities[entityID] = EntityInfo{ descriptorsCount, {} };
+
+		for (auto kindIndex = size_t{ 0u }; kindIndex < CountersKindsCount; ++kindIndex)
+		{
+			rescheduleEntity(entityID, static_cast<CountersKind>(kindIndex), now);
+		}
+	}
+
+	/** Stops polling the counters of an entity (intervals overrides and watched state are kept). */
+	void removeEntity(UniqueIdentifier const entityID) noexcept
+	{
+		auto const entityIt = _entities.find(entityID);
+		if (entityIt == _entities.end())
+			return;
+
+		forEachQuery(entityID, entityIt->second,
+			[this](Query const& query)
+			{
+				unschedule(query);
+			});
+		_entities.erase(entityIt);
+	}
+
+	/** Counters of a descriptor were received without being polled, postpone its next poll. */
+	void onUnsolicitedCounters(UniqueIdentifier const entityID, CountersKind const kind, entity::model::DescriptorIndex const descriptorIndex, Clock::time_point const now) noexcept
+	{
+		auto const query = Query{ entityID, kind, descriptorIndex };
+		auto const scheduleIt = _schedule.find(query);
+		if (scheduleIt == _schedule.end())
+			return;
+
+		auto const postponedTime = now + BackOffFactor * getInterval(entityID, kind);
+		if (postponedTime > scheduleIt->second)
+		{
+			schedule(query, postponedTime);
+			++_statistics.postponedQueries;
+		}
+	}
+
+	/** The entity does not support this kind of counters, stop polling it until the entity is added again. */
+	void onQueryNotSupported(UniqueIdentifier const entityID, CountersKind const kind) noexcept
+	{
+		auto const entityIt = _entities.find(entityID);
+		if (entityIt == _entities.end())
+			return;
+
+		auto& info = entityIt->second;
+		info.isNotSupported[index(kind)] = true;
+		for (auto descriptorIndex = entity::model::DescriptorIndex{ 0u }; descriptorIndex < info.descriptorsCount[index(kind)]; ++descriptorIndex)
+		{
+			unschedule(Query{ entityID, kind, descriptorIndex });
+		}
+	}
+
+	/** Returns the next query to send if it's due and the budget allows it, and reschedules it one interval later. */
+	std::optional<Query> popNextQuery(Clock::time_point const now) noexcept
+	{
+		if (now < _nextQueryTime)
+			return std::nullopt;
+
+		auto const isWatchedDue = isDue(_watchedLane, now);
+		auto const isNormalDue = isDue(_normalLane, now);
+		auto* lane = static_cast<Lane*>(nullptr);
+		if (isWatchedDue && (!isNormalDue || _normalSkippedCount < MaxWatchedQueriesInRow))
+		{
+			lane = &_watchedLane;
+			if (isNormalDue)
+				++_normalSkippedCount;
+		}
+		else if (isNormalDue)
+		{
+			lane = &_normalLane;
+			_normalSkippedCount = 0u;
+		}
+		else
+			return std::nullopt;
+
+		auto const query = lane->begin()->query;
+
+		// Reschedule from now (and not from the theoretical time), so a late query does not cause a burst to catch up
+		schedule(query, now + getInterval(query.entityID, query.kind));
+
+		_nextQueryTime = now + _queriesPeriod;
+		++_statistics.sentQueries;
+		return query;
+	}
+
+	/** Returns the time of the next query to send (Clock::time_point::max() if nothing is scheduled). */
+	Clock::time_point getNextWakeUpTime() const noexcept
+	{
+		auto nextTime = Clock::time_point::max();
+		if (!_watchedLane.empty())
+			nextTime = std::min(nextTime, _watchedLane.begin()->time);
+		if (!_normalLane.empty())
+			nextTime = std::min(nextTime, _normalLane.begin()->time);
+		if (nextTime == Clock::time_point::max())
+			return nextTime;
+		return std::max(nextTime, _nextQueryTime);
+	}
+
+	Statistics const& getStatistics() const noexcept
+	{
+		return _statistics;
+	}
+
+	bool isEntityWatched(UniqueIdentifier const entityID) const noexcept
+	{
+		return _watchedEntities.count(entityID) != 0;
+	}
+
+	std::chrono::milliseconds getInterval(UniqueIdentifier const entityID, CountersKind const kind) const noexcept
+	{
+		auto const overrideInterval = getEntityIntervalOverride(entityID, kind);
+		if (overrideInterval)
+			return *overrideInterval;
+		return _defaultIntervals[index(kind)];
+	}
+
+	// Deleted compiler auto-generated methods
+	CountersPollingScheduler(CountersPollingScheduler&&) = delete;
+	CountersPollingScheduler(CountersPollingScheduler const&) = delete;
+	CountersPollingScheduler& operator=(CountersPollingScheduler const&) = delete;
+	CountersPollingScheduler& operator=(CountersPollingScheduler&&) = delete;
+
+private:
+	using Intervals = std::array<std::chrono::milliseconds, CountersKindsCount>;
+	using IntervalsOverrides = std::array<std::optional<std::chrono::milliseconds>, CountersKindsCount>;
+	struct EntityInfo
+	{
+		DescriptorsCount descriptorsCount{};
+		std::array<bool, CountersKindsCount> isNotSupported{};
+	};
+	struct ScheduledQuery
+	{
+		Clock::time_point time{};
+		Query query{};
+
+		bool operator<(ScheduledQuery const& other) const noexcept
+		{
+			if (time != other.time)
+				return time < other.time;
+			return query < other.query;
+		}
+	};
+	using Lane = std::set<ScheduledQuery>; // Ordered by time
+
+	static constexpr size_t index(CountersKind const kind) noexcept
+	{
+		return static_cast<size_t>(kind);
+	}
+
+	static bool isDue(Lane const& lane, Clock::time_point const now) noexcept
+	{
+		return !lane.empty() && lane.begin()->time <= now;
+	}
+
+	std::optional<std::chrono::milliseconds> getEntityIntervalOverride(UniqueIdentifier const entityID, CountersKind const kind) const noexcept
+	{
+		auto const intervalsIt = _entityIntervals.find(entityID);
+		if (intervalsIt == _entityIntervals.end())
+			return std::nullopt;
+		return intervalsIt->second[index(kind)];
+	}
+
+	template<typename Handler>
+	static void forEachQuery(UniqueIdentifier const entityID, EntityInfo const& info, Handler const& handler) noexcept
+	{
+		for (auto kindIndex = size_t{ 0u }; kindIndex < CountersKindsCount; ++kindIndex)
+		{
+			for (auto descriptorIndex = entity::model::DescriptorIndex{ 0u }; descriptorIndex < info.descriptorsCount[kindIndex]; ++descriptorIndex)
+			{
+				handler(Query{ entityID, static_cast<CountersKind>(kindIndex), descriptorIndex });
+			}
+		}
+	}
+
+	Lane& getLane(UniqueIdentifier const entityID) noexcept
+	{
+		return isEntityWatched(entityID) ? _watchedLane : _normalLane;
+	}
+
+	void schedule(Query const& query, Clock::time_point const time) noexcept
+	{
+		auto& lane = getLane(query.entityID);
+		auto const scheduleIt = _schedule.find(query);
+		if (scheduleIt != _schedule.end())
+		{
+			lane.erase(ScheduledQuery{ scheduleIt->second, query });
+			scheduleIt->second = time;
+		}
+		else
+		{
+			_schedule.emplace(query, time);
+		}
+		lane.insert(ScheduledQuery{ time, query });
+	}
+
+	void unschedule(Query const& query) noexcept
+	{
+		auto const scheduleIt = _schedule.find(query);
+		if (scheduleIt != _schedule.end())
+		{
+			getLane(query.entityID).erase(ScheduledQuery{ scheduleIt->second, query });
+			_schedule.erase(scheduleIt);
+		}
+	}
+
+	/** Schedules (or unschedules if disabled) all the descriptors of a kind for an entity, the first poll being randomly spread over the interval. */
+	void rescheduleEntity(UniqueIdentifier const entityID, CountersKind const kind, Clock::time_point const now) noexcept
+	{
+		auto const entityIt = _entities.find(entityID);
+		if (entityIt == _entities.end())
+			return;
+
+		auto const& info = entityIt->second;
+		auto const interval = getInterval(entityID, kind);
+		auto const isPolled = interval.count() > 0 && !info.isNotSupported[index(kind)];
+		auto distribution = std::uniform_int_distribution<std::chrono::milliseconds::rep>{ 0, std::max(interval.count() - 1, std::chrono::milliseconds::rep{ 0 }) };
+
+		for (auto descriptorIndex = entity::model::DescriptorIndex{ 0u }; descriptorIndex < info.descriptorsCount[index(kind)]; ++descriptorIndex)
+		{
+			auto const query = Query{ entityID, kind, descriptorIndex };
+			if (isPolled)
+				schedule(query, now + std::chrono::milliseconds{ distribution(_randomGenerator) });
+			else
+				unschedule(query);
+		}
+	}
+
+	Intervals _defaultIntervals{};
+	std::unordered_map<UniqueIdentifier, IntervalsOverrides, UniqueIdentifier::hash> _entityIntervals{};
+	std::unordered_set<UniqueIdentifier, UniqueIdentifier::hash> _watchedEntities{};
+	std::unordered_map<UniqueIdentifier, EntityInfo, UniqueIdentifier::hash> _entities{};
+	std::unordered_map<Query, Clock::time_point, Query::hash> _schedule{}; // Scheduled time of each polled descriptor
+	Lane _watchedLane{};
+	Lane _normalLane{};
+	Clock::duration _queriesPeriod{ std::chrono::duration_cast<Clock::duration>(std::chrono::seconds{ 1 }) / DefaultMaxQueriesPerSecond };
+	Clock::time_point _nextQueryTime{};
+	std::uint32_t _normalSkippedCount{ 0u }; // Number of queries of watched entities sent while a query of the normal lane was due
+	Statistics _statistics{};
+	std::mt19937 _randomGenerator{ std::random_device{}() };
+};
+
+} // namespace controller
+} // namespace avdecc
+} // namespace la
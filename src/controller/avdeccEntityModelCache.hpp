@@ -22,10 +22,17 @@
 * @author Christophe Calmejane
 */
 
+
 #pragma once
 
 #include "avdeccControlledEntityModelTree.hpp"
+#include "avdeccMemoryFootprint.hpp"
+#include "la/avdecc/internals/uniqueIdentifier.hpp"
 #include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <atomic>
 
 namespace la
 {
@@ -33,9 +40,18 @@ namespace avdecc
 {
 namespace controller
 {
+/**
+* @brief EntityStaticTrees shared by entities with the same EntityModelID.
+* @details Entities of the same model have the same static model, so only one tree per EntityModelID and configuration is kept in memory.
+*          - Cached trees are immutable, an entity modifying its static model works on its own copy
+*          - A null EntityModelID is never cached
+*          - Thread safe
+*/
 class EntityModelCache final
 {
 public:
+	using EntityStaticTree = std::shared_ptr<model::EntityStaticTree const>;
+
 	static EntityModelCache& getInstance() noexcept
 	{
 		static EntityModelCache s_instance{};
@@ -52,48 +68,88 @@ public:
 		_isEnabled = false;
 	}
 
-	// TODO: If we want to add a clearCache method, we'll have to add locking to this class
-	// because clearCache would probably not be called from the same thread than getCachedEntityStaticTree and cacheEntityStaticTree.
-	// Also we should return a copy of the data (pair<bool, Tree> or std::optional) so the lock is release with valid data
+	bool isCacheEnabled() const noexcept
+	{
+		return _isEnabled;
+	}
 
-	model::EntityStaticTree const* getCachedEntityStaticTree(UniqueIdentifier const entityID, entity::model::ConfigurationIndex const configurationIndex) const noexcept
+	EntityStaticTree getCachedEntityStaticTree(UniqueIdentifier const entityModelID, entity::model::ConfigurationIndex const configurationIndex) const noexcept
 	{
-		if (_isEnabled)
+		if (_isEnabled && entityModelID)
 		{
-			auto const entityModelIt = _modelCache.find(entityID);
-			if (entityModelIt != _modelCache.end())
+			// Lock to protect _modelCache
+			std::lock_guard<decltype(_lock)> const lg(_lock);
+
+			auto const modelIt = _modelCache.find(Key{ entityModelID, configurationIndex });
+			if (modelIt != _modelCache.end())
 			{
-				auto const& entityModel = entityModelIt->second;
-				auto const modelIt = entityModel.find(configurationIndex);
-				if (modelIt != entityModel.end())
-				{
-					return &modelIt->second;
-				}
+				return modelIt->second;
 			}
 		}
 
-		return nullptr;
+		return {};
 	}
 
-	void cacheEntityStaticTree(UniqueIdentifier const entityID, entity::model::ConfigurationIndex const configurationIndex, model::EntityStaticTree const& staticTree) noexcept
+	/** Caches the tree (if not already in cache), which must not be modified anymore. Returns true if the tree has been cached. */
+	bool cacheEntityStaticTree(UniqueIdentifier const entityModelID, entity::model::ConfigurationIndex const configurationIndex, EntityStaticTree const& staticTree) noexcept
 	{
-		if (_isEnabled)
+		if (_isEnabled && entityModelID && staticTree)
 		{
-			auto& entityModel = _modelCache[entityID];
+			// Lock to protect _modelCache
+			std::lock_guard<decltype(_lock)> const lg(_lock);
 
 			// Cache the EntityModel but only if not already in cache
-			auto modelIt = entityModel.find(configurationIndex);
-			if (modelIt == entityModel.end())
-			{
-				entityModel.insert(std::make_pair(configurationIndex, staticTree));
-			}
+			return _modelCache.insert(std::make_pair(Key{ entityModelID, configurationIndex }, staticTree)).second;
+		}
+
+		return false;
+	}
+
+	/** Estimated memory held by the cache, in bytes. Cached trees are evenly split between the cache and the entities sharing them. */
+	size_t getMemoryFootprint() const noexcept
+	{
+		// Lock to protect _modelCache
+		std::lock_guard<decltype(_lock)> const lg(_lock);
+
+		auto size = memoryFootprint::heapSize(_modelCache);
+		for (auto const& modelKV : _modelCache)
+		{
+			auto const& staticTree = modelKV.second;
+			size += memoryFootprint::totalSize(*staticTree) / static_cast<size_t>(staticTree.use_count());
 		}
+		return size;
 	}
 
+	// Deleted compiler auto-generated methods
+	EntityModelCache(EntityModelCache const&) = delete;
+	EntityModelCache(EntityModelCache&&) = delete;
+	EntityModelCache& operator=(EntityModelCache const&) = delete;
+	EntityModelCache& operator=(EntityModelCache&&) = delete;
+
 private:
-	using StaticEntityModel = std::unordered_map<entity::model::ConfigurationIndex, model::EntityStaticTree>;
-	std::unordered_map<UniqueIdentifier, StaticEntityModel, la::avdecc::UniqueIdentifier::hash> _modelCache{};
-	bool _isEnabled{ false };
+	struct Key
+	{
+		UniqueIdentifier entityModelID{};
+		entity::model::ConfigurationIndex configurationIndex{ 0u };
+
+		bool operator==(Key const& other) const noexcept
+		{
+			return entityModelID == other.entityModelID && configurationIndex == other.configurationIndex;
+		}
+	};
+	struct KeyHash
+	{
+		size_t operator()(Key const& key) const noexcept
+		{
+			return UniqueIdentifier::hash{}(key.entityModelID) ^ (std::hash<entity::model::ConfigurationIndex>{}(key.configurationIndex) << 1);
+		}
+	};
+
+	EntityModelCache() noexcept = default;
+
+	mutable std::mutex _lock{};
+	std::unordered_map<Key, EntityStaticTree, KeyHash> _modelCache{};
+	std::atomic_bool _isEnabled{ false };
 };
 
 } // namespace controller
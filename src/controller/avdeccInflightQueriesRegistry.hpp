@@ -0,0 +1,188 @@
+/*
+* Copyright (C) 2016-2018, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be usefu_state,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file avdeccInflightQueriesRegistry.hpp
+* @author Christophe Calmejane
+*/
+
+#pragma once
+
+#include "la/avdecc/controller/avdeccController.hpp"
+#include <unordered_map>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+
+namespace la
+{
+namespace avdecc
+{
+namespace controller
+{
+/**
+* @brief Registry of the enumeration queries currently inflight, to avoid sending identical queries twice.
+* @details Not thread safe, the owner calls registerQuery right before sending a query and completeQuery when its result handler is called.
+*          - A query identical (same entity, kind, type, configuration, descriptor and sub-index) to an inflight one is not sent, and shares the result of the inflight one
+*          - Except a dynamic query triggered after the inflight one was sent (its result might predate the change that triggered the new query): it is sent again once the inflight one completes, identical queries triggered meanwhile being merged into it
+*          - An inflight query is considered lost after MaxInflightDuration (in case its result handler is never called), and an identical query is sent again
+*          - Inflight queries of an entity are forgotten when it goes offline
+*/
+class InflightQueriesRegistry final
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	using Statistics = Controller::QueriesStatistics;
+	using QueryHandler = std::function<void(entity::ControllerEntity*)>;
+
+	static constexpr auto MaxInflightDuration = std::chrono::milliseconds{ 5000 }; // Way longer than an AECP command with all its retries
+
+	enum class QueryKind : std::uint8_t
+	{
+		Descriptor,
+		DynamicInfo,
+		DescriptorDynamicInfo,
+	};
+
+	struct Key
+	{
+		UniqueIdentifier entityID{ UniqueIdentifier::getUninitializedUniqueIdentifier() };
+		QueryKind kind{ QueryKind::Descriptor };
+		std::uint16_t type{ 0u }; /**< DescriptorType, DynamicInfoType or DescriptorDynamicInfoType depending on kind */
+		entity::model::ConfigurationIndex configurationIndex{ 0u };
+		entity::model::DescriptorIndex descriptorIndex{ 0u };
+		std::uint16_t subIndex{ 0u };
+
+		bool operator==(Key const& other) const noexcept
+		{
+			return entityID == other.entityID && kind == other.kind && type == other.type && configurationIndex == other.configurationIndex && descriptorIndex == other.descriptorIndex && subIndex == other.subIndex;
+		}
+
+		struct hash
+		{
+			std::size_t operator()(Key const& key) const noexcept
+			{
+				auto const query = (static_cast<std::uint64_t>(key.kind) << 56) | (static_cast<std::uint64_t>(key.type) << 48) | (static_cast<std::uint64_t>(key.configurationIndex) << 32) | (static_cast<std::uint64_t>(key.descriptorIndex) << 16) | static_cast<std::uint64_t>(key.subIndex);
+				return UniqueIdentifier::hash{}(key.entityID) ^ std::hash<std::uint64_t>{}(query);
+			}
+		};
+	};
+
+	InflightQueriesRegistry() noexcept = default;
+
+	/** Registers a query about to be sent, triggered right now. Returns false if an identical query is already inflight, in which case the query should not be sent. */
+	bool registerQuery(Key const& key, Clock::time_point const now) noexcept
+	{
+		return registerQuery(key, now, now, {});
+	}
+
+	/**
+	* Registers a query about to be sent, triggered at triggerTime (earlier than now for a delayed query).
+	* Returns false if an identical query is already inflight, in which case the query should not be sent.
+	* If the inflight query result might predate the trigger of this one, resendHandler is returned by completeQuery for the inflight one.
+	*/
+	bool registerQuery(Key const& key, Clock::time_point const now, Clock::time_point const triggerTime, QueryHandler const& resendHandler) noexcept
+	{
+		auto const [queryIt, inserted] = _inflightQueries.emplace(key, InflightQuery{ now, {} });
+		if (!inserted)
+		{
+			auto& query = queryIt->second;
+			// Identical query still inflight
+			if ((now - query.sendTime) < MaxInflightDuration)
+			{
+				// Descriptors are static, and the inflight query was sent after the trigger of a dynamic one: share its result
+				if (key.kind == QueryKind::Descriptor || triggerTime <= query.sendTime || !resendHandler)
+				{
+					++_statistics.deduplicatedQueries;
+					return false;
+				}
+				// Send it again once the inflight one completes, merging it with an identical query already waiting for that
+				if (query.resendHandler)
+				{
+					++_statistics.deduplicatedQueries;
+				}
+				query.resendHandler = resendHandler;
+				return false;
+			}
+			// Previous query is considered lost
+			query = InflightQuery{ now, {} };
+		}
+		++_statistics.sentQueries;
+		return true;
+	}
+
+	/** Unregisters a query when its result is received (must be called before a possible retry of the query is sent). Returns the handler to send the query again if an identical one was registered meanwhile, or an empty handler. */
+	QueryHandler completeQuery(Key const& key) noexcept
+	{
+		auto resendHandler = QueryHandler{};
+		auto const queryIt = _inflightQueries.find(key);
+		if (queryIt != _inflightQueries.end())
+		{
+			resendHandler = std::move(queryIt->second.resendHandler);
+			_inflightQueries.erase(queryIt);
+		}
+		return resendHandler;
+	}
+
+	/** Unregisters all inflight queries of an entity. */
+	void removeQueries(UniqueIdentifier const entityID) noexcept
+	{
+		for (auto it = _inflightQueries.begin(); it != _inflightQueries.end();)
+		{
+			if (it->first.entityID == entityID)
+			{
+				it = _inflightQueries.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	bool isInflight(Key const& key) const noexcept
+	{
+		return _inflightQueries.count(key) != 0;
+	}
+
+	Statistics const& getStatistics() const noexcept
+	{
+		return _statistics;
+	}
+
+	// Deleted compiler auto-generated methods
+	InflightQueriesRegistry(InflightQueriesRegistry&&) = delete;
+	InflightQueriesRegistry(InflightQueriesRegistry const&) = delete;
+	InflightQueriesRegistry& operator=(InflightQueriesRegistry const&) = delete;
+	InflightQueriesRegistry& operator=(InflightQueriesRegistry&&) = delete;
+
+private:
+	struct InflightQuery
+	{
+		Clock::time_point sendTime{};
+		QueryHandler resendHandler{}; // Set if an identical dynamic query was triggered after this one was sent
+	};
+
+	std::unordered_map<Key, InflightQuery, Key::hash> _inflightQueries{};
+	Statistics _statistics{};
+};
+
+} // namespace controller
+} // namespace avdecc
+} // namespace la
@@ -0,0 +1,118 @@
+/*
+* Copyright (C) 2016-2018, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be usefu_state,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/**
+* @file avdeccLocalizedStringsRegistry.hpp
+* @author Christophe Calmejane
+*/
+
+#pragma once
+
+#include "la/avdecc/controller/internals/avdeccControlledEntityDynamicModel.hpp"
+#include "la/avdecc/internals/uniqueIdentifier.hpp"
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <functional>
+
+namespace la
+{
+namespace avdecc
+{
+namespace controller
+{
+/**
+* @brief Localized strings tables shared by entities with the same EntityModelID.
+* @details Entities of the same model have the same STRINGS descriptors, so only one table per EntityModelID and configuration is kept in memory.
+*          - Tables are immutable once shared, an entity loading strings again works on its own copy
+*          - Only weak references are kept, a table is released with the last entity using it
+*          - A table different from the registered one (partially loaded strings, different firmware with the same EntityModelID) is not shared
+*          - Thread safe
+*/
+class LocalizedStringsRegistry final
+{
+public:
+	using LocalizedStrings = std::shared_ptr<model::LocalizedStrings const>;
+
+	static LocalizedStringsRegistry& getInstance() noexcept
+	{
+		static LocalizedStringsRegistry s_instance{};
+		return s_instance;
+	}
+
+	/** Returns the registered table identical to localizedStrings, or registers localizedStrings and returns it. A null entityModelID is never shared. */
+	LocalizedStrings share(UniqueIdentifier const entityModelID, entity::model::ConfigurationIndex const configurationIndex, LocalizedStrings const& localizedStrings) noexcept
+	{
+		if (!entityModelID || !localizedStrings)
+		{
+			return localizedStrings;
+		}
+
+		// Lock to protect _tables
+		std::lock_guard<decltype(_lock)> const lg(_lock);
+
+		auto& table = _tables[Key{ entityModelID, configurationIndex }];
+		if (auto registered = table.lock())
+		{
+			if (*registered == *localizedStrings)
+			{
+				return registered;
+			}
+			return localizedStrings;
+		}
+
+		table = localizedStrings;
+		return localizedStrings;
+	}
+
+	// Deleted compiler auto-generated methods
+	LocalizedStringsRegistry(LocalizedStringsRegistry const&) = delete;
+	LocalizedStringsRegistry(LocalizedStringsRegistry&&) = delete;
+	LocalizedStringsRegistry& operator=(LocalizedStringsRegistry const&) = delete;
+	LocalizedStringsRegistry& operator=(LocalizedStringsRegistry&&) = delete;
+
+private:
+	struct Key
+	{
+		UniqueIdentifier entityModelID{};
+		entity::model::ConfigurationIndex configurationIndex{ 0u };
+
+		bool operator==(Key const& other) const noexcept
+		{
+			return entityModelID == other.entityModelID && configurationIndex == other.configurationIndex;
+		}
+	};
+	struct KeyHash
+	{
+		size_t operator()(Key const& key) const noexcept
+		{
+			return UniqueIdentifier::hash{}(key.entityModelID) ^ (std::hash<entity::model::ConfigurationIndex>{}(key.configurationIndex) << 1);
+		}
+	};
+
+	LocalizedStringsRegistry() noexcept = default;
+
+	std::mutex _lock{};
+	std::unordered_map<Key, std::weak_ptr<model::LocalizedStrings const>, KeyHash> _tables{};
+};
+
+} // namespace controller
+} // namespace avdecc
+} // namespace la
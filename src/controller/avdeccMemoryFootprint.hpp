@@ -0,0 +1,354 @@
+/*
+* Copyright (C) 2016-2018, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be usefu_state,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/**
+* @file avdeccMemoryFootprint.hpp
+* @author Christophe Calmejane
+* @brief Estimation of the heap memory held by the controller data structures.
+*/
+
+#pragma once
+
+#include "avdeccControlledEntityModelTree.hpp"
+#include "la/avdecc/controller/internals/avdeccControlledEntityModel.hpp"
+#include <vector>
+#include <set>
+#include <map>
+#include <unordered_set>
+#include <unordered_map>
+#include <optional>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+
+namespace la
+{
+namespace avdecc
+{
+namespace controller
+{
+/**
+* @brief Heap memory held by a value, not counting sizeof(value) which is accounted for by its owner.
+* @details This is an estimation, allocator bookkeeping is not taken into account:
+*          - Node based containers allocate one node per element, holding the element and the links of the node
+*          - Hash based containers also allocate an array of buckets
+*          - Data shared through a std::shared_ptr is not followed, the owner decides how to account for it
+*          Types holding heap memory must have an overload, the generic one only accepts trivially copyable types.
+*/
+namespace memoryFootprint
+{
+static constexpr size_t TreeNodeOverhead = 4 * sizeof(void*); // Parent, left and right links, and color
+static constexpr size_t HashNodeOverhead = 2 * sizeof(void*); // Next link and cached hash
+
+// Declarations, so overloads can be used by each other whatever their definition order
+template<typename T>
+size_t heapSize(T const& value) noexcept;
+template<typename T>
+size_t heapSize(std::vector<T> const& values) noexcept;
+template<typename T>
+size_t heapSize(std::optional<T> const& value) noexcept;
+template<typename T>
+size_t heapSize(std::shared_ptr<T> const& value) noexcept;
+template<typename T1, typename T2>
+size_t heapSize(std::pair<T1, T2> const& value) noexcept;
+template<typename Key, typename Compare>
+size_t heapSize(std::set<Key, Compare> const& values) noexcept;
+template<typename Key, typename T, typename Compare>
+size_t heapSize(std::map<Key, T, Compare> const& values) noexcept;
+template<typename Key, typename Hash, typename Equal>
+size_t heapSize(std::unordered_set<Key, Hash, Equal> const& values) noexcept;
+template<typename Key, typename T, typename Hash, typename Equal>
+size_t heapSize(std::unordered_map<Key, T, Hash, Equal> const& values) noexcept;
+template<typename IndexType, typename ModelType>
+size_t heapSize(model::DenseIndexMap<IndexType, ModelType> const& models) noexcept;
+size_t heapSize(entity::model::AvbInfo const& value) noexcept;
+size_t heapSize(model::AudioUnitNodeStaticModel const& model) noexcept;
+size_t heapSize(model::StreamNodeStaticModel const& model) noexcept;
+size_t heapSize(model::AudioMapNodeStaticModel const& model) noexcept;
+size_t heapSize(model::ClockDomainNodeStaticModel const& model) noexcept;
+size_t heapSize(model::ConfigurationNodeStaticModel const& model) noexcept;
+size_t heapSize(model::ConfigurationStaticTree const& tree) noexcept;
+size_t heapSize(model::EntityStaticTree const& tree) noexcept;
+size_t heapSize(model::StreamInputNodeDynamicModel const& model) noexcept;
+size_t heapSize(model::StreamOutputNodeDynamicModel const& model) noexcept;
+size_t heapSize(model::AvbInterfaceNodeDynamicModel const& model) noexcept;
+size_t heapSize(model::StreamPortNodeDynamicModel const& model) noexcept;
+size_t heapSize(model::ClockDomainNodeDynamicModel const& model) noexcept;
+size_t heapSize(model::ConfigurationNodeDynamicModel const& model) noexcept;
+size_t heapSize(model::ConfigurationDynamicTree const& tree) noexcept;
+size_t heapSize(model::EntityDynamicTree const& tree) noexcept;
+size_t heapSize(model::StreamPortNode const& node) noexcept;
+size_t heapSize(model::AudioUnitNode const& node) noexcept;
+size_t heapSize(model::LocaleNode const& node) noexcept;
+size_t heapSize(model::ClockDomainNode const& node) noexcept;
+#ifdef ENABLE_AVDECC_FEATURE_REDUNDANCY
+size_t heapSize(model::RedundantStreamNode const& node) noexcept;
+#endif // ENABLE_AVDECC_FEATURE_REDUNDANCY
+size_t heapSize(model::ConfigurationNode const& node) noexcept;
+size_t heapSize(model::EntityNode const& node) noexcept;
+
+/** Memory held by an object, including itself */
+template<typename T>
+size_t totalSize(T const& value) noexcept
+{
+	return sizeof(value) + heapSize(value);
+}
+
+/* ************************************************************************** */
+/* Generic types and containers                                               */
+/* ************************************************************************** */
+template<typename T>
+size_t heapSize(T const& /*value*/) noexcept
+{
+	static_assert(std::is_trivially_copyable_v<T>, "No heapSize overload for this type, which might hold heap memory");
+	return 0u;
+}
+
+template<typename T>
+size_t heapSize(std::vector<T> const& values) noexcept
+{
+	auto size = values.capacity() * sizeof(T);
+	for (auto const& value : values)
+	{
+		size += heapSize(value);
+	}
+	return size;
+}
+
+template<typename T>
+size_t heapSize(std::optional<T> const& value) noexcept
+{
+	return value ? heapSize(*value) : 0u;
+}
+
+template<typename T>
+size_t heapSize(std::shared_ptr<T> const& /*value*/) noexcept
+{
+	// Shared data is not followed
+	return 0u;
+}
+
+template<typename T1, typename T2>
+size_t heapSize(std::pair<T1, T2> const& value) noexcept
+{
+	return heapSize(value.first) + heapSize(value.second);
+}
+
+template<typename Key, typename Compare>
+size_t heapSize(std::set<Key, Compare> const& values) noexcept
+{
+	auto size = values.size() * (sizeof(Key) + TreeNodeOverhead);
+	for (auto const& value : values)
+	{
+		size += heapSize(value);
+	}
+	return size;
+}
+
+template<typename Key, typename T, typename Compare>
+size_t heapSize(std::map<Key, T, Compare> const& values) noexcept
+{
+	auto size = values.size() * (sizeof(typename std::map<Key, T, Compare>::value_type) + TreeNodeOverhead);
+	for (auto const& value : values)
+	{
+		size += heapSize(value);
+	}
+	return size;
+}
+
+template<typename Key, typename Hash, typename Equal>
+size_t heapSize(std::unordered_set<Key, Hash, Equal> const& values) noexcept
+{
+	auto size = values.bucket_count() * sizeof(void*) + values.size() * (sizeof(Key) + HashNodeOverhead);
+	for (auto const& value : values)
+	{
+		size += heapSize(value);
+	}
+	return size;
+}
+
+template<typename Key, typename T, typename Hash, typename Equal>
+size_t heapSize(std::unordered_map<Key, T, Hash, Equal> const& values) noexcept
+{
+	auto size = values.bucket_count() * sizeof(void*) + values.size() * (sizeof(typename std::unordered_map<Key, T, Hash, Equal>::value_type) + HashNodeOverhead);
+	for (auto const& value : values)
+	{
+		size += heapSize(value);
+	}
+	return size;
+}
+
+template<typename IndexType, typename ModelType>
+size_t heapSize(model::DenseIndexMap<IndexType, ModelType> const& models) noexcept
+{
+	// All slots are allocated, even empty ones
+	auto size = models.capacity() * sizeof(std::optional<typename model::DenseIndexMap<IndexType, ModelType>::value_type>);
+	// Plus a tree node for each model stored sparsely
+	size += models.sparseSize() * (sizeof(IndexType) + sizeof(typename model::DenseIndexMap<IndexType, ModelType>::value_type) + TreeNodeOverhead);
+	for (auto const& modelKV : models)
+	{
+		size += heapSize(modelKV.second);
+	}
+	return size;
+}
+
+/* ************************************************************************** */
+/* AEM types                                                                  */
+/* ************************************************************************** */
+inline size_t heapSize(entity::model::AvbInfo const& value) noexcept
+{
+	return heapSize(value.mappings);
+}
+
+/* ************************************************************************** */
+/* Static model                                                               */
+/* ************************************************************************** */
+inline size_t heapSize(model::AudioUnitNodeStaticModel const& model) noexcept
+{
+	return heapSize(model.samplingRates);
+}
+
+inline size_t heapSize(model::StreamNodeStaticModel const& model) noexcept
+{
+	auto size = heapSize(model.formats);
+#ifdef ENABLE_AVDECC_FEATURE_REDUNDANCY
+	size += heapSize(model.redundantStreams);
+#endif // ENABLE_AVDECC_FEATURE_REDUNDANCY
+	return size;
+}
+
+inline size_t heapSize(model::AudioMapNodeStaticModel const& model) noexcept
+{
+	return heapSize(model.mappings);
+}
+
+inline size_t heapSize(model::ClockDomainNodeStaticModel const& model) noexcept
+{
+	return heapSize(model.clockSources);
+}
+
+inline size_t heapSize(model::ConfigurationNodeStaticModel const& model) noexcept
+{
+	return heapSize(model.descriptorCounts);
+}
+
+inline size_t heapSize(model::ConfigurationStaticTree const& tree) noexcept
+{
+	return heapSize(tree.audioUnitStaticModels) + heapSize(tree.streamInputStaticModels) + heapSize(tree.streamOutputStaticModels) + heapSize(tree.avbInterfaceStaticModels) + heapSize(tree.clockSourceStaticModels) + heapSize(tree.memoryObjectStaticModels) + heapSize(tree.localeStaticModels) + heapSize(tree.stringsStaticModels) + heapSize(tree.streamPortInputStaticModels) + heapSize(tree.streamPortOutputStaticModels) + heapSize(tree.audioClusterStaticModels) + heapSize(tree.audioMapStaticModels) + heapSize(tree.clockDomainStaticModels) + heapSize(tree.staticModel);
+}
+
+inline size_t heapSize(model::EntityStaticTree const& tree) noexcept
+{
+	return heapSize(tree.configurationStaticTrees) + heapSize(tree.staticModel);
+}
+
+/* ************************************************************************** */
+/* Dynamic model                                                              */
+/* ************************************************************************** */
+inline size_t heapSize(model::StreamInputNodeDynamicModel const& model) noexcept
+{
+	return heapSize(model.counters);
+}
+
+inline size_t heapSize(model::StreamOutputNodeDynamicModel const& model) noexcept
+{
+	return heapSize(model.connections);
+}
+
+inline size_t heapSize(model::AvbInterfaceNodeDynamicModel const& model) noexcept
+{
+	return heapSize(model.avbInfo) + heapSize(model.counters);
+}
+
+inline size_t heapSize(model::StreamPortNodeDynamicModel const& model) noexcept
+{
+	return heapSize(model.dynamicAudioMap);
+}
+
+inline size_t heapSize(model::ClockDomainNodeDynamicModel const& model) noexcept
+{
+	return heapSize(model.counters);
+}
+
+inline size_t heapSize(model::ConfigurationNodeDynamicModel const& /*model*/) noexcept
+{
+	// Localized strings are shared by the entities of the same model, not accounted for here
+	return 0u;
+}
+
+inline size_t heapSize(model::ConfigurationDynamicTree const& tree) noexcept
+{
+	return heapSize(tree.audioUnitDynamicModels) + heapSize(tree.streamInputDynamicModels) + heapSize(tree.streamOutputDynamicModels) + heapSize(tree.avbInterfaceDynamicModels) + heapSize(tree.clockSourceDynamicModels) + heapSize(tree.memoryObjectDynamicModels) + heapSize(tree.streamPortInputDynamicModels) + heapSize(tree.streamPortOutputDynamicModels) + heapSize(tree.audioClusterDynamicModels) + heapSize(tree.clockDomainDynamicModels) + heapSize(tree.dynamicModel);
+}
+
+inline size_t heapSize(model::EntityDynamicTree const& tree) noexcept
+{
+	return heapSize(tree.configurationDynamicTrees) + heapSize(tree.dynamicModel);
+}
+
+/* ************************************************************************** */
+/* Model graph                                                                */
+/* ************************************************************************** */
+inline size_t heapSize(model::StreamPortNode const& node) noexcept
+{
+	return heapSize(node.audioClusters) + heapSize(node.audioMaps);
+}
+
+inline size_t heapSize(model::AudioUnitNode const& node) noexcept
+{
+	return heapSize(node.streamPortInputs) + heapSize(node.streamPortOutputs);
+}
+
+inline size_t heapSize(model::LocaleNode const& node) noexcept
+{
+	return heapSize(node.strings);
+}
+
+inline size_t heapSize(model::ClockDomainNode const& node) noexcept
+{
+	return heapSize(node.clockSources);
+}
+
+#ifdef ENABLE_AVDECC_FEATURE_REDUNDANCY
+inline size_t heapSize(model::RedundantStreamNode const& node) noexcept
+{
+	return heapSize(node.redundantStreams);
+}
+#endif // ENABLE_AVDECC_FEATURE_REDUNDANCY
+
+inline size_t heapSize(model::ConfigurationNode const& node) noexcept
+{
+	auto size = heapSize(node.audioUnits) + heapSize(node.streamInputs) + heapSize(node.streamOutputs) + heapSize(node.avbInterfaces) + heapSize(node.clockSources) + heapSize(node.memoryObjects) + heapSize(node.locales) + heapSize(node.clockDomains);
+#ifdef ENABLE_AVDECC_FEATURE_REDUNDANCY
+	size += heapSize(node.redundantStreamInputs) + heapSize(node.redundantStreamOutputs);
+#endif // ENABLE_AVDECC_FEATURE_REDUNDANCY
+	return size;
+}
+
+inline size_t heapSize(model::EntityNode const& node) noexcept
+{
+	return heapSize(node.configurations);
+}
+
+} // namespace memoryFootprint
+} // namespace controller
+} // namespace avdecc
+} // namespace la
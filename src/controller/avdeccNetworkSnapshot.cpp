@@ -0,0 +1,641 @@
+/*
+* Copyright (C) 2016-2018, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be usefu_state,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file avdeccNetworkSnapshot.cpp
+* @author Christophe Calmejane
+*/
+
+#include "avdeccNetworkSnapshot.hpp"
+#include "la/avdecc/internals/serialization.hpp"
+#include <type_traits>
+#include <stdexcept>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <array>
+#include <memory>
+
+namespace la
+{
+namespace avdecc
+{
+namespace controller
+{
+namespace networkSnapshot
+{
+namespace
+{
+/* ************************************************************ */
+/* Archives                                                     */
+/* ************************************************************ */
+/** Writes values to a growing buffer. Models are described once (see 'archive' functions below) and shared with the Reader, so both are always in sync. */
+class Writer final
+{
+public:
+	template<typename T>
+	using Field = T const;
+
+	template<typename... Values>
+	void operator()(Values const&... values)
+	{
+		(process(values), ...);
+	}
+
+	std::vector<std::uint8_t>& getBuffer() noexcept
+	{
+		return _buffer;
+	}
+
+private:
+	template<typename T>
+	void process(T const& v)
+	{
+		if constexpr (std::is_enum<T>::value || std::is_arithmetic<T>::value)
+		{
+			auto const packed = AVDECC_PACK_TYPE(v, T);
+			append(&packed, sizeof(packed));
+		}
+		else
+		{
+			archive(*this, v);
+		}
+	}
+	void process(bool const v)
+	{
+		process(static_cast<std::uint8_t>(v ? 1u : 0u));
+	}
+	void process(UniqueIdentifier const& v)
+	{
+		process(v.getValue());
+	}
+	void process(entity::model::AvdeccFixedString const& v)
+	{
+		append(v.data(), v.size());
+	}
+	void process(networkInterface::MacAddress const& v)
+	{
+		append(v.data(), v.size());
+	}
+	template<typename T, size_t Size>
+	void process(std::array<T, Size> const& a)
+	{
+		for (auto const& v : a)
+		{
+			process(v);
+		}
+	}
+	template<typename T, typename... Others>
+	void process(std::vector<T, Others...> const& c)
+	{
+		processContainer(c);
+	}
+	template<typename T, typename... Others>
+	void process(std::set<T, Others...> const& c)
+	{
+		processContainer(c);
+	}
+	template<typename Key, typename T, typename... Others>
+	void process(std::map<Key, T, Others...> const& c)
+	{
+		processContainer(c);
+	}
+	template<typename Key, typename T, typename... Others>
+	void process(std::unordered_map<Key, T, Others...> const& c)
+	{
+		processContainer(c);
+	}
+	template<typename Key, typename T>
+	void process(model::DenseIndexMap<Key, T> const& c)
+	{
+		processContainer(c);
+	}
+	void process(std::shared_ptr<model::LocalizedStrings const> const& c)
+	{
+		process(c ? *c : model::LocalizedStrings{});
+	}
+	template<typename First, typename Second>
+	void process(std::pair<First, Second> const& p)
+	{
+		process(p.first);
+		process(p.second);
+	}
+	template<typename Container>
+	void processContainer(Container const& c)
+	{
+		process(static_cast<std::uint32_t>(c.size()));
+		for (auto const& v : c)
+		{
+			process(v);
+		}
+	}
+	void append(void const* const ptr, size_t const size)
+	{
+		auto const* const data = static_cast<std::uint8_t const*>(ptr);
+		_buffer.insert(_buffer.end(), data, data + size);
+	}
+
+	std::vector<std::uint8_t> _buffer{};
+};
+
+/** Reads values from a buffer. Throws std::invalid_argument if there is not enough data. */
+class Reader final
+{
+public:
+	template<typename T>
+	using Field = T;
+
+	Reader(void const* const ptr, size_t const size) noexcept
+		: _des(ptr, size)
+	{
+	}
+
+	template<typename... Values>
+	void operator()(Values&... values)
+	{
+		(process(values), ...);
+	}
+
+	size_t remaining() const
+	{
+		return _des.remaining();
+	}
+
+private:
+	template<typename T>
+	void process(T& v)
+	{
+		if constexpr (std::is_enum<T>::value || std::is_arithmetic<T>::value)
+		{
+			_des >> v;
+		}
+		else
+		{
+			archive(*this, v);
+		}
+	}
+	void process(bool& v)
+	{
+		auto value = std::uint8_t{ 0u };
+		process(value);
+		v = value != 0u;
+	}
+	void process(UniqueIdentifier& v)
+	{
+		_des >> v;
+	}
+	void process(entity::model::AvdeccFixedString& v)
+	{
+		_des >> v;
+	}
+	void process(networkInterface::MacAddress& v)
+	{
+		_des >> v;
+	}
+	template<typename T, size_t Size>
+	void process(std::array<T, Size>& a)
+	{
+		for (auto& v : a)
+		{
+			process(v);
+		}
+	}
+	template<typename T, typename... Others>
+	void process(std::vector<T, Others...>& c)
+	{
+		auto const count = readCount();
+		c.clear();
+		for (auto i = 0u; i < count; ++i)
+		{
+			auto v = T{};
+			process(v);
+			c.push_back(std::move(v));
+		}
+	}
+	template<typename T, typename... Others>
+	void process(std::set<T, Others...>& c)
+	{
+		auto const count = readCount();
+		c.clear();
+		for (auto i = 0u; i < count; ++i)
+		{
+			auto v = T{};
+			process(v);
+			c.insert(std::move(v));
+		}
+	}
+	template<typename Key, typename T, typename... Others>
+	void process(std::map<Key, T, Others...>& c)
+	{
+		processMap(c);
+	}
+	template<typename Key, typename T, typename... Others>
+	void process(std::unordered_map<Key, T, Others...>& c)
+	{
+		processMap(c);
+	}
+	template<typename Key, typename T>
+	void process(model::DenseIndexMap<Key, T>& c)
+	{
+		processMap(c);
+	}
+	void process(std::shared_ptr<model::LocalizedStrings const>& c)
+	{
+		auto strings = model::LocalizedStrings{};
+		process(strings);
+		c = strings.empty() ? nullptr : std::make_shared<model::LocalizedStrings const>(std::move(strings));
+	}
+	template<typename Map>
+	void processMap(Map& c)
+	{
+		auto const count = readCount();
+		c.clear();
+		for (auto i = 0u; i < count; ++i)
+		{
+			auto key = typename Map::key_type{};
+			process(key);
+			process(c[key]);
+		}
+	}
+	std::uint32_t readCount()
+	{
+		auto count = std::uint32_t{ 0u };
+		process(count);
+		// Each element is at least 1 byte long, detect corrupted counts right away
+		if (count > remaining())
+		{
+			throw std::invalid_argument("Invalid elements count");
+		}
+		return count;
+	}
+
+	Deserializer _des;
+};
+
+/* ************************************************************ */
+/* Models description                                           */
+/* ************************************************************ */
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<entity::model::StreamIdentification>& m)
+{
+	ar(m.entityID, m.streamIndex);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<entity::model::AudioMapping>& m)
+{
+	ar(m.streamIndex, m.streamChannel, m.clusterOffset, m.clusterChannel);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<entity::model::MsrpMapping>& m)
+{
+	ar(m.trafficClass, m.priority, m.vlanID);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<entity::model::StreamInfo>& m)
+{
+	ar(m.streamInfoFlags, m.streamFormat, m.streamID, m.msrpAccumulatedLatency, m.streamDestMac, m.msrpFailureCode, m.msrpFailureBridgeID, m.streamVlanID);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<entity::model::AvbInfo>& m)
+{
+	ar(m.gptpGrandmasterID, m.propagationDelay, m.gptpDomainNumber, m.flags, m.mappings);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::StreamConnectionState>& m)
+{
+	ar(m.listenerStream, m.talkerStream, m.state);
+}
+
+/* Static model */
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::AudioUnitNodeStaticModel>& m)
+{
+	ar(m.localizedDescription, m.clockDomainIndex);
+	ar(m.numberOfStreamInputPorts, m.baseStreamInputPort, m.numberOfStreamOutputPorts, m.baseStreamOutputPort);
+	ar(m.numberOfExternalInputPorts, m.baseExternalInputPort, m.numberOfExternalOutputPorts, m.baseExternalOutputPort);
+	ar(m.numberOfInternalInputPorts, m.baseInternalInputPort, m.numberOfInternalOutputPorts, m.baseInternalOutputPort);
+	ar(m.numberOfControls, m.baseControl, m.numberOfSignalSelectors, m.baseSignalSelector, m.numberOfMixers, m.baseMixer, m.numberOfMatrices, m.baseMatrix);
+	ar(m.numberOfSplitters, m.baseSplitter, m.numberOfCombiners, m.baseCombiner, m.numberOfDemultiplexers, m.baseDemultiplexer, m.numberOfMultiplexers, m.baseMultiplexer);
+	ar(m.numberOfTranscoders, m.baseTranscoder, m.numberOfControlBlocks, m.baseControlBlock);
+	ar(m.samplingRates);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::StreamNodeStaticModel>& m)
+{
+	ar(m.localizedDescription, m.clockDomainIndex, m.streamFlags);
+	ar(m.backupTalkerEntityID_0, m.backupTalkerUniqueID_0, m.backupTalkerEntityID_1, m.backupTalkerUniqueID_1, m.backupTalkerEntityID_2, m.backupTalkerUniqueID_2, m.backedupTalkerEntityID, m.backedupTalkerUnique);
+	ar(m.avbInterfaceIndex, m.bufferLength, m.formats);
+	// Always present in the file, whatever the compilation options
+#ifdef ENABLE_AVDECC_FEATURE_REDUNDANCY
+	ar(m.redundantStreams);
+#else // !ENABLE_AVDECC_FEATURE_REDUNDANCY
+	auto redundantStreams = std::set<entity::model::StreamIndex>{};
+	ar(redundantStreams);
+#endif // ENABLE_AVDECC_FEATURE_REDUNDANCY
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::AvbInterfaceNodeStaticModel>& m)
+{
+	ar(m.localizedDescription, m.macAddress, m.interfaceFlags, m.clockIdentity, m.priority1, m.clockClass, m.offsetScaledLogVariance, m.clockAccuracy, m.priority2, m.domainNumber, m.logSyncInterval, m.logAnnounceInterval, m.logPDelayInterval, m.portNumber);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::ClockSourceNodeStaticModel>& m)
+{
+	ar(m.localizedDescription, m.clockSourceType, m.clockSourceLocationType, m.clockSourceLocationIndex);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::MemoryObjectNodeStaticModel>& m)
+{
+	ar(m.localizedDescription, m.memoryObjectType, m.targetDescriptorType, m.targetDescriptorIndex, m.startAddress, m.maximumLength);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::LocaleNodeStaticModel>& m)
+{
+	ar(m.localeID, m.numberOfStringDescriptors, m.baseStringDescriptorIndex);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::StringsNodeStaticModel>& m)
+{
+	ar(m.strings);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::StreamPortNodeStaticModel>& m)
+{
+	ar(m.clockDomainIndex, m.portFlags, m.numberOfControls, m.baseControl, m.numberOfClusters, m.baseCluster, m.numberOfMaps, m.baseMap, m.hasDynamicAudioMap);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::AudioClusterNodeStaticModel>& m)
+{
+	ar(m.localizedDescription, m.signalType, m.signalIndex, m.signalOutput, m.pathLatency, m.blockLatency, m.channelCount, m.format);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::AudioMapNodeStaticModel>& m)
+{
+	ar(m.mappings);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::ClockDomainNodeStaticModel>& m)
+{
+	ar(m.localizedDescription, m.clockSources);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::ConfigurationNodeStaticModel>& m)
+{
+	ar(m.localizedDescription, m.descriptorCounts);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::EntityNodeStaticModel>& m)
+{
+	ar(m.vendorNameString, m.modelNameString);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::ConfigurationStaticTree>& m)
+{
+	ar(m.audioUnitStaticModels, m.streamInputStaticModels, m.streamOutputStaticModels, m.avbInterfaceStaticModels, m.clockSourceStaticModels, m.memoryObjectStaticModels, m.localeStaticModels, m.stringsStaticModels);
+	ar(m.streamPortInputStaticModels, m.streamPortOutputStaticModels, m.audioClusterStaticModels, m.audioMapStaticModels, m.clockDomainStaticModels);
+	ar(m.staticModel);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::EntityStaticTree>& m)
+{
+	ar(m.configurationStaticTrees, m.staticModel);
+}
+
+/* Dynamic model */
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::AudioUnitNodeDynamicModel>& m)
+{
+	ar(m.objectName, m.currentSamplingRate);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::StreamInputNodeDynamicModel>& m)
+{
+	ar(m.objectName, m.currentFormat, m.streamInfo, m.connectionState, m.counters);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::StreamOutputNodeDynamicModel>& m)
+{
+	ar(m.objectName, m.currentFormat, m.streamInfo, m.connections);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::AvbInterfaceNodeDynamicModel>& m)
+{
+	ar(m.objectName, m.avbInfo, m.counters);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::ClockSourceNodeDynamicModel>& m)
+{
+	ar(m.objectName, m.clockSourceFlags, m.clockSourceIdentifier);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::MemoryObjectNodeDynamicModel>& m)
+{
+	ar(m.objectName, m.length);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::StreamPortNodeDynamicModel>& m)
+{
+	ar(m.dynamicAudioMap);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::AudioClusterNodeDynamicModel>& m)
+{
+	ar(m.objectName);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::ClockDomainNodeDynamicModel>& m)
+{
+	ar(m.objectName, m.clockSourceIndex, m.counters);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::ConfigurationNodeDynamicModel>& m)
+{
+	ar(m.objectName, m.selectedLocaleBaseIndex, m.localizedStrings, m.isActiveConfiguration);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::EntityNodeDynamicModel>& m)
+{
+	ar(m.entityName, m.groupName, m.firmwareVersion, m.serialNumber, m.currentConfiguration);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::ConfigurationDynamicTree>& m)
+{
+	ar(m.audioUnitDynamicModels, m.streamInputDynamicModels, m.streamOutputDynamicModels, m.avbInterfaceDynamicModels, m.clockSourceDynamicModels, m.memoryObjectDynamicModels);
+	ar(m.streamPortInputDynamicModels, m.streamPortOutputDynamicModels, m.audioClusterDynamicModels, m.clockDomainDynamicModels);
+	ar(m.dynamicModel);
+}
+
+template<class Archive>
+void archive(Archive& ar, typename Archive::template Field<model::EntityDynamicTree>& m)
+{
+	ar(m.configurationDynamicTrees, m.dynamicModel);
+}
+
+} // namespace
+
+/* ************************************************************ */
+/* Public methods                                               */
+/* ************************************************************ */
+std::vector<std::uint8_t> serialize(std::vector<ControlledEntityImpl const*> const& entities) noexcept
+{
+	auto writer = Writer{};
+
+	writer(Magic, Version, static_cast<std::uint32_t>(entities.size()));
+
+	for (auto const* const controlledEntity : entities)
+	{
+		auto const& e = controlledEntity->getEntity();
+		auto const hasModel = hasFlag(e.getEntityCapabilities(), entity::EntityCapabilities::AemSupported);
+
+		// ADP information
+		writer(e.getEntityID(), e.getMacAddress(), e.getValidTime(), e.getEntityModelID(), e.getEntityCapabilities(), e.getTalkerStreamSources(), e.getTalkerCapabilities(), e.getListenerStreamSinks(), e.getListenerCapabilities(), e.getControllerCapabilities());
+		writer(e.getAvailableIndex(), e.getGptpGrandmasterID(), e.getGptpDomainNumber(), e.getIdentifyControlIndex(), e.getInterfaceIndex(), e.getAssociationID());
+
+		// Controller information
+		writer(controlledEntity->getCompatibility(), controlledEntity->getAcquireState(), controlledEntity->getOwningControllerID());
+
+		// Entity Model
+		writer(hasModel);
+		if (hasModel)
+		{
+			writer(controlledEntity->getEntityStaticTree(), controlledEntity->getEntityDynamicTree());
+		}
+	}
+
+	return std::move(writer.getBuffer());
+}
+
+std::pair<Controller::NetworkSnapshotError, ControlledEntities> deserialize(void const* const ptr, size_t const size) noexcept
+{
+	auto entities = ControlledEntities{};
+
+	try
+	{
+		auto reader = Reader{ ptr, size };
+
+		// Header
+		auto magic = std::uint32_t{ 0u };
+		auto version = std::uint16_t{ 0u };
+		auto count = std::uint32_t{ 0u };
+		reader(magic, version);
+		if (magic != Magic || version == 0u)
+		{
+			return std::make_pair(Controller::NetworkSnapshotError::InvalidFormat, ControlledEntities{});
+		}
+		if (version > Version)
+		{
+			return std::make_pair(Controller::NetworkSnapshotError::UnsupportedVersion, ControlledEntities{});
+		}
+		reader(count);
+
+		for (auto i = 0u; i < count; ++i)
+		{
+			// ADP information
+			auto entityID = UniqueIdentifier{};
+			auto macAddress = networkInterface::MacAddress{};
+			auto validTime = std::uint8_t{ 0u };
+			auto entityModelID = UniqueIdentifier{};
+			auto entityCapabilities = entity::EntityCapabilities::None;
+			auto talkerStreamSources = std::uint16_t{ 0u };
+			auto talkerCapabilities = entity::TalkerCapabilities::None;
+			auto listenerStreamSinks = std::uint16_t{ 0u };
+			auto listenerCapabilities = entity::ListenerCapabilities::None;
+			auto controllerCapabilities = entity::ControllerCapabilities::None;
+			auto availableIndex = std::uint32_t{ 0u };
+			auto gptpGrandmasterID = UniqueIdentifier{};
+			auto gptpDomainNumber = std::uint8_t{ 0u };
+			auto identifyControlIndex = std::uint16_t{ 0u };
+			auto interfaceIndex = std::uint16_t{ 0u };
+			auto associationID = UniqueIdentifier{};
+			reader(entityID, macAddress, validTime, entityModelID, entityCapabilities, talkerStreamSources, talkerCapabilities, listenerStreamSinks, listenerCapabilities, controllerCapabilities);
+			reader(availableIndex, gptpGrandmasterID, gptpDomainNumber, identifyControlIndex, interfaceIndex, associationID);
+
+			// Controller information
+			auto compatibility = ControlledEntity::Compatibility::IEEE17221;
+			auto acquireState = model::AcquireState::Undefined;
+			auto owningControllerID = UniqueIdentifier{};
+			reader(compatibility, acquireState, owningControllerID);
+
+			auto controlledEntity = std::make_shared<ControlledEntityImpl>(entity::DiscoveredEntity{ entityID, macAddress, validTime, entityModelID, entityCapabilities, talkerStreamSources, talkerCapabilities, listenerStreamSinks, listenerCapabilities, controllerCapabilities, availableIndex, gptpGrandmasterID, gptpDomainNumber, identifyControlIndex, interfaceIndex, associationID });
+			controlledEntity->setCompatibility(compatibility);
+			controlledEntity->setAcquireState(acquireState);
+			controlledEntity->setOwningController(owningControllerID);
+
+			// Entity Model
+			auto hasModel = false;
+			reader(hasModel);
+			if (hasModel)
+			{
+				reader(controlledEntity->getEntityStaticTree(), controlledEntity->getEntityDynamicTree());
+			}
+
+			entities.push_back(std::move(controlledEntity));
+		}
+
+		if (reader.remaining() != 0u)
+		{
+			return std::make_pair(Controller::NetworkSnapshotError::InvalidFormat, ControlledEntities{});
+		}
+	}
+	catch (std::invalid_argument const&)
+	{
+		return std::make_pair(Controller::NetworkSnapshotError::InvalidFormat, ControlledEntities{});
+	}
+	catch (...)
+	{
+		return std::make_pair(Controller::NetworkSnapshotError::InternalError, ControlledEntities{});
+	}
+
+	return std::make_pair(Controller::NetworkSnapshotError::NoError, std::move(entities));
+}
+
+} // namespace networkSnapshot
+} // namespace controller
+} // namespace avdecc
+} // namespace la
@@ -0,0 +1,61 @@
+/*
+* Copyright (C) 2016-2018, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be usefu_state,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file avdeccNetworkSnapshot.hpp
+* @author Christophe Calmejane
+*/
+
+#pragma once
+
+#include "la/avdecc/controller/avdeccController.hpp"
+#include "avdeccControlledEntityImpl.hpp"
+#include <vector>
+#include <memory>
+#include <utility>
+#include <cstdint>
+
+namespace la
+{
+namespace avdecc
+{
+namespace controller
+{
+/**
+* @brief Binary serialization of the state of ControlledEntities.
+* @details A network snapshot contains, for each entity, its ADP information, compatibility, acquire state and the whole static and dynamic models (including talker connections).
+*          All values are stored in network order, the file starting with a magic number and a format version (any change in the format must increment the version).
+*/
+namespace networkSnapshot
+{
+static constexpr std::uint32_t Magic = 0x41564E53; // 'AVNS'
+static constexpr std::uint16_t Version = 2; // 2: Localized strings stored as a table
+
+using ControlledEntities = std::vector<std::shared_ptr<ControlledEntityImpl>>;
+
+/** Serializes the specified entities. Entities must not be modified during the call (caller has to lock them). */
+std::vector<std::uint8_t> serialize(std::vector<ControlledEntityImpl const*> const& entities) noexcept;
+
+/** Deserializes entities from a buffer. Returned entities are not advertised, not stale and have no enumeration step set. */
+std::pair<Controller::NetworkSnapshotError, ControlledEntities> deserialize(void const* const ptr, size_t const size) noexcept;
+
+} // namespace networkSnapshot
+} // namespace controller
+} // namespace avdecc
+} // namespace la
@@ -0,0 +1,160 @@
+/*
+* Copyright (C) 2016-2018, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be usefu_state,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file avdeccOperationsBatchScheduler.hpp
+* @author Christophe Calmejane
+*/
+
+#pragma once
+
+#include "la/avdecc/internals/uniqueIdentifier.hpp"
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <chrono>
+#include <optional>
+#include <algorithm>
+#include <cstdint>
+
+namespace la
+{
+namespace avdecc
+{
+namespace controller
+{
+/**
+* @brief Scheduler of a batch of operations targeting many entities.
+* @details Decides which operation to send, and when. Not thread safe, and does not send anything itself: the owner calls popNextOperation
+*          until it returns nothing, sends the returned operations, then calls completeOperation when each of them completes.
+*          - At most maxInflightOperations operations are inflight at the same time
+*          - At most one operation is inflight per target entity, so operations targeting a same entity are sent in order
+*          - Target entities are served in a round-robin way, so a slow entity does not delay the others
+*/
+class OperationsBatchScheduler final
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	/** Constructs the scheduler from the target entity of each operation. */
+	OperationsBatchScheduler(std::vector<UniqueIdentifier> const& targetEntities, std::uint32_t const maxInflightOperations, Clock::time_point const now) noexcept
+		: _operationsCount(targetEntities.size())
+		, _maxInflightOperations(std::max(maxInflightOperations, std::uint32_t{ 1u }))
+		, _startTime(now)
+	{
+		_sendTimes.resize(_operationsCount);
+		_targetIndexes.resize(_operationsCount);
+
+		// Group operations per target entity, in the order of the batch
+		auto targetsIndexes = std::unordered_map<UniqueIdentifier, size_t, UniqueIdentifier::hash>{};
+		for (auto index = size_t{ 0u }; index < _operationsCount; ++index)
+		{
+			auto const targetIt = targetsIndexes.emplace(targetEntities[index], _targets.size()).first;
+			if (targetIt->second == _targets.size())
+			{
+				_targets.emplace_back(Target{ {}, false });
+			}
+			_targets[targetIt->second].pendingOperations.push_back(index);
+			_targetIndexes[index] = targetIt->second;
+		}
+	}
+
+	/** Returns the index of the next operation to send if the concurrency limits allow it. */
+	std::optional<size_t> popNextOperation(Clock::time_point const now) noexcept
+	{
+		if (_inflightOperations >= _maxInflightOperations)
+			return std::nullopt;
+
+		// Round-robin through targets with no inflight operation
+		for (auto count = size_t{ 0u }; count < _targets.size(); ++count)
+		{
+			auto& target = _targets[_nextTarget];
+			_nextTarget = (_nextTarget + 1u) % _targets.size();
+
+			if (target.isInflight || target.pendingOperations.empty())
+				continue;
+
+			auto const index = target.pendingOperations.front();
+			target.pendingOperations.pop_front();
+			target.isInflight = true;
+			++_inflightOperations;
+			_sendTimes[index] = now;
+			return index;
+		}
+
+		return std::nullopt;
+	}
+
+	/** Completes an operation previously returned by popNextOperation. Returns the duration of the operation. */
+	std::chrono::milliseconds completeOperation(size_t const index, Clock::time_point const now) noexcept
+	{
+		_targets[_targetIndexes[index]].isInflight = false;
+		--_inflightOperations;
+		++_completedOperations;
+
+		return std::chrono::duration_cast<std::chrono::milliseconds>(now - _sendTimes[index]);
+	}
+
+	bool isComplete() const noexcept
+	{
+		return _completedOperations == _operationsCount;
+	}
+
+	std::chrono::milliseconds getElapsedTime(Clock::time_point const now) const noexcept
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(now - _startTime);
+	}
+
+	size_t getInflightOperationsCount() const noexcept
+	{
+		return _inflightOperations;
+	}
+
+	size_t getCompletedOperationsCount() const noexcept
+	{
+		return _completedOperations;
+	}
+
+	// Deleted compiler auto-generated methods
+	OperationsBatchScheduler(OperationsBatchScheduler&&) = delete;
+	OperationsBatchScheduler(OperationsBatchScheduler const&) = delete;
+	OperationsBatchScheduler& operator=(OperationsBatchScheduler const&) = delete;
+	OperationsBatchScheduler& operator=(OperationsBatchScheduler&&) = delete;
+
+private:
+	struct Target
+	{
+		std::deque<size_t> pendingOperations{};
+		bool isInflight{ false };
+	};
+
+	size_t const _operationsCount{ 0u };
+	size_t const _maxInflightOperations{ 1u };
+	Clock::time_point const _startTime{};
+	std::vector<Target> _targets{};
+	size_t _nextTarget{ 0u };
+	size_t _inflightOperations{ 0u };
+	size_t _completedOperations{ 0u };
+	std::vector<size_t> _targetIndexes{}; // Index in _targets, for each operation
+	std::vector<Clock::time_point> _sendTimes{};
+};
+
+} // namespace controller
+} // namespace avdecc
+} // namespace la
@@ -0,0 +1,77 @@
+/*
+* Copyright (C) 2016-2018, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be usefu_state,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/**
+* @file dispatchTable.hpp
+* @author Christophe Calmejane
+*/
+
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <initializer_list>
+#include <algorithm>
+#include <cstddef>
+
+namespace la
+{
+namespace avdecc
+{
+/**
+* @brief Dense table of handlers, indexed by a message or command type value.
+* @details Looking up a handler is an array access (instead of hashing and walking a bucket), and Handler is expected to be a plain function pointer (captureless lambdas convert to it) so calling it is a direct call.
+*          The table is as large as the highest value it contains, only use it for small values.
+*/
+template<typename Value, typename Handler>
+class DispatchTable final
+{
+public:
+	DispatchTable(std::initializer_list<std::pair<Value, Handler>> const handlers)
+	{
+		auto maxValue = Value{ 0u };
+		for (auto const& handler : handlers)
+		{
+			maxValue = std::max(maxValue, handler.first);
+		}
+		_handlers.resize(static_cast<size_t>(maxValue) + 1u, nullptr);
+		for (auto const& handler : handlers)
+		{
+			_handlers[static_cast<size_t>(handler.first)] = handler.second;
+		}
+	}
+
+	/** Returns the handler for the specified value, nullptr if there is none */
+	Handler get(Value const value) const noexcept
+	{
+		auto const index = static_cast<size_t>(value);
+		if (index < _handlers.size())
+		{
+			return _handlers[index];
+		}
+		return nullptr;
+	}
+
+private:
+	std::vector<Handler> _handlers{};
+};
+
+} // namespace avdecc
+} // namespace la
@@ -45,6 +45,7 @@ public:
 
 	// EndStation overrides
 	virtual entity::ControllerEntity* addControllerEntity(std::uint16_t const progID, UniqueIdentifier const entityModelID, entity::ControllerEntity::Delegate* const delegate) override;
+	virtual entity::ControllerEntity* addControllerEntity(std::uint16_t const progID, UniqueIdentifier const entityModelID, entity::ControllerEntity::Delegate* const delegate, Clock const& clock) override;
 
 	/** Destroy method for COM-like interface */
 	virtual void destroy() noexcept override;
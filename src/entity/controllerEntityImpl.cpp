@@ -25,12 +25,12 @@
 #include "la/avdecc/utils.hpp"
 #include "logHelper.hpp"
 #include "controllerEntityImpl.hpp"
+#include "dispatchTable.hpp"
 #include "protocol/protocolAemPayloads.hpp"
 #include "protocol/protocolMvuPayloads.hpp"
 #include <exception>
 #include <cassert>
 #include <chrono>
-#include <unordered_map>
 #include <algorithm>
 
 namespace la
@@ -39,8 +39,8 @@ namespace avdecc
 {
 namespace entity
 {
-/** Delay (in milliseconds) between 2 DISCOVER message broadcast */
-constexpr int DISCOVER_SEND_DELAY = 10000;
+/** Default delay between 2 DISCOVER message broadcast */
+constexpr auto DiscoverSendDelay = std::chrono::milliseconds{ 10000 };
 
 static model::AudioMappings const s_emptyMappings{ 0 }; // Empty audio channel mappings used by timeout callback (needs a ref to an AudioMappings)
 static model::StreamInfo const s_emptyStreamInfo{}; // Empty stream info used by timeout callback (needs a ref to a StreamInfo)
@@ -85,32 +85,22 @@ private:
 /* ************************************************************************** */
 /* ControllerEntityImpl life cycle                                            */
 /* ************************************************************************** */
-ControllerEntityImpl::ControllerEntityImpl(protocol::ProtocolInterface* const protocolInterface, std::uint16_t const progID, UniqueIdentifier const entityModelID, ControllerEntity::Delegate* const delegate)
+ControllerEntityImpl::ControllerEntityImpl(protocol::ProtocolInterface* const protocolInterface, std::uint16_t const progID, UniqueIdentifier const entityModelID, ControllerEntity::Delegate* const delegate, Clock const& clock)
 	: LocalEntityImpl(protocolInterface, progID, entityModelID, EntityCapabilities::None, 0, TalkerCapabilities::None, 0, ListenerCapabilities::None, ControllerCapabilities::Implemented, 0, 0, UniqueIdentifier{})
 	, _delegate(delegate)
+	, _manualTimerService(clock.isManual() ? TimerService::create(clock) : nullptr)
+	, _timerService(_manualTimerService ? *_manualTimerService : TimerService::getInstance())
 {
 	// Register observer
 	getProtocolInterface()->registerObserver(this);
 
-	// Create the state machine thread
-	_discoveryThread = std::thread(
+	// Periodically discover remote entities, starting right now
+	_discoveryTimerID = _timerService.addTimer(DiscoverSendDelay, _timerService.getClock().now(),
 		[this]
 		{
-			setCurrentThreadName("avdecc::ControllerDiscovery");
-			while (!_shouldTerminate)
-			{
-				// Request a discovery
-				auto* pi = getProtocolInterface();
-				pi->discoverRemoteEntities();
-
-				// Wait few seconds before sending another one
-				std::chrono::time_point<std::chrono::system_clock> start{ std::chrono::system_clock::now() };
-				do
-				{
-					// Wait a little bit so we don't burn the CPU
-					std::this_thread::sleep_for(std::chrono::milliseconds(10));
-				} while (!_shouldTerminate && std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - start).count() <= DISCOVER_SEND_DELAY);
-			}
+			// Request a discovery
+			auto* pi = getProtocolInterface();
+			pi->discoverRemoteEntities();
 		});
 }
 
@@ -119,12 +109,13 @@ ControllerEntityImpl::~ControllerEntityImpl() noexcept
 	// Unregister ourself as a ProtocolInterface observer
 	invokeProtectedMethod(&protocol::ProtocolInterface::unregisterObserver, getProtocolInterface(), this);
 
-	// Notify the thread we are shutting down
-	_shouldTerminate = true;
+	// Stop the discovery timer (waiting for its handler to complete, if running)
+	_timerService.removeTimer(_discoveryTimerID);
+}
 
-	// Wait for the thread to complete its pending tasks
-	if (_discoveryThread.joinable())
-		_discoveryThread.join();
+void ControllerEntityImpl::AnswerCallback::logTypeMismatch() noexcept
+{
+	LOG_GENERIC_ERROR("AnswerCallback invoked with another handler type than the one it was constructed with, handler not called");
 }
 
 /* ************************************************************************** */
@@ -235,6 +226,10 @@ ControllerEntity::ControlStatus ControllerEntityImpl::convertErrorToControlStatu
 
 void ControllerEntityImpl::sendAemAecpCommand(UniqueIdentifier const targetEntityID, protocol::AemCommandType const commandType, void const* const payload, size_t const payloadLength, OnAemAECPErrorCallback const& onErrorCallback, AnswerCallback const& answerCallback) const noexcept
 {
+	// Handlers called synchronously (errors) must not send their own commands with the priority of this one
+	auto const priority = getThreadCommandPriority();
+	auto const priorityGuard = CommandPriorityGuard{ protocol::AecpCommandPriority::Interactive };
+
 	try
 	{
 		auto* pi = const_cast<ControllerEntityImpl*>(this)->getProtocolInterface();
@@ -279,20 +274,25 @@ void ControllerEntityImpl::sendAemAecpCommand(UniqueIdentifier const targetEntit
 		aem->setCommandType(commandType);
 		aem->setCommandSpecificData(payload, payloadLength);
 
+		// Keep the callbacks in the pool, so the result handler only captures an iterator (and doesn't allocate)
+		auto const callbacks = _aemCommandCallbacks.acquire(onErrorCallback, answerCallback);
 		auto const error = pi->sendAecpCommand(std::move(frame), targetMacAddress,
-			[onErrorCallback, answerCallback, this](protocol::Aecpdu const* const response, protocol::ProtocolInterface::Error const error) noexcept
+			[callbacks, this](protocol::Aecpdu const* const response, protocol::ProtocolInterface::Error const error) noexcept
 			{
 				if (!error)
 				{
-					processAemAecpResponse(response, onErrorCallback, answerCallback); // We sent an AEM command, we know it's an AEM response (so directly call processAemAecpResponse)
+					processAemAecpResponse(response, callbacks->onErrorCallback, callbacks->answerCallback); // We sent an AEM command, we know it's an AEM response (so directly call processAemAecpResponse)
 				}
 				else
 				{
-					invokeProtectedHandler(onErrorCallback, convertErrorToAemCommandStatus(error));
+					invokeProtectedHandler(callbacks->onErrorCallback, convertErrorToAemCommandStatus(error));
 				}
-			});
+				_aemCommandCallbacks.release(callbacks);
+			},
+			priority);
 		if (!!error)
 		{
+			_aemCommandCallbacks.release(callbacks);
 			invokeProtectedHandler(onErrorCallback, convertErrorToAemCommandStatus(error));
 		}
 	}
@@ -308,6 +308,10 @@ void ControllerEntityImpl::sendAemAecpCommand(UniqueIdentifier const targetEntit
 
 void ControllerEntityImpl::sendAaAecpCommand(UniqueIdentifier const targetEntityID, addressAccess::Tlvs const& tlvs, OnAaAECPErrorCallback const& onErrorCallback, AnswerCallback const& answerCallback) const noexcept
 {
+	// Handlers called synchronously (errors) must not send their own commands with the priority of this one
+	auto const priority = getThreadCommandPriority();
+	auto const priorityGuard = CommandPriorityGuard{ protocol::AecpCommandPriority::Interactive };
+
 	try
 	{
 		auto* pi = const_cast<ControllerEntityImpl*>(this)->getProtocolInterface();
@@ -353,20 +357,25 @@ void ControllerEntityImpl::sendAaAecpCommand(UniqueIdentifier const targetEntity
 			aa->addTlv(tlv);
 		}
 
+		// Keep the callbacks in the pool, so the result handler only captures an iterator (and doesn't allocate)
+		auto const callbacks = _aaCommandCallbacks.acquire(onErrorCallback, answerCallback);
 		auto const error = pi->sendAecpCommand(std::move(frame), targetMacAddress,
-			[onErrorCallback, answerCallback, this](protocol::Aecpdu const* const response, protocol::ProtocolInterface::Error const error) noexcept
+			[callbacks, this](protocol::Aecpdu const* const response, protocol::ProtocolInterface::Error const error) noexcept
 			{
 				if (!error)
 				{
-					processAaAecpResponse(response, onErrorCallback, answerCallback); // We sent an Address Access command, we know it's an Address Access response (so directly call processAaAecpResponse)
+					processAaAecpResponse(response, callbacks->onErrorCallback, callbacks->answerCallback); // We sent an Address Access command, we know it's an Address Access response (so directly call processAaAecpResponse)
 				}
 				else
 				{
-					invokeProtectedHandler(onErrorCallback, convertErrorToAaCommandStatus(error));
+					invokeProtectedHandler(callbacks->onErrorCallback, convertErrorToAaCommandStatus(error));
 				}
-			});
+				_aaCommandCallbacks.release(callbacks);
+			},
+			priority);
 		if (!!error)
 		{
+			_aaCommandCallbacks.release(callbacks);
 			invokeProtectedHandler(onErrorCallback, convertErrorToAaCommandStatus(error));
 		}
 	}
@@ -382,6 +391,10 @@ void ControllerEntityImpl::sendAaAecpCommand(UniqueIdentifier const targetEntity
 
 void ControllerEntityImpl::sendMvuAecpCommand(UniqueIdentifier const targetEntityID, protocol::MvuCommandType const commandType, void const* const payload, size_t const payloadLength, OnMvuAECPErrorCallback const& onErrorCallback, AnswerCallback const& answerCallback) const noexcept
 {
+	// Handlers called synchronously (errors) must not send their own commands with the priority of this one
+	auto const priority = getThreadCommandPriority();
+	auto const priorityGuard = CommandPriorityGuard{ protocol::AecpCommandPriority::Interactive };
+
 	try
 	{
 		auto* pi = const_cast<ControllerEntityImpl*>(this)->getProtocolInterface();
@@ -425,20 +438,25 @@ void ControllerEntityImpl::sendMvuAecpCommand(UniqueIdentifier const targetEntit
 		mvu->setCommandType(commandType);
 		mvu->setCommandSpecificData(payload, payloadLength);
 
+		// Keep the callbacks in the pool, so the result handler only captures an iterator (and doesn't allocate)
+		auto const callbacks = _mvuCommandCallbacks.acquire(onErrorCallback, answerCallback);
 		auto const error = pi->sendAecpCommand(std::move(frame), targetMacAddress,
-			[onErrorCallback, answerCallback, this](protocol::Aecpdu const* const response, protocol::ProtocolInterface::Error const error) noexcept
+			[callbacks, this](protocol::Aecpdu const* const response, protocol::ProtocolInterface::Error const error) noexcept
 			{
 				if (!error)
 				{
-					processMvuAecpResponse(response, onErrorCallback, answerCallback); // We sent an MVU command, we know it's an MVU response (so directly call processMvuAecpResponse)
+					processMvuAecpResponse(response, callbacks->onErrorCallback, callbacks->answerCallback); // We sent an MVU command, we know it's an MVU response (so directly call processMvuAecpResponse)
 				}
 				else
 				{
-					invokeProtectedHandler(onErrorCallback, convertErrorToMvuCommandStatus(error));
+					invokeProtectedHandler(callbacks->onErrorCallback, convertErrorToMvuCommandStatus(error));
 				}
-			});
+				_mvuCommandCallbacks.release(callbacks);
+			},
+			priority);
 		if (!!error)
 		{
+			_mvuCommandCallbacks.release(callbacks);
 			invokeProtectedHandler(onErrorCallback, convertErrorToMvuCommandStatus(error));
 		}
 	}
@@ -518,20 +536,24 @@ void ControllerEntityImpl::sendAcmpCommand(protocol::AcmpMessageType const messa
 		acmp->setFlags(ConnectionFlags::None);
 		acmp->setStreamVlanID(0);
 
+		// Keep the callbacks in the pool, so the result handler only captures an iterator (and doesn't allocate)
+		auto const callbacks = _acmpCommandCallbacks.acquire(onErrorCallback, answerCallback);
 		auto const error = pi->sendAcmpCommand(std::move(frame),
-			[onErrorCallback, answerCallback, this](protocol::Acmpdu const* const response, protocol::ProtocolInterface::Error const error) noexcept
+			[callbacks, this](protocol::Acmpdu const* const response, protocol::ProtocolInterface::Error const error) noexcept
 			{
 				if (!error)
 				{
-					processAcmpResponse(response, onErrorCallback, answerCallback, false);
+					processAcmpResponse(response, callbacks->onErrorCallback, callbacks->answerCallback, false);
 				}
 				else
 				{
-					invokeProtectedHandler(onErrorCallback, convertErrorToControlStatus(error));
+					invokeProtectedHandler(callbacks->onErrorCallback, convertErrorToControlStatus(error));
 				}
+				_acmpCommandCallbacks.release(callbacks);
 			});
 		if (!!error)
 		{
+			_acmpCommandCallbacks.release(callbacks);
 			invokeProtectedHandler(onErrorCallback, convertErrorToControlStatus(error));
 		}
 	}
@@ -550,7 +572,7 @@ void ControllerEntityImpl::processAemAecpResponse(protocol::Aecpdu const* const
 	auto const& aem = static_cast<protocol::AemAecpdu const&>(*response);
 	auto const status = static_cast<AemCommandStatus>(aem.getStatus().getValue()); // We have to convert protocol status to our extended status
 
-	static std::unordered_map<protocol::AemCommandType::value_type, std::function<void(ControllerEntityImpl const* const controller, AemCommandStatus const status, protocol::AemAecpdu const& aem, AnswerCallback const& answerCallback)>> s_Dispatch
+	static DispatchTable<protocol::AemCommandType::value_type, void (*)(ControllerEntityImpl const* const controller, AemCommandStatus const status, protocol::AemAecpdu const& aem, AnswerCallback const& answerCallback)> const s_Dispatch
 	{
 		// Acquire Entity
 		{ protocol::AemCommandType::AcquireEntity.getValue(), [](ControllerEntityImpl const* const controller, AemCommandStatus const status, protocol::AemAecpdu const& aem, AnswerCallback const& answerCallback)
@@ -1868,8 +1890,8 @@ void ControllerEntityImpl::processAemAecpResponse(protocol::Aecpdu const* const
 		// Get Stream Backup
 	};
 
-	auto const& it = s_Dispatch.find(aem.getCommandType().getValue());
-	if (it == s_Dispatch.end())
+	auto const handler = s_Dispatch.get(aem.getCommandType().getValue());
+	if (!handler)
 	{
 		// If this is an unsolicited notification, simply log we do not handle the message
 		if (aem.getUnsolicited())
@@ -1905,7 +1927,7 @@ void ControllerEntityImpl::processAemAecpResponse(protocol::Aecpdu const* const
 
 		try
 		{
-			it->second(this, status, aem, answerCallback);
+			handler(this, status, aem, answerCallback);
 		}
 		catch (protocol::aemPayload::IncorrectPayloadSizeException const& e)
 		{
@@ -1940,7 +1962,7 @@ void ControllerEntityImpl::processMvuAecpResponse(protocol::Aecpdu const* const
 	auto const& mvu = static_cast<protocol::MvuAecpdu const&>(*response);
 	auto const status = static_cast<MvuCommandStatus>(mvu.getStatus().getValue()); // We have to convert protocol status to our extended status
 
-	static std::unordered_map<protocol::MvuCommandType::value_type, std::function<void(ControllerEntityImpl const* const controller, MvuCommandStatus const status, protocol::MvuAecpdu const& mvu, AnswerCallback const& answerCallback)>> s_Dispatch{
+	static DispatchTable<protocol::MvuCommandType::value_type, void (*)(ControllerEntityImpl const* const controller, MvuCommandStatus const status, protocol::MvuAecpdu const& mvu, AnswerCallback const& answerCallback)> const s_Dispatch{
 		// Get Milan Info
 		{ protocol::MvuCommandType::GetMilanInfo.getValue(),
 			[](ControllerEntityImpl const* const controller, MvuCommandStatus const status, protocol::MvuAecpdu const& mvu, AnswerCallback const& answerCallback)
@@ -1962,8 +1984,8 @@ void ControllerEntityImpl::processMvuAecpResponse(protocol::Aecpdu const* const
 			} },
 	};
 
-	auto const& it = s_Dispatch.find(mvu.getCommandType().getValue());
-	if (it == s_Dispatch.end())
+	auto const handler = s_Dispatch.get(mvu.getCommandType().getValue());
+	if (!handler)
 	{
 		// It's an expected response, this is an internal error since we sent a command and didn't implement the code to handle the response
 		LOG_CONTROLLER_ENTITY_ERROR(mvu.getTargetEntityID(), "Failed to process MVU response: Unhandled command type {} ({})", std::string(mvu.getCommandType()), toHexString(mvu.getCommandType().getValue()));
@@ -1973,7 +1995,7 @@ void ControllerEntityImpl::processMvuAecpResponse(protocol::Aecpdu const* const
 	{
 		try
 		{
-			it->second(this, status, mvu, answerCallback);
+			handler(this, status, mvu, answerCallback);
 		}
 		catch ([[maybe_unused]] protocol::mvuPayload::IncorrectPayloadSizeException const& e)
 		{
@@ -2001,7 +2023,7 @@ void ControllerEntityImpl::processAcmpResponse(protocol::Acmpdu const* const res
 	auto const& acmp = static_cast<protocol::Acmpdu const&>(*response);
 	auto const status = static_cast<ControllerEntity::ControlStatus>(acmp.getStatus().getValue()); // We have to convert protocol status to our extended status
 
-	static std::unordered_map<protocol::AcmpMessageType::value_type, std::function<void(ControllerEntityImpl const* const controller, ControllerEntity::ControlStatus const status, protocol::Acmpdu const& acmp, AnswerCallback const& answerCallback, bool const sniffed)>> s_Dispatch{
+	static DispatchTable<protocol::AcmpMessageType::value_type, void (*)(ControllerEntityImpl const* const controller, ControllerEntity::ControlStatus const status, protocol::Acmpdu const& acmp, AnswerCallback const& answerCallback, bool const sniffed)> const s_Dispatch{
 		// Connect TX response
 		{ protocol::AcmpMessageType::ConnectTxResponse.getValue(),
 			[](ControllerEntityImpl const* const controller, ControllerEntity::ControlStatus const status, protocol::Acmpdu const& acmp, AnswerCallback const& /*answerCallback*/, bool const sniffed)
@@ -2117,8 +2139,8 @@ void ControllerEntityImpl::processAcmpResponse(protocol::Acmpdu const* const res
 			} },
 	};
 
-	auto const& it = s_Dispatch.find(acmp.getMessageType().getValue());
-	if (it == s_Dispatch.end())
+	auto const handler = s_Dispatch.get(acmp.getMessageType().getValue());
+	if (!handler)
 	{
 		// If this is a sniffed message, simply log we do not handle the message
 		if (sniffed)
@@ -2136,7 +2158,7 @@ void ControllerEntityImpl::processAcmpResponse(protocol::Acmpdu const* const res
 	{
 		try
 		{
-			it->second(this, status, acmp, answerCallback, sniffed);
+			handler(this, status, acmp, answerCallback, sniffed);
 		}
 		catch (ControlException const& e)
 		{
@@ -2158,6 +2180,21 @@ void ControllerEntityImpl::processAcmpResponse(protocol::Acmpdu const* const res
 /* ControllerEntity overrides                                                 */
 /* ************************************************************************** */
 /* Discovery Protocol (ADP) */
+void ControllerEntityImpl::setAutomaticDiscoveryDelay(std::chrono::milliseconds const delay) noexcept
+{
+	_timerService.setTimerPeriod(_discoveryTimerID, delay);
+}
+
+void ControllerEntityImpl::discoverRemoteEntities() noexcept
+{
+	// Broadcast from the timer thread (or the next checkTimers for a manual clock), restarting the delay
+	_timerService.triggerTimer(_discoveryTimerID);
+}
+
+void ControllerEntityImpl::checkTimers() noexcept
+{
+	_timerService.checkTimers();
+}
 
 /* Enumeration and Control Protocol (AECP) AEM */
 void ControllerEntityImpl::acquireEntity(UniqueIdentifier const targetEntityID, bool const isPersistent, model::DescriptorType const descriptorType, model::DescriptorIndex const descriptorIndex, AcquireEntityHandler const& handler) const noexcept
@@ -3463,6 +3500,16 @@ void ControllerEntityImpl::setDelegate(Delegate* const delegate) noexcept
 	_delegate = delegate;
 }
 
+protocol::AecpCommandsStatistics ControllerEntityImpl::getAecpCommandsStatistics() const noexcept
+{
+	return getProtocolInterface()->getAecpCommandsStatistics();
+}
+
+size_t ControllerEntityImpl::getStateMachineMemoryFootprint() const noexcept
+{
+	return getProtocolInterface()->getStateMachineMemoryFootprint();
+}
+
 ControllerEntityImpl::Delegate* ControllerEntityImpl::getDelegate() const noexcept
 {
 	return _delegate;
@@ -3573,7 +3620,7 @@ void ControllerEntityImpl::onAecpCommand(protocol::ProtocolInterface* const /*pi
 		if (controllerID == selfID)
 			return;
 
-		static std::unordered_map<protocol::AemCommandType::value_type, std::function<void(ControllerEntityImpl const* const controller, protocol::AemAecpdu const& aem)>> s_Dispatch{
+		static DispatchTable<protocol::AemCommandType::value_type, void (*)(ControllerEntityImpl const* const controller, protocol::AemAecpdu const& aem)> const s_Dispatch{
 			// Entity Available
 			{ protocol::AemCommandType::EntityAvailable.getValue(),
 				[](ControllerEntityImpl const* const controller, protocol::AemAecpdu const& aem)
@@ -3590,10 +3637,10 @@ void ControllerEntityImpl::onAecpCommand(protocol::ProtocolInterface* const /*pi
 				} },
 		};
 
-		auto const& it = s_Dispatch.find(aem.getCommandType().getValue());
-		if (it != s_Dispatch.end())
+		auto const handler = s_Dispatch.get(aem.getCommandType().getValue());
+		if (handler)
 		{
-			invokeProtectedHandler(it->second, this, aem);
+			invokeProtectedHandler(handler, this, aem);
 		}
 		else
 		{
@@ -3630,6 +3677,18 @@ void ControllerEntityImpl::onAcmpSniffedResponse(protocol::ProtocolInterface* co
 /* ************************************************************************** */
 /* Utility methods                                                            */
 /* ************************************************************************** */
+static thread_local protocol::AecpCommandPriority s_threadCommandPriority{ protocol::AecpCommandPriority::Interactive }; // Priority of the AECP commands sent by the current thread
+
+void LA_AVDECC_CALL_CONVENTION ControllerEntity::setThreadCommandPriority(protocol::AecpCommandPriority const priority) noexcept
+{
+	s_threadCommandPriority = priority;
+}
+
+protocol::AecpCommandPriority LA_AVDECC_CALL_CONVENTION ControllerEntity::getThreadCommandPriority() noexcept
+{
+	return s_threadCommandPriority;
+}
+
 std::string LA_AVDECC_CALL_CONVENTION ControllerEntity::statusToString(ControllerEntity::AemCommandStatus const status)
 {
 	switch (status)
@@ -30,10 +30,17 @@
 #include "la/avdecc/internals/protocolAaAecpdu.hpp"
 #include "la/avdecc/internals/protocolMvuAecpdu.hpp"
 #include "entityImpl.hpp"
+#include "timerService.hpp"
+#include "smallFunction.hpp"
 #include <unordered_map>
 #include <functional>
-#include <thread>
+#include <chrono>
 #include <mutex>
+#include <memory>
+#include <vector>
+#include <list>
+#include <new>
+#include <type_traits>
 
 namespace la
 {
@@ -52,44 +59,228 @@ private:
 	/* ************************************************************************** */
 	/* ControllerEntityImpl life cycle                                            */
 	/* ************************************************************************** */
-	ControllerEntityImpl(protocol::ProtocolInterface* const protocolInterface, std::uint16_t const progID, UniqueIdentifier const entityModelID, ControllerEntity::Delegate* const delegate);
+	ControllerEntityImpl(protocol::ProtocolInterface* const protocolInterface, std::uint16_t const progID, UniqueIdentifier const entityModelID, ControllerEntity::Delegate* const delegate, Clock const& clock); // Automatic discovery is based on clock, which must outlive the entity
 	~ControllerEntityImpl() noexcept;
 
 private:
-	struct AnswerCallback
+	/**
+	* @brief Result handler of a command, stored with its actual type.
+	* @details The handler (a std::function of any signature) is stored inline, along with its type. Invoking it with another handler type than the one it was constructed with is a programming error: it asserts, logs and does nothing.
+	*/
+	class AnswerCallback
 	{
-		using Callback = std::function<void()>;
-		Callback onAnswer{ nullptr };
+	public:
 		// Constructors
-		AnswerCallback() = default;
-		template<typename T>
-		AnswerCallback(T const& f)
-			: onAnswer(reinterpret_cast<Callback const&>(f))
+		AnswerCallback() noexcept = default;
+		template<typename T, typename = std::enable_if_t<!std::is_same<T, AnswerCallback>::value>>
+		AnswerCallback(T const& handler)
+		{
+			static_assert(sizeof(T) <= sizeof(Storage) && alignof(Storage) % alignof(T) == 0 && std::is_nothrow_move_constructible<T>::value, "Handler cannot be stored in AnswerCallback");
+			if (handler)
+			{
+				new (&_storage) T(handler);
+				_ops = &Ops<T>::Table;
+			}
+		}
+		AnswerCallback(AnswerCallback const& other)
+		{
+			if (other._ops)
+			{
+				other._ops->copy(&_storage, &other._storage);
+				_ops = other._ops;
+			}
+		}
+		AnswerCallback(AnswerCallback&& other) noexcept
+		{
+			moveFrom(other);
+		}
+		~AnswerCallback() noexcept
+		{
+			reset();
+		}
+		AnswerCallback& operator=(AnswerCallback const& other)
+		{
+			if (this != &other)
+			{
+				// Copy first so we are left untouched if it throws
+				auto copy = AnswerCallback{ other };
+				reset();
+				moveFrom(copy);
+			}
+			return *this;
+		}
+		AnswerCallback& operator=(AnswerCallback&& other) noexcept
 		{
+			if (this != &other)
+			{
+				reset();
+				moveFrom(other);
+			}
+			return *this;
 		}
+
 		// Call operator
 		template<typename T, typename... Ts>
 		void invoke(Ts&&... params) const noexcept
 		{
-			if (onAnswer)
+			// No handler
+			if (!_ops)
+				return;
+			// Not the handler expected by the response (sent command and received response do not match)
+			if (_ops != &Ops<T>::Table)
+			{
+				AVDECC_ASSERT(false, "AnswerCallback invoked with another handler type than the one it was constructed with");
+				logTypeMismatch();
+				return;
+			}
+			try
+			{
+				(*std::launder(reinterpret_cast<T const*>(&_storage)))(std::forward<Ts>(params)...);
+			}
+			catch (...)
+			{
+				// Ignore throws in user handler
+			}
+		}
+
+	private:
+		static void logTypeMismatch() noexcept;
+
+		// All handlers are std::function, which have the same size whatever their signature
+		using Storage = std::aligned_storage_t<sizeof(std::function<void()>), alignof(std::function<void()>)>;
+
+		struct OpsTable
+		{
+			void (*copy)(void* dest, void const* source);
+			void (*move)(void* dest, void* source) noexcept;
+			void (*destroy)(void* storage) noexcept;
+		};
+
+		template<typename T>
+		struct Ops
+		{
+			static void copy(void* dest, void const* source)
+			{
+				new (dest) T(*std::launder(static_cast<T const*>(source)));
+			}
+			static void move(void* dest, void* source) noexcept
+			{
+				auto* const sourceHandler = std::launder(static_cast<T*>(source));
+				new (dest) T(std::move(*sourceHandler));
+				sourceHandler->~T();
+			}
+			static void destroy(void* storage) noexcept
+			{
+				std::launder(static_cast<T*>(storage))->~T();
+			}
+			static constexpr OpsTable Table{ &copy, &move, &destroy };
+		};
+
+		void moveFrom(AnswerCallback& other) noexcept
+		{
+			if (other._ops)
 			{
-				try
+				other._ops->move(&_storage, &other._storage);
+				_ops = other._ops;
+				other._ops = nullptr;
+			}
+		}
+		void reset() noexcept
+		{
+			if (_ops)
+			{
+				_ops->destroy(&_storage);
+				_ops = nullptr;
+			}
+		}
+
+		Storage _storage;
+		OpsTable const* _ops{ nullptr }; // Identifies the type of the stored handler
+	};
+
+	using DiscoveredEntities = std::unordered_map<UniqueIdentifier, DiscoveredEntity, UniqueIdentifier::hash>;
+	// Error handlers are bound to the user handler (a std::function) and the command parameters, make sure the most common ones do not allocate
+	static constexpr size_t ErrorCallbackInlineSize = 12 * sizeof(void*);
+	using OnAemAECPErrorCallback = SmallFunction<void(ControllerEntity::AemCommandStatus const error), ErrorCallbackInlineSize>;
+	using OnAaAECPErrorCallback = SmallFunction<void(ControllerEntity::AaCommandStatus const error), ErrorCallbackInlineSize>;
+	using OnMvuAECPErrorCallback = SmallFunction<void(ControllerEntity::MvuCommandStatus const error), ErrorCallbackInlineSize>;
+	using OnACMPErrorCallback = SmallFunction<void(ControllerEntity::ControlStatus const error), ErrorCallbackInlineSize>;
+
+	/** Callbacks of an inflight command */
+	template<typename ErrorCallback>
+	struct CommandCallbacks
+	{
+		ErrorCallback onErrorCallback{};
+		AnswerCallback answerCallback{};
+	};
+
+	/**
+	* @brief Pool of CommandCallbacks.
+	* @details The result handler given to the ProtocolInterface only captures an iterator to pooled callbacks, so it fits std::function's inline storage.
+	*          Callbacks are list nodes moved between the inflight and available lists, only allocated when no released node is available.
+	*/
+	template<typename ErrorCallback>
+	class CommandCallbacksPool
+	{
+	public:
+		static constexpr size_t MaxAvailableCallbacks = 256; // Maximum number of list nodes kept for reuse, so a burst of commands doesn't keep its memory forever
+
+		using Callbacks = CommandCallbacks<ErrorCallback>;
+		using CallbacksList = std::list<Callbacks>;
+		using Handle = typename CallbacksList::iterator;
+
+		Handle acquire(ErrorCallback const& onErrorCallback, AnswerCallback const& answerCallback)
+		{
+			auto callbacks = Handle{};
+			{
+				// Lock to protect the pool
+				std::lock_guard<decltype(_lock)> const lg(_lock);
+
+				if (_available.empty())
 				{
-					reinterpret_cast<T const&>(onAnswer)(std::forward<Ts>(params)...);
+					_inflight.emplace_front();
 				}
-				catch (...)
+				else
 				{
-					// Ignore throws in user handler
+					_inflight.splice(_inflight.begin(), _available, _available.begin());
 				}
+				callbacks = _inflight.begin();
+			}
+
+			try
+			{
+				callbacks->onErrorCallback = onErrorCallback;
+				callbacks->answerCallback = answerCallback;
+			}
+			catch (...)
+			{
+				release(callbacks);
+				throw;
 			}
+			return callbacks;
 		}
-	};
 
-	using DiscoveredEntities = std::unordered_map<UniqueIdentifier, DiscoveredEntity, UniqueIdentifier::hash>;
-	using OnAemAECPErrorCallback = std::function<void(ControllerEntity::AemCommandStatus const error)>;
-	using OnAaAECPErrorCallback = std::function<void(ControllerEntity::AaCommandStatus const error)>;
-	using OnMvuAECPErrorCallback = std::function<void(ControllerEntity::MvuCommandStatus const error)>;
-	using OnACMPErrorCallback = std::function<void(ControllerEntity::ControlStatus const error)>;
+		void release(Handle const callbacks) noexcept
+		{
+			// Release captured data outside the lock
+			callbacks->onErrorCallback = nullptr;
+			callbacks->answerCallback = {};
+
+			// Lock to protect the pool
+			std::lock_guard<decltype(_lock)> const lg(_lock);
+			if (_available.size() >= MaxAvailableCallbacks)
+			{
+				_inflight.erase(callbacks);
+				return;
+			}
+			_available.splice(_available.begin(), _inflight, callbacks);
+		}
+
+	private:
+		std::mutex _lock{};
+		CallbacksList _inflight{};
+		CallbacksList _available{};
+	};
 
 	/* ************************************************************************** */
 	/* ControllerEntityImpl internal methods                                      */
@@ -153,6 +344,9 @@ private:
 	/* ControllerEntity overrides                                                 */
 	/* ************************************************************************** */
 	/* Discovery Protocol (ADP) */
+	virtual void setAutomaticDiscoveryDelay(std::chrono::milliseconds const delay) noexcept override;
+	virtual void discoverRemoteEntities() noexcept override;
+	virtual void checkTimers() noexcept override;
 	/* Enumeration and Control Protocol (AECP) AEM */
 	virtual void acquireEntity(UniqueIdentifier const targetEntityID, bool const isPersistent, model::DescriptorType const descriptorType, model::DescriptorIndex const descriptorIndex, AcquireEntityHandler const& handler) const noexcept override;
 	virtual void releaseEntity(UniqueIdentifier const targetEntityID, model::DescriptorType const descriptorType, model::DescriptorIndex const descriptorIndex, ReleaseEntityHandler const& handler) const noexcept override;
@@ -251,6 +445,8 @@ private:
 	virtual void getTalkerStreamConnection(model::StreamIdentification const& talkerStream, uint16_t const connectionIndex, GetTalkerStreamConnectionHandler const& handler) const noexcept override;
 	/* Other methods */
 	virtual void setDelegate(Delegate* const delegate) noexcept override;
+	virtual protocol::AecpCommandsStatistics getAecpCommandsStatistics() const noexcept override;
+	virtual size_t getStateMachineMemoryFootprint() const noexcept override;
 	Delegate* getDelegate() const noexcept;
 
 	/* ************************************************************************** */
@@ -276,9 +472,14 @@ private:
 	/* Internal variables                                                         */
 	/* ************************************************************************** */
 	ControllerEntity::Delegate* _delegate{ nullptr };
-	bool _shouldTerminate{ false };
 	DiscoveredEntities _discoveredEntities{};
-	std::thread _discoveryThread{};
+	std::unique_ptr<TimerService> _manualTimerService{}; // Only created for a manual clock, driven by checkTimers
+	TimerService& _timerService;
+	TimerService::TimerID _discoveryTimerID{ TimerService::InvalidTimerID };
+	mutable CommandCallbacksPool<OnAemAECPErrorCallback> _aemCommandCallbacks{};
+	mutable CommandCallbacksPool<OnAaAECPErrorCallback> _aaCommandCallbacks{};
+	mutable CommandCallbacksPool<OnMvuAECPErrorCallback> _mvuCommandCallbacks{};
+	mutable CommandCallbacksPool<OnACMPErrorCallback> _acmpCommandCallbacks{};
 };
 
 } // namespace entity
@@ -27,6 +27,7 @@
 #include "la/avdecc/internals/entity.hpp"
 #include "la/avdecc/internals/entityModel.hpp"
 #include "la/avdecc/internals/protocolInterface.hpp"
+#include "la/avdecc/internals/clock.hpp"
 #include <cstdint>
 #include <thread>
 #include <sstream>
@@ -186,8 +187,8 @@ template<class SuperClass>
 class LocalEntityGuard final : public SuperClass
 {
 public:
-	LocalEntityGuard(protocol::ProtocolInterface* const protocolInterface, std::uint16_t const progID, UniqueIdentifier const entityModelID, ControllerEntity::Delegate* const delegate)
-		: SuperClass(protocolInterface, progID, entityModelID, delegate)
+	LocalEntityGuard(protocol::ProtocolInterface* const protocolInterface, std::uint16_t const progID, UniqueIdentifier const entityModelID, ControllerEntity::Delegate* const delegate, Clock const& clock = Clock::getDefaultClock())
+		: SuperClass(protocolInterface, progID, entityModelID, delegate, clock)
 	{
 	}
 	~LocalEntityGuard() noexcept
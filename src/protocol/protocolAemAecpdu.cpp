@@ -26,6 +26,9 @@
 #include "logHelper.hpp"
 #include <cassert>
 #include <string>
+#include <vector>
+#include <mutex>
+#include <new>
 
 namespace la
 {
@@ -33,6 +36,79 @@ namespace avdecc
 {
 namespace protocol
 {
+/***********************************************************/
+/* AemAecpdu storage pool                                  */
+/***********************************************************/
+namespace
+{
+/** Keeps the storage of destroyed AemAecpdus, so the ones created for each sent command (or copied) do not hit the heap */
+class AemAecpduPool final
+{
+public:
+	static constexpr size_t MaxAvailableStorages = 64;
+
+	static AemAecpduPool& getInstance() noexcept
+	{
+		// Never destroyed, AemAecpdus may still be released during static destruction (and the kept storages are freed by the OS)
+		static auto* const s_Instance = new AemAecpduPool{};
+		return *s_Instance;
+	}
+
+	void* acquire()
+	{
+		{
+			// Lock to protect the pool
+			std::lock_guard<decltype(_lock)> const lg(_lock);
+
+			if (!_storages.empty())
+			{
+				auto* const storage = _storages.back();
+				_storages.pop_back();
+				return storage;
+			}
+		}
+		return ::operator new(sizeof(AemAecpdu));
+	}
+
+	void release(void* const storage) noexcept
+	{
+		{
+			// Lock to protect the pool
+			std::lock_guard<decltype(_lock)> const lg(_lock);
+
+			if (_storages.size() < MaxAvailableStorages)
+			{
+				_storages.push_back(storage);
+				return;
+			}
+		}
+		::operator delete(storage);
+	}
+
+	// Deleted compiler auto-generated methods
+	AemAecpduPool(AemAecpduPool&&) = delete;
+	AemAecpduPool(AemAecpduPool const&) = delete;
+	AemAecpduPool& operator=(AemAecpduPool const&) = delete;
+	AemAecpduPool& operator=(AemAecpduPool&&) = delete;
+
+private:
+	AemAecpduPool() noexcept
+	{
+		try
+		{
+			_storages.reserve(MaxAvailableStorages);
+		}
+		catch (...)
+		{
+		}
+	}
+
+	std::mutex _lock{};
+	std::vector<void*> _storages{};
+};
+
+} // namespace
+
 /***********************************************************/
 /* AemAecpdu class definition                              */
 /***********************************************************/
@@ -171,19 +247,32 @@ Aecpdu::UniquePointer LA_AVDECC_CALL_CONVENTION AemAecpdu::copy() const
 	{
 		static_cast<AemAecpdu*>(self)->destroy();
 	};
-	return UniquePointer(new AemAecpdu(*this), deleter);
+	auto& pool = AemAecpduPool::getInstance();
+	auto* const storage = pool.acquire();
+	try
+	{
+		return UniquePointer(new (storage) AemAecpdu(*this), deleter);
+	}
+	catch (...)
+	{
+		pool.release(storage);
+		throw;
+	}
 }
 
 /** Entry point */
 AemAecpdu* LA_AVDECC_CALL_CONVENTION AemAecpdu::createRawAemAecpdu()
 {
-	return new AemAecpdu();
+	// Constructor is noexcept, no need to protect the storage
+	return new (AemAecpduPool::getInstance().acquire()) AemAecpdu();
 }
 
 /** Destroy method for COM-like interface */
 void LA_AVDECC_CALL_CONVENTION AemAecpdu::destroy() noexcept
 {
-	delete this;
+	// Storage comes from the pool (see createRawAemAecpdu and copy)
+	this->~AemAecpdu();
+	AemAecpduPool::getInstance().release(this);
 }
 
 } // namespace protocol
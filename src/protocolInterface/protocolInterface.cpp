@@ -84,6 +84,21 @@ la::avdecc::networkInterface::MacAddress const& ProtocolInterface::getMacAddress
 	return _networkInterfaceMacAddress;
 }
 
+AecpCommandsStatistics ProtocolInterface::getAecpCommandsStatistics() const noexcept
+{
+	return {};
+}
+
+ProtocolInterface::Error ProtocolInterface::sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, networkInterface::MacAddress const& macAddress, AecpCommandResultHandler const& onResult, AecpCommandPriority const /*priority*/) const noexcept
+{
+	return sendAecpCommand(std::move(aecpdu), macAddress, onResult);
+}
+
+size_t ProtocolInterface::getStateMachineMemoryFootprint() const noexcept
+{
+	return 0u;
+}
+
 ProtocolInterface* LA_AVDECC_CALL_CONVENTION ProtocolInterface::createRawProtocolInterface(Type const protocolInterfaceType, std::string const& networkInterfaceName)
 {
 	if (!isSupportedProtocolInterfaceType(protocolInterfaceType))
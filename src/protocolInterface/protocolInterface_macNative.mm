@@ -240,6 +240,8 @@ private:
 		return Error::MessageNotSupported;
 	}
 
+	// macOS native AVB stack has its own commands queue, priority lanes are not supported (ProtocolInterface ignores the priority)
+	using ProtocolInterface::sendAecpCommand;
 	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, networkInterface::MacAddress const& macAddress, AecpCommandResultHandler const& onResult) const noexcept override
 	{
 		return [_bridge sendAecpCommand:std::move(aecpdu) macAddress:macAddress handler:onResult];
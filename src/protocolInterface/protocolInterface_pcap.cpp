@@ -34,7 +34,6 @@
 #include <sstream>
 #include <array>
 #include <thread>
-#include <unordered_map>
 #include <functional>
 #include <memory>
 
@@ -234,6 +233,16 @@ private:
 		return _controllerStateMachine.discoverRemoteEntity(entityID);
 	}
 
+	virtual AecpCommandsStatistics getAecpCommandsStatistics() const noexcept override
+	{
+		return _controllerStateMachine.getAecpCommandsStatistics();
+	}
+
+	virtual size_t getStateMachineMemoryFootprint() const noexcept override
+	{
+		return _controllerStateMachine.getMemoryFootprint();
+	}
+
 	virtual Error sendAdpMessage(Adpdu::UniquePointer&& adpdu) const noexcept override
 	{
 		// Directly send the message on the network
@@ -252,11 +261,16 @@ private:
 		return sendMessage(static_cast<Acmpdu const&>(*acmpdu));
 	}
 
-	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, networkInterface::MacAddress const& /*macAddress*/, AecpCommandResultHandler const& onResult) const noexcept override
+	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, networkInterface::MacAddress const& macAddress, AecpCommandResultHandler const& onResult) const noexcept override
+	{
+		return sendAecpCommand(std::move(aecpdu), macAddress, onResult, AecpCommandPriority::Interactive);
+	}
+
+	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, networkInterface::MacAddress const& /*macAddress*/, AecpCommandResultHandler const& onResult, AecpCommandPriority const priority) const noexcept override
 	{
 		// PCap protocol interface do not need the macAddress parameter, it will be retrieved from the Aecpdu when sending it
 		// Command goes through the state machine to handle timeout, retry and response
-		return _controllerStateMachine.sendAecpCommand(std::move(aecpdu), onResult);
+		return _controllerStateMachine.sendAecpCommand(std::move(aecpdu), onResult, priority);
 	}
 
 	virtual Error sendAecpResponse(Aecpdu::UniquePointer&& aecpdu, networkInterface::MacAddress const& /*macAddress*/) const noexcept override
@@ -326,6 +340,12 @@ private:
 		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityUpdated, this, entity);
 	}
 
+	virtual void onDeferredDiscoveryError(ProtocolInterface::Error const error) noexcept override
+	{
+		// Not a transport failure (the interface is still usable, next discovery will be sent normally), only log it
+		LOG_PROTOCOL_INTERFACE_WARN(getMacAddress(), Adpdu::Multicast_Mac_Address, "Failed to send deferred ENTITY_DISCOVER message: error {}", to_integral(error));
+	}
+
 	virtual void onAecpCommand(entity::LocalEntity const& entity, Aecpdu const& aecpdu) noexcept override
 	{
 		// Notify observers
@@ -461,53 +481,34 @@ private:
 					auto const messageType = static_cast<AecpMessageType>(controlData);
 
 #pragma message("TODO: Handle other AECP message types")
-					static std::unordered_map<AecpMessageType, std::function<Aecpdu::UniquePointer(std::uint8_t const* const pkt_data, size_t const pkt_len)>, AecpMessageType::Hash> s_Dispatch{
-						{ AecpMessageType::AemCommand,
-							[](std::uint8_t const* const /*pkt_data*/, size_t const /*pkt_len*/)
-							{
-								return AemAecpdu::create();
-							} },
-						{ AecpMessageType::AemResponse,
-							[](std::uint8_t const* const /*pkt_data*/, size_t const /*pkt_len*/)
-							{
-								return AemAecpdu::create();
-							} },
-						{ AecpMessageType::AddressAccessCommand,
-							[](std::uint8_t const* const /*pkt_data*/, size_t const /*pkt_len*/)
-							{
-								return AaAecpdu::create();
-							} },
-						{ AecpMessageType::AddressAccessResponse,
-							[](std::uint8_t const* const /*pkt_data*/, size_t const /*pkt_len*/)
-							{
-								return AaAecpdu::create();
-							} },
-						{ AecpMessageType::VendorUniqueResponse,
-							[](std::uint8_t const* const pkt_data, size_t const pkt_len)
+					// Create aecpdu frame based on message type
+					if (messageType == AecpMessageType::AemCommand || messageType == AecpMessageType::AemResponse)
+					{
+						aecpdu = AemAecpdu::create();
+					}
+					else if (messageType == AecpMessageType::AddressAccessCommand || messageType == AecpMessageType::AddressAccessResponse)
+					{
+						aecpdu = AaAecpdu::create();
+					}
+					else if (messageType == AecpMessageType::VendorUniqueResponse)
+					{
+						// We have to retrieve the ProtocolID to dispatch
+						auto const protocolIdentifierOffset = AvtpduControl::HeaderLength + Aecpdu::HeaderLength;
+						if (pkt_len >= (protocolIdentifierOffset + VuAecpdu::ProtocolIdentifierSize))
+						{
+							VuAecpdu::ProtocolIdentifier protocolIdentifier;
+							std::memcpy(protocolIdentifier.data(), pkt_data + protocolIdentifierOffset, VuAecpdu::ProtocolIdentifierSize);
+
+							if (protocolIdentifier == MvuAecpdu::ProtocolID)
 							{
-								// We have to retrieve the ProtocolID to dispatch
-								auto const protocolIdentifierOffset = AvtpduControl::HeaderLength + Aecpdu::HeaderLength;
-								if (pkt_len >= (protocolIdentifierOffset + VuAecpdu::ProtocolIdentifierSize))
-								{
-									VuAecpdu::ProtocolIdentifier protocolIdentifier;
-									std::memcpy(protocolIdentifier.data(), pkt_data + protocolIdentifierOffset, VuAecpdu::ProtocolIdentifierSize);
-
-									if (protocolIdentifier == MvuAecpdu::ProtocolID)
-									{
-										return MvuAecpdu::create();
-									}
-								}
-
-								return Aecpdu::UniquePointer{ nullptr, nullptr };
-							} },
-					};
-
-					auto const& it = s_Dispatch.find(messageType);
-					if (it == s_Dispatch.end())
+								aecpdu = MvuAecpdu::create();
+							}
+						}
+					}
+					else
+					{
 						return; // Unsupported AECP message type
-
-					// Create aecpdu frame based on message type
-					aecpdu = it->second(pkt_data, pkt_len);
+					}
 
 					if (aecpdu != nullptr)
 					{
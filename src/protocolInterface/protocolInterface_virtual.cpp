@@ -268,7 +268,7 @@ class ProtocolInterfaceVirtualImpl final : public ProtocolInterfaceVirtual, priv
 {
 public:
 	/** Constructor */
-	ProtocolInterfaceVirtualImpl(std::string const& networkInterfaceName, networkInterface::MacAddress const& macAddress);
+	ProtocolInterfaceVirtualImpl(std::string const& networkInterfaceName, networkInterface::MacAddress const& macAddress, Clock const& clock);
 
 	/** Destructor */
 	virtual ~ProtocolInterfaceVirtualImpl() noexcept;
@@ -288,6 +288,8 @@ private:
 	Error sendPacket(SerializationBuffer const& buffer) const noexcept;
 
 	// ProtocolInterface overrides
+	virtual AecpCommandsStatistics getAecpCommandsStatistics() const noexcept override;
+	virtual size_t getStateMachineMemoryFootprint() const noexcept override;
 	virtual void shutdown() noexcept override;
 	virtual Error registerLocalEntity(entity::LocalEntity& entity) noexcept override;
 	virtual Error unregisterLocalEntity(entity::LocalEntity& entity) noexcept override;
@@ -299,6 +301,7 @@ private:
 	virtual Error sendAecpMessage(Aecpdu::UniquePointer&& aecpdu) const noexcept override;
 	virtual Error sendAcmpMessage(Acmpdu::UniquePointer&& acmpdu) const noexcept override;
 	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, networkInterface::MacAddress const& macAddress, AecpCommandResultHandler const& onResult) const noexcept override;
+	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, networkInterface::MacAddress const& macAddress, AecpCommandResultHandler const& onResult, AecpCommandPriority const priority) const noexcept override;
 	virtual Error sendAecpResponse(Aecpdu::UniquePointer&& aecpdu, networkInterface::MacAddress const& macAddress) const noexcept override;
 	virtual Error sendAcmpCommand(Acmpdu::UniquePointer&& acmpdu, AcmpCommandResultHandler const& onResult) const noexcept override;
 	virtual Error sendAcmpResponse(Acmpdu::UniquePointer&& acmpdu) const noexcept override;
@@ -307,6 +310,7 @@ private:
 
 	// ProtocolInterfaceVirtual overrides
 	virtual void forceTransportError() const noexcept override;
+	virtual void checkTimers() const noexcept override;
 
 	// stateMachine::ControllerStateMachine::Delegate overrides
 	virtual void onLocalEntityOnline(la::avdecc::entity::DiscoveredEntity const& entity) noexcept override;
@@ -315,6 +319,7 @@ private:
 	virtual void onRemoteEntityOnline(la::avdecc::entity::DiscoveredEntity const& entity) noexcept override;
 	virtual void onRemoteEntityOffline(la::avdecc::UniqueIdentifier const entityID) noexcept override;
 	virtual void onRemoteEntityUpdated(la::avdecc::entity::DiscoveredEntity const& entity) noexcept override;
+	virtual void onDeferredDiscoveryError(ProtocolInterface::Error const error) noexcept override;
 	virtual void onAecpCommand(la::avdecc::entity::LocalEntity const& entity, la::avdecc::protocol::Aecpdu const& aecpdu) noexcept override;
 	virtual void onAecpUnsolicitedResponse(la::avdecc::entity::LocalEntity const& entity, la::avdecc::protocol::Aecpdu const& aecpdu) noexcept override;
 	virtual void onAcmpSniffedCommand(la::avdecc::entity::LocalEntity const& entity, la::avdecc::protocol::Acmpdu const& acmpdu) noexcept override;
@@ -328,12 +333,13 @@ private:
 	virtual void onTransportError() noexcept override;
 
 	// Private variables
-	mutable stateMachine::ControllerStateMachine _controllerStateMachine{ this, this };
+	mutable stateMachine::ControllerStateMachine _controllerStateMachine;
 };
 
 /** Constructor */
-ProtocolInterfaceVirtualImpl::ProtocolInterfaceVirtualImpl(std::string const& networkInterfaceName, networkInterface::MacAddress const& macAddress)
+ProtocolInterfaceVirtualImpl::ProtocolInterfaceVirtualImpl(std::string const& networkInterfaceName, networkInterface::MacAddress const& macAddress, Clock const& clock)
 	: ProtocolInterfaceVirtual(networkInterfaceName, macAddress)
+	, _controllerStateMachine(this, this, Aecpdu::DefaultMaxInflightCommands, clock)
 {
 	// Should always be supported. Cannot create a Virtual ProtocolInterface if it's not supported.
 	AVDECC_ASSERT(isSupported(), "Should always be supported. Cannot create a Virtual ProtocolInterface if it's not supported");
@@ -393,35 +399,13 @@ void ProtocolInterfaceVirtualImpl::dispatchAvdeccMessage(std::uint8_t const* con
 				auto const messageType = static_cast<AecpMessageType>(controlData);
 
 #pragma message("TODO: Handle other AECP message types")
-				static std::unordered_map<AecpMessageType, std::function<Aecpdu::UniquePointer()>, AecpMessageType::Hash> s_Dispatch{
-					{ AecpMessageType::AemCommand,
-						[]()
-						{
-							return AemAecpdu::create();
-						} },
-					{ AecpMessageType::AemResponse,
-						[]()
-						{
-							return AemAecpdu::create();
-						} },
-					{ AecpMessageType::AddressAccessCommand,
-						[]()
-						{
-							return AaAecpdu::create();
-						} },
-					{ AecpMessageType::AddressAccessResponse,
-						[]()
-						{
-							return AaAecpdu::create();
-						} },
-				};
-
-				auto const& it = s_Dispatch.find(messageType);
-				if (it == s_Dispatch.end())
-					return; // Unsupported AECP message type
-
 				// Create aecpdu frame based on message type
-				aecpdu = it->second();
+				if (messageType == AecpMessageType::AemCommand || messageType == AecpMessageType::AemResponse)
+					aecpdu = AemAecpdu::create();
+				else if (messageType == AecpMessageType::AddressAccessCommand || messageType == AecpMessageType::AddressAccessResponse)
+					aecpdu = AaAecpdu::create();
+				else
+					return; // Unsupported AECP message type
 
 				if (aecpdu != nullptr)
 				{
@@ -560,6 +544,16 @@ ProtocolInterface::Error ProtocolInterfaceVirtualImpl::discoverRemoteEntity(Uniq
 	return _controllerStateMachine.discoverRemoteEntity(entityID);
 }
 
+AecpCommandsStatistics ProtocolInterfaceVirtualImpl::getAecpCommandsStatistics() const noexcept
+{
+	return _controllerStateMachine.getAecpCommandsStatistics();
+}
+
+size_t ProtocolInterfaceVirtualImpl::getStateMachineMemoryFootprint() const noexcept
+{
+	return _controllerStateMachine.getMemoryFootprint();
+}
+
 ProtocolInterface::Error ProtocolInterfaceVirtualImpl::sendAdpMessage(Adpdu::UniquePointer&& adpdu) const noexcept
 {
 	// Directly send the message on the network
@@ -578,11 +572,16 @@ ProtocolInterface::Error ProtocolInterfaceVirtualImpl::sendAcmpMessage(Acmpdu::U
 	return sendMessage(static_cast<Acmpdu const&>(*acmpdu));
 }
 
-ProtocolInterface::Error ProtocolInterfaceVirtualImpl::sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, networkInterface::MacAddress const& /*macAddress*/, AecpCommandResultHandler const& onResult) const noexcept
+ProtocolInterface::Error ProtocolInterfaceVirtualImpl::sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, networkInterface::MacAddress const& macAddress, AecpCommandResultHandler const& onResult) const noexcept
+{
+	return sendAecpCommand(std::move(aecpdu), macAddress, onResult, AecpCommandPriority::Interactive);
+}
+
+ProtocolInterface::Error ProtocolInterfaceVirtualImpl::sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, networkInterface::MacAddress const& /*macAddress*/, AecpCommandResultHandler const& onResult, AecpCommandPriority const priority) const noexcept
 {
 	// Virtual protocol interface do not need the macAddress parameter, it will be retrieved from the Aecpdu when sending it
 	// Command goes through the state machine to handle timeout, retry and response
-	return _controllerStateMachine.sendAecpCommand(std::move(aecpdu), onResult);
+	return _controllerStateMachine.sendAecpCommand(std::move(aecpdu), onResult, priority);
 }
 
 ProtocolInterface::Error ProtocolInterfaceVirtualImpl::sendAecpResponse(Aecpdu::UniquePointer&& aecpdu, networkInterface::MacAddress const& /*macAddress*/) const noexcept
@@ -620,6 +619,11 @@ void ProtocolInterfaceVirtualImpl::forceTransportError() const noexcept
 	sendPacket({});
 }
 
+void ProtocolInterfaceVirtualImpl::checkTimers() const noexcept
+{
+	_controllerStateMachine.checkTimers();
+}
+
 // stateMachine::ControllerStateMachine::Delegate overrides
 void ProtocolInterfaceVirtualImpl::onLocalEntityOnline(la::avdecc::entity::DiscoveredEntity const& entity) noexcept
 {
@@ -659,6 +663,12 @@ void ProtocolInterfaceVirtualImpl::onRemoteEntityUpdated(la::avdecc::entity::Dis
 	notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityUpdated, this, entity);
 }
 
+void ProtocolInterfaceVirtualImpl::onDeferredDiscoveryError(ProtocolInterface::Error const error) noexcept
+{
+	// Not a transport failure (the interface is still usable, next discovery will be sent normally), only log it
+	LOG_PROTOCOL_INTERFACE_WARN(getMacAddress(), Adpdu::Multicast_Mac_Address, "Failed to send deferred ENTITY_DISCOVER message: error {}", to_integral(error));
+}
+
 void ProtocolInterfaceVirtualImpl::onAecpCommand(entity::LocalEntity const& entity, Aecpdu const& aecpdu) noexcept
 {
 	// Notify observers
@@ -800,9 +810,9 @@ bool ProtocolInterfaceVirtual::isSupported() noexcept
 	return true;
 }
 
-ProtocolInterfaceVirtual* ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(std::string const& networkInterfaceName, networkInterface::MacAddress const& macAddress)
+ProtocolInterfaceVirtual* ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(std::string const& networkInterfaceName, networkInterface::MacAddress const& macAddress, Clock const& clock)
 {
-	return new ProtocolInterfaceVirtualImpl(networkInterfaceName, macAddress);
+	return new ProtocolInterfaceVirtualImpl(networkInterfaceName, macAddress, clock);
 }
 
 } // namespace protocol
@@ -25,6 +25,7 @@
 #pragma once
 
 #include "la/avdecc/internals/protocolInterface.hpp"
+#include "la/avdecc/internals/clock.hpp"
 
 namespace la
 {
@@ -40,10 +41,11 @@ public:
 	* @details Factory method to create a ProtocolInterfaceVirtual as a raw pointer.
 	* @param[in] networkInterfaceName The name of the virtual interface to use.
 	* @param[in] macAddress The MAC address associated with the network interface. Cannot be all 0.
+	* @param[in] clock The clock used for all protocol timings (advertising, timeouts). Must outlive the ProtocolInterfaceVirtual.
 	* @return A new ProtocolInterfaceVirtual as a raw pointer
 	* @note Throws Exception if #interfaceName is invalid or inaccessible.
 	*/
-	static ProtocolInterfaceVirtual* createRawProtocolInterfaceVirtual(std::string const& networkInterfaceName, networkInterface::MacAddress const& macAddress);
+	static ProtocolInterfaceVirtual* createRawProtocolInterfaceVirtual(std::string const& networkInterfaceName, networkInterface::MacAddress const& macAddress, Clock const& clock = Clock::getDefaultClock());
 
 	/** Returns true if this ProtocolInterface is supported (runtime check) */
 	static bool isSupported() noexcept;
@@ -54,6 +56,9 @@ public:
 	/** Force a transport error on the interface */
 	virtual void forceTransportError() const noexcept = 0;
 
+	/** Processes all protocol timings right away, to be called after advancing a ManualClock */
+	virtual void checkTimers() const noexcept = 0;
+
 	// Deleted compiler auto-generated methods
 	ProtocolInterfaceVirtual(ProtocolInterfaceVirtual&&) = delete;
 	ProtocolInterfaceVirtual(ProtocolInterfaceVirtual const&) = delete;
@@ -0,0 +1,233 @@
+/*
+* Copyright (C) 2016-2018, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be usefu_state,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/**
+* @file smallFunction.hpp
+* @author Christophe Calmejane
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <functional>
+
+namespace la
+{
+namespace avdecc
+{
+/**
+* @brief Copyable function wrapper with a guaranteed inline storage.
+* @details Behaves like std::function but callables whose size fits InlineSize (and which are nothrow movable) are stored inside the object itself, never on the heap.
+*          Bigger callables are allocated, as std::function would do.
+*/
+template<typename Signature, size_t InlineSize>
+class SmallFunction;
+
+template<typename Result, typename... Args, size_t InlineSize>
+class SmallFunction<Result(Args...), InlineSize>
+{
+public:
+	SmallFunction() noexcept = default;
+
+	SmallFunction(std::nullptr_t) noexcept {}
+
+	template<typename Callable, typename = std::enable_if_t<!std::is_same<std::decay_t<Callable>, SmallFunction>::value && !std::is_same<std::decay_t<Callable>, std::nullptr_t>::value>>
+	SmallFunction(Callable&& callable)
+	{
+		using Type = std::decay_t<Callable>;
+		if constexpr (isInline<Type>())
+		{
+			new (&_storage) Type(std::forward<Callable>(callable));
+			_ops = &InlineOps<Type>::Table;
+		}
+		else
+		{
+			*reinterpret_cast<Type**>(&_storage) = new Type(std::forward<Callable>(callable));
+			_ops = &HeapOps<Type>::Table;
+		}
+	}
+
+	SmallFunction(SmallFunction const& other)
+	{
+		if (other._ops)
+		{
+			other._ops->copy(&_storage, &other._storage);
+			_ops = other._ops;
+		}
+	}
+
+	SmallFunction(SmallFunction&& other) noexcept
+	{
+		if (other._ops)
+		{
+			other._ops->move(&_storage, &other._storage);
+			_ops = other._ops;
+			other._ops = nullptr;
+		}
+	}
+
+	~SmallFunction() noexcept
+	{
+		reset();
+	}
+
+	SmallFunction& operator=(SmallFunction const& other)
+	{
+		if (this != &other)
+		{
+			// Copy first so we are left untouched if it throws
+			auto copy = SmallFunction{ other };
+			*this = std::move(copy);
+		}
+		return *this;
+	}
+
+	SmallFunction& operator=(SmallFunction&& other) noexcept
+	{
+		if (this != &other)
+		{
+			reset();
+			if (other._ops)
+			{
+				other._ops->move(&_storage, &other._storage);
+				_ops = other._ops;
+				other._ops = nullptr;
+			}
+		}
+		return *this;
+	}
+
+	SmallFunction& operator=(std::nullptr_t) noexcept
+	{
+		reset();
+		return *this;
+	}
+
+	Result operator()(Args... args) const
+	{
+		if (!_ops)
+			throw std::bad_function_call();
+		return _ops->invoke(&_storage, std::forward<Args>(args)...);
+	}
+
+	explicit operator bool() const noexcept
+	{
+		return _ops != nullptr;
+	}
+
+	friend bool operator==(SmallFunction const& f, std::nullptr_t) noexcept
+	{
+		return !f;
+	}
+
+	friend bool operator!=(SmallFunction const& f, std::nullptr_t) noexcept
+	{
+		return !!f;
+	}
+
+private:
+	using Storage = std::aligned_storage_t<InlineSize, alignof(std::max_align_t)>;
+
+	struct Ops
+	{
+		Result (*invoke)(void const* storage, Args&&... args);
+		void (*copy)(void* dest, void const* source);
+		void (*move)(void* dest, void* source) noexcept;
+		void (*destroy)(void* storage) noexcept;
+	};
+
+	template<typename Type>
+	static constexpr bool isInline() noexcept
+	{
+		return sizeof(Type) <= sizeof(Storage) && alignof(Storage) % alignof(Type) == 0 && std::is_nothrow_move_constructible<Type>::value;
+	}
+
+	template<typename Type>
+	struct InlineOps
+	{
+		static Type& get(void const* storage) noexcept
+		{
+			return *const_cast<Type*>(static_cast<Type const*>(storage));
+		}
+		static Result invoke(void const* storage, Args&&... args)
+		{
+			return get(storage)(std::forward<Args>(args)...);
+		}
+		static void copy(void* dest, void const* source)
+		{
+			new (dest) Type(get(source));
+		}
+		static void move(void* dest, void* source) noexcept
+		{
+			new (dest) Type(std::move(get(source)));
+			get(source).~Type();
+		}
+		static void destroy(void* storage) noexcept
+		{
+			get(storage).~Type();
+		}
+		static constexpr Ops Table{ &invoke, &copy, &move, &destroy };
+	};
+
+	template<typename Type>
+	struct HeapOps
+	{
+		static Type*& get(void const* storage) noexcept
+		{
+			return *const_cast<Type**>(static_cast<Type* const*>(storage));
+		}
+		static Result invoke(void const* storage, Args&&... args)
+		{
+			return (*get(storage))(std::forward<Args>(args)...);
+		}
+		static void copy(void* dest, void const* source)
+		{
+			*static_cast<Type**>(dest) = new Type(*get(source));
+		}
+		static void move(void* dest, void* source) noexcept
+		{
+			*static_cast<Type**>(dest) = get(source);
+			get(source) = nullptr;
+		}
+		static void destroy(void* storage) noexcept
+		{
+			delete get(storage);
+		}
+		static constexpr Ops Table{ &invoke, &copy, &move, &destroy };
+	};
+
+	void reset() noexcept
+	{
+		if (_ops)
+		{
+			_ops->destroy(&_storage);
+			_ops = nullptr;
+		}
+	}
+
+	Storage _storage;
+	Ops const* _ops{ nullptr };
+};
+
+} // namespace avdecc
+} // namespace la
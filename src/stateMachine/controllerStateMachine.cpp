@@ -29,6 +29,9 @@
 #include <stdexcept>
 #include <chrono>
 #include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
 
 namespace la
 {
@@ -50,15 +53,25 @@ static constexpr auto AcmpConnectRxCommandTimeoutMsec = 4500u;
 static constexpr auto AcmpDisconnectRxCommandTimeoutMsec = 500u;
 static constexpr auto AcmpGetRxStateCommandTimeoutMsec = 200u;
 static constexpr auto AcmpGetTxConnectionCommandTimeoutMsec = 200u;
+/* Adp outgoing messages */
+static constexpr auto AdpMaxResponseDelayMsec = 500u; // Upper bound of the random delay before the first advertise and before replying to a discovery request (the standard allows up to 1/5 of valid_time, which is far too long for a discovery reply)
+static constexpr auto AdpDiscoverMaxDelayMsec = 100u; // Upper bound of the random delay before sending an ENTITY_DISCOVER message
 
-ControllerStateMachine::ControllerStateMachine(ProtocolInterface const* const protocolInterface, Delegate* const delegate, size_t const maxInflightAecpMessages)
+ControllerStateMachine::ControllerStateMachine(ProtocolInterface const* const protocolInterface, Delegate* const delegate, size_t const maxInflightAecpMessages, Clock const& clock)
 	: _protocolInterface(protocolInterface)
 	, _delegate(delegate)
+	, _clock(clock)
 	, _maxInflightAecpMessages(maxInflightAecpMessages)
+	, _adpSendTokens(AdpMaxSendBurst)
+	, _adpSendTokensRefilledAt(_clock.now())
 {
 	if (_delegate == nullptr)
 		throw Exception("ControllerStateMachine's delegate cannot be nullptr");
 
+	// A manual clock is driven by the owner, which calls checkTimers after advancing it
+	if (_clock.isManual())
+		return;
+
 	// Create the state machine thread
 	_stateMachineThread = std::thread(
 		[this]
@@ -66,14 +79,8 @@ ControllerStateMachine::ControllerStateMachine(ProtocolInterface const* const pr
 			setCurrentThreadName("avdecc::ControllerStateMachine");
 			while (!_shouldTerminate)
 			{
-				// Check for local entities announcement
-				checkLocalEntitiesAnnouncement();
-
-				// Check for timeout expiracy on all entities
-				checkEntitiesTimeoutExpiracy();
-
-				// Check for inflight commands expiracy
-				checkInflightCommandsTimeoutExpiracy();
+				// Check all timings
+				checkTimers();
 
 				// Wait a little bit so we don't burn the CPU
 				std::this_thread::sleep_for(std::chrono::milliseconds(10));
@@ -91,7 +98,7 @@ ControllerStateMachine::~ControllerStateMachine() noexcept
 		_stateMachineThread.join();
 }
 
-ProtocolInterface::Error ControllerStateMachine::sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, ProtocolInterface::AecpCommandResultHandler const& onResult) noexcept
+ProtocolInterface::Error ControllerStateMachine::sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, ProtocolInterface::AecpCommandResultHandler const& onResult, AecpCommandPriority const priority) noexcept
 {
 	auto* aecp = static_cast<Aecpdu*>(aecpdu.get());
 	auto const targetEntityID = aecp->getTargetEntityID();
@@ -117,7 +124,7 @@ ProtocolInterface::Error ControllerStateMachine::sendAecpCommand(Aecpdu::UniqueP
 	{
 #pragma message("TODO: If Entity is a LocalEntity, then bypass networking and inflight stuff, and directly call processAecpdu()")
 		// Record the query for when we get a response (so we can send it again if it timed out)
-		AecpCommandInfo command{ sequenceID, std::move(aecpdu), onResult };
+		AecpCommandInfo command{ sequenceID, priority, std::move(aecpdu), onResult };
 		{
 			auto& inflight = localEntity.inflightAecpCommands[targetEntityID];
 			// Check if we don't have too many inflight commands for this entity
@@ -126,10 +133,13 @@ ProtocolInterface::Error ControllerStateMachine::sendAecpCommand(Aecpdu::UniqueP
 				// Send the command
 				setCommandInflight(localEntity, inflight, inflight.end(), std::move(command));
 			}
-			else // Too many inflight commands, queue it
+			else // Too many inflight commands, queue it in the lane of its priority
 			{
 				auto& queue = localEntity.commandsQueue[targetEntityID];
-				queue.push_back(std::move(command));
+				command.queuedAt = _clock.now();
+				auto& lane = queue.lanes[static_cast<size_t>(priority)];
+				insertAecpCommand(lane, lane.end(), std::move(command));
+				++_aecpCommandsStatistics[static_cast<size_t>(priority)].queuedCommands;
 			}
 		}
 	}
@@ -186,32 +196,24 @@ bool ControllerStateMachine::processAdpdu(Adpdu const& adpdu) noexcept
 {
 	// Dispatching and handling of ADP messages is done on this layer
 
-	static std::unordered_map<AdpMessageType::value_type, std::function<void(ControllerStateMachine* const stateMachine, Adpdu const& adpdu)>> s_Dispatch{
-		// Entity Available
-		{ AdpMessageType::EntityAvailable.getValue(),
-			[](ControllerStateMachine* const stateMachine, Adpdu const& adpdu)
-			{
-				stateMachine->handleAdpEntityAvailable(adpdu);
-			} },
-		// Entity Departing
-		{ AdpMessageType::EntityDeparting.getValue(),
-			[](ControllerStateMachine* const stateMachine, Adpdu const& adpdu)
-			{
-				stateMachine->handleAdpEntityDeparting(adpdu);
-			} },
-		// Entity Discover
-		{ AdpMessageType::EntityDiscover.getValue(),
-			[](ControllerStateMachine* const stateMachine, Adpdu const& adpdu)
-			{
-				stateMachine->handleAdpEntityDiscover(adpdu);
-			} },
-	};
-
-	auto const messageType = adpdu.getMessageType().getValue();
-	auto const& it = s_Dispatch.find(messageType);
-	if (it != s_Dispatch.end())
+	// Only 3 message types, directly compare them (most frequent first)
+	auto const messageType = adpdu.getMessageType();
+	// Entity Available
+	if (messageType == AdpMessageType::EntityAvailable)
 	{
-		invokeProtectedHandler(it->second, this, adpdu);
+		handleAdpEntityAvailable(adpdu);
+		return true;
+	}
+	// Entity Departing
+	if (messageType == AdpMessageType::EntityDeparting)
+	{
+		handleAdpEntityDeparting(adpdu);
+		return true;
+	}
+	// Entity Discover
+	if (messageType == AdpMessageType::EntityDiscover)
+	{
+		handleAdpEntityDiscover(adpdu);
 		return true;
 	}
 	return false;
@@ -452,8 +454,12 @@ ProtocolInterface::Error ControllerStateMachine::enableEntityAdvertising(entity:
 		return ProtocolInterface::Error::UnknownLocalEntity;
 	auto& localEntity = localEntityIt->second;
 
+	// Advertise asap, but after a small random delay so entities started at the same time do not advertise all at once
+	if (!localEntity.isAdvertising)
+	{
+		localEntity.nextAdvertiseAt = _clock.now() + computeRandomDeviceDelay(entity, AdpMaxResponseDelayMsec);
+	}
 	localEntity.isAdvertising = true;
-	// No need to update nextAdvertiseAt value, we want to advertise asap
 
 	return ProtocolInterface::Error::NoError;
 }
@@ -489,8 +495,94 @@ ProtocolInterface::Error ControllerStateMachine::discoverRemoteEntities() noexce
 
 ProtocolInterface::Error ControllerStateMachine::discoverRemoteEntity(UniqueIdentifier const entityID) noexcept
 {
-	auto frame = makeDiscoveryMessage(entityID);
-	return _delegate->sendMessage(frame);
+	// Lock self
+	std::lock_guard<ControllerStateMachine> const lg(getSelf());
+
+	// Already scheduled
+	if (_pendingDiscoveries.find(entityID) != _pendingDiscoveries.end())
+		return ProtocolInterface::Error::NoError;
+
+	// Schedule the message after a small random delay (it will be sent by the state machine thread), so controllers started at the same time do not discover all at once. Sending errors are reported through Delegate::onDeferredDiscoveryError
+	try
+	{
+		auto const delay = std::chrono::milliseconds(std::uniform_int_distribution<std::uint32_t>{ 0u, AdpDiscoverMaxDelayMsec }(_randomGenerator));
+		_pendingDiscoveries.emplace(entityID, _clock.now() + delay);
+	}
+	catch (...)
+	{
+		return ProtocolInterface::Error::InternalError;
+	}
+
+	return ProtocolInterface::Error::NoError;
+}
+
+void ControllerStateMachine::checkTimers() noexcept
+{
+	// Lock self, so all checks are done at once
+	std::lock_guard<ControllerStateMachine> const lg(getSelf());
+
+	// Check for local entities announcement
+	checkLocalEntitiesAnnouncement();
+
+	// Check for discovery messages to be sent
+	checkPendingDiscoveries();
+
+	// Check for timeout expiracy on all entities
+	checkEntitiesTimeoutExpiracy();
+
+	// Check for inflight commands expiracy
+	checkInflightCommandsTimeoutExpiracy();
+}
+
+AecpCommandsStatistics ControllerStateMachine::getAecpCommandsStatistics() const noexcept
+{
+	// Lock self
+	std::lock_guard<ControllerStateMachine> const lg(getSelf());
+
+	return _aecpCommandsStatistics;
+}
+
+size_t ControllerStateMachine::getMemoryFootprint() const noexcept
+{
+	// Estimation of the nodes allocated by the containers (AECP commands are estimated using the size of an AEM command, memory allocated by the result handlers is not known)
+	static constexpr auto ListNodeOverhead = 2 * sizeof(void*);
+	static constexpr auto HashNodeOverhead = 2 * sizeof(void*);
+	auto const hashMapSize = [](auto const& map)
+	{
+		using Map = std::decay_t<decltype(map)>;
+		return map.bucket_count() * sizeof(void*) + map.size() * (sizeof(typename Map::value_type) + HashNodeOverhead);
+	};
+	auto const aecpCommandsSize = [](AecpCommands const& commands)
+	{
+		return commands.size() * (sizeof(AecpCommandInfo) + ListNodeOverhead + sizeof(AemAecpdu));
+	};
+
+	// Lock self
+	std::lock_guard<ControllerStateMachine> const lg(getSelf());
+
+	auto size = hashMapSize(_discoveredEntities) + hashMapSize(_localEntities) + hashMapSize(_pendingDiscoveries);
+	for (auto const& entityKV : _localEntities)
+	{
+		auto const& info = entityKV.second;
+		size += hashMapSize(info.inflightAecpCommands);
+		for (auto const& inflightKV : info.inflightAecpCommands)
+		{
+			size += aecpCommandsSize(inflightKV.second);
+		}
+		size += hashMapSize(info.commandsQueue);
+		for (auto const& queueKV : info.commandsQueue)
+		{
+			for (auto const& lane : queueKV.second.lanes)
+			{
+				size += aecpCommandsSize(lane);
+			}
+		}
+		size += hashMapSize(info.inflightAcmpCommands) + info.inflightAcmpCommands.size() * sizeof(Acmpdu);
+		size += info.scheduledAecpErrors.size() * (sizeof(ScheduledAecpErrors::value_type) + ListNodeOverhead);
+	}
+	size += _availableAecpCommands.size() * (sizeof(AecpCommandInfo) + ListNodeOverhead);
+
+	return size;
 }
 
 void ControllerStateMachine::lock() noexcept
@@ -587,6 +679,81 @@ Adpdu ControllerStateMachine::makeEntityDepartingMessage(entity::Entity& entity)
 	return frame;
 }
 
+ControllerStateMachine::AecpCommands::iterator ControllerStateMachine::insertAecpCommand(AecpCommands& commands, AecpCommands::iterator const pos, AecpCommandInfo&& command)
+{
+	if (_availableAecpCommands.empty())
+	{
+		return commands.insert(pos, std::move(command));
+	}
+
+	// Reuse an available node (splice doesn't invalidate the iterator, which now belongs to commands)
+	auto const it = _availableAecpCommands.begin();
+	*it = std::move(command);
+	commands.splice(pos, _availableAecpCommands, it);
+	return it;
+}
+
+ControllerStateMachine::AecpCommands::iterator ControllerStateMachine::releaseAecpCommand(AecpCommands& commands, AecpCommands::iterator const it) noexcept
+{
+	if (_availableAecpCommands.size() >= MaxAvailableAecpCommands)
+	{
+		return commands.erase(it);
+	}
+
+	// Release the command data (Aecpdu and result handler) but keep the node
+	auto const next = std::next(it);
+	*it = AecpCommandInfo{};
+	_availableAecpCommands.splice(_availableAecpCommands.end(), commands, it);
+	return next;
+}
+
+size_t ControllerStateMachine::selectQueueLane(AecpCommandsLanes& queue) noexcept
+{
+	auto selectedLane = AecpCommandPrioritiesCount;
+
+	// Starvation protection: a lane that has been waiting for too many commands is served first
+	for (auto laneIndex = size_t{ 0u }; laneIndex < AecpCommandPrioritiesCount; ++laneIndex)
+	{
+		if (!queue.lanes[laneIndex].empty() && queue.skippedCounts[laneIndex] >= MaxSkippedCommands)
+		{
+			selectedLane = laneIndex;
+			++_aecpCommandsStatistics[laneIndex].promotedCommands;
+			break;
+		}
+	}
+
+	// Otherwise the highest priority lane with a command
+	if (selectedLane == AecpCommandPrioritiesCount)
+	{
+		for (auto laneIndex = size_t{ 0u }; laneIndex < AecpCommandPrioritiesCount; ++laneIndex)
+		{
+			if (!queue.lanes[laneIndex].empty())
+			{
+				selectedLane = laneIndex;
+				break;
+			}
+		}
+	}
+
+	// Update waiting lanes
+	if (selectedLane != AecpCommandPrioritiesCount)
+	{
+		for (auto laneIndex = size_t{ 0u }; laneIndex < AecpCommandPrioritiesCount; ++laneIndex)
+		{
+			if (laneIndex == selectedLane || queue.lanes[laneIndex].empty())
+			{
+				queue.skippedCounts[laneIndex] = 0u;
+			}
+			else
+			{
+				++queue.skippedCounts[laneIndex];
+			}
+		}
+	}
+
+	return selectedLane;
+}
+
 void ControllerStateMachine::resetAecpCommandTimeoutValue(AecpCommandInfo& command) const noexcept
 {
 	static std::unordered_map<AecpMessageType, std::uint32_t, AecpMessageType::Hash> s_AecpCommandTimeoutMap{
@@ -602,7 +769,7 @@ void ControllerStateMachine::resetAecpCommandTimeoutValue(AecpCommandInfo& comma
 		timeout = it->second;
 	}
 
-	command.timeout = std::chrono::system_clock::now() + std::chrono::milliseconds(timeout);
+	command.timeout = _clock.now() + std::chrono::milliseconds(timeout);
 }
 
 void ControllerStateMachine::resetAcmpCommandTimeoutValue(AcmpCommandInfo& command) const noexcept
@@ -624,7 +791,7 @@ void ControllerStateMachine::resetAcmpCommandTimeoutValue(AcmpCommandInfo& comma
 		timeout = it->second;
 	}
 
-	command.timeout = std::chrono::system_clock::now() + std::chrono::milliseconds(timeout);
+	command.timeout = _clock.now() + std::chrono::milliseconds(timeout);
 }
 
 AecpSequenceID ControllerStateMachine::getNextAecpSequenceID(LocalEntityInfo& info) noexcept
@@ -641,11 +808,34 @@ AcmpSequenceID ControllerStateMachine::getNextAcmpSequenceID(LocalEntityInfo& in
 	return nextID;
 }
 
-std::chrono::time_point<std::chrono::system_clock> ControllerStateMachine::computeNextAdvertiseTime(entity::Entity const& entity) const noexcept
+std::chrono::milliseconds ControllerStateMachine::computeRandomDeviceDelay(entity::Entity const& entity, std::uint32_t const maxDelayMsec) noexcept
+{
+	// Random delay between 0 and 1/5 of the valid time (which is in 2 seconds unit) - See IEEE-P1722.1-cor1-D8.pdf clause 6.2.4.2.2
+	auto const randomDeviceDelayMsec = std::min(maxDelayMsec, static_cast<std::uint32_t>(entity.getValidTime()) * 2000u / 5u);
+	return std::chrono::milliseconds(std::uniform_int_distribution<std::uint32_t>{ 0u, randomDeviceDelayMsec }(_randomGenerator));
+}
+
+Clock::time_point ControllerStateMachine::computeNextAdvertiseTime(entity::Entity const& entity) noexcept
 {
-#pragma message("TODO: Compute a random delay. See IEEE-P1722.1-cor1-D8.pdf clause 6.2.4.2.2")
-	auto const randomDelay{ 0u };
-	return std::chrono::system_clock::now() + std::chrono::milliseconds(std::max(1000u, entity.getValidTime() * 1000 / 2 + randomDelay));
+	auto const randomDelay = computeRandomDeviceDelay(entity, std::numeric_limits<std::uint32_t>::max());
+	return _clock.now() + std::chrono::milliseconds(std::max(1000u, entity.getValidTime() * 1000u / 2u)) + randomDelay;
+}
+
+bool ControllerStateMachine::acquireAdpSendToken(Clock::time_point const& now) noexcept
+{
+	// Refill the bucket according to the elapsed time since last refill
+	auto const elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(now - _adpSendTokensRefilledAt).count();
+	if (elapsed > 0)
+	{
+		_adpSendTokens = std::min(static_cast<double>(AdpMaxSendBurst), _adpSendTokens + elapsed * AdpMaxSendRate);
+		_adpSendTokensRefilledAt = now;
+	}
+
+	if (_adpSendTokens < 1.0)
+		return false;
+
+	_adpSendTokens -= 1.0;
+	return true;
 }
 
 void ControllerStateMachine::checkLocalEntitiesAnnouncement() noexcept
@@ -653,29 +843,83 @@ void ControllerStateMachine::checkLocalEntitiesAnnouncement() noexcept
 	// Lock self
 	std::lock_guard<ControllerStateMachine> const lg(getSelf());
 
-	auto const now = std::chrono::system_clock::now();
+	auto const now = _clock.now();
 
-	for (auto& entityKV : _localEntities)
+	// Start with the entity that could not be served during the last check (rate limit reached), so no entity is starved
+	auto entityIt = _localEntities.find(_adpAnnounceResumeEntityID);
+	if (entityIt == _localEntities.end())
+		entityIt = _localEntities.begin();
+	_adpAnnounceResumeEntityID = UniqueIdentifier::getNullUniqueIdentifier();
+
+	for (auto count = _localEntities.size(); count > 0; --count, ++entityIt)
 	{
-		auto& entityInfo = entityKV.second;
+		if (entityIt == _localEntities.end())
+			entityIt = _localEntities.begin();
+
+		auto& entityInfo = entityIt->second;
 		auto& entity = entityInfo.entity;
 
-		// Continue to next entity if advertising is disabled for this one
-		if (!entityInfo.isAdvertising)
+		// Continue to next entity if advertising is disabled for this one, and it has no pending discovery reply
+		if (!entityInfo.isAdvertising && !entityInfo.isDiscoverReplyPending)
 			continue;
 
 		// Lock the whole entity while checking dirty state and building the EntityAvailable message so that nobody alters discovery fields at the same time
 		std::lock_guard<entity::LocalEntity> const elg(entity);
 
-		// Send an EntityAvailable message if entity is dirty or if the advertise timeout expired
-		if (entity.isDirty() || now >= entityInfo.nextAdvertiseAt)
+		// Send an EntityAvailable message if entity is dirty, if the advertise timeout expired or if a discovery request has to be replied to
+		auto const shouldAdvertise = entityInfo.isAdvertising && (entity.isDirty() || now >= entityInfo.nextAdvertiseAt);
+		auto const shouldReply = entityInfo.isDiscoverReplyPending && now >= entityInfo.discoverReplyAt;
+		if (shouldAdvertise || shouldReply)
 		{
+			// Rate limit reached, remaining entities will be advertised during a next check (starting with this one)
+			if (!acquireAdpSendToken(now))
+			{
+				_adpAnnounceResumeEntityID = entityIt->first;
+				break;
+			}
+
 			// Build the EntityAvailable message
 			auto frame = makeEntityAvailableMessage(entity);
 			// Send it
 			_delegate->sendMessage(frame);
+			entityInfo.isDiscoverReplyPending = false;
 			// Update the time for next advertise
-			entityInfo.nextAdvertiseAt = computeNextAdvertiseTime(entity);
+			if (entityInfo.isAdvertising)
+			{
+				entityInfo.nextAdvertiseAt = computeNextAdvertiseTime(entity);
+			}
+		}
+	}
+}
+
+void ControllerStateMachine::checkPendingDiscoveries() noexcept
+{
+	// Lock self
+	std::lock_guard<ControllerStateMachine> const lg(getSelf());
+
+	auto const now = _clock.now();
+
+	for (auto it = _pendingDiscoveries.begin(); it != _pendingDiscoveries.end(); /* Iterate inside the loop */)
+	{
+		if (now >= it->second)
+		{
+			// Rate limit reached, remaining messages will be sent during a next check
+			if (!acquireAdpSendToken(now))
+				break;
+
+			auto frame = makeDiscoveryMessage(it->first);
+			auto const error = _delegate->sendMessage(frame);
+			it = _pendingDiscoveries.erase(it);
+
+			// The caller already returned, report the error to the delegate
+			if (!!error)
+			{
+				invokeProtectedMethod(&Delegate::onDeferredDiscoveryError, _delegate, error);
+			}
+		}
+		else
+		{
+			++it;
 		}
 	}
 }
@@ -686,7 +930,7 @@ void ControllerStateMachine::checkEntitiesTimeoutExpiracy() noexcept
 	std::lock_guard<ControllerStateMachine> const lg(getSelf());
 
 	// Get current time
-	std::chrono::time_point<std::chrono::system_clock> currentTime = std::chrono::system_clock::now();
+	Clock::time_point currentTime = _clock.now();
 
 	for (auto it = _discoveredEntities.begin(); it != _discoveredEntities.end(); /* Iterate inside the loop */)
 	{
@@ -709,7 +953,7 @@ void ControllerStateMachine::checkInflightCommandsTimeoutExpiracy() noexcept
 	std::lock_guard<ControllerStateMachine> const lg(getSelf());
 
 	// Get current time
-	std::chrono::time_point<std::chrono::system_clock> currentTime = std::chrono::system_clock::now();
+	Clock::time_point currentTime = _clock.now();
 
 	for (auto& localEntityKV : _localEntities)
 	{
@@ -802,13 +1046,12 @@ void ControllerStateMachine::handleAdpEntityAvailable(Adpdu const& adpdu) noexce
 		return;
 
 	auto const entityID = adpdu.getEntityID();
+	auto const fingerprint = makeAdvertisementFingerprint(adpdu);
 	bool notify = true;
 	bool update = false;
 	bool notAllowedUpdate = false;
 	// Compute timeout value
-	std::chrono::time_point<std::chrono::system_clock> timeout = std::chrono::system_clock::now() + std::chrono::seconds(2 * adpdu.getValidTime());
-	DiscoveredEntityInfo info{ timeout, adpdu };
-	Adpdu previousAdpdu;
+	Clock::time_point timeout = _clock.now() + std::chrono::seconds(2 * adpdu.getValidTime());
 
 	// Lock self
 	std::lock_guard<ControllerStateMachine> const lg(getSelf());
@@ -819,20 +1062,30 @@ void ControllerStateMachine::handleAdpEntityAvailable(Adpdu const& adpdu) noexce
 	// Found it in the list, check if data are the same
 	if (entityIt != _discoveredEntities.end())
 	{
-		previousAdpdu = std::move(entityIt->second.adpdu);
+		auto& info = entityIt->second;
+
+		// Fast path for the steady state re-advertisement: only AvailableIndex (which must be increasing) and ValidTime changed
+		if (info.fingerprint == fingerprint && info.adpdu.getAvailableIndex() < adpdu.getAvailableIndex())
+		{
+			info.timeout = timeout;
+			info.adpdu.setAvailableIndex(adpdu.getAvailableIndex());
+			info.adpdu.setValidTime(adpdu.getValidTime());
+			return;
+		}
+
 		// Get adpdu difference
-		auto const diff = getAdpdusDiff(previousAdpdu, adpdu);
+		auto const diff = getAdpdusDiff(info.adpdu, adpdu);
 		if (diff == AdpduDiff::Same)
 			notify = false;
 		// Always update info
-		entityIt->second = info;
+		info = DiscoveredEntityInfo{ timeout, adpdu, fingerprint };
 		notAllowedUpdate = diff == AdpduDiff::DiffNotAllowed;
 		update = !notAllowedUpdate;
 	}
 	// Not found, create a new entity
 	else
 	{
-		_discoveredEntities[entityID] = info;
+		_discoveredEntities[entityID] = DiscoveredEntityInfo{ timeout, adpdu, fingerprint };
 	}
 
 	// Notify delegate
@@ -892,14 +1145,17 @@ void ControllerStateMachine::handleAdpEntityDiscover(Adpdu const& adpdu) noexcep
 		// Only reply to global (entityID == 0) discovery messages (only if advertising is active) and to targeted ones
 		if ((!entityID && entityInfo.isAdvertising) || entityID == entity.getEntityID())
 		{
-			// Build the EntityAvailable message
-			auto frame = makeEntityAvailableMessage(entity);
-			// Send it
-			_delegate->sendMessage(frame);
-			// Update the time for next advertise (only if isAdvertising is true, meaning it's not a targeted message)
+			// Reply after a random delay so all entities on the network do not reply at once, the message will be sent by the state machine thread
+			auto const replyAt = _clock.now() + computeRandomDeviceDelay(entity, AdpMaxResponseDelayMsec);
 			if (entityInfo.isAdvertising)
 			{
-				entityInfo.nextAdvertiseAt = computeNextAdvertiseTime(entity);
+				// Advance the next advertise
+				entityInfo.nextAdvertiseAt = std::min(entityInfo.nextAdvertiseAt, replyAt);
+			}
+			else if (!entityInfo.isDiscoverReplyPending)
+			{
+				entityInfo.isDiscoverReplyPending = true;
+				entityInfo.discoverReplyAt = replyAt;
 			}
 		}
 	}
@@ -955,6 +1211,34 @@ ControllerStateMachine::AdpduDiff ControllerStateMachine::getAdpdusDiff(Adpdu co
 	return AdpduDiff::Same;
 }
 
+ControllerStateMachine::AdvertisementFingerprint ControllerStateMachine::makeAdvertisementFingerprint(Adpdu const& adpdu) noexcept
+{
+	auto fingerprint = AdvertisementFingerprint{};
+	auto* ptr = fingerprint.data();
+	auto const pack = [&ptr](auto const value)
+	{
+		std::memcpy(ptr, &value, sizeof(value));
+		ptr += sizeof(value);
+	};
+
+	pack(adpdu.getSrcAddress());
+	pack(adpdu.getEntityModelID().getValue());
+	pack(adpdu.getEntityCapabilities());
+	pack(adpdu.getTalkerStreamSources());
+	pack(adpdu.getTalkerCapabilities());
+	pack(adpdu.getListenerStreamSinks());
+	pack(adpdu.getListenerCapabilities());
+	pack(adpdu.getControllerCapabilities());
+	pack(adpdu.getGptpGrandmasterID().getValue());
+	pack(adpdu.getGptpDomainNumber());
+	pack(adpdu.getIdentifyControlIndex());
+	pack(adpdu.getInterfaceIndex());
+	pack(adpdu.getAssociationID().getValue());
+
+	AVDECC_ASSERT(ptr == fingerprint.data() + fingerprint.size(), "AdvertisementFingerprintSize does not match packed fields");
+	return fingerprint;
+}
+
 entity::DiscoveredEntity ControllerStateMachine::makeEntity(Adpdu const& adpdu) const noexcept
 {
 	return entity::DiscoveredEntity{ adpdu.getEntityID(), adpdu.getSrcAddress(), adpdu.getValidTime(), adpdu.getEntityModelID(), adpdu.getEntityCapabilities(), adpdu.getTalkerStreamSources(), adpdu.getTalkerCapabilities(), adpdu.getListenerStreamSinks(), adpdu.getListenerCapabilities(), adpdu.getControllerCapabilities(), adpdu.getAvailableIndex(), adpdu.getGptpGrandmasterID(), adpdu.getGptpDomainNumber(), adpdu.getIdentifyControlIndex(), adpdu.getInterfaceIndex(), adpdu.getAssociationID() };
@@ -26,6 +26,7 @@
 
 #include "la/avdecc/internals/protocolInterface.hpp"
 #include "la/avdecc/internals/entity.hpp"
+#include "la/avdecc/internals/clock.hpp"
 #include <thread>
 #include <mutex>
 #include <list>
@@ -33,6 +34,9 @@
 #include <utility>
 #include <chrono>
 #include <unordered_map>
+#include <array>
+#include <random>
+#include <algorithm>
 
 namespace la
 {
@@ -55,6 +59,7 @@ public:
 		virtual void onRemoteEntityOnline(la::avdecc::entity::DiscoveredEntity const& entity) noexcept = 0;
 		virtual void onRemoteEntityOffline(la::avdecc::UniqueIdentifier const entityID) noexcept = 0;
 		virtual void onRemoteEntityUpdated(la::avdecc::entity::DiscoveredEntity const& entity) noexcept = 0;
+		virtual void onDeferredDiscoveryError(ProtocolInterface::Error const error) noexcept = 0; // An ENTITY_DISCOVER message sent by the state machine (after its random delay) could not be sent
 		/* **** AECP notifications **** */
 		virtual void onAecpCommand(la::avdecc::entity::LocalEntity const& entity, la::avdecc::protocol::Aecpdu const& aecpdu) noexcept = 0;
 		virtual void onAecpUnsolicitedResponse(la::avdecc::entity::LocalEntity const& entity, la::avdecc::protocol::Aecpdu const& aecpdu) noexcept = 0;
@@ -67,10 +72,14 @@ public:
 		virtual ProtocolInterface::Error sendMessage(la::avdecc::protocol::Acmpdu const& acmpdu) const noexcept = 0;
 	};
 
-	ControllerStateMachine(ProtocolInterface const* const protocolInterface, Delegate* const delegate, size_t const maxInflightAecpMessages = Aecpdu::DefaultMaxInflightCommands); // Throws Exception if delegate is nullptr
+	/** Token bucket limiting outgoing ENTITY_AVAILABLE and ENTITY_DISCOVER messages */
+	static constexpr std::uint32_t AdpMaxSendBurst = 5u; // Maximum count of messages sent at once
+	static constexpr std::uint32_t AdpMaxSendRate = 10u; // Maximum sustained count of messages sent per second
+
+	ControllerStateMachine(ProtocolInterface const* const protocolInterface, Delegate* const delegate, size_t const maxInflightAecpMessages = Aecpdu::DefaultMaxInflightCommands, Clock const& clock = Clock::getDefaultClock()); // Throws Exception if delegate is nullptr. All timings are based on clock, which must outlive the state machine. No thread is started if the clock is manual
 	~ControllerStateMachine() noexcept;
 
-	ProtocolInterface::Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, ProtocolInterface::AecpCommandResultHandler const& onResult) noexcept;
+	ProtocolInterface::Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, ProtocolInterface::AecpCommandResultHandler const& onResult, AecpCommandPriority const priority = AecpCommandPriority::Interactive) noexcept;
 	ProtocolInterface::Error sendAcmpCommand(Acmpdu::UniquePointer&& acmpdu, ProtocolInterface::AcmpCommandResultHandler const& onResult) noexcept;
 	bool processAdpdu(Adpdu const& adpdu) noexcept; // Returns true if processed
 	bool isAEMUnsolicitedResponse(Aecpdu const& aecpdu) const noexcept;
@@ -83,6 +92,12 @@ public:
 	ProtocolInterface::Error disableEntityAdvertising(entity::LocalEntity& entity) noexcept;
 	ProtocolInterface::Error discoverRemoteEntities() noexcept;
 	ProtocolInterface::Error discoverRemoteEntity(UniqueIdentifier const entityID) noexcept;
+	/** Processes all timings (advertising, pending discoveries, entities and commands timeouts). Periodically called by the state machine thread, or by the owner of a manual Clock right after advancing it */
+	void checkTimers() noexcept;
+	/** Returns statistics about sent AECP commands, per priority lane */
+	AecpCommandsStatistics getAecpCommandsStatistics() const noexcept;
+	/** Returns an estimation of the memory held by the state machine queues (discovered entities, inflight and queued commands), in bytes */
+	size_t getMemoryFootprint() const noexcept;
 
 	/** BasicLockable concept 'lock' method for the whole ControllerStateMachine */
 	void lock() noexcept;
@@ -90,37 +105,53 @@ public:
 	void unlock() noexcept;
 
 private:
+	/** Packed fields of an ADPDU that are not expected to change between two advertisements of the same entity (all but EntityID, AvailableIndex and ValidTime) */
+	static constexpr size_t AdvertisementFingerprintSize = 6 /* SrcAddress */ + 8 /* EntityModelID */ + 4 /* EntityCapabilities */ + 2 /* TalkerStreamSources */ + 2 /* TalkerCapabilities */ + 2 /* ListenerStreamSinks */ + 2 /* ListenerCapabilities */ + 4 /* ControllerCapabilities */ + 8 /* GptpGrandmasterID */ + 1 /* GptpDomainNumber */ + 2 /* IdentifyControlIndex */ + 2 /* InterfaceIndex */ + 8 /* AssociationID */;
+	using AdvertisementFingerprint = std::array<std::uint8_t, AdvertisementFingerprintSize>;
+
 	struct DiscoveredEntityInfo
 	{
-		std::chrono::time_point<std::chrono::system_clock> timeout;
+		Clock::time_point timeout;
 		Adpdu adpdu;
+		AdvertisementFingerprint fingerprint;
 	};
 	using DiscoveredEntities = std::unordered_map<UniqueIdentifier, DiscoveredEntityInfo, UniqueIdentifier::hash>;
 
 	struct AecpCommandInfo
 	{
 		AecpSequenceID sequenceID{ 0 };
-		std::chrono::time_point<std::chrono::system_clock> timeout{};
+		Clock::time_point timeout{};
 		bool retried{ false };
+		AecpCommandPriority priority{ AecpCommandPriority::Interactive };
+		Clock::time_point queuedAt{}; // Only valid while the command is in the commandsQueue
 		Aecpdu::UniquePointer command{ nullptr, nullptr };
 		ProtocolInterface::AecpCommandResultHandler resultHandler{};
 
 		AecpCommandInfo() {}
-		AecpCommandInfo(AecpSequenceID const sequenceID, Aecpdu::UniquePointer&& command, ProtocolInterface::AecpCommandResultHandler const& resultHandler)
+		AecpCommandInfo(AecpSequenceID const sequenceID, AecpCommandPriority const priority, Aecpdu::UniquePointer&& command, ProtocolInterface::AecpCommandResultHandler const& resultHandler)
 			: sequenceID(sequenceID)
+			, priority(priority)
 			, command(std::move(command))
 			, resultHandler(resultHandler)
 		{
 		}
 	};
 	using AecpCommands = std::list<AecpCommandInfo>;
+	static constexpr size_t MaxAvailableAecpCommands = 256; // Maximum number of list nodes kept for reuse, so sending a command doesn't allocate
 	using InflightAecpCommands = std::unordered_map<UniqueIdentifier, AecpCommands, UniqueIdentifier::hash>;
-	using AecpCommandsQueue = std::unordered_map<UniqueIdentifier, AecpCommands, UniqueIdentifier::hash>;
+	/** Queued commands of a target entity, one FIFO per priority lane */
+	struct AecpCommandsLanes
+	{
+		std::array<AecpCommands, AecpCommandPrioritiesCount> lanes{}; // Indexed by AecpCommandPriority
+		std::array<std::uint32_t, AecpCommandPrioritiesCount> skippedCounts{}; // Number of commands sent from other lanes while this lane was waiting
+	};
+	using AecpCommandsQueue = std::unordered_map<UniqueIdentifier, AecpCommandsLanes, UniqueIdentifier::hash>;
+	static constexpr std::uint32_t MaxSkippedCommands = 8; // Starvation protection: a waiting lane is served after at most this number of commands from other lanes
 
 	struct AcmpCommandInfo
 	{
 		AcmpSequenceID sequenceID{ 0 };
-		std::chrono::time_point<std::chrono::system_clock> timeout{};
+		Clock::time_point timeout{};
 		bool retried{ false };
 		Acmpdu::UniquePointer command{ nullptr, nullptr };
 		ProtocolInterface::AcmpCommandResultHandler resultHandler{};
@@ -141,7 +172,9 @@ private:
 		// ADP variables
 		entity::LocalEntity& entity;
 		bool isAdvertising{ false };
-		std::chrono::time_point<std::chrono::system_clock> nextAdvertiseAt{};
+		Clock::time_point nextAdvertiseAt{};
+		bool isDiscoverReplyPending{ false }; // A targeted ENTITY_DISCOVER has to be replied to, even if not advertising
+		Clock::time_point discoverReplyAt{};
 		// AECP variables
 		AecpSequenceID currentAecpSequenceID{ 0 };
 		InflightAecpCommands inflightAecpCommands{};
@@ -172,9 +205,11 @@ private:
 		}
 		else
 		{
+			++_aecpCommandsStatistics[static_cast<size_t>(command.priority)].sentCommands;
+
 			// Move the command to inflight queue
 			resetAecpCommandTimeoutValue(command);
-			return inflight.insert(it, std::move(command));
+			return insertAecpCommand(inflight, it, std::move(command));
 		}
 	}
 	template<typename T>
@@ -184,14 +219,19 @@ private:
 		if (inflight.size() >= _maxInflightAecpMessages)
 			return it;
 
-		// Check if queue is not empty for this entity
+		// Check if queue is not empty for this entity, and get the lane to send from
 		auto& queue = info.commandsQueue[entityID];
-		if (queue.empty())
+		auto const laneIndex = selectQueueLane(queue);
+		if (laneIndex >= AecpCommandPrioritiesCount)
 			return it;
 
 		// Remove command from queue
-		auto command = std::move(queue.front());
-		queue.pop_front();
+		auto& lane = queue.lanes[laneIndex];
+		auto command = std::move(lane.front());
+		releaseAecpCommand(lane, lane.begin());
+
+		auto& statistics = _aecpCommandsStatistics[laneIndex];
+		statistics.maxQueueDuration = std::max(statistics.maxQueueDuration, std::chrono::duration_cast<std::chrono::milliseconds>(_clock.now() - command.queuedAt));
 
 		return setCommandInflight(info, inflight, it, std::move(command));
 	}
@@ -199,7 +239,7 @@ private:
 	template<typename T>
 	T removeInflight(LocalEntityInfo& info, la::avdecc::UniqueIdentifier const entityID, AecpCommands& inflight, T const it)
 	{
-		auto retIt = inflight.erase(it);
+		auto retIt = releaseAecpCommand(inflight, it);
 		return checkQueue(info, entityID, inflight, retIt);
 	}
 
@@ -219,11 +259,17 @@ private:
 	Adpdu makeEntityAvailableMessage(entity::Entity& entity) const noexcept;
 	Adpdu makeEntityDepartingMessage(entity::Entity& entity) const noexcept;
 	void resetAecpCommandTimeoutValue(AecpCommandInfo& command) const noexcept;
+	AecpCommands::iterator insertAecpCommand(AecpCommands& commands, AecpCommands::iterator const pos, AecpCommandInfo&& command); // Inserts using an available list node, if any
+	AecpCommands::iterator releaseAecpCommand(AecpCommands& commands, AecpCommands::iterator const it) noexcept; // Removes the command, keeping its list node available for reuse. Returns the iterator following the removed command
+	size_t selectQueueLane(AecpCommandsLanes& queue) noexcept; // Returns AecpCommandPrioritiesCount if all lanes are empty
 	void resetAcmpCommandTimeoutValue(AcmpCommandInfo& command) const noexcept;
 	AecpSequenceID getNextAecpSequenceID(LocalEntityInfo& info) noexcept;
 	AcmpSequenceID getNextAcmpSequenceID(LocalEntityInfo& info) noexcept;
-	std::chrono::time_point<std::chrono::system_clock> computeNextAdvertiseTime(entity::Entity const& entity) const noexcept;
+	std::chrono::milliseconds computeRandomDeviceDelay(entity::Entity const& entity, std::uint32_t const maxDelayMsec) noexcept;
+	Clock::time_point computeNextAdvertiseTime(entity::Entity const& entity) noexcept;
+	bool acquireAdpSendToken(Clock::time_point const& now) noexcept;
 	void checkLocalEntitiesAnnouncement() noexcept;
+	void checkPendingDiscoveries() noexcept;
 	void checkEntitiesTimeoutExpiracy() noexcept;
 	void checkInflightCommandsTimeoutExpiracy() noexcept;
 	void handleAdpEntityAvailable(Adpdu const& adpdu) noexcept;
@@ -231,16 +277,25 @@ private:
 	void handleAdpEntityDiscover(Adpdu const& adpdu) noexcept;
 	bool isLocalEntity(UniqueIdentifier const entityID) const noexcept;
 	AdpduDiff getAdpdusDiff(Adpdu const& lhs, Adpdu const& rhs) const noexcept;
+	static AdvertisementFingerprint makeAdvertisementFingerprint(Adpdu const& adpdu) noexcept;
 	entity::DiscoveredEntity makeEntity(Adpdu const& adpdu) const noexcept;
 
 	// Common variables
 	mutable std::recursive_mutex _lock{}; /** Lock to protect the whole class */
 	ProtocolInterface const* const _protocolInterface{ nullptr };
 	Delegate* const _delegate{ nullptr };
+	Clock const& _clock; /** Source of time for all timeouts and delays */
 	size_t _maxInflightAecpMessages{ 0 };
 	bool _shouldTerminate{ false };
 	DiscoveredEntities _discoveredEntities{};
 	std::unordered_map<UniqueIdentifier, LocalEntityInfo, UniqueIdentifier::hash> _localEntities{}; /** Local entities declared by the running program */
+	std::unordered_map<UniqueIdentifier, Clock::time_point, UniqueIdentifier::hash> _pendingDiscoveries{}; /** ENTITY_DISCOVER messages to be sent, with the time to send them at */
+	std::mt19937 _randomGenerator{ std::random_device{}() };
+	double _adpSendTokens{ 0.0 }; /** Token bucket for outgoing ENTITY_AVAILABLE and ENTITY_DISCOVER messages */
+	Clock::time_point _adpSendTokensRefilledAt{};
+	UniqueIdentifier _adpAnnounceResumeEntityID{}; /** Local entity the next announcement check starts with, so entities are served in turn when the rate limit is reached */
+	AecpCommandsStatistics _aecpCommandsStatistics{};
+	AecpCommands _availableAecpCommands{}; /** Released AECP command nodes, reused by insertAecpCommand */
 	std::thread _stateMachineThread{};
 };
 
@@ -0,0 +1,261 @@
+/*
+* Copyright (C) 2016-2018, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be usefu_state,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file timerService.cpp
+* @author Christophe Calmejane
+*/
+
+#include "timerService.hpp"
+#include "la/avdecc/utils.hpp"
+#include <unordered_map>
+#include <set>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <utility>
+
+namespace la
+{
+namespace avdecc
+{
+class TimerServiceImpl final : public TimerService
+{
+public:
+	TimerServiceImpl(Clock const& clock) noexcept
+		: _clock(clock)
+	{
+	}
+
+	virtual ~TimerServiceImpl() noexcept override
+	{
+		{
+			// Lock to protect the thread state
+			std::lock_guard<decltype(_lock)> const lg(_lock);
+			_shouldTerminate = true;
+		}
+		_condVar.notify_all();
+
+		if (_thread.joinable())
+			_thread.join();
+	}
+
+	virtual TimerID addTimer(Clock::duration const period, Clock::time_point const firstExpiry, Handler&& handler) noexcept override
+	{
+		// Lock to protect _timers
+		std::lock_guard<decltype(_lock)> const lg(_lock);
+
+		auto const timerID = ++_lastTimerID;
+		_timers.emplace(timerID, Timer{ period, Clock::time_point::max(), std::move(handler) });
+		if (firstExpiry != Clock::time_point::max())
+			schedule(timerID, firstExpiry);
+
+		// Start the thread upon first timer (a manual clock is driven by checkTimers)
+		if (!_thread.joinable() && !_clock.isManual())
+		{
+			_thread = std::thread(
+				[this]
+				{
+					setCurrentThreadName("avdecc::TimerService");
+					run();
+				});
+		}
+
+		return timerID;
+	}
+
+	virtual void removeTimer(TimerID const timerID) noexcept override
+	{
+		std::unique_lock<decltype(_lock)> lock(_lock);
+
+		auto const timerIt = _timers.find(timerID);
+		if (timerIt == _timers.end())
+			return;
+
+		unschedule(timerID, timerIt->second);
+		_timers.erase(timerIt);
+
+		// Wait for the handler to complete, if running (and not removing itself)
+		if (std::this_thread::get_id() != _runningThreadID)
+		{
+			_condVar.wait(lock,
+				[this, timerID]
+				{
+					return _runningTimerID != timerID;
+				});
+		}
+	}
+
+	virtual void setTimerPeriod(TimerID const timerID, Clock::duration const period) noexcept override
+	{
+		// Lock to protect _timers
+		std::lock_guard<decltype(_lock)> const lg(_lock);
+
+		auto const timerIt = _timers.find(timerID);
+		if (timerIt == _timers.end())
+			return;
+
+		auto& timer = timerIt->second;
+		timer.period = period;
+		unschedule(timerID, timer);
+		if (period.count() > 0)
+			schedule(timerID, _clock.now() + period);
+	}
+
+	virtual void triggerTimer(TimerID const timerID) noexcept override
+	{
+		// Lock to protect _timers
+		std::lock_guard<decltype(_lock)> const lg(_lock);
+
+		auto const timerIt = _timers.find(timerID);
+		if (timerIt == _timers.end())
+			return;
+
+		unschedule(timerID, timerIt->second);
+		schedule(timerID, _clock.now());
+	}
+
+	virtual void checkTimers() noexcept override
+	{
+		std::unique_lock<decltype(_lock)> lock(_lock);
+
+		auto const now = _clock.now();
+		while (!_schedule.empty() && _schedule.begin()->first <= now)
+		{
+			runFirstTimer(lock);
+		}
+	}
+
+	virtual Clock const& getClock() const noexcept override
+	{
+		return _clock;
+	}
+
+private:
+	struct Timer
+	{
+		Clock::duration period{};
+		Clock::time_point expiry{ Clock::time_point::max() }; // Clock::time_point::max() when not scheduled
+		Handler handler{};
+	};
+	using Timers = std::unordered_map<TimerID, Timer>;
+	using Schedule = std::set<std::pair<Clock::time_point, TimerID>>; // Ordered by expiry time
+
+	// Must be called with _lock taken
+	void schedule(TimerID const timerID, Clock::time_point const expiry) noexcept
+	{
+		auto& timer = _timers[timerID];
+		timer.expiry = expiry;
+		auto const isFirst = _schedule.empty() || expiry < _schedule.begin()->first;
+		_schedule.emplace(expiry, timerID);
+
+		// Only wake up the thread if it has to wait less than before
+		if (isFirst)
+			_condVar.notify_all();
+	}
+
+	// Must be called with _lock taken
+	void unschedule(TimerID const timerID, Timer& timer) noexcept
+	{
+		if (timer.expiry != Clock::time_point::max())
+		{
+			_schedule.erase(std::make_pair(timer.expiry, timerID));
+			timer.expiry = Clock::time_point::max();
+		}
+	}
+
+	// Must be called with _lock taken (through lock), and the first scheduled timer expired
+	void runFirstTimer(std::unique_lock<std::mutex>& lock) noexcept
+	{
+		auto const [expiry, timerID] = *_schedule.begin();
+
+		// Reschedule the timer before calling the handler (so the handler can trigger or change the period), from its theoretical expiry so it doesn't drift
+		auto& timer = _timers[timerID];
+		unschedule(timerID, timer);
+		if (timer.period.count() > 0)
+		{
+			auto const now = _clock.now();
+			auto nextExpiry = expiry + timer.period;
+			if (nextExpiry <= now)
+				nextExpiry = now + timer.period;
+			schedule(timerID, nextExpiry);
+		}
+
+		// Call the handler outside the lock (on a copy, it can remove the timer)
+		auto const handler = timer.handler;
+		_runningTimerID = timerID;
+		_runningThreadID = std::this_thread::get_id();
+		lock.unlock();
+		invokeProtectedHandler(handler);
+		lock.lock();
+		_runningTimerID = InvalidTimerID;
+		_runningThreadID = std::thread::id{};
+		_condVar.notify_all();
+	}
+
+	void run() noexcept
+	{
+		std::unique_lock<decltype(_lock)> lock(_lock);
+		while (!_shouldTerminate)
+		{
+			// Nothing scheduled, wait until something is
+			if (_schedule.empty())
+			{
+				_condVar.wait(lock);
+				continue;
+			}
+
+			// Wait for the first timer to expire
+			auto const expiry = _schedule.begin()->first;
+			if (_clock.now() < expiry)
+			{
+				_condVar.wait_until(lock, expiry);
+				continue;
+			}
+
+			runFirstTimer(lock);
+		}
+	}
+
+	Clock const& _clock;
+	std::mutex _lock{};
+	std::condition_variable _condVar{};
+	bool _shouldTerminate{ false };
+	TimerID _lastTimerID{ InvalidTimerID };
+	TimerID _runningTimerID{ InvalidTimerID };
+	std::thread::id _runningThreadID{};
+	Timers _timers{};
+	Schedule _schedule{};
+	std::thread _thread{};
+};
+
+TimerService& TimerService::getInstance() noexcept
+{
+	static TimerServiceImpl s_Instance{ Clock::getDefaultClock() };
+
+	return s_Instance;
+}
+
+std::unique_ptr<TimerService> TimerService::create(Clock const& clock)
+{
+	return std::make_unique<TimerServiceImpl>(clock);
+}
+
+} // namespace avdecc
+} // namespace la
@@ -0,0 +1,86 @@
+/*
+* Copyright (C) 2016-2018, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be usefu_state,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file timerService.hpp
+* @author Christophe Calmejane
+*/
+
+#pragma once
+
+#include "la/avdecc/internals/clock.hpp"
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <cstdint>
+
+namespace la
+{
+namespace avdecc
+{
+/**
+* @brief Periodic timers shared by the whole library.
+* @details All timers are run from a single thread, sleeping until the next timer expires (no wake up at all if there is no active timer).
+*          Handlers must be short and must not block, they delay all other timers.
+*          Timers are based on a monotonic Clock (steady_clock for the shared instance), they are not affected by system time changes.
+*          With a manual Clock, no thread is started: expired timers are run by checkTimers, from the calling thread.
+*/
+class TimerService
+{
+public:
+	using Clock = la::avdecc::Clock;
+	using TimerID = std::uint64_t;
+	using Handler = std::function<void()>;
+
+	static constexpr TimerID InvalidTimerID = 0u;
+
+	/** Returns the shared instance, based on the default Clock */
+	static TimerService& getInstance() noexcept;
+	/** Creates a new instance based on the specified clock, which must outlive it */
+	static std::unique_ptr<TimerService> create(Clock const& clock);
+
+	/** Returns the clock timers are based on */
+	virtual Clock const& getClock() const noexcept = 0;
+
+	/** Adds a timer first expiring at firstExpiry (Clock::time_point::max() to wait for a trigger), then every period (a period of 0 means the timer only expires when triggered). */
+	virtual TimerID addTimer(Clock::duration const period, Clock::time_point const firstExpiry, Handler&& handler) noexcept = 0;
+	/** Removes a timer. When returning, the handler is no longer running (unless called from the handler itself) and will not be called anymore. */
+	virtual void removeTimer(TimerID const timerID) noexcept = 0;
+	/** Changes the period of a timer, the next expiry being one period from now (a period of 0 means the timer only expires when triggered). */
+	virtual void setTimerPeriod(TimerID const timerID, Clock::duration const period) noexcept = 0;
+	/** Makes the timer expire as soon as possible, next expiry being one period later. */
+	virtual void triggerTimer(TimerID const timerID) noexcept = 0;
+	/** Runs the handlers of all expired timers from the calling thread. To be called after advancing a manual Clock. */
+	virtual void checkTimers() noexcept = 0;
+
+	/** Destructor */
+	virtual ~TimerService() noexcept = default;
+
+	// Deleted compiler auto-generated methods
+	TimerService(TimerService&&) = delete;
+	TimerService(TimerService const&) = delete;
+	TimerService& operator=(TimerService const&) = delete;
+	TimerService& operator=(TimerService&&) = delete;
+
+protected:
+	TimerService() noexcept = default;
+};
+
+} // namespace avdecc
+} // namespace la
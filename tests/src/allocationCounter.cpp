@@ -0,0 +1,65 @@
+/*
+* Copyright (C) 2016-2018, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be usefu_state,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/**
+* @file allocationCounter.cpp
+* @author Christophe Calmejane
+*/
+
+#include "allocationCounter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+// Per thread, so allocations made by background threads (timers, state machines, other tests) are not counted
+static thread_local size_t s_allocations{ 0u };
+static thread_local size_t s_bytes{ 0u };
+
+void* operator new(size_t size)
+{
+	++s_allocations;
+	s_bytes += size;
+
+	if (size == 0u)
+		size = 1u;
+	if (auto* const ptr = std::malloc(size))
+		return ptr;
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t /*size*/) noexcept
+{
+	std::free(ptr);
+}
+
+AllocationCounter::AllocationCounter() noexcept
+	: _start{ s_allocations, s_bytes }
+{
+}
+
+AllocationCounter::Statistics AllocationCounter::getStatistics() const noexcept
+{
+	return Statistics{ s_allocations - _start.allocations, s_bytes - _start.bytes };
+}
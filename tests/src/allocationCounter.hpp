@@ -0,0 +1,47 @@
+/*
+* Copyright (C) 2016-2018, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be usefu_state,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/**
+* @file allocationCounter.hpp
+* @author Christophe Calmejane
+*/
+
+#pragma once
+
+#include <cstddef>
+
+/** Global operator new is replaced by the Tests executable to count heap allocations (see allocationCounter.cpp) */
+class AllocationCounter final
+{
+public:
+	struct Statistics
+	{
+		size_t allocations{ 0u };
+		size_t bytes{ 0u };
+	};
+
+	/** Allocations made by the calling thread since the counter was constructed (must be called from the thread that constructed the counter) */
+	Statistics getStatistics() const noexcept;
+
+	AllocationCounter() noexcept;
+
+private:
+	Statistics _start{};
+};
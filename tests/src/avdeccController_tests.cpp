@@ -28,14 +28,34 @@
 
 // Internal API
 #include "controller/avdeccControlledEntityImpl.hpp"
+#include "controller/avdeccControlledEntityModelTree.hpp"
+#include "controller/avdeccControlledEntityRegistry.hpp"
+#include "controller/avdeccControllerImpl.hpp"
+#include "controller/avdeccCountersPollingScheduler.hpp"
+#include "controller/avdeccInflightQueriesRegistry.hpp"
+#include "controller/avdeccNetworkSnapshot.hpp"
+#include "controller/avdeccOperationsBatchScheduler.hpp"
 #include "entity/controllerEntityImpl.hpp"
 #include "protocolInterface/protocolInterface_virtual.hpp"
+#include "protocol/protocolAemPayloads.hpp"
+#include "allocationCounter.hpp"
 
 #include <gtest/gtest.h>
 #include <string>
 #include <thread>
 #include <chrono>
 #include <future>
+#include <vector>
+#include <atomic>
+#include <iostream>
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <array>
 
 namespace
 {
@@ -289,35 +309,2643 @@ TEST(Controller, DestroyWhileSending)
 	ASSERT_NE(std::future_status::timeout, status);
 }
 
+TEST(Controller, BatchedNotifications)
+{
+	using NotificationMode = la::avdecc::controller::Controller::NotificationMode;
+
+	class Observer : public la::avdecc::controller::Controller::Observer
+	{
+	public:
+		Observer(NotificationMode const mode) noexcept
+			: _mode(mode)
+		{
+		}
+
+		NotificationMode _mode{ NotificationMode::Immediate };
+		std::atomic<size_t> _onlineCount{ 0u };
+		std::atomic<size_t> _gptpChangedCount{ 0u };
+		std::atomic<size_t> _avbInfoChangedCount{ 0u };
+		std::atomic<size_t> _batchBeginCount{ 0u };
+		std::atomic<size_t> _batchEndCount{ 0u };
+		la::avdecc::UniqueIdentifier _lastGrandMasterID{};
+
+	private:
+		virtual NotificationMode getNotificationMode() const noexcept override
+		{
+			return _mode;
+		}
+		virtual void onNotificationsBatchBegin(la::avdecc::controller::Controller const* const /*controller*/) noexcept override
+		{
+			++_batchBeginCount;
+		}
+		virtual void onNotificationsBatchEnd(la::avdecc::controller::Controller const* const /*controller*/) noexcept override
+		{
+			++_batchEndCount;
+		}
+		virtual void onEntityOnline(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/) noexcept override
+		{
+			++_onlineCount;
+		}
+		virtual void onGptpChanged(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/, la::avdecc::entity::model::AvbInterfaceIndex const /*avbInterfaceIndex*/, la::avdecc::UniqueIdentifier const grandMasterID, std::uint8_t const /*grandMasterDomain*/) noexcept override
+		{
+			++_gptpChangedCount;
+			_lastGrandMasterID = grandMasterID;
+		}
+		virtual void onAvbInfoChanged(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/, la::avdecc::entity::model::AvbInterfaceIndex const /*avbInterfaceIndex*/, la::avdecc::entity::model::AvbInfo const& /*info*/) noexcept override
+		{
+			++_avbInfoChangedCount;
+		}
+
+		DECLARE_AVDECC_OBSERVER_GUARD(Observer);
+	};
+
+	static constexpr auto BurstCount = 10u;
+	auto immediateObs = Observer{ NotificationMode::Immediate };
+	auto batchedObs = Observer{ NotificationMode::Batched };
+
+	auto controller = la::avdecc::controller::Controller::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, "BatchedNotificationsInterface", 0x0001, la::avdecc::UniqueIdentifier{ 0x0102030405060708 }, "en");
+	auto talkerInterface = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual>(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual("BatchedNotificationsInterface", { { 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b } }));
+	controller->registerObserver(&immediateObs);
+	controller->registerObserver(&batchedObs);
+
+	// Use a window long enough so that the whole burst is coalesced, the batch being flushed when batching is disabled
+	controller->enableNotificationsBatching(std::chrono::seconds(10));
+
+	auto const sendAdp = [&talkerInterface](std::uint32_t const availableIndex, la::avdecc::UniqueIdentifier const grandMasterID)
+	{
+		auto adpdu = la::avdecc::protocol::Adpdu::create();
+		// Set Ether2 fields
+		adpdu->setSrcAddress(talkerInterface->getMacAddress());
+		adpdu->setDestAddress(la::avdecc::protocol::Adpdu::Multicast_Mac_Address);
+		// Set ADP fields
+		adpdu->setMessageType(la::avdecc::protocol::AdpMessageType::EntityAvailable);
+		adpdu->setValidTime(31);
+		adpdu->setEntityID(la::avdecc::UniqueIdentifier{ 0x000102FFFE030405 });
+		adpdu->setEntityModelID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+		adpdu->setEntityCapabilities(la::avdecc::entity::EntityCapabilities::GptpSupported | la::avdecc::entity::EntityCapabilities::AemInterfaceIndexValid);
+		adpdu->setTalkerStreamSources(0);
+		adpdu->setTalkerCapabilities(la::avdecc::entity::TalkerCapabilities::None);
+		adpdu->setListenerStreamSinks(0);
+		adpdu->setListenerCapabilities(la::avdecc::entity::ListenerCapabilities::None);
+		adpdu->setControllerCapabilities(la::avdecc::entity::ControllerCapabilities::None);
+		adpdu->setAvailableIndex(availableIndex);
+		adpdu->setGptpGrandmasterID(grandMasterID);
+		adpdu->setGptpDomainNumber(0);
+		adpdu->setIdentifyControlIndex(0);
+		adpdu->setInterfaceIndex(0);
+		adpdu->setAssociationID(la::avdecc::UniqueIdentifier{});
+		talkerInterface->sendAdpMessage(std::move(adpdu));
+	};
+
+	// Messages are processed asynchronously by the controller, wait for a condition to be fulfilled
+	auto const waitFor = [](auto const& condition)
+	{
+		for (auto i = 0; i < 100 && !condition(); ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		return condition();
+	};
+
+	// Entity goes online (not a coalescable event, all observers are notified immediately)
+	sendAdp(1u, la::avdecc::UniqueIdentifier{ 0x1000u });
+	ASSERT_TRUE(waitFor(
+		[&immediateObs, &batchedObs]
+		{
+			return immediateObs._onlineCount == 1u && batchedObs._onlineCount == 1u;
+		}));
+
+	// Burst of gPTP changes
+	for (auto i = 1u; i <= BurstCount; ++i)
+	{
+		sendAdp(1u + i, la::avdecc::UniqueIdentifier{ 0x1000u + i });
+	}
+
+	// Immediate observer got all the events, Batched one nothing yet
+	ASSERT_TRUE(waitFor(
+		[&immediateObs]
+		{
+			return immediateObs._gptpChangedCount == BurstCount;
+		}));
+	EXPECT_EQ(BurstCount, immediateObs._avbInfoChangedCount);
+	EXPECT_EQ(0u, batchedObs._gptpChangedCount);
+	EXPECT_EQ(0u, batchedObs._batchBeginCount);
+
+	// Flush
+	controller->disableNotificationsBatching();
+
+	// Batched observer got a single batch, with only the last values
+	EXPECT_EQ(1u, batchedObs._batchBeginCount);
+	EXPECT_EQ(1u, batchedObs._batchEndCount);
+	EXPECT_EQ(1u, batchedObs._gptpChangedCount);
+	EXPECT_EQ(1u, batchedObs._avbInfoChangedCount);
+	EXPECT_EQ(la::avdecc::UniqueIdentifier{ 0x1000u + BurstCount }, batchedObs._lastGrandMasterID);
+	EXPECT_EQ(0u, immediateObs._batchBeginCount);
+
+	auto const stats = controller->getNotificationsStatistics();
+	EXPECT_EQ(2u * BurstCount, stats.queuedEvents);
+	EXPECT_EQ(2u * (BurstCount - 1u), stats.coalescedEvents);
+	EXPECT_EQ(2u, stats.deliveredEvents);
+	EXPECT_EQ(1u, stats.deliveredBatches);
+
+	// Batching disabled, all observers are notified immediately
+	sendAdp(2u + BurstCount, la::avdecc::UniqueIdentifier{ 0x2000u });
+	EXPECT_TRUE(waitFor(
+		[&immediateObs, &batchedObs]
+		{
+			return immediateObs._gptpChangedCount == BurstCount + 1u && batchedObs._gptpChangedCount == 2u;
+		}));
+	EXPECT_EQ(1u, batchedObs._batchBeginCount);
+}
+
+TEST(Controller, NetworkSnapshot)
+{
+	using NetworkSnapshotError = la::avdecc::controller::Controller::NetworkSnapshotError;
+
+	class Observer : public la::avdecc::controller::Controller::Observer
+	{
+	public:
+		std::atomic<size_t> _onlineCount{ 0u };
+		std::atomic<size_t> _offlineCount{ 0u };
+		std::atomic<size_t> _revalidatedCount{ 0u };
+		std::atomic<bool> _wasStaleWhenOnline{ false };
+
+	private:
+		virtual void onEntityOnline(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const entity) noexcept override
+		{
+			_wasStaleWhenOnline = entity->isStale();
+			++_onlineCount;
+		}
+		virtual void onEntityOffline(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/) noexcept override
+		{
+			++_offlineCount;
+		}
+		virtual void onEntityRevalidated(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/) noexcept override
+		{
+			++_revalidatedCount;
+		}
+
+		DECLARE_AVDECC_OBSERVER_GUARD(Observer);
+	};
+
+	static auto const FilePath = std::string{ "NetworkSnapshotTest.bin" };
+	static auto const EntityID = la::avdecc::UniqueIdentifier{ 0x000102FFFE030405 };
+	static auto const ShortLivedEntityID = la::avdecc::UniqueIdentifier{ 0x000102FFFE030406 };
+
+	auto talkerInterface = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual>(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual("NetworkSnapshotInterface", { { 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b } }));
+
+	auto const sendAdp = [&talkerInterface](la::avdecc::UniqueIdentifier const entityID, std::uint8_t const validTime, std::uint32_t const availableIndex)
+	{
+		auto adpdu = la::avdecc::protocol::Adpdu::create();
+		// Set Ether2 fields
+		adpdu->setSrcAddress(talkerInterface->getMacAddress());
+		adpdu->setDestAddress(la::avdecc::protocol::Adpdu::Multicast_Mac_Address);
+		// Set ADP fields
+		adpdu->setMessageType(la::avdecc::protocol::AdpMessageType::EntityAvailable);
+		adpdu->setValidTime(validTime);
+		adpdu->setEntityID(entityID);
+		adpdu->setEntityModelID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+		adpdu->setEntityCapabilities(la::avdecc::entity::EntityCapabilities::None);
+		adpdu->setTalkerStreamSources(0);
+		adpdu->setTalkerCapabilities(la::avdecc::entity::TalkerCapabilities::None);
+		adpdu->setListenerStreamSinks(0);
+		adpdu->setListenerCapabilities(la::avdecc::entity::ListenerCapabilities::None);
+		adpdu->setControllerCapabilities(la::avdecc::entity::ControllerCapabilities::None);
+		adpdu->setAvailableIndex(availableIndex);
+		adpdu->setGptpGrandmasterID(la::avdecc::UniqueIdentifier{});
+		adpdu->setGptpDomainNumber(0);
+		adpdu->setIdentifyControlIndex(0);
+		adpdu->setInterfaceIndex(0);
+		adpdu->setAssociationID(la::avdecc::UniqueIdentifier{});
+		talkerInterface->sendAdpMessage(std::move(adpdu));
+	};
+
+	// Messages are processed asynchronously by the controller, wait for a condition to be fulfilled
+	auto const waitFor = [](auto const& condition, std::chrono::milliseconds const timeout = std::chrono::seconds(1))
+	{
+		auto const end = std::chrono::steady_clock::now() + timeout;
+		while (!condition() && std::chrono::steady_clock::now() < end)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		return condition();
+	};
+
+	// Save the state of a first controller
+	{
+		auto obs = Observer{};
+		auto controller = la::avdecc::controller::Controller::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, "NetworkSnapshotInterface", 0x0001, la::avdecc::UniqueIdentifier{ 0x0102030405060708 }, "en");
+		controller->registerObserver(&obs);
+
+		sendAdp(EntityID, 31, 5u);
+		sendAdp(ShortLivedEntityID, 1, 5u);
+		ASSERT_TRUE(waitFor(
+			[&obs]
+			{
+				return obs._onlineCount == 2u;
+			}));
+		EXPECT_FALSE(obs._wasStaleWhenOnline);
+
+		EXPECT_EQ(NetworkSnapshotError::NoError, controller->saveNetworkSnapshot(FilePath));
+		// Saving again replaces the previous snapshot, through a temporary file which is not left behind
+		EXPECT_EQ(NetworkSnapshotError::NoError, controller->saveNetworkSnapshot(FilePath));
+		EXPECT_FALSE(std::ifstream{ FilePath + ".tmp" }.is_open());
+		EXPECT_EQ(NetworkSnapshotError::CannotOpenFile, controller->saveNetworkSnapshot("/non/existing/directory/snapshot.bin"));
+	}
+
+	// Restore it in a new controller
+	{
+		auto obs = Observer{};
+		auto controller = la::avdecc::controller::Controller::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, "NetworkSnapshotInterface", 0x0001, la::avdecc::UniqueIdentifier{ 0x0102030405060709 }, "en");
+		controller->registerObserver(&obs);
+
+		EXPECT_EQ(NetworkSnapshotError::CannotOpenFile, controller->loadNetworkSnapshot("NonExistingSnapshot.bin"));
+		ASSERT_EQ(NetworkSnapshotError::NoError, controller->loadNetworkSnapshot(FilePath));
+
+		// Entities are online right away, flagged as stale
+		EXPECT_EQ(2u, obs._onlineCount);
+		EXPECT_TRUE(obs._wasStaleWhenOnline);
+		{
+			auto const entity = controller->getControlledEntity(EntityID);
+			ASSERT_TRUE(!!entity);
+			EXPECT_TRUE(entity->isStale());
+			EXPECT_EQ(5u, entity->getEntity().getAvailableIndex());
+		}
+
+		// Entity discovered again without reboot, revalidated
+		sendAdp(EntityID, 31, 6u);
+		ASSERT_TRUE(waitFor(
+			[&obs]
+			{
+				return obs._revalidatedCount == 1u;
+			}));
+		{
+			auto const entity = controller->getControlledEntity(EntityID);
+			ASSERT_TRUE(!!entity);
+			EXPECT_FALSE(entity->isStale());
+			EXPECT_EQ(6u, entity->getEntity().getAvailableIndex());
+		}
+
+		// Entity not discovered again, declared offline after its valid time
+		EXPECT_TRUE(waitFor(
+			[&obs]
+			{
+				return obs._offlineCount == 1u;
+			},
+			std::chrono::seconds(5)));
+		EXPECT_FALSE(!!controller->getControlledEntity(ShortLivedEntityID));
+		EXPECT_TRUE(!!controller->getControlledEntity(EntityID));
+		EXPECT_EQ(2u, obs._onlineCount);
+	}
+
+	// Invalid file
+	{
+		{
+			auto file = std::ofstream{ FilePath, std::ios::binary | std::ios::trunc };
+			file << "Not a network snapshot";
+		}
+		auto controller = la::avdecc::controller::Controller::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, "NetworkSnapshotInterface", 0x0001, la::avdecc::UniqueIdentifier{ 0x0102030405060709 }, "en");
+		EXPECT_EQ(NetworkSnapshotError::InvalidFormat, controller->loadNetworkSnapshot(FilePath));
+	}
+
+	std::remove(FilePath.c_str());
+}
+
+TEST(Controller, ManualClock)
+{
+	class Observer : public la::avdecc::controller::Controller::Observer
+	{
+	public:
+		std::atomic<size_t> _onlineCount{ 0u };
+		std::atomic<size_t> _offlineCount{ 0u };
+
+	private:
+		virtual void onEntityOnline(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/) noexcept override
+		{
+			++_onlineCount;
+		}
+		virtual void onEntityOffline(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/) noexcept override
+		{
+			++_offlineCount;
+		}
+
+		DECLARE_AVDECC_OBSERVER_GUARD(Observer);
+	};
+
+	static auto const FilePath = std::string{ "ManualClockSnapshotTest.bin" };
+	static auto const EntityID = la::avdecc::UniqueIdentifier{ 0x000102FFFE030407 };
+
+	// Snapshot of an entity with the default valid time (62 seconds)
+	{
+		auto const e{ la::avdecc::entity::Entity{ EntityID, la::avdecc::networkInterface::MacAddress{ { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } }, la::avdecc::UniqueIdentifier::getNullUniqueIdentifier(), la::avdecc::entity::EntityCapabilities::None, 0, la::avdecc::entity::TalkerCapabilities::None, 0, la::avdecc::entity::ListenerCapabilities::None, la::avdecc::entity::ControllerCapabilities::None, 0, 0, la::avdecc::UniqueIdentifier::getNullUniqueIdentifier() } };
+		la::avdecc::controller::ControlledEntityImpl entity{ e };
+		auto const buffer = la::avdecc::controller::networkSnapshot::serialize({ &entity });
+		auto file = std::ofstream{ FilePath, std::ios::binary | std::ios::trunc };
+		file.write(reinterpret_cast<char const*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+	}
+
+	auto clock = la::avdecc::ManualClock{};
+	auto obs = Observer{};
+	auto controller = la::avdecc::controller::ControllerImpl::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, "ManualClockInterface", 0x0001, la::avdecc::UniqueIdentifier{ 0x010203040506070A }, "en", clock);
+	controller->registerObserver(&obs);
+
+	ASSERT_EQ(la::avdecc::controller::Controller::NetworkSnapshotError::NoError, controller->loadNetworkSnapshot(FilePath));
+	EXPECT_EQ(1u, obs._onlineCount);
+
+	// Restored entity not discovered again, only declared offline once its valid time elapsed on the clock, no matter how long it really takes
+	auto* const controllerImpl = static_cast<la::avdecc::controller::ControllerImpl*>(controller.get());
+	clock.advance(std::chrono::seconds(61));
+	controllerImpl->checkTimers();
+	EXPECT_EQ(0u, obs._offlineCount);
+	EXPECT_TRUE(!!controller->getControlledEntity(EntityID));
+
+	clock.advance(std::chrono::seconds(1));
+	controllerImpl->checkTimers();
+	EXPECT_EQ(1u, obs._offlineCount);
+	EXPECT_FALSE(!!controller->getControlledEntity(EntityID));
+
+	std::remove(FilePath.c_str());
+}
+
+TEST(Controller, BatchedNotificationsManualClock)
+{
+	using NotificationMode = la::avdecc::controller::Controller::NotificationMode;
+
+	class Observer : public la::avdecc::controller::Controller::Observer
+	{
+	public:
+		std::atomic<size_t> _onlineCount{ 0u };
+		std::atomic<size_t> _gptpChangedCount{ 0u };
+		std::atomic<size_t> _batchBeginCount{ 0u };
+
+	private:
+		virtual NotificationMode getNotificationMode() const noexcept override
+		{
+			return NotificationMode::Batched;
+		}
+		virtual void onNotificationsBatchBegin(la::avdecc::controller::Controller const* const /*controller*/) noexcept override
+		{
+			++_batchBeginCount;
+		}
+		virtual void onEntityOnline(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/) noexcept override
+		{
+			++_onlineCount;
+		}
+		virtual void onGptpChanged(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/, la::avdecc::entity::model::AvbInterfaceIndex const /*avbInterfaceIndex*/, la::avdecc::UniqueIdentifier const /*grandMasterID*/, std::uint8_t const /*grandMasterDomain*/) noexcept override
+		{
+			++_gptpChangedCount;
+		}
+
+		DECLARE_AVDECC_OBSERVER_GUARD(Observer);
+	};
+
+	auto clock = la::avdecc::ManualClock{};
+	auto obs = Observer{};
+	auto controller = la::avdecc::controller::ControllerImpl::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, "BatchedNotificationsManualClockInterface", 0x0001, la::avdecc::UniqueIdentifier{ 0x010203040506070B }, "en", clock);
+	auto* const controllerImpl = static_cast<la::avdecc::controller::ControllerImpl*>(controller.get());
+	auto talkerInterface = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual>(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual("BatchedNotificationsManualClockInterface", { { 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b } }));
+	controller->registerObserver(&obs);
+	controller->enableNotificationsBatching(std::chrono::milliseconds(20));
+
+	auto const sendAdp = [&talkerInterface](std::uint32_t const availableIndex, la::avdecc::UniqueIdentifier const grandMasterID)
+	{
+		auto adpdu = la::avdecc::protocol::Adpdu::create();
+		// Set Ether2 fields
+		adpdu->setSrcAddress(talkerInterface->getMacAddress());
+		adpdu->setDestAddress(la::avdecc::protocol::Adpdu::Multicast_Mac_Address);
+		// Set ADP fields
+		adpdu->setMessageType(la::avdecc::protocol::AdpMessageType::EntityAvailable);
+		adpdu->setValidTime(31);
+		adpdu->setEntityID(la::avdecc::UniqueIdentifier{ 0x000102FFFE030408 });
+		adpdu->setEntityModelID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+		adpdu->setEntityCapabilities(la::avdecc::entity::EntityCapabilities::GptpSupported | la::avdecc::entity::EntityCapabilities::AemInterfaceIndexValid);
+		adpdu->setTalkerStreamSources(0);
+		adpdu->setTalkerCapabilities(la::avdecc::entity::TalkerCapabilities::None);
+		adpdu->setListenerStreamSinks(0);
+		adpdu->setListenerCapabilities(la::avdecc::entity::ListenerCapabilities::None);
+		adpdu->setControllerCapabilities(la::avdecc::entity::ControllerCapabilities::None);
+		adpdu->setAvailableIndex(availableIndex);
+		adpdu->setGptpGrandmasterID(grandMasterID);
+		adpdu->setGptpDomainNumber(0);
+		adpdu->setIdentifyControlIndex(0);
+		adpdu->setInterfaceIndex(0);
+		adpdu->setAssociationID(la::avdecc::UniqueIdentifier{});
+		talkerInterface->sendAdpMessage(std::move(adpdu));
+	};
+
+	// Messages are processed asynchronously by the controller, wait for a condition to be fulfilled
+	auto const waitFor = [](auto const& condition)
+	{
+		for (auto i = 0; i < 100 && !condition(); ++i)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		return condition();
+	};
+
+	sendAdp(1u, la::avdecc::UniqueIdentifier{ 0x1000u });
+	ASSERT_TRUE(waitFor(
+		[&obs]
+		{
+			return obs._onlineCount == 1u;
+		}));
+	sendAdp(2u, la::avdecc::UniqueIdentifier{ 0x1001u });
+	ASSERT_TRUE(waitFor(
+		[&controller]
+		{
+			return controller->getNotificationsStatistics().queuedEvents == 2u;
+		}));
+
+	// No dispatcher thread, the batch is not delivered no matter how long it really takes
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	controllerImpl->checkTimers();
+	EXPECT_EQ(0u, obs._batchBeginCount);
+
+	// Only delivered once the window elapsed on the clock
+	clock.advance(std::chrono::milliseconds(19));
+	controllerImpl->checkTimers();
+	EXPECT_EQ(0u, obs._batchBeginCount);
+
+	clock.advance(std::chrono::milliseconds(1));
+	controllerImpl->checkTimers();
+	EXPECT_EQ(1u, obs._batchBeginCount);
+	EXPECT_EQ(1u, obs._gptpChangedCount);
+}
+
+TEST(NetworkSnapshot, SerializationRoundTrip)
+{
+	auto const e{ la::avdecc::entity::Entity{ la::avdecc::UniqueIdentifier{ 0x0102030405060708 }, la::avdecc::networkInterface::MacAddress{ { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } }, la::avdecc::UniqueIdentifier{ 0x1122334455667788 }, la::avdecc::entity::EntityCapabilities::AemSupported, 0, la::avdecc::entity::TalkerCapabilities::None, 2, la::avdecc::entity::ListenerCapabilities::Implemented, la::avdecc::entity::ControllerCapabilities::None, 0, 0, la::avdecc::UniqueIdentifier::getNullUniqueIdentifier() } };
+	la::avdecc::controller::ControlledEntityImpl entity{ e };
+
+	entity.setEntityDescriptor(la::avdecc::entity::model::EntityDescriptor{ la::avdecc::UniqueIdentifier{ 0x0102030405060708 }, la::avdecc::UniqueIdentifier{ 0x1122334455667788 }, la::avdecc::entity::EntityCapabilities::AemSupported, 0, la::avdecc::entity::TalkerCapabilities::None, 2, la::avdecc::entity::ListenerCapabilities::Implemented, la::avdecc::entity::ControllerCapabilities::None, 0, la::avdecc::UniqueIdentifier::getNullUniqueIdentifier(), std::string("Test entity"), la::avdecc::entity::model::getNullLocalizedStringReference(), la::avdecc::entity::model::getNullLocalizedStringReference(), std::string("Test firmware"), std::string("Test group"), std::string("Test serial number"), 1, 0 });
+	entity.setConfigurationDescriptor(la::avdecc::entity::model::ConfigurationDescriptor{ std::string("Test configuration"), la::avdecc::entity::model::getNullLocalizedStringReference(), { { la::avdecc::entity::model::DescriptorType::StreamInput, std::uint16_t{ 2 } } } }, 0);
+	entity.setStreamInputDescriptor(la::avdecc::entity::model::StreamDescriptor{ std::string("Test stream 1"), la::avdecc::entity::model::getNullLocalizedStringReference(), 0, la::avdecc::entity::StreamFlags::None, la::avdecc::entity::model::getNullStreamFormat(), la::avdecc::UniqueIdentifier::getNullUniqueIdentifier(), 0, la::avdecc::UniqueIdentifier::getNullUniqueIdentifier(), 0, la::avdecc::UniqueIdentifier::getNullUniqueIdentifier(), 0, la::avdecc::UniqueIdentifier::getNullUniqueIdentifier(), 0, 0, 0, { 0x0205022000406000, 0x0205022001006000 }, {} }, 0, 0);
+	entity.setStreamInputDescriptor(la::avdecc::entity::model::StreamDescriptor{ std::string("Test stream 2"), la::avdecc::entity::model::getNullLocalizedStringReference(), 0, la::avdecc::entity::StreamFlags::None, la::avdecc::entity::model::getNullStreamFormat(), la::avdecc::UniqueIdentifier::getNullUniqueIdentifier(), 0, la::avdecc::UniqueIdentifier::getNullUniqueIdentifier(), 0, la::avdecc::UniqueIdentifier::getNullUniqueIdentifier(), 0, la::avdecc::UniqueIdentifier::getNullUniqueIdentifier(), 0, 0, 0, {}, {} }, 0, 1);
+	entity.setAcquireState(la::avdecc::controller::model::AcquireState::AcquiredByOther);
+	entity.setOwningController(la::avdecc::UniqueIdentifier{ 0x0A0B0C0D0E0F1011 });
+	entity.getStreamInputCounters(0)[la::avdecc::entity::StreamInputCounterValidFlag::MediaLocked] = 12u;
+
+	auto const buffer = la::avdecc::controller::networkSnapshot::serialize({ &entity });
+	auto [error, entities] = la::avdecc::controller::networkSnapshot::deserialize(buffer.data(), buffer.size());
+	ASSERT_EQ(la::avdecc::controller::Controller::NetworkSnapshotError::NoError, error);
+	ASSERT_EQ(1u, entities.size());
+	auto const& restored = *entities[0];
+
+	// Same ADP and controller information
+	EXPECT_EQ(e.getEntityID(), restored.getEntity().getEntityID());
+	EXPECT_EQ(e.getMacAddress(), restored.getEntity().getMacAddress());
+	EXPECT_EQ(e.getEntityModelID(), restored.getEntity().getEntityModelID());
+	EXPECT_EQ(e.getListenerStreamSinks(), restored.getEntity().getListenerStreamSinks());
+	EXPECT_EQ(la::avdecc::controller::model::AcquireState::AcquiredByOther, restored.getAcquireState());
+	EXPECT_EQ(la::avdecc::UniqueIdentifier{ 0x0A0B0C0D0E0F1011 }, restored.getOwningControllerID());
+
+	// Same model
+	{
+		EntityModelVisitor original{};
+		entity.accept(&original);
+		EntityModelVisitor copy{};
+		restored.accept(&copy);
+		EXPECT_EQ(original.getSerializedModel(), copy.getSerializedModel());
+	}
+	EXPECT_STREQ("Test entity", restored.getEntityNode().dynamicModel->entityName.str().c_str());
+	auto const& streamNode = restored.getStreamInputNode(0, 0);
+	EXPECT_STREQ("Test stream 1", streamNode.dynamicModel->objectName.str().c_str());
+	EXPECT_EQ(2u, streamNode.staticModel->formats.size());
+	EXPECT_EQ(12u, streamNode.dynamicModel->counters.at(la::avdecc::entity::StreamInputCounterValidFlag::MediaLocked));
+
+	// Truncated buffers are rejected
+	for (auto const size : { size_t{ 0u }, size_t{ 5u }, buffer.size() / 2u, buffer.size() - 1u })
+	{
+		EXPECT_EQ(la::avdecc::controller::Controller::NetworkSnapshotError::InvalidFormat, la::avdecc::controller::networkSnapshot::deserialize(buffer.data(), size).first);
+	}
+
+	// Newer version is rejected
+	{
+		auto newerBuffer = buffer;
+		newerBuffer[5] = static_cast<std::uint8_t>(la::avdecc::controller::networkSnapshot::Version + 1u);
+		EXPECT_EQ(la::avdecc::controller::Controller::NetworkSnapshotError::UnsupportedVersion, la::avdecc::controller::networkSnapshot::deserialize(newerBuffer.data(), newerBuffer.size()).first);
+	}
+}
+
+TEST(OperationsBatchScheduler, Scheduling)
+{
+	using Scheduler = la::avdecc::controller::OperationsBatchScheduler;
+
+	auto const listener1 = la::avdecc::UniqueIdentifier{ 0x0002000000000001 };
+	auto const listener2 = la::avdecc::UniqueIdentifier{ 0x0002000000000002 };
+	auto const listener3 = la::avdecc::UniqueIdentifier{ 0x0002000000000003 };
+	auto const targetEntities = std::vector<la::avdecc::UniqueIdentifier>{ listener1, listener1, listener2, listener3, listener3 };
+
+	auto now = Scheduler::Clock::now();
+	auto scheduler = Scheduler{ targetEntities, 2u, now };
+
+	// Global concurrency limit
+	EXPECT_EQ(0u, scheduler.popNextOperation(now));
+	EXPECT_EQ(2u, scheduler.popNextOperation(now));
+	EXPECT_FALSE(scheduler.popNextOperation(now));
+	EXPECT_EQ(2u, scheduler.getInflightOperationsCount());
+
+	// Next target gets the free slot (round-robin), listener1 still has an operation pending but listener3 is served first
+	now += std::chrono::milliseconds{ 10 };
+	EXPECT_EQ(std::chrono::milliseconds{ 10 }, scheduler.completeOperation(0u, now));
+	EXPECT_EQ(3u, scheduler.popNextOperation(now));
+	EXPECT_FALSE(scheduler.popNextOperation(now));
+
+	// Only one inflight operation per target, in the order of the batch
+	scheduler.completeOperation(3u, now);
+	EXPECT_EQ(1u, scheduler.popNextOperation(now));
+	EXPECT_FALSE(scheduler.popNextOperation(now));
+	scheduler.completeOperation(2u, now);
+	EXPECT_EQ(4u, scheduler.popNextOperation(now));
+	EXPECT_FALSE(scheduler.popNextOperation(now));
+
+	now += std::chrono::milliseconds{ 5 };
+	EXPECT_EQ(std::chrono::milliseconds{ 5 }, scheduler.completeOperation(1u, now));
+	EXPECT_FALSE(scheduler.popNextOperation(now));
+	EXPECT_FALSE(scheduler.isComplete());
+	scheduler.completeOperation(4u, now);
+	EXPECT_TRUE(scheduler.isComplete());
+	EXPECT_EQ(5u, scheduler.getCompletedOperationsCount());
+	EXPECT_EQ(std::chrono::milliseconds{ 15 }, scheduler.getElapsedTime(now));
+}
+
+TEST(Controller, ExecuteAemOperations)
+{
+	using Operation = la::avdecc::controller::Controller::AemOperation;
+	using PreStep = la::avdecc::controller::Controller::AemOperationsPreStep;
+	using AemCommandStatus = la::avdecc::entity::ControllerEntity::AemCommandStatus;
+
+	auto controller = la::avdecc::controller::Controller::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, "ExecuteAemOperationsInterface", 0x0001, la::avdecc::UniqueIdentifier{ 0x0102030405060708 }, "en");
+
+	auto const entity1 = la::avdecc::UniqueIdentifier{ 0x0003000000000001 };
+	auto const entity2 = la::avdecc::UniqueIdentifier{ 0x0003000000000002 };
+	auto const operations = la::avdecc::controller::Controller::AemOperations{
+		{ entity1, Operation::Type::SetEntityName, 0u, 0u, la::avdecc::entity::model::AvdeccFixedString{ "Name" } },
+		{ entity2, Operation::Type::SetAudioUnitSamplingRate, 0u, 0u, {}, la::avdecc::entity::model::SamplingRate{ 96000u } },
+		{ entity1, Operation::Type::SetStreamInputName, 0u, 1u, la::avdecc::entity::model::AvdeccFixedString{ "Input" } },
+	};
+
+	for (auto const preStep : { PreStep::None, PreStep::Acquire })
+	{
+		auto progress = std::vector<size_t>{};
+		auto resultsPromise = std::promise<std::pair<la::avdecc::controller::Controller::AemOperationResults, la::avdecc::controller::Controller::AemOperationsStatistics>>{};
+		controller->executeAemOperations(operations, preStep, 2u,
+			[&progress](size_t const completedOperations, size_t const totalOperations)
+			{
+				EXPECT_EQ(3u, totalOperations);
+				progress.push_back(completedOperations);
+			},
+			[&resultsPromise](la::avdecc::controller::Controller::AemOperationResults const& results, la::avdecc::controller::Controller::AemOperationsStatistics const& statistics)
+			{
+				resultsPromise.set_value(std::make_pair(results, statistics));
+			});
+
+		auto resultsFuture = resultsPromise.get_future();
+		ASSERT_EQ(std::future_status::ready, resultsFuture.wait_for(std::chrono::seconds(1)));
+		auto const [results, statistics] = resultsFuture.get();
+
+		// Unknown entities: commands (or pre-steps) fail, but all operations complete
+		ASSERT_EQ(operations.size(), results.size());
+		for (auto const& result : results)
+		{
+			EXPECT_EQ(AemCommandStatus::UnknownEntity, result.status);
+		}
+		EXPECT_EQ((std::vector<size_t>{ 1u, 2u, 3u }), progress);
+		EXPECT_EQ(0u, statistics.succeededOperations);
+		EXPECT_EQ(3u, statistics.failedOperations);
+	}
+}
+
+TEST(Controller, ExecuteAemOperationsSynchronousResults)
+{
+	using Operation = la::avdecc::controller::Controller::AemOperation;
+	using PreStep = la::avdecc::controller::Controller::AemOperationsPreStep;
+	static constexpr auto OperationsCount = size_t{ 100000u };
+
+	auto controller = la::avdecc::controller::Controller::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, "ExecuteAemOperationsSyncInterface", 0x0001, la::avdecc::UniqueIdentifier{ 0x0102030405060708 }, "en");
+
+	// Unknown entity: the pre-step fails synchronously and all operations are skipped, which must not recurse once per operation
+	auto const operations = la::avdecc::controller::Controller::AemOperations(OperationsCount, { la::avdecc::UniqueIdentifier{ 0x0003000000000001 }, Operation::Type::SetEntityName, 0u, 0u, la::avdecc::entity::model::AvdeccFixedString{ "Name" } });
+
+	auto progressCount = size_t{ 0u };
+	auto statistics = la::avdecc::controller::Controller::AemOperationsStatistics{};
+	controller->executeAemOperations(operations, PreStep::Acquire, 1u,
+		[&progressCount](size_t const /*completedOperations*/, size_t const /*totalOperations*/)
+		{
+			++progressCount;
+		},
+		[&statistics](la::avdecc::controller::Controller::AemOperationResults const& /*results*/, la::avdecc::controller::Controller::AemOperationsStatistics const& stats)
+		{
+			statistics = stats;
+		});
+
+	EXPECT_EQ(OperationsCount, progressCount);
+	EXPECT_EQ(0u, statistics.succeededOperations);
+	EXPECT_EQ(OperationsCount, statistics.failedOperations);
+}
+
+TEST(Controller, BatchStreamConnectionsSynchronousResults)
+{
+	using Action = la::avdecc::controller::Controller::StreamConnectionOperation::Action;
+	static constexpr auto OperationsCount = size_t{ 100000u };
+
+	auto controller = la::avdecc::controller::Controller::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, "BatchStreamConnectionsSyncInterface", 0x0001, la::avdecc::UniqueIdentifier{ 0x0102030405060708 }, "en");
+
+	// Unknown listener: each result is reported synchronously, which must not recurse once per operation
+	auto const listenerID = la::avdecc::UniqueIdentifier{ 0x0003000000000001 };
+	auto const operations = la::avdecc::controller::Controller::StreamConnectionOperations(OperationsCount, { { la::avdecc::UniqueIdentifier{ 0x0003000000000002 }, 0u }, { listenerID, 0u }, Action::Disconnect });
+
+	auto resultsCount = size_t{ 0u };
+	auto unknownEntityCount = size_t{ 0u };
+	controller->batchStreamConnections(operations, 1u,
+		[&resultsCount, &unknownEntityCount](la::avdecc::controller::Controller::StreamConnectionOperationResults const& results, std::chrono::milliseconds const /*elapsed*/)
+		{
+			resultsCount = results.size();
+			unknownEntityCount = static_cast<size_t>(std::count_if(results.begin(), results.end(),
+				[](auto const& result)
+				{
+					return result.status == la::avdecc::entity::ControllerEntity::ControlStatus::UnknownEntity;
+				}));
+		});
+
+	EXPECT_EQ(OperationsCount, resultsCount);
+	EXPECT_EQ(OperationsCount, unknownEntityCount);
+}
+
+namespace
+{
+/** Simulated listeners, replying to CONNECT_RX and DISCONNECT_RX commands one after the other (per listener) after ProcessingTime */
+class SimulatedListeners : public la::avdecc::protocol::ProtocolInterface::Observer
+{
+public:
+	static constexpr auto ProcessingTime = std::chrono::milliseconds{ 2 };
+
+	SimulatedListeners(std::string const& interfaceName, std::uint16_t const streamsPerListener)
+		: _streamsPerListener(streamsPerListener)
+		, _pi(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(interfaceName, { { 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b } }))
+		, _localEntity(std::make_unique<la::avdecc::entity::LocalEntityGuard<la::avdecc::entity::ControllerEntityImpl>>(_pi.get(), std::uint16_t{ 2 }, la::avdecc::UniqueIdentifier{ 0u }, nullptr))
+	{
+		_pi->registerObserver(this);
+		_thread = std::thread(
+			[this]
+			{
+				auto lock = std::unique_lock<decltype(_lock)>{ _lock };
+				while (!_shouldTerminate)
+				{
+					if (_responses.empty())
+					{
+						_condVar.wait(lock);
+						continue;
+					}
+					auto const dueTime = _responses.begin()->first;
+					if (std::chrono::steady_clock::now() < dueTime)
+					{
+						_condVar.wait_until(lock, dueTime);
+						continue;
+					}
+					auto response = std::move(_responses.begin()->second);
+					_responses.erase(_responses.begin());
+					lock.unlock();
+					_pi->sendAcmpMessage(std::move(response));
+					lock.lock();
+				}
+			});
+	}
+	~SimulatedListeners() noexcept
+	{
+		{
+			auto const lg = std::lock_guard<decltype(_lock)>{ _lock };
+			_shouldTerminate = true;
+		}
+		_condVar.notify_all();
+		_thread.join();
+		_pi->unregisterObserver(this);
+	}
+
+	void advertise(la::avdecc::UniqueIdentifier const entityID) noexcept
+	{
+		auto adpdu = la::avdecc::protocol::Adpdu::create();
+		adpdu->setSrcAddress(_pi->getMacAddress());
+		adpdu->setDestAddress(la::avdecc::protocol::Adpdu::Multicast_Mac_Address);
+		adpdu->setMessageType(la::avdecc::protocol::AdpMessageType::EntityAvailable);
+		adpdu->setValidTime(31);
+		adpdu->setEntityID(entityID);
+		adpdu->setEntityModelID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+		adpdu->setEntityCapabilities(la::avdecc::entity::EntityCapabilities::None);
+		adpdu->setTalkerStreamSources(0);
+		adpdu->setTalkerCapabilities(la::avdecc::entity::TalkerCapabilities::None);
+		adpdu->setListenerStreamSinks(_streamsPerListener);
+		adpdu->setListenerCapabilities(la::avdecc::entity::ListenerCapabilities::Implemented | la::avdecc::entity::ListenerCapabilities::AudioSink);
+		adpdu->setControllerCapabilities(la::avdecc::entity::ControllerCapabilities::None);
+		adpdu->setAvailableIndex(1);
+		adpdu->setGptpGrandmasterID(la::avdecc::UniqueIdentifier{});
+		adpdu->setGptpDomainNumber(0);
+		adpdu->setIdentifyControlIndex(0);
+		adpdu->setInterfaceIndex(0);
+		adpdu->setAssociationID(la::avdecc::UniqueIdentifier{});
+		_pi->sendAdpMessage(std::move(adpdu));
+	}
+
+private:
+	virtual void onTransportError(la::avdecc::protocol::ProtocolInterface* const /*pi*/) noexcept override {}
+	virtual void onAcmpSniffedCommand(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::entity::LocalEntity const& /*entity*/, la::avdecc::protocol::Acmpdu const& acmpdu) noexcept override
+	{
+		auto const messageType = acmpdu.getMessageType();
+		auto const isConnect = messageType == la::avdecc::protocol::AcmpMessageType::ConnectRxCommand;
+		if (!isConnect && messageType != la::avdecc::protocol::AcmpMessageType::DisconnectRxCommand)
+			return;
+
+		auto response = acmpdu.copy();
+		response->setSrcAddress(_pi->getMacAddress());
+		response->setMessageType(isConnect ? la::avdecc::protocol::AcmpMessageType::ConnectRxResponse : la::avdecc::protocol::AcmpMessageType::DisconnectRxResponse);
+		response->setStatus(la::avdecc::protocol::AcmpStatus::Success);
+		response->setConnectionCount(isConnect ? 1u : 0u);
+
+		{
+			auto const lg = std::lock_guard<decltype(_lock)>{ _lock };
+			// A listener processes its commands one after the other
+			auto& busyUntil = _listenersBusyUntil[acmpdu.getListenerEntityID()];
+			busyUntil = std::max(busyUntil, std::chrono::steady_clock::now()) + ProcessingTime;
+			_responses.emplace(busyUntil, std::move(response));
+		}
+		_condVar.notify_all();
+	}
+
+	std::uint16_t const _streamsPerListener{ 0u };
+	std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual> _pi{ nullptr };
+	std::unique_ptr<la::avdecc::entity::LocalEntityGuard<la::avdecc::entity::ControllerEntityImpl>> _localEntity{ nullptr };
+	std::mutex _lock{};
+	std::condition_variable _condVar{};
+	bool _shouldTerminate{ false };
+	std::multimap<std::chrono::steady_clock::time_point, la::avdecc::protocol::Acmpdu::UniquePointer> _responses{};
+	std::unordered_map<la::avdecc::UniqueIdentifier, std::chrono::steady_clock::time_point, la::avdecc::UniqueIdentifier::hash> _listenersBusyUntil{};
+	std::thread _thread{};
+
+	DECLARE_AVDECC_OBSERVER_GUARD(SimulatedListeners);
+};
+
+/** Controller and online simulated listeners, with a scene connecting all the streams of all the listeners (in listener order, as a user would build it) */
+class StreamConnectionsScene
+{
+public:
+	using Results = la::avdecc::controller::Controller::StreamConnectionOperationResults;
+
+	StreamConnectionsScene(std::string const& interfaceName, std::uint32_t const listenersCount, std::uint16_t const streamsPerListener)
+		: _controller(la::avdecc::controller::Controller::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, interfaceName, 0x0001, la::avdecc::UniqueIdentifier{ 0x0102030405060708 }, "en"))
+		, _listeners(interfaceName, streamsPerListener)
+	{
+		using Action = la::avdecc::controller::Controller::StreamConnectionOperation::Action;
+		static auto const TalkerID = la::avdecc::UniqueIdentifier{ 0x0001000000000000 };
+
+		for (auto listener = 0u; listener < listenersCount; ++listener)
+		{
+			auto const listenerID = la::avdecc::UniqueIdentifier{ FirstListenerID + listener };
+			_listeners.advertise(listenerID);
+			for (auto stream = 0u; stream < streamsPerListener; ++stream)
+			{
+				_operations.push_back({ { TalkerID, la::avdecc::entity::model::StreamIndex(stream) }, { listenerID, la::avdecc::entity::model::StreamIndex(stream) }, Action::Connect });
+			}
+		}
+
+		// Wait for all listeners to be online
+		for (auto i = 0; i < 100; ++i)
+		{
+			auto online = 0u;
+			for (auto listener = 0u; listener < listenersCount; ++listener)
+			{
+				if (_controller->getControlledEntity(la::avdecc::UniqueIdentifier{ FirstListenerID + listener }))
+					++online;
+			}
+			if (online == listenersCount)
+				break;
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+
+	la::avdecc::controller::Controller::StreamConnectionOperations const& getOperations() const noexcept
+	{
+		return _operations;
+	}
+
+	/** Recalls the scene, returning the results and the elapsed time */
+	std::pair<Results, std::chrono::milliseconds> recall(std::uint32_t const maxInflightOperations) const
+	{
+		auto promise = std::promise<std::pair<Results, std::chrono::milliseconds>>{};
+		_controller->batchStreamConnections(_operations, maxInflightOperations,
+			[&promise](Results const& results, std::chrono::milliseconds const elapsed)
+			{
+				promise.set_value(std::make_pair(results, elapsed));
+			});
+		auto future = promise.get_future();
+		EXPECT_EQ(std::future_status::ready, future.wait_for(std::chrono::seconds(30)));
+		return future.get();
+	}
+
+private:
+	static constexpr auto FirstListenerID = std::uint64_t{ 0x0002000000000000 };
+
+	la::avdecc::controller::Controller::UniquePointer _controller{ nullptr, nullptr };
+	SimulatedListeners _listeners;
+	la::avdecc::controller::Controller::StreamConnectionOperations _operations{};
+};
+} // namespace
+
+TEST(Controller, BatchStreamConnections)
+{
+	auto const scene = StreamConnectionsScene{ "BatchStreamConnectionsInterface", 4u, 4u };
+
+	for (auto const maxInflightOperations : { 1u, 8u })
+	{
+		auto const [results, elapsed] = scene.recall(maxInflightOperations);
+
+		// All operations succeed, each one taking at least the processing time of the listener
+		ASSERT_EQ(scene.getOperations().size(), results.size());
+		for (auto const& result : results)
+		{
+			EXPECT_EQ(la::avdecc::entity::ControllerEntity::ControlStatus::Success, result.status);
+			EXPECT_LE(SimulatedListeners::ProcessingTime, result.duration);
+		}
+		EXPECT_LE(SimulatedListeners::ProcessingTime, elapsed);
+	}
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests
+TEST(Controller, DISABLED_BatchStreamConnectionsBenchmark)
+{
+	static constexpr auto ListenersCount = 20u;
+	static constexpr auto StreamsPerListener = std::uint16_t{ 25u };
+
+	auto const scene = StreamConnectionsScene{ "BatchStreamConnectionsBenchmarkInterface", ListenersCount, StreamsPerListener };
+
+	auto const recallScene = [&scene](std::uint32_t const maxInflightOperations)
+	{
+		auto const [results, elapsed] = scene.recall(maxInflightOperations);
+
+		EXPECT_EQ(scene.getOperations().size(), results.size());
+		auto successCount = size_t{ 0u };
+		auto maxDuration = std::chrono::milliseconds{ 0 };
+		for (auto const& result : results)
+		{
+			if (result.status == la::avdecc::entity::ControllerEntity::ControlStatus::Success)
+				++successCount;
+			maxDuration = std::max(maxDuration, result.duration);
+		}
+		EXPECT_EQ(scene.getOperations().size(), successCount);
+		std::cout << "[ BENCH    ] Scene recall of " << scene.getOperations().size() << " connections (" << ListenersCount << " listeners, " << SimulatedListeners::ProcessingTime.count() << " msec per command), " << maxInflightOperations << " inflight: " << elapsed.count() << " msec (slowest operation " << maxDuration.count() << " msec)" << std::endl;
+		return elapsed;
+	};
+
+	auto const sequential = recallScene(1u);
+	auto const pipelined = recallScene(32u);
+	EXPECT_LT(pipelined, sequential);
+}
+
 TEST(StreamConnectionState, Comparison)
 {
-	// Not connected
+	// Not connected
+	{
+		auto const s1{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{}, la::avdecc::entity::model::StreamIdentification{}, la::avdecc::controller::model::StreamConnectionState::State::NotConnected } };
+		auto const s2{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{}, la::avdecc::entity::model::StreamIdentification{ la::avdecc::UniqueIdentifier{ 0x1 }, 1 }, la::avdecc::controller::model::StreamConnectionState::State::NotConnected } };
+		auto const s3{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{ la::avdecc::UniqueIdentifier{ 0x1 }, 1 }, la::avdecc::entity::model::StreamIdentification{}, la::avdecc::controller::model::StreamConnectionState::State::NotConnected } };
+		EXPECT_EQ(s2, s1) << "Talker StreamIdentification ignored when not connected";
+		EXPECT_NE(s3, s1);
+		EXPECT_NE(s3, s2);
+	}
+
+	// FastConnecting
+	{
+		auto const s1{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{}, la::avdecc::entity::model::StreamIdentification{}, la::avdecc::controller::model::StreamConnectionState::State::FastConnecting } };
+		auto const s2{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{}, la::avdecc::entity::model::StreamIdentification{ la::avdecc::UniqueIdentifier{ 0x1 }, 1 }, la::avdecc::controller::model::StreamConnectionState::State::FastConnecting } };
+		auto const s3{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{ la::avdecc::UniqueIdentifier{ 0x1 }, 1 }, la::avdecc::entity::model::StreamIdentification{}, la::avdecc::controller::model::StreamConnectionState::State::FastConnecting } };
+		EXPECT_NE(s2, s1) << "Talker StreamIdentification not ignored when fast connecting";
+		EXPECT_NE(s3, s1);
+		EXPECT_NE(s3, s2);
+	}
+
+	// Connected
+	{
+		auto const s1{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{}, la::avdecc::entity::model::StreamIdentification{}, la::avdecc::controller::model::StreamConnectionState::State::Connected } };
+		auto const s2{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{}, la::avdecc::entity::model::StreamIdentification{ la::avdecc::UniqueIdentifier{ 0x1 }, 1 }, la::avdecc::controller::model::StreamConnectionState::State::Connected } };
+		auto const s3{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{ la::avdecc::UniqueIdentifier{ 0x1 }, 1 }, la::avdecc::entity::model::StreamIdentification{}, la::avdecc::controller::model::StreamConnectionState::State::Connected } };
+		EXPECT_NE(s2, s1) << "Talker StreamIdentification not ignored when connected";
+		EXPECT_NE(s3, s1);
+		EXPECT_NE(s3, s2);
+	}
+}
+
+namespace
+{
+la::avdecc::controller::ControlledEntityRegistry::OnlineControlledEntity makeRegistryEntity(la::avdecc::UniqueIdentifier const entityID)
+{
+	auto const e{ la::avdecc::entity::Entity{ entityID, la::avdecc::networkInterface::MacAddress{}, la::avdecc::UniqueIdentifier{ 0x1122334455667788 }, la::avdecc::entity::EntityCapabilities::None, 0, la::avdecc::entity::TalkerCapabilities::None, 0, la::avdecc::entity::ListenerCapabilities::None, la::avdecc::entity::ControllerCapabilities::None, 0, 0, la::avdecc::UniqueIdentifier::getNullUniqueIdentifier() } };
+	return std::make_shared<la::avdecc::controller::ControlledEntityImpl>(e);
+}
+} // namespace
+
+TEST(ControlledEntityRegistry, OnlineOffline)
+{
+	la::avdecc::controller::ControlledEntityRegistry registry{};
+	auto const entityID = la::avdecc::UniqueIdentifier{ 0x0102030405060708 };
+
+	EXPECT_FALSE(registry.find(entityID));
+
+	auto const entity = makeRegistryEntity(entityID);
+	EXPECT_TRUE(registry.insert(entityID, entity));
+	EXPECT_EQ(entity, registry.find(entityID));
+
+	// Already online, should not be replaced
+	EXPECT_FALSE(registry.insert(entityID, makeRegistryEntity(entityID)));
+	EXPECT_EQ(entity, registry.find(entityID));
+
+	// A reference taken before going offline stays valid
+	auto const lookedUp = registry.find(entityID);
+	EXPECT_EQ(entity, registry.erase(entityID));
+	EXPECT_FALSE(registry.find(entityID));
+	EXPECT_FALSE(registry.erase(entityID));
+	ASSERT_TRUE(lookedUp);
+	EXPECT_EQ(entityID, lookedUp->getEntity().getEntityID());
+
+	// Clear returns all entities
+	for (auto i = 0u; i < 100u; ++i)
+	{
+		auto const id = la::avdecc::UniqueIdentifier{ 0x001B92FFFE000000u + i };
+		EXPECT_TRUE(registry.insert(id, makeRegistryEntity(id)));
+	}
+	EXPECT_EQ(100u, registry.getAll().size());
+	EXPECT_EQ(100u, registry.clear().size());
+	EXPECT_EQ(0u, registry.getAll().size());
+}
+
+TEST(ControlledEntityRegistry, ConcurrentLookups)
+{
+	static constexpr auto EntitiesCount = 256u;
+	static constexpr auto ChurnEntitiesCount = 64u;
+	static constexpr auto LookupsPerThread = 20000u;
+	static constexpr auto ThreadsCount = 4u;
+
+	la::avdecc::controller::ControlledEntityRegistry registry{};
+	for (auto i = 0u; i < EntitiesCount; ++i)
+	{
+		auto const id = la::avdecc::UniqueIdentifier{ 0x001B92FFFE000000u + i };
+		registry.insert(id, makeRegistryEntity(id));
+	}
+
+	// Other entities constantly switching online/offline while looking up
+	auto shouldStop = std::atomic_bool{ false };
+	auto churnThread = std::thread(
+		[&shouldStop, &registry]
+		{
+			while (!shouldStop)
+			{
+				for (auto i = 0u; i < ChurnEntitiesCount; ++i)
+				{
+					auto const id = la::avdecc::UniqueIdentifier{ 0x00AA00FFFE000000u + i };
+					registry.insert(id, makeRegistryEntity(id));
+				}
+				for (auto i = 0u; i < ChurnEntitiesCount; ++i)
+				{
+					registry.erase(la::avdecc::UniqueIdentifier{ 0x00AA00FFFE000000u + i });
+				}
+			}
+		});
+
+	auto missingCount = std::atomic<std::uint32_t>{ 0u };
+	auto lookupThreads = std::vector<std::thread>{};
+	for (auto t = 0u; t < ThreadsCount; ++t)
+	{
+		lookupThreads.emplace_back(
+			[&registry, &missingCount, t]
+			{
+				for (auto i = 0u; i < LookupsPerThread; ++i)
+				{
+					if (!registry.find(la::avdecc::UniqueIdentifier{ 0x001B92FFFE000000u + (i * 7u + t) % EntitiesCount }))
+					{
+						++missingCount;
+					}
+				}
+			});
+	}
+	for (auto& thread : lookupThreads)
+	{
+		thread.join();
+	}
+	shouldStop = true;
+	churnThread.join();
+
+	// Entities that were never removed must always be found
+	EXPECT_EQ(0u, missingCount);
+	EXPECT_EQ(EntitiesCount, registry.getAll().size());
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests
+TEST(ControlledEntityRegistry, DISABLED_ConcurrentLookupsBenchmark)
+{
+	static constexpr auto EntitiesCount = 2048u;
+	static constexpr auto ChurnEntitiesCount = 64u;
+	static constexpr auto LookupsPerThread = 200000u;
+	auto const threadsCount = std::max(4u, std::thread::hardware_concurrency());
+
+	auto entityIDs = std::vector<la::avdecc::UniqueIdentifier>{};
+	for (auto i = 0u; i < EntitiesCount; ++i)
+	{
+		entityIDs.push_back(la::avdecc::UniqueIdentifier{ 0x001B92FFFE000000u + i });
+	}
+
+	// Run the same workload (N lookup threads, one thread constantly switching other entities online/offline) on both implementations
+	auto const runBenchmark = [&entityIDs, threadsCount](auto&& lookup, auto&& online, auto&& offline)
+	{
+		for (auto const& entityID : entityIDs)
+		{
+			online(entityID);
+		}
+
+		auto shouldStop = std::atomic_bool{ false };
+		auto missingCount = std::atomic<std::uint32_t>{ 0u };
+		auto churnThread = std::thread(
+			[&shouldStop, &online, &offline]
+			{
+				while (!shouldStop)
+				{
+					for (auto i = 0u; i < ChurnEntitiesCount; ++i)
+					{
+						online(la::avdecc::UniqueIdentifier{ 0x00AA00FFFE000000u + i });
+					}
+					for (auto i = 0u; i < ChurnEntitiesCount; ++i)
+					{
+						offline(la::avdecc::UniqueIdentifier{ 0x00AA00FFFE000000u + i });
+					}
+				}
+			});
+
+		auto const startTime = std::chrono::steady_clock::now();
+		auto lookupThreads = std::vector<std::thread>{};
+		for (auto t = 0u; t < threadsCount; ++t)
+		{
+			lookupThreads.emplace_back(
+				[&entityIDs, &lookup, &missingCount, t]
+				{
+					for (auto i = 0u; i < LookupsPerThread; ++i)
+					{
+						if (!lookup(entityIDs[(i * 7u + t) % EntitiesCount]))
+						{
+							++missingCount;
+						}
+					}
+				});
+		}
+		for (auto& thread : lookupThreads)
+		{
+			thread.join();
+		}
+		auto const duration = std::chrono::steady_clock::now() - startTime;
+
+		shouldStop = true;
+		churnThread.join();
+
+		// Entities that were never removed must always be found
+		EXPECT_EQ(0u, missingCount);
+
+		return std::chrono::duration_cast<std::chrono::microseconds>(duration);
+	};
+
+	// Previous implementation: single map protected by a mutex
+	auto mutexDuration = std::chrono::microseconds{};
+	{
+		auto lock = std::mutex{};
+		auto entities = la::avdecc::controller::ControlledEntityRegistry::Entities{};
+		mutexDuration = runBenchmark(
+			[&lock, &entities](la::avdecc::UniqueIdentifier const entityID)
+			{
+				std::lock_guard<decltype(lock)> const lg(lock);
+				auto const it = entities.find(entityID);
+				return it != entities.end() ? it->second : la::avdecc::controller::ControlledEntityRegistry::OnlineControlledEntity{};
+			},
+			[&lock, &entities](la::avdecc::UniqueIdentifier const entityID)
+			{
+				auto entity = makeRegistryEntity(entityID);
+				std::lock_guard<decltype(lock)> const lg(lock);
+				entities.insert(std::make_pair(entityID, std::move(entity)));
+			},
+			[&lock, &entities](la::avdecc::UniqueIdentifier const entityID)
+			{
+				std::lock_guard<decltype(lock)> const lg(lock);
+				entities.erase(entityID);
+			});
+	}
+
+	// Registry
+	auto registryDuration = std::chrono::microseconds{};
+	{
+		la::avdecc::controller::ControlledEntityRegistry registry{};
+		registryDuration = runBenchmark(
+			[&registry](la::avdecc::UniqueIdentifier const entityID)
+			{
+				return registry.find(entityID);
+			},
+			[&registry](la::avdecc::UniqueIdentifier const entityID)
+			{
+				registry.insert(entityID, makeRegistryEntity(entityID));
+			},
+			[&registry](la::avdecc::UniqueIdentifier const entityID)
+			{
+				registry.erase(entityID);
+			});
+	}
+
+	auto const totalLookups = static_cast<double>(threadsCount) * LookupsPerThread;
+	std::cout << "[ BENCH    ] " << threadsCount << " threads, " << EntitiesCount << " entities: mutex map " << (totalLookups / mutexDuration.count()) << " lookups/us, registry " << (totalLookups / registryDuration.count()) << " lookups/us" << std::endl;
+}
+
+TEST(CountersPollingScheduler, Pacing)
+{
+	using Scheduler = la::avdecc::controller::CountersPollingScheduler;
+	using Kind = la::avdecc::controller::Controller::CountersKind;
+	constexpr auto EntitiesCount = 20u;
+	constexpr auto MaxQueriesPerSecond = 10u;
+
+	Scheduler scheduler{};
+	scheduler.setMaxQueriesPerSecond(MaxQueriesPerSecond);
+	scheduler.setDefaultInterval(Kind::ClockDomain, std::chrono::milliseconds{ 0 }, Scheduler::Clock::now()); // Disabled
+
+	// All entities going online at the same time
+	auto const start = Scheduler::Clock::now();
+	for (auto i = 0u; i < EntitiesCount; ++i)
+	{
+		scheduler.addEntity(la::avdecc::UniqueIdentifier{ static_cast<std::uint64_t>(0x0001000000000000 + i) }, Scheduler::DescriptorsCount{ 1u, 1u, 2u }, start);
+	}
+
+	// Simulate 60 seconds, sending queries as soon as the scheduler allows it
+	auto sentTimes = std::vector<Scheduler::Clock::time_point>{};
+	auto now = start;
+	auto const end = start + std::chrono::seconds{ 60 };
+	while (now < end)
+	{
+		auto const query = scheduler.popNextQuery(now);
+		if (query)
+		{
+			EXPECT_NE(Kind::ClockDomain, query->kind);
+			sentTimes.push_back(now);
+			continue;
+		}
+		now = std::max(now + std::chrono::milliseconds{ 1 }, std::min(scheduler.getNextWakeUpTime(), end));
+	}
+
+	// Budget is the bottleneck (60 queries per 10 seconds wanted, 10 per second allowed): never 2 queries closer than 1/MaxQueriesPerSecond
+	ASSERT_FALSE(sentTimes.empty());
+	for (auto i = 1u; i < sentTimes.size(); ++i)
+	{
+		EXPECT_GE(sentTimes[i] - sentTimes[i - 1], std::chrono::milliseconds{ 1000 / MaxQueriesPerSecond });
+	}
+	EXPECT_LE(sentTimes.size(), 60u * MaxQueriesPerSecond + 1u);
+	EXPECT_EQ(sentTimes.size(), scheduler.getStatistics().sentQueries);
+}
+
+TEST(CountersPollingScheduler, BackOffAndWatched)
+{
+	using Scheduler = la::avdecc::controller::CountersPollingScheduler;
+	using Kind = la::avdecc::controller::Controller::CountersKind;
+
+	auto const entity1 = la::avdecc::UniqueIdentifier{ 0x0001000000000001 };
+	auto const entity2 = la::avdecc::UniqueIdentifier{ 0x0001000000000002 };
+	auto const start = Scheduler::Clock::now();
+
+	Scheduler scheduler{};
+	scheduler.setMaxQueriesPerSecond(1000u);
+	scheduler.addEntity(entity1, Scheduler::DescriptorsCount{ 1u, 0u, 0u }, start);
+	scheduler.addEntity(entity2, Scheduler::DescriptorsCount{ 1u, 0u, 0u }, start);
+
+	// Both entities are due after one interval, the watched one is sent first whatever its scheduled time
+	scheduler.setEntityWatched(entity2, true);
+	auto now = start + Scheduler::DefaultInterval;
+	auto query = scheduler.popNextQuery(now);
+	ASSERT_TRUE(query);
+	EXPECT_EQ(entity2, query->entityID);
+	now += std::chrono::seconds{ 1 };
+	query = scheduler.popNextQuery(now);
+	ASSERT_TRUE(query);
+	EXPECT_EQ(entity1, query->entityID);
+	EXPECT_FALSE(scheduler.popNextQuery(now + std::chrono::seconds{ 1 }));
+
+	// Unsolicited counters received for entity1: not polled during BackOffFactor intervals
+	scheduler.onUnsolicitedCounters(entity1, Kind::AvbInterface, 0u, now);
+	EXPECT_EQ(1u, scheduler.getStatistics().postponedQueries);
+	for (auto elapsed = std::chrono::seconds{ 1 }; elapsed < Scheduler::BackOffFactor * Scheduler::DefaultInterval; elapsed += std::chrono::seconds{ 1 })
+	{
+		auto const q = scheduler.popNextQuery(now + elapsed);
+		if (q)
+		{
+			EXPECT_EQ(entity2, q->entityID);
+		}
+	}
+
+	// Per entity interval overrides, 0 disabling the polling
+	now += Scheduler::BackOffFactor * Scheduler::DefaultInterval;
+	scheduler.setEntityInterval(entity1, Kind::AvbInterface, std::chrono::milliseconds{ 0 }, now);
+	scheduler.setEntityInterval(entity2, Kind::AvbInterface, std::chrono::milliseconds{ 0 }, now);
+	EXPECT_EQ(Scheduler::Clock::time_point::max(), scheduler.getNextWakeUpTime());
+	scheduler.clearEntityIntervals(entity1, now);
+	EXPECT_LE(scheduler.getNextWakeUpTime(), now + Scheduler::DefaultInterval);
+
+	// Offline entities are no longer polled
+	scheduler.removeEntity(entity1);
+	EXPECT_EQ(Scheduler::Clock::time_point::max(), scheduler.getNextWakeUpTime());
+}
+
+TEST(CountersPollingScheduler, WatchedDoNotStarve)
+{
+	using Scheduler = la::avdecc::controller::CountersPollingScheduler;
+
+	static constexpr auto WatchedEntitiesCount = 100u;
+	static constexpr auto MaxQueriesPerSecond = 10u; // Far less than what watched entities need
+	auto const normalEntity = la::avdecc::UniqueIdentifier{ 0x0001000000000001 };
+	auto const start = Scheduler::Clock::now();
+
+	Scheduler scheduler{};
+	scheduler.setMaxQueriesPerSecond(MaxQueriesPerSecond);
+	scheduler.addEntity(normalEntity, Scheduler::DescriptorsCount{ 1u, 0u, 0u }, start);
+	for (auto i = 0u; i < WatchedEntitiesCount; ++i)
+	{
+		auto const entityID = la::avdecc::UniqueIdentifier{ static_cast<std::uint64_t>(0x0002000000000000 + i) };
+		scheduler.setEntityWatched(entityID, true);
+		scheduler.addEntity(entityID, Scheduler::DescriptorsCount{ 1u, 0u, 0u }, start);
+	}
+
+	// Watched entities are always due, the not watched entity is still polled at every interval (delayed by at most MaxWatchedQueriesInRow queries)
+	auto normalQueries = std::vector<Scheduler::Clock::time_point>{};
+	auto watchedQueries = size_t{ 0u };
+	auto const end = start + 5 * Scheduler::DefaultInterval;
+	for (auto now = start; now < end; now += std::chrono::milliseconds{ 10 })
+	{
+		if (auto const query = scheduler.popNextQuery(now))
+		{
+			if (query->entityID == normalEntity)
+				normalQueries.push_back(now);
+			else
+				++watchedQueries;
+		}
+	}
+	ASSERT_LE(4u, normalQueries.size());
+	auto const maxDelay = (Scheduler::MaxWatchedQueriesInRow + 1u) * std::chrono::milliseconds{ 1000u / MaxQueriesPerSecond };
+	for (auto i = 1u; i < normalQueries.size(); ++i)
+	{
+		EXPECT_GE(Scheduler::DefaultInterval + maxDelay, normalQueries[i] - normalQueries[i - 1]);
+	}
+	EXPECT_LT(normalQueries.size() * 10u, watchedQueries);
+}
+
+TEST(InflightQueriesRegistry, Deduplication)
+{
+	using Registry = la::avdecc::controller::InflightQueriesRegistry;
+	using QueryKind = Registry::QueryKind;
+
+	auto const entity1 = la::avdecc::UniqueIdentifier{ 0x0004000000000001 };
+	auto const entity2 = la::avdecc::UniqueIdentifier{ 0x0004000000000002 };
+	auto const streamInfo = Registry::Key{ entity1, QueryKind::DynamicInfo, 7u, 0u, 1u, 0u };
+	auto const strings = Registry::Key{ entity1, QueryKind::Descriptor, static_cast<std::uint16_t>(la::avdecc::entity::model::DescriptorType::Strings), 0u, 3u, 0u };
+
+	auto now = Registry::Clock::now();
+	auto registry = Registry{};
+
+	// Identical query is not sent while the first one is inflight
+	EXPECT_TRUE(registry.registerQuery(streamInfo, now));
+	EXPECT_FALSE(registry.registerQuery(streamInfo, now));
+	EXPECT_FALSE(registry.registerQuery(streamInfo, now));
+
+	// Any difference in the key is another query
+	EXPECT_TRUE(registry.registerQuery(strings, now));
+	EXPECT_TRUE(registry.registerQuery(Registry::Key{ entity2, QueryKind::DynamicInfo, 7u, 0u, 1u, 0u }, now));
+	EXPECT_TRUE(registry.registerQuery(Registry::Key{ entity1, QueryKind::DynamicInfo, 7u, 0u, 1u, 1u }, now));
+	EXPECT_TRUE(registry.registerQuery(Registry::Key{ entity1, QueryKind::DescriptorDynamicInfo, 7u, 0u, 1u, 0u }, now));
+
+	// Once completed, the query can be sent again (retry)
+	registry.completeQuery(streamInfo);
+	EXPECT_FALSE(registry.isInflight(streamInfo));
+	EXPECT_TRUE(registry.registerQuery(streamInfo, now));
+
+	// A query inflight for too long is considered lost
+	now += Registry::MaxInflightDuration;
+	EXPECT_TRUE(registry.registerQuery(strings, now));
+
+	// Offline entity
+	registry.removeQueries(entity1);
+	EXPECT_FALSE(registry.isInflight(streamInfo));
+	EXPECT_FALSE(registry.isInflight(strings));
+	EXPECT_TRUE(registry.isInflight(Registry::Key{ entity2, QueryKind::DynamicInfo, 7u, 0u, 1u, 0u }));
+
+	EXPECT_EQ(7u, registry.getStatistics().sentQueries);
+	EXPECT_EQ(2u, registry.getStatistics().deduplicatedQueries);
+}
+
+TEST(InflightQueriesRegistry, ResendAfterCompletion)
+{
+	using Registry = la::avdecc::controller::InflightQueriesRegistry;
+	using QueryKind = Registry::QueryKind;
+
+	auto const streamInfo = Registry::Key{ la::avdecc::UniqueIdentifier{ 0x0004000000000001 }, QueryKind::DynamicInfo, 7u, 0u, 1u, 0u };
+	auto const strings = Registry::Key{ la::avdecc::UniqueIdentifier{ 0x0004000000000001 }, QueryKind::Descriptor, static_cast<std::uint16_t>(la::avdecc::entity::model::DescriptorType::Strings), 0u, 3u, 0u };
+	auto const sendTime = Registry::Clock::now();
+	auto const before = sendTime - std::chrono::milliseconds{ 100 };
+	auto const after = sendTime + std::chrono::milliseconds{ 100 };
+	auto registry = Registry{};
+	auto resentCount = size_t{ 0u };
+	auto const resendHandler = [&resentCount](la::avdecc::entity::ControllerEntity* const /*controller*/)
+	{
+		++resentCount;
+	};
+
+	// No identical query while inflight, nothing to send again
+	EXPECT_TRUE(registry.registerQuery(streamInfo, sendTime, sendTime, resendHandler));
+	EXPECT_FALSE(!!registry.completeQuery(streamInfo));
+
+	// Identical dynamic query triggered before the inflight one was sent (delayed query): shares its result
+	EXPECT_TRUE(registry.registerQuery(streamInfo, sendTime, sendTime, resendHandler));
+	EXPECT_FALSE(registry.registerQuery(streamInfo, after, before, resendHandler));
+	EXPECT_FALSE(!!registry.completeQuery(streamInfo));
+	EXPECT_EQ(1u, registry.getStatistics().deduplicatedQueries);
+
+	// Identical descriptor query (static): shares its result, whenever triggered
+	EXPECT_TRUE(registry.registerQuery(strings, sendTime, sendTime, resendHandler));
+	EXPECT_FALSE(registry.registerQuery(strings, after, after, resendHandler));
+	EXPECT_FALSE(!!registry.completeQuery(strings));
+	EXPECT_EQ(2u, registry.getStatistics().deduplicatedQueries);
+
+	// Identical dynamic queries triggered after the inflight one was sent (change notifications): merged and sent once again when the inflight one completes
+	EXPECT_TRUE(registry.registerQuery(streamInfo, sendTime, sendTime, resendHandler));
+	EXPECT_FALSE(registry.registerQuery(streamInfo, after, after, resendHandler));
+	EXPECT_FALSE(registry.registerQuery(streamInfo, after, after, resendHandler));
+	auto const handler = registry.completeQuery(streamInfo);
+	ASSERT_TRUE(!!handler);
+	handler(nullptr);
+	EXPECT_EQ(1u, resentCount);
+	EXPECT_FALSE(!!registry.completeQuery(streamInfo));
+	// Only the merged query is counted as deduplicated, the other one being sent
+	EXPECT_EQ(3u, registry.getStatistics().deduplicatedQueries);
+	EXPECT_EQ(4u, registry.getStatistics().sentQueries);
+
+	// Not sent again once the entity went offline
+	EXPECT_TRUE(registry.registerQuery(streamInfo, sendTime, sendTime, resendHandler));
+	EXPECT_FALSE(registry.registerQuery(streamInfo, after, after, resendHandler));
+	registry.removeQueries(streamInfo.entityID);
+	EXPECT_FALSE(!!registry.completeQuery(streamInfo));
+}
+
+TEST(DenseIndexMap, MapSemantics)
+{
+	auto nodes = la::avdecc::controller::model::DenseIndexMap<la::avdecc::entity::model::StreamIndex, std::uint32_t>{};
+	EXPECT_TRUE(nodes.empty());
+	EXPECT_EQ(nodes.end(), nodes.begin());
+
+	// Descriptors are not received in order
+	nodes.reserve(8u);
+	nodes[5] = 50u;
+	nodes[1] = 10u;
+	auto const* const firstNode = &nodes[1];
+	nodes[3] = 30u;
+	EXPECT_EQ(3u, nodes.size());
+	EXPECT_EQ(firstNode, &nodes[1]); // Reserved, no model moved
+
+	// Empty slots are not visible
+	EXPECT_EQ(0u, nodes.count(0));
+	EXPECT_EQ(0u, nodes.count(2));
+	EXPECT_EQ(0u, nodes.count(42));
+	EXPECT_EQ(nodes.end(), nodes.find(2));
+	EXPECT_THROW(nodes.at(4), std::out_of_range);
+	EXPECT_EQ(30u, nodes.at(3));
+	EXPECT_EQ(50u, nodes.find(5)->second);
+
+	// Iteration in index order, as with std::map
+	auto visited = std::vector<std::pair<la::avdecc::entity::model::StreamIndex, std::uint32_t>>{};
+	for (auto const& nodeKV : nodes)
+	{
+		visited.push_back(nodeKV);
+	}
+	auto const expected = std::vector<std::pair<la::avdecc::entity::model::StreamIndex, std::uint32_t>>{ { 1u, 10u }, { 3u, 30u }, { 5u, 50u } };
+	EXPECT_EQ(expected, visited);
+
+	// Copies are independent
+	auto const copy = nodes;
+	nodes[3] = 33u;
+	EXPECT_EQ(30u, copy.at(3));
+	EXPECT_EQ(3u, copy.size());
+
+	nodes.clear();
+	EXPECT_TRUE(nodes.empty());
+	EXPECT_EQ(0u, nodes.count(1));
+}
+
+TEST(DenseIndexMap, OutOfRangeIndex)
+{
+	auto nodes = la::avdecc::controller::model::DenseIndexMap<la::avdecc::entity::model::StreamIndex, std::uint32_t>{};
+	nodes.reserve(2u);
+	nodes[0] = 0u;
+	nodes[1] = 10u;
+	auto const* const firstNode = &nodes[0];
+	auto const capacity = nodes.capacity();
+
+	// Out of range index (from a faulty entity): stored sparsely, without growing the slots up to it
+	EXPECT_FALSE(nodes.createMovesModels(0xFFFF));
+	nodes[0xFFFF] = 42u;
+	EXPECT_EQ(capacity, nodes.capacity());
+	EXPECT_EQ(1u, nodes.sparseSize());
+	EXPECT_EQ(firstNode, &nodes[0]);
+	EXPECT_EQ(3u, nodes.size());
+	EXPECT_EQ(1u, nodes.count(0xFFFF));
+	EXPECT_EQ(42u, nodes.at(0xFFFF));
+	EXPECT_EQ(42u, nodes.find(0xFFFF)->second);
+	EXPECT_EQ(0u, nodes.count(0xFFFE));
+	EXPECT_EQ(nodes.end(), nodes.find(0xFFFE));
+	EXPECT_THROW(nodes.at(0xFFFE), std::out_of_range);
+
+	// Appending directly after the last slot still grows the slots
+	EXPECT_TRUE(nodes.createMovesModels(2));
+	nodes[2] = 20u;
+	EXPECT_EQ(0u, nodes.count(3));
+
+	// Iteration in index order, sparse models last
+	auto visited = std::vector<std::pair<la::avdecc::entity::model::StreamIndex, std::uint32_t>>{};
+	for (auto const& nodeKV : nodes)
+	{
+		visited.push_back(nodeKV);
+	}
+	auto const expected = std::vector<std::pair<la::avdecc::entity::model::StreamIndex, std::uint32_t>>{ { 0u, 0u }, { 1u, 10u }, { 2u, 20u }, { 0xFFFF, 42u } };
+	EXPECT_EQ(expected, visited);
+
+	// Unordered models without reserve end up in their slot once within capacity
+	auto unordered = la::avdecc::controller::model::DenseIndexMap<la::avdecc::entity::model::StreamIndex, std::uint32_t>{};
+	unordered[3] = 30u;
+	unordered[0] = 0u;
+	unordered[1] = 10u;
+	unordered[2] = 20u;
+	unordered.reserve(4u);
+	EXPECT_EQ(0u, unordered.sparseSize());
+	EXPECT_EQ(4u, unordered.size());
+	EXPECT_EQ(30u, unordered.at(3));
+
+	nodes.clear();
+	EXPECT_TRUE(nodes.empty());
+	EXPECT_EQ(0u, nodes.count(0xFFFF));
+}
+
+namespace
+{
+/** Node models of a large entity configuration, stored in ModelsContainer<Index, Model> */
+template<template<typename...> class ModelsContainer>
+struct BenchmarkConfigurationTree
+{
+	ModelsContainer<la::avdecc::entity::model::StreamIndex, la::avdecc::controller::model::StreamNodeStaticModel> streamInputStaticModels{};
+	ModelsContainer<la::avdecc::entity::model::StreamIndex, la::avdecc::controller::model::StreamNodeStaticModel> streamOutputStaticModels{};
+	ModelsContainer<la::avdecc::entity::model::StreamIndex, la::avdecc::controller::model::StreamInputNodeDynamicModel> streamInputDynamicModels{};
+	ModelsContainer<la::avdecc::entity::model::StreamIndex, la::avdecc::controller::model::StreamOutputNodeDynamicModel> streamOutputDynamicModels{};
+	ModelsContainer<la::avdecc::entity::model::ClusterIndex, la::avdecc::controller::model::AudioClusterNodeStaticModel> audioClusterStaticModels{};
+	ModelsContainer<la::avdecc::entity::model::ClusterIndex, la::avdecc::controller::model::AudioClusterNodeDynamicModel> audioClusterDynamicModels{};
+	ModelsContainer<la::avdecc::entity::model::MapIndex, la::avdecc::controller::model::AudioMapNodeStaticModel> audioMapStaticModels{};
+	ModelsContainer<la::avdecc::entity::model::ClockSourceIndex, la::avdecc::controller::model::ClockSourceNodeStaticModel> clockSourceStaticModels{};
+	ModelsContainer<la::avdecc::entity::model::ClockSourceIndex, la::avdecc::controller::model::ClockSourceNodeDynamicModel> clockSourceDynamicModels{};
+};
+
+template<typename Container>
+void fillBenchmarkModels(Container& models, size_t const count)
+{
+	if constexpr (!std::is_same_v<Container, std::map<typename Container::key_type, typename Container::mapped_type>>)
+	{
+		models.reserve(count);
+	}
+	for (auto index = size_t{ 0u }; index < count; ++index)
+	{
+		models[static_cast<typename Container::key_type>(index)];
+	}
+}
+
+template<typename Tree>
+Tree makeBenchmarkConfigurationTree()
+{
+	auto tree = Tree{};
+	fillBenchmarkModels(tree.streamInputStaticModels, 64u);
+	fillBenchmarkModels(tree.streamOutputStaticModels, 64u);
+	fillBenchmarkModels(tree.streamInputDynamicModels, 64u);
+	fillBenchmarkModels(tree.streamOutputDynamicModels, 64u);
+	fillBenchmarkModels(tree.audioClusterStaticModels, 512u);
+	fillBenchmarkModels(tree.audioClusterDynamicModels, 512u);
+	fillBenchmarkModels(tree.audioMapStaticModels, 128u);
+	fillBenchmarkModels(tree.clockSourceStaticModels, 16u);
+	fillBenchmarkModels(tree.clockSourceDynamicModels, 16u);
+	return tree;
+}
+
+template<typename Tree>
+size_t traverseBenchmarkConfigurationTree(Tree const& tree)
+{
+	auto count = size_t{ 0u };
+	for (auto const& streamKV : tree.streamInputStaticModels)
+	{
+		count += streamKV.second.formats.size() + tree.streamInputDynamicModels.at(streamKV.first).connectionState.talkerStream.streamIndex;
+	}
+	for (auto const& clusterKV : tree.audioClusterStaticModels)
+	{
+		count += clusterKV.second.channelCount + tree.audioClusterDynamicModels.at(clusterKV.first).objectName.size();
+	}
+	return count;
+}
+} // namespace
+
+TEST(DenseIndexMap, TreeCopyAllocations)
+{
+	static constexpr auto EntitiesCount = 16u;
+	using MapTree = BenchmarkConfigurationTree<std::map>;
+	using DenseTree = BenchmarkConfigurationTree<la::avdecc::controller::model::DenseIndexMap>;
+
+	auto const mapModel = makeBenchmarkConfigurationTree<MapTree>();
+	auto const denseModel = makeBenchmarkConfigurationTree<DenseTree>();
+
+	// Copy the model for each entity (as done from the model cache)
+	auto const copyModels = [](auto const& model, auto& copies)
+	{
+		auto const counter = AllocationCounter{};
+		copies.reserve(EntitiesCount);
+		for (auto i = 0u; i < EntitiesCount; ++i)
+		{
+			copies.push_back(model);
+		}
+		return counter.getStatistics();
+	};
+	auto mapCopies = std::vector<MapTree>{};
+	auto denseCopies = std::vector<DenseTree>{};
+	auto const mapMemory = copyModels(mapModel, mapCopies);
+	auto const denseMemory = copyModels(denseModel, denseCopies);
+
+	// 9 node types per tree (plus the vector of copies): one allocation per type instead of one per node
+	EXPECT_EQ(1u + EntitiesCount * 9u, denseMemory.allocations);
+	EXPECT_GT(mapMemory.allocations, 100u * denseMemory.allocations);
+	EXPECT_LT(denseMemory.bytes, mapMemory.bytes);
+
+	// Same content
+	for (auto i = 0u; i < EntitiesCount; ++i)
+	{
+		EXPECT_EQ(traverseBenchmarkConfigurationTree(mapCopies[i]), traverseBenchmarkConfigurationTree(denseCopies[i]));
+	}
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests
+TEST(DenseIndexMap, DISABLED_MemoryAndTraversalBenchmark)
+{
+	static constexpr auto EntitiesCount = 400u;
+	static constexpr auto TraversalsCount = 50u;
+	using MapTree = BenchmarkConfigurationTree<std::map>;
+	using DenseTree = BenchmarkConfigurationTree<la::avdecc::controller::model::DenseIndexMap>;
+
+	auto const mapModel = makeBenchmarkConfigurationTree<MapTree>();
+	auto const denseModel = makeBenchmarkConfigurationTree<DenseTree>();
+
+	// Copy the model for each entity (as done from the model cache)
+	auto const copyModels = [](auto const& model, auto& copies)
+	{
+		auto const counter = AllocationCounter{};
+		copies.reserve(EntitiesCount);
+		for (auto i = 0u; i < EntitiesCount; ++i)
+		{
+			copies.push_back(model);
+		}
+		return counter.getStatistics();
+	};
+	auto mapCopies = std::vector<MapTree>{};
+	auto denseCopies = std::vector<DenseTree>{};
+	auto const mapMemory = copyModels(mapModel, mapCopies);
+	auto const denseMemory = copyModels(denseModel, denseCopies);
+
+	// 9 node types per tree (plus the vector of copies): one allocation per type instead of one per node
+	EXPECT_EQ(1u + EntitiesCount * 9u, denseMemory.allocations);
+	EXPECT_GT(mapMemory.allocations, 100u * denseMemory.allocations);
+	EXPECT_LT(denseMemory.bytes, mapMemory.bytes);
+
+	// Walk all trees, as a UI refreshing its view
+	auto const traverse = [](auto const& copies)
+	{
+		auto result = size_t{ 0u };
+		auto const startTime = std::chrono::steady_clock::now();
+		for (auto i = 0u; i < TraversalsCount; ++i)
+		{
+			for (auto const& tree : copies)
+			{
+				result += traverseBenchmarkConfigurationTree(tree);
+			}
+		}
+		return std::make_pair(result, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime));
+	};
+	auto const mapTraversal = traverse(mapCopies);
+	auto const denseTraversal = traverse(denseCopies);
+	EXPECT_EQ(mapTraversal.first, denseTraversal.first);
+
+	std::cout << "[ BENCH    ] " << EntitiesCount << " entities: std::map " << mapMemory.allocations << " allocations (" << (mapMemory.bytes / 1024u) << " KiB), " << mapTraversal.second.count() << " usec for " << TraversalsCount << " traversals / DenseIndexMap " << denseMemory.allocations << " allocations (" << (denseMemory.bytes / 1024u) << " KiB), " << denseTraversal.second.count() << " usec" << std::endl;
+}
+
+namespace
+{
+/** Entity with about 2000 descriptors (64 stream ports of 24 clusters and 4 maps each, 128 streams) */
+std::shared_ptr<la::avdecc::controller::ControlledEntityImpl> makeLargeMatrixEntity(la::avdecc::UniqueIdentifier const entityID)
+{
+	static constexpr auto StreamPortsCount = std::uint16_t{ 32u }; // Per direction
+	static constexpr auto ClustersPerPort = std::uint16_t{ 24u };
+	static constexpr auto MapsPerPort = std::uint16_t{ 4u };
+	static constexpr auto StreamsCount = std::uint16_t{ 64u }; // Per direction
+
+	auto const e{ la::avdecc::entity::Entity{ entityID, la::avdecc::networkInterface::MacAddress{}, la::avdecc::UniqueIdentifier{ 0x1122334455667788 }, la::avdecc::entity::EntityCapabilities::AemSupported, 0, la::avdecc::entity::TalkerCapabilities::None, 0, la::avdecc::entity::ListenerCapabilities::None, la::avdecc::entity::ControllerCapabilities::None, 0, 0, la::avdecc::UniqueIdentifier::getNullUniqueIdentifier() } };
+	auto controlledEntity = std::make_shared<la::avdecc::controller::ControlledEntityImpl>(e);
+	auto& entity = *controlledEntity;
+	auto const configurationIndex = la::avdecc::entity::model::ConfigurationIndex{ 0u };
+	using StaticTree = la::avdecc::controller::model::ConfigurationStaticTree;
+	using DynamicTree = la::avdecc::controller::model::ConfigurationDynamicTree;
+
+	auto& audioUnit = entity.getNodeStaticModel(configurationIndex, la::avdecc::entity::model::AudioUnitIndex{ 0u }, &StaticTree::audioUnitStaticModels);
+	entity.getNodeDynamicModel(configurationIndex, la::avdecc::entity::model::AudioUnitIndex{ 0u }, &DynamicTree::audioUnitDynamicModels);
+	audioUnit.numberOfStreamInputPorts = StreamPortsCount;
+	audioUnit.numberOfStreamOutputPorts = StreamPortsCount;
+
+	auto const makeStreamPorts = [&](auto const staticField, auto const dynamicField, std::uint16_t const baseDescriptor)
+	{
+		for (auto portIndex = la::avdecc::entity::model::StreamPortIndex{ 0u }; portIndex < StreamPortsCount; ++portIndex)
+		{
+			auto& streamPort = entity.getNodeStaticModel(configurationIndex, portIndex, staticField);
+			entity.getNodeDynamicModel(configurationIndex, portIndex, dynamicField);
+			streamPort.numberOfClusters = ClustersPerPort;
+			streamPort.baseCluster = static_cast<la::avdecc::entity::model::ClusterIndex>((baseDescriptor + portIndex) * ClustersPerPort);
+			streamPort.numberOfMaps = MapsPerPort;
+			streamPort.baseMap = static_cast<la::avdecc::entity::model::MapIndex>((baseDescriptor + portIndex) * MapsPerPort);
+			for (auto i = 0u; i < ClustersPerPort; ++i)
+			{
+				entity.getNodeStaticModel(configurationIndex, static_cast<la::avdecc::entity::model::ClusterIndex>(streamPort.baseCluster + i), &StaticTree::audioClusterStaticModels);
+				entity.getNodeDynamicModel(configurationIndex, static_cast<la::avdecc::entity::model::ClusterIndex>(streamPort.baseCluster + i), &DynamicTree::audioClusterDynamicModels);
+			}
+			for (auto i = 0u; i < MapsPerPort; ++i)
+			{
+				entity.getNodeStaticModel(configurationIndex, static_cast<la::avdecc::entity::model::MapIndex>(streamPort.baseMap + i), &StaticTree::audioMapStaticModels);
+			}
+		}
+	};
+	makeStreamPorts(&StaticTree::streamPortInputStaticModels, &DynamicTree::streamPortInputDynamicModels, 0u);
+	makeStreamPorts(&StaticTree::streamPortOutputStaticModels, &DynamicTree::streamPortOutputDynamicModels, StreamPortsCount);
+
+	for (auto streamIndex = la::avdecc::entity::model::StreamIndex{ 0u }; streamIndex < StreamsCount; ++streamIndex)
+	{
+		entity.getNodeStaticModel(configurationIndex, streamIndex, &StaticTree::streamInputStaticModels);
+		entity.getNodeDynamicModel(configurationIndex, streamIndex, &DynamicTree::streamInputDynamicModels);
+		entity.getNodeStaticModel(configurationIndex, streamIndex, &StaticTree::streamOutputStaticModels);
+		entity.getNodeDynamicModel(configurationIndex, streamIndex, &DynamicTree::streamOutputDynamicModels);
+	}
+
+	return controlledEntity;
+}
+} // namespace
+
+TEST(ControlledEntity, EntityModelGraphBuild)
+{
+	// Graph built on first access, and graph built by the controller before advertising the entity
+	auto const lazyEntity = makeLargeMatrixEntity(la::avdecc::UniqueIdentifier{ 0x0001000000000000u });
+	auto const eagerEntity = makeLargeMatrixEntity(la::avdecc::UniqueIdentifier{ 0x0002000000000000u });
+	eagerEntity->buildEntityModelGraph();
+
+	// Both graphs are complete
+	for (auto const& entity : { lazyEntity, eagerEntity })
+	{
+		EXPECT_EQ(1u, entity->getEntityNode().configurations.size());
+		auto const& configNode = entity->getConfigurationNode(0u);
+		ASSERT_EQ(1u, configNode.audioUnits.size());
+		auto const& audioUnitNode = configNode.audioUnits.at(0u);
+		EXPECT_EQ(32u, audioUnitNode.streamPortInputs.size());
+		EXPECT_EQ(32u, audioUnitNode.streamPortOutputs.size());
+		EXPECT_EQ(24u, audioUnitNode.streamPortOutputs.at(31u).audioClusters.size());
+		EXPECT_EQ(4u, audioUnitNode.streamPortOutputs.at(31u).audioMaps.size());
+		EXPECT_EQ(64u, configNode.streamInputs.size());
+		EXPECT_EQ(64u, configNode.streamOutputs.size());
+	}
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests
+TEST(ControlledEntity, DISABLED_EntityModelGraphBuildBenchmark)
+{
+	static constexpr auto EntitiesCount = 20u;
+
+	auto lazyEntities = std::vector<std::shared_ptr<la::avdecc::controller::ControlledEntityImpl>>{};
+	auto eagerEntities = std::vector<std::shared_ptr<la::avdecc::controller::ControlledEntityImpl>>{};
+	for (auto i = 0u; i < EntitiesCount; ++i)
+	{
+		lazyEntities.push_back(makeLargeMatrixEntity(la::avdecc::UniqueIdentifier{ 0x0001000000000000u + i }));
+		eagerEntities.push_back(makeLargeMatrixEntity(la::avdecc::UniqueIdentifier{ 0x0002000000000000u + i }));
+	}
+
+	// Time spent by the first user of the entity, the graph being built on first access
+	auto const measureFirstAccess = [](auto const& entities)
+	{
+		auto const startTime = std::chrono::steady_clock::now();
+		for (auto const& entity : entities)
+		{
+			auto const& entityNode = entity->getEntityNode();
+			EXPECT_EQ(1u, entityNode.configurations.size());
+		}
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime) / EntitiesCount;
+	};
+	auto const lazyAccess = measureFirstAccess(lazyEntities);
+
+	// Graph built by the controller before advertising the entities
+	auto const buildStartTime = std::chrono::steady_clock::now();
+	for (auto const& entity : eagerEntities)
+	{
+		entity->buildEntityModelGraph();
+	}
+	auto const eagerBuild = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - buildStartTime) / EntitiesCount;
+	auto const eagerAccess = measureFirstAccess(eagerEntities);
+
+	EXPECT_LT(eagerAccess, lazyAccess);
+
+	std::cout << "[ BENCH    ] 2000 descriptors entity: graph built on first access " << lazyAccess.count() << " usec, built by the controller " << eagerBuild.count() << " usec then first access " << eagerAccess.count() << " usec" << std::endl;
+}
+
+TEST(ControlledEntity, SharedEntityStaticTreeMemory)
+{
+	static constexpr auto EntitiesCount = 100u;
+	using StaticTree = la::avdecc::controller::model::ConfigurationStaticTree;
+
+	// First entity of the model, enumerated then stored in the cache
+	auto source = makeLargeMatrixEntity(la::avdecc::UniqueIdentifier{ 0x0003000000000000u });
+	source->buildEntityModelGraph();
+	auto const sharedTree = source->shareEntityStaticTree();
+	ASSERT_NE(nullptr, sharedTree);
+	EXPECT_TRUE(source->isEntityStaticTreeShared());
+
+	auto entities = std::vector<std::shared_ptr<la::avdecc::controller::ControlledEntityImpl>>{};
+	for (auto i = 0u; i < EntitiesCount; ++i)
+	{
+		auto const e{ la::avdecc::entity::Entity{ la::avdecc::UniqueIdentifier{ 0x0003000000000001u + i }, la::avdecc::networkInterface::MacAddress{}, la::avdecc::UniqueIdentifier{ 0x1122334455667788 }, la::avdecc::entity::EntityCapabilities::AemSupported, 0, la::avdecc::entity::TalkerCapabilities::None, 0, la::avdecc::entity::ListenerCapabilities::None, la::avdecc::entity::ControllerCapabilities::None, 0, 0, la::avdecc::UniqueIdentifier::getNullUniqueIdentifier() } };
+		entities.push_back(std::make_shared<la::avdecc::controller::ControlledEntityImpl>(e));
+	}
+
+	// Previous behavior: each entity gets a copy of the cached tree
+	auto copies = std::vector<la::avdecc::controller::model::EntityStaticTree>{};
+	copies.reserve(EntitiesCount);
+	auto const copiedMemory = [&copies, &sharedTree]()
+	{
+		auto const counter = AllocationCounter{};
+		for (auto i = 0u; i < EntitiesCount; ++i)
+		{
+			copies.push_back(*sharedTree);
+		}
+		return counter.getStatistics();
+	}();
+
+	// Each entity shares the cached tree
+	auto const descriptor = la::avdecc::entity::model::EntityDescriptor{};
+	auto const sharedMemory = [&entities, &sharedTree, &descriptor]()
+	{
+		auto const counter = AllocationCounter{};
+		for (auto const& entity : entities)
+		{
+			EXPECT_TRUE(entity->setCachedEntityStaticTree(sharedTree, descriptor));
+		}
+		return counter.getStatistics();
+	}();
+	EXPECT_LT(sharedMemory.bytes * 100u, copiedMemory.bytes);
+
+	// Building the graph of an entity sharing the tree doesn't copy it
+	for (auto const& entity : entities)
+	{
+		entity->buildEntityModelGraph();
+		auto const& entityNode = entity->getEntityNode();
+		EXPECT_EQ(&sharedTree->staticModel, entityNode.staticModel);
+		EXPECT_EQ(sharedTree.get(), &static_cast<la::avdecc::controller::ControlledEntityImpl const&>(*entity).getEntityStaticTree());
+	}
+	auto const& audioUnitNode = entities.front()->getConfigurationNode(0u).audioUnits.at(0u);
+	EXPECT_EQ(24u, audioUnitNode.streamPortOutputs.at(31u).audioClusters.size());
+
+	// Modifying the static model of an entity works on its own copy
+	auto& entity = *entities.front();
+	entity.getNodeStaticModel(0u, la::avdecc::entity::model::StreamIndex{ 0u }, &StaticTree::streamInputStaticModels).localizedDescription = la::avdecc::entity::model::LocalizedStringReference{ 1u };
+	EXPECT_FALSE(entity.isEntityStaticTreeShared());
+	EXPECT_NE(sharedTree.get(), &static_cast<la::avdecc::controller::ControlledEntityImpl const&>(entity).getEntityStaticTree());
+	EXPECT_EQ(la::avdecc::entity::model::LocalizedStringReference{ 1u }, entity.getStreamInputNode(0u, 0u).staticModel->localizedDescription);
+	EXPECT_NE(la::avdecc::entity::model::LocalizedStringReference{ 1u }, sharedTree->configurationStaticTrees.at(0u).streamInputStaticModels.at(0u).localizedDescription);
+}
+
+namespace
+{
+std::shared_ptr<la::avdecc::controller::ControlledEntityImpl> makeLocalizedEntity(la::avdecc::UniqueIdentifier const entityID, la::avdecc::UniqueIdentifier const entityModelID, std::uint16_t const stringsDescriptorsCount, std::string const& prefix)
+{
+	auto const e{ la::avdecc::entity::Entity{ entityID, la::avdecc::networkInterface::MacAddress{}, entityModelID, la::avdecc::entity::EntityCapabilities::AemSupported, 0, la::avdecc::entity::TalkerCapabilities::None, 0, la::avdecc::entity::ListenerCapabilities::None, la::avdecc::entity::ControllerCapabilities::None, 0, 0, la::avdecc::UniqueIdentifier::getNullUniqueIdentifier() } };
+	auto controlledEntity = std::make_shared<la::avdecc::controller::ControlledEntityImpl>(e);
+	for (auto stringsIndex = la::avdecc::entity::model::StringsIndex{ 0u }; stringsIndex < stringsDescriptorsCount; ++stringsIndex)
 	{
-		auto const s1{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{}, la::avdecc::entity::model::StreamIdentification{}, la::avdecc::controller::model::StreamConnectionState::State::NotConnected } };
-		auto const s2{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{}, la::avdecc::entity::model::StreamIdentification{ la::avdecc::UniqueIdentifier{ 0x1 }, 1 }, la::avdecc::controller::model::StreamConnectionState::State::NotConnected } };
-		auto const s3{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{ la::avdecc::UniqueIdentifier{ 0x1 }, 1 }, la::avdecc::entity::model::StreamIdentification{}, la::avdecc::controller::model::StreamConnectionState::State::NotConnected } };
-		EXPECT_EQ(s2, s1) << "Talker StreamIdentification ignored when not connected";
-		EXPECT_NE(s3, s1);
-		EXPECT_NE(s3, s2);
+		auto strings = la::avdecc::controller::model::AvdeccFixedStrings{};
+		for (auto i = 0u; i < strings.size(); ++i)
+		{
+			strings[i] = prefix + std::to_string(stringsIndex * strings.size() + i);
+		}
+		controlledEntity->setLocalizedStrings(0u, stringsIndex, strings);
 	}
+	return controlledEntity;
+}
 
-	// FastConnecting
+constexpr la::avdecc::entity::model::LocalizedStringReference makeStringReference(std::uint16_t const globalOffset)
+{
+	return static_cast<la::avdecc::entity::model::LocalizedStringReference>(((globalOffset / 7u) << 3) | (globalOffset % 7u));
+}
+} // namespace
+
+TEST(ControlledEntity, LocalizedStringsSharing)
+{
+	auto const entityModelID = la::avdecc::UniqueIdentifier{ 0x0001020304050607 };
+	auto entity1 = makeLocalizedEntity(la::avdecc::UniqueIdentifier{ 0x0001000000000001 }, entityModelID, 4u, "String ");
+	auto entity2 = makeLocalizedEntity(la::avdecc::UniqueIdentifier{ 0x0001000000000002 }, entityModelID, 4u, "String ");
+	auto entity3 = makeLocalizedEntity(la::avdecc::UniqueIdentifier{ 0x0001000000000003 }, entityModelID, 4u, "Other firmware ");
+
+	// Each entity loads its own table
+	EXPECT_NE(entity1->getConfigurationNodeDynamicModel(0u).localizedStrings, entity2->getConfigurationNodeDynamicModel(0u).localizedStrings);
+
+	// Same model and same strings: shared
+	entity1->shareLocalizedStrings();
+	entity2->shareLocalizedStrings();
+	entity3->shareLocalizedStrings();
+	auto const& strings1 = entity1->getConfigurationNodeDynamicModel(0u).localizedStrings;
+	EXPECT_EQ(strings1, entity2->getConfigurationNodeDynamicModel(0u).localizedStrings);
+	EXPECT_NE(strings1, entity3->getConfigurationNodeDynamicModel(0u).localizedStrings);
+	ASSERT_NE(nullptr, strings1);
+	EXPECT_EQ(28u, strings1->size());
+
+	// Loading strings again doesn't modify the shared table
+	auto strings = la::avdecc::controller::model::AvdeccFixedStrings{};
+	strings[0] = std::string{ "Updated" };
+	entity2->setLocalizedStrings(0u, 0u, strings);
+	EXPECT_EQ(std::string{ "String 0" }, entity1->getLocalizedString(0u, makeStringReference(0u)).str());
+	EXPECT_EQ(std::string{ "Updated" }, entity2->getLocalizedString(0u, makeStringReference(0u)).str());
+
+	// Invalid references and configurations resolve to an empty string
+	EXPECT_EQ(std::string{ "String 27" }, entity1->getLocalizedString(0u, makeStringReference(27u)).str());
+	EXPECT_TRUE(entity1->getLocalizedString(0u, makeStringReference(28u)).empty());
+	EXPECT_TRUE(entity1->getLocalizedString(1u, makeStringReference(0u)).empty());
+	EXPECT_TRUE(entity1->getLocalizedString(0u, la::avdecc::entity::model::getNullLocalizedStringReference()).empty());
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests (lookups are checked by LocalizedStringsSharing)
+TEST(ControlledEntity, DISABLED_LocalizedStringsBenchmark)
+{
+	static constexpr auto LookupsCount = 100000u;
+	static constexpr auto StringsDescriptorsCount = std::uint16_t{ 64u }; // 448 strings
+
+	auto entity = makeLocalizedEntity(la::avdecc::UniqueIdentifier{ 0x0002000000000001 }, la::avdecc::UniqueIdentifier{ 0x0002020304050607 }, StringsDescriptorsCount, "String ");
+
+	// Previous storage: a map and an exception for each missing string
+	auto map = std::map<la::avdecc::entity::model::StringsIndex, la::avdecc::entity::model::AvdeccFixedString>{};
+	for (auto const& string : *entity->getConfigurationNodeDynamicModel(0u).localizedStrings)
 	{
-		auto const s1{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{}, la::avdecc::entity::model::StreamIdentification{}, la::avdecc::controller::model::StreamConnectionState::State::FastConnecting } };
-		auto const s2{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{}, la::avdecc::entity::model::StreamIdentification{ la::avdecc::UniqueIdentifier{ 0x1 }, 1 }, la::avdecc::controller::model::StreamConnectionState::State::FastConnecting } };
-		auto const s3{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{ la::avdecc::UniqueIdentifier{ 0x1 }, 1 }, la::avdecc::entity::model::StreamIdentification{}, la::avdecc::controller::model::StreamConnectionState::State::FastConnecting } };
-		EXPECT_NE(s2, s1) << "Talker StreamIdentification not ignored when fast connecting";
-		EXPECT_NE(s3, s1);
-		EXPECT_NE(s3, s2);
+		map[static_cast<la::avdecc::entity::model::StringsIndex>(map.size())] = string;
 	}
+	auto const mapLookup = [&map](la::avdecc::entity::model::LocalizedStringReference const stringReference) -> la::avdecc::entity::model::AvdeccFixedString const&
+	{
+		static auto const s_noLocalizationString = la::avdecc::entity::model::AvdeccFixedString{};
+		try
+		{
+			auto const globalOffset = (((stringReference >> 3) * 7u) + (stringReference & 0x0007)) & 0xFFFF;
+			return map.at(static_cast<la::avdecc::entity::model::StringsIndex>(globalOffset));
+		}
+		catch (...)
+		{
+			return s_noLocalizationString;
+		}
+	};
 
-	// Connected
+	// 1 reference out of 4 is missing
+	auto references = std::vector<la::avdecc::entity::model::LocalizedStringReference>{};
+	references.reserve(LookupsCount);
+	for (auto i = 0u; i < LookupsCount; ++i)
 	{
-		auto const s1{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{}, la::avdecc::entity::model::StreamIdentification{}, la::avdecc::controller::model::StreamConnectionState::State::Connected } };
-		auto const s2{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{}, la::avdecc::entity::model::StreamIdentification{ la::avdecc::UniqueIdentifier{ 0x1 }, 1 }, la::avdecc::controller::model::StreamConnectionState::State::Connected } };
-		auto const s3{ la::avdecc::controller::model::StreamConnectionState{ la::avdecc::entity::model::StreamIdentification{ la::avdecc::UniqueIdentifier{ 0x1 }, 1 }, la::avdecc::entity::model::StreamIdentification{}, la::avdecc::controller::model::StreamConnectionState::State::Connected } };
-		EXPECT_NE(s2, s1) << "Talker StreamIdentification not ignored when connected";
-		EXPECT_NE(s3, s1);
-		EXPECT_NE(s3, s2);
+		references.push_back(makeStringReference(static_cast<std::uint16_t>((i % 4u) == 3u ? 1000u + (i % 100u) : (i % 448u))));
+	}
+
+	auto const measure = [&references](auto const& lookup)
+	{
+		auto foundCount = size_t{ 0u };
+		auto const startTime = std::chrono::steady_clock::now();
+		for (auto const reference : references)
+		{
+			if (!lookup(reference).empty())
+				++foundCount;
+		}
+		return std::make_pair(foundCount, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime));
+	};
+	auto const mapResult = measure(mapLookup);
+	auto const tableResult = measure(
+		[&entity](la::avdecc::entity::model::LocalizedStringReference const stringReference) -> la::avdecc::entity::model::AvdeccFixedString const&
+		{
+			return entity->getLocalizedString(0u, stringReference);
+		});
+	EXPECT_EQ(LookupsCount - LookupsCount / 4u, tableResult.first);
+	EXPECT_EQ(mapResult.first, tableResult.first);
+	EXPECT_LT(tableResult.second, mapResult.second);
+
+	std::cout << "[ BENCH    ] " << LookupsCount << " localized string references (25% missing): map and exceptions " << mapResult.second.count() << " usec, table " << tableResult.second.count() << " usec" << std::endl;
+}
+
+TEST(ControlledEntity, FindLocaleNode)
+{
+	auto const e{ la::avdecc::entity::Entity{ la::avdecc::UniqueIdentifier{ 0x0003000000000001 }, la::avdecc::networkInterface::MacAddress{}, la::avdecc::UniqueIdentifier{ 0x0003020304050607 }, la::avdecc::entity::EntityCapabilities::AemSupported, 0, la::avdecc::entity::TalkerCapabilities::None, 0, la::avdecc::entity::ListenerCapabilities::None, la::avdecc::entity::ControllerCapabilities::None, 0, 0, la::avdecc::UniqueIdentifier::getNullUniqueIdentifier() } };
+	auto entity = la::avdecc::controller::ControlledEntityImpl{ e };
+
+	// No locale at all
+	EXPECT_THROW(entity.findLocaleNode(0u, "en-US"), la::avdecc::controller::ControlledEntity::Exception);
+
+	auto const locales = std::array<char const*, 4>{ "fr-FR", "en-GB", "en_US", "de" };
+	for (auto index = la::avdecc::entity::model::LocaleIndex{ 0u }; index < locales.size(); ++index)
+	{
+		auto descriptor = la::avdecc::entity::model::LocaleDescriptor{};
+		descriptor.localeID = std::string{ locales[index] };
+		descriptor.numberOfStringDescriptors = 1u;
+		descriptor.baseStringDescriptorIndex = index;
+		entity.setLocaleDescriptor(descriptor, 0u, index);
+	}
+
+	auto const findBaseIndex = [&entity](std::string const& locale)
+	{
+		auto const* const localeNode = entity.findLocaleNode(0u, locale);
+		return localeNode == nullptr ? -1 : static_cast<int>(localeNode->baseStringDescriptorIndex);
+	};
+
+	// Exact match, whatever the case and separator
+	EXPECT_EQ(2, findBaseIndex("en-US"));
+	EXPECT_EQ(2, findBaseIndex("EN_us"));
+	EXPECT_EQ(1, findBaseIndex("en-GB"));
+	// Same language
+	EXPECT_EQ(1, findBaseIndex("en"));
+	EXPECT_EQ(1, findBaseIndex("en-AU"));
+	EXPECT_EQ(0, findBaseIndex("fr-CA"));
+	EXPECT_EQ(3, findBaseIndex("de-DE"));
+	// No match
+	EXPECT_EQ(-1, findBaseIndex("it-IT"));
+	EXPECT_EQ(-1, findBaseIndex(""));
+}
+
+TEST(ControlledEntity, OutOfRangeUnsolicitedIndex)
+{
+	auto entity = makeLargeMatrixEntity(la::avdecc::UniqueIdentifier{ 0x0005000000000000u });
+	entity->buildEntityModelGraph();
+	auto const& streamInputModels = static_cast<la::avdecc::controller::ControlledEntityImpl const&>(*entity).getConfigurationDynamicTree(0u).streamInputDynamicModels;
+	auto const capacity = streamInputModels.capacity();
+	auto const footprint = entity->getMemoryFootprint();
+
+	// Unsolicited response for a stream the entity does not have
+	entity->setStreamInputFormat(la::avdecc::entity::model::StreamIndex{ 0xFFFF }, la::avdecc::entity::model::StreamFormat{ 0x00A0020840000800 });
+
+	// No slots allocated up to the index, and the model graph is kept
+	EXPECT_EQ(capacity, streamInputModels.capacity());
+	EXPECT_EQ(1u, streamInputModels.sparseSize());
+	EXPECT_EQ(footprint.modelGraph, entity->getMemoryFootprint().modelGraph);
+	EXPECT_LT(entity->getMemoryFootprint().dynamicModel, footprint.dynamicModel + 1024u);
+	EXPECT_EQ(la::avdecc::entity::model::StreamFormat{ 0x00A0020840000800 }, streamInputModels.at(0xFFFF).currentFormat);
+	EXPECT_EQ(64u, entity->getEntityNode().configurations.at(0u).streamInputs.size());
+}
+
+TEST(ControlledEntity, MemoryFootprint)
+{
+	static constexpr auto MaxEntityFootprint = size_t{ 1024u * 1024u }; // Upper bound for the 2000 descriptors entity
+	using DynamicTree = la::avdecc::controller::model::ConfigurationDynamicTree;
+
+	// Fully enumerated large entity, with counters, dynamic mappings and localized strings
+	auto const counter = AllocationCounter{};
+	auto entity = makeLargeMatrixEntity(la::avdecc::UniqueIdentifier{ 0x0004000000000000u });
+	for (auto streamIndex = la::avdecc::entity::model::StreamIndex{ 0u }; streamIndex < 64u; ++streamIndex)
+	{
+		auto& counters = entity->getNodeDynamicModel(0u, streamIndex, &DynamicTree::streamInputDynamicModels).counters;
+		for (auto bit = 0u; bit < 12u; ++bit)
+		{
+			counters[static_cast<la::avdecc::entity::StreamInputCounterValidFlag>(1u << bit)] = bit;
+		}
+	}
+	for (auto portIndex = la::avdecc::entity::model::StreamPortIndex{ 0u }; portIndex < 32u; ++portIndex)
+	{
+		auto& mappings = entity->getNodeDynamicModel(0u, portIndex, &DynamicTree::streamPortInputDynamicModels).dynamicAudioMap;
+		for (auto channel = std::uint16_t{ 0u }; channel < 8u; ++channel)
+		{
+			mappings.push_back(la::avdecc::entity::model::AudioMapping{ portIndex, channel, la::avdecc::entity::model::ClusterIndex{ 0u }, channel });
+		}
+	}
+	for (auto stringsIndex = la::avdecc::entity::model::StringsIndex{ 0u }; stringsIndex < 16u; ++stringsIndex)
+	{
+		entity->setLocalizedStrings(0u, stringsIndex, la::avdecc::controller::model::AvdeccFixedStrings{});
+	}
+	entity->buildEntityModelGraph();
+	auto const allocated = counter.getStatistics();
+
+	auto const footprint = entity->getMemoryFootprint();
+	EXPECT_EQ(sizeof(la::avdecc::controller::ControlledEntityImpl), footprint.entity);
+	EXPECT_NE(0u, footprint.staticModel);
+	EXPECT_NE(0u, footprint.dynamicModel);
+	EXPECT_NE(0u, footprint.counters);
+	EXPECT_NE(0u, footprint.audioMappings);
+	EXPECT_LE(16u * 7u * sizeof(la::avdecc::entity::model::AvdeccFixedString), footprint.localizedStrings);
+	EXPECT_NE(0u, footprint.modelGraph);
+	EXPECT_LT(footprint.total(), MaxEntityFootprint);
+	// Live memory can't exceed what has been allocated, and the estimation should not miss a large part of it
+	EXPECT_LE(footprint.total() - footprint.entity, allocated.bytes);
+	EXPECT_GE(footprint.total() * 2u, allocated.bytes);
+
+	// Shared static model is split between the entities sharing it (sharedTree standing for the EntityModelCache)
+	auto const sharedTree = entity->shareEntityStaticTree();
+	EXPECT_EQ(footprint.staticModel / 2u, entity->getMemoryFootprint().staticModel);
+}
+
+TEST(Controller, MemoryFootprint)
+{
+	auto controller = la::avdecc::controller::Controller::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, "MemoryFootprintInterface", 0x0001, la::avdecc::UniqueIdentifier{ 0x0102030405060708 }, "en");
+
+	auto const footprint = controller->getMemoryFootprint();
+	EXPECT_TRUE(footprint.entities.empty());
+	EXPECT_EQ(0u, footprint.entitiesTotal.total());
+	EXPECT_NE(0u, footprint.stateMachineQueues);
+	EXPECT_EQ(footprint.entityModelCache + footprint.stateMachineQueues, footprint.total());
+}
+
+namespace
+{
+/** Simulated AEM entity with 3 locales and optional streams, replying to READ_DESCRIPTOR, ACQUIRE_ENTITY and SET_NAME commands (NOT_IMPLEMENTED to other commands) one after the other after ProcessingTime */
+class SimulatedEntity : public la::avdecc::entity::LocalEntity, public la::avdecc::protocol::ProtocolInterface::Observer
+{
+public:
+	static constexpr auto StringsPerLocale = std::uint16_t{ 24u };
+	static constexpr auto ProcessingTime = std::chrono::milliseconds{ 2 };
+	static constexpr auto Locales = std::array<char const*, 3>{ "fr-FR", "de-DE", "en-US" };
+	static constexpr auto MacAddress = la::avdecc::networkInterface::MacAddress{ { 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b } };
+	static constexpr auto OtherControllerID = std::uint64_t{ 0x0A0B0C0D0E0F1011 }; // Owner reported when refusing an ACQUIRE_ENTITY
+
+	SimulatedEntity(std::string const& interfaceName, la::avdecc::UniqueIdentifier const entityID, la::avdecc::UniqueIdentifier const entityModelID, std::uint16_t const streamsCount = 0u, la::avdecc::entity::model::StreamFormat const streamFormat = la::avdecc::entity::model::getNullStreamFormat())
+		: LocalEntity(entityID, MacAddress, entityModelID, la::avdecc::entity::EntityCapabilities::AemSupported, 0, la::avdecc::entity::TalkerCapabilities::None, 0, la::avdecc::entity::ListenerCapabilities::None, la::avdecc::entity::ControllerCapabilities::Implemented, 0, 0, la::avdecc::UniqueIdentifier{})
+		, _streamsCount(streamsCount)
+		, _streamFormat(streamFormat)
+		, _pi(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(interfaceName, MacAddress))
+	{
+		_pi->registerObserver(this);
+		_pi->registerLocalEntity(*this);
+		_thread = std::thread(
+			[this]
+			{
+				auto lock = std::unique_lock<decltype(_responsesLock)>{ _responsesLock };
+				while (!_shouldTerminate)
+				{
+					if (_responses.empty())
+					{
+						_condVar.wait(lock);
+						continue;
+					}
+					auto const dueTime = _responses.begin()->first;
+					if (std::chrono::steady_clock::now() < dueTime)
+					{
+						_condVar.wait_until(lock, dueTime);
+						continue;
+					}
+					auto response = std::move(_responses.begin()->second);
+					_responses.erase(_responses.begin());
+					lock.unlock();
+					_pi->sendAecpResponse(std::move(response), la::avdecc::networkInterface::MacAddress{});
+					lock.lock();
+				}
+			});
+	}
+	~SimulatedEntity() noexcept
+	{
+		{
+			auto const lg = std::lock_guard<decltype(_responsesLock)>{ _responsesLock };
+			_shouldTerminate = true;
+		}
+		_condVar.notify_all();
+		_thread.join();
+		_pi->unregisterLocalEntity(*this);
+		_pi->unregisterObserver(this);
+	}
+
+	void advertise() noexcept
+	{
+		auto adpdu = la::avdecc::protocol::Adpdu::create();
+		adpdu->setSrcAddress(_pi->getMacAddress());
+		adpdu->setDestAddress(la::avdecc::protocol::Adpdu::Multicast_Mac_Address);
+		adpdu->setMessageType(la::avdecc::protocol::AdpMessageType::EntityAvailable);
+		adpdu->setValidTime(31);
+		adpdu->setEntityID(getEntityID());
+		adpdu->setEntityModelID(getEntityModelID());
+		adpdu->setEntityCapabilities(getEntityCapabilities());
+		adpdu->setTalkerStreamSources(0);
+		adpdu->setTalkerCapabilities(la::avdecc::entity::TalkerCapabilities::None);
+		adpdu->setListenerStreamSinks(0);
+		adpdu->setListenerCapabilities(la::avdecc::entity::ListenerCapabilities::None);
+		adpdu->setControllerCapabilities(getControllerCapabilities());
+		adpdu->setAvailableIndex(1);
+		adpdu->setGptpGrandmasterID(la::avdecc::UniqueIdentifier{});
+		adpdu->setGptpDomainNumber(0);
+		adpdu->setIdentifyControlIndex(0);
+		adpdu->setInterfaceIndex(0);
+		adpdu->setAssociationID(la::avdecc::UniqueIdentifier{});
+		_pi->sendAdpMessage(std::move(adpdu));
+	}
+
+	/** Returns the ACQUIRE_ENTITY (as "ACQUIRE" or "RELEASE") and SET_NAME commands received so far, in order */
+	std::vector<std::string> getControlCommands() const noexcept
+	{
+		auto const lg = std::lock_guard<decltype(_responsesLock)>{ _responsesLock };
+		return _controlCommands;
+	}
+
+	void clearControlCommands() noexcept
+	{
+		auto const lg = std::lock_guard<decltype(_responsesLock)>{ _responsesLock };
+		_controlCommands.clear();
+	}
+
+	std::atomic<size_t> _stringsReadCount{ 0u };
+	std::atomic<size_t> _streamsReadCount{ 0u };
+	std::atomic_bool _refuseAcquire{ false }; // Reply ENTITY_ACQUIRED to ACQUIRE_ENTITY commands
+
+private:
+	// la::avdecc::entity::LocalEntity overrides
+	virtual bool enableEntityAdvertising(std::uint32_t const /*availableDuration*/) noexcept override
+	{
+		return false;
+	}
+	virtual void disableEntityAdvertising() noexcept override {}
+	virtual bool isDirty() noexcept override
+	{
+		return false;
+	}
+	virtual void lock() noexcept override
+	{
+		_entityLock.lock();
+	}
+	virtual void unlock() noexcept override
+	{
+		_entityLock.unlock();
+	}
+
+	// la::avdecc::protocol::ProtocolInterface::Observer overrides
+	virtual void onTransportError(la::avdecc::protocol::ProtocolInterface* const /*pi*/) noexcept override {}
+	virtual void onAecpCommand(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::entity::LocalEntity const& /*entity*/, la::avdecc::protocol::Aecpdu const& aecpdu) noexcept override
+	{
+		if (aecpdu.getMessageType() != la::avdecc::protocol::AecpMessageType::AemCommand)
+			return;
+
+		auto const& command = static_cast<la::avdecc::protocol::AemAecpdu const&>(aecpdu);
+		auto response = la::avdecc::protocol::AemAecpdu::create();
+		auto& aem = static_cast<la::avdecc::protocol::AemAecpdu&>(*response);
+		aem.setSrcAddress(_pi->getMacAddress());
+		aem.setDestAddress(command.getSrcAddress());
+		aem.setMessageType(la::avdecc::protocol::AecpMessageType::AemResponse);
+		aem.setTargetEntityID(command.getTargetEntityID());
+		aem.setControllerEntityID(command.getControllerEntityID());
+		aem.setSequenceID(command.getSequenceID());
+		aem.setUnsolicited(false);
+		aem.setCommandType(command.getCommandType());
+
+		if (command.getCommandType() == la::avdecc::protocol::AemCommandType::ReadDescriptor)
+		{
+			auto const [configurationIndex, descriptorType, descriptorIndex] = la::avdecc::protocol::aemPayload::deserializeReadDescriptorCommand(command.getPayload());
+			auto ser = la::avdecc::Serializer<la::avdecc::protocol::AemAecpdu::MaximumSendPayloadBufferLength>{};
+			ser << configurationIndex << std::uint16_t{ 0u } << descriptorType << descriptorIndex;
+			aem.setStatus(la::avdecc::protocol::AecpStatus::Success);
+
+			switch (descriptorType)
+			{
+				case la::avdecc::entity::model::DescriptorType::Entity:
+					ser << getEntityID() << getEntityModelID() << getEntityCapabilities();
+					ser << std::uint16_t{ 0u } << la::avdecc::entity::TalkerCapabilities::None;
+					ser << std::uint16_t{ 0u } << la::avdecc::entity::ListenerCapabilities::None;
+					ser << getControllerCapabilities();
+					ser << std::uint32_t{ 1u };
+					ser << la::avdecc::UniqueIdentifier{};
+					ser << la::avdecc::entity::model::AvdeccFixedString{ "Simulated entity" };
+					ser << la::avdecc::entity::model::LocalizedStringReference{ 0u } << la::avdecc::entity::model::LocalizedStringReference{ 1u };
+					ser << la::avdecc::entity::model::AvdeccFixedString{ "1.0" };
+					ser << la::avdecc::entity::model::AvdeccFixedString{};
+					ser << la::avdecc::entity::model::AvdeccFixedString{ "0001" };
+					ser << std::uint16_t{ 1u } << la::avdecc::entity::model::ConfigurationIndex{ 0u };
+					break;
+				case la::avdecc::entity::model::DescriptorType::Configuration:
+					ser << la::avdecc::entity::model::AvdeccFixedString{} << la::avdecc::entity::model::getNullLocalizedStringReference();
+					ser << static_cast<std::uint16_t>(_streamsCount != 0u ? 4u : 2u) << std::uint16_t{ 74u };
+					ser << la::avdecc::entity::model::DescriptorType::Locale << static_cast<std::uint16_t>(Locales.size());
+					ser << la::avdecc::entity::model::DescriptorType::Strings << static_cast<std::uint16_t>(Locales.size() * StringsPerLocale);
+					if (_streamsCount != 0u)
+					{
+						ser << la::avdecc::entity::model::DescriptorType::StreamInput << _streamsCount;
+						ser << la::avdecc::entity::model::DescriptorType::StreamOutput << _streamsCount;
+					}
+					break;
+				case la::avdecc::entity::model::DescriptorType::Locale:
+					ser << la::avdecc::entity::model::AvdeccFixedString{ Locales.at(descriptorIndex) };
+					ser << StringsPerLocale << static_cast<la::avdecc::entity::model::StringsIndex>(descriptorIndex * StringsPerLocale);
+					break;
+				case la::avdecc::entity::model::DescriptorType::Strings:
+					for (auto i = 0u; i < 7u; ++i)
+					{
+						ser << la::avdecc::entity::model::AvdeccFixedString{ std::string{ Locales.at(descriptorIndex / StringsPerLocale) } + " " + std::to_string((descriptorIndex % StringsPerLocale) * 7u + i) };
+					}
+					++_stringsReadCount;
+					break;
+				case la::avdecc::entity::model::DescriptorType::StreamInput:
+					[[fallthrough]];
+				case la::avdecc::entity::model::DescriptorType::StreamOutput:
+					if (descriptorIndex >= _streamsCount)
+					{
+						aem.setStatus(la::avdecc::protocol::AemAecpStatus::NoSuchDescriptor);
+						break;
+					}
+					ser << la::avdecc::entity::model::AvdeccFixedString{ "Stream " + std::to_string(descriptorIndex) } << la::avdecc::entity::model::getNullLocalizedStringReference();
+					ser << la::avdecc::entity::model::ClockDomainIndex{ 0u } << la::avdecc::entity::StreamFlags::None << _streamFormat;
+					ser << std::uint16_t{ 132u } << std::uint16_t{ 1u }; // formats_offset (from the base of the descriptor) and number_of_formats
+					for (auto i = 0u; i < 4u; ++i)
+					{
+						ser << la::avdecc::UniqueIdentifier{} << std::uint16_t{ 0u }; // Backup/Backedup talkers
+					}
+					ser << la::avdecc::entity::model::AvbInterfaceIndex{ 0u } << std::uint32_t{ 0u };
+					ser << _streamFormat;
+					++_streamsReadCount;
+					break;
+				default:
+					aem.setStatus(la::avdecc::protocol::AemAecpStatus::NoSuchDescriptor);
+					break;
+			}
+			aem.setCommandSpecificData(ser.data(), ser.size());
+		}
+		else if (command.getCommandType() == la::avdecc::protocol::AemCommandType::AcquireEntity)
+		{
+			auto const [flags, ownerID, descriptorType, descriptorIndex] = la::avdecc::protocol::aemPayload::deserializeAcquireEntityCommand(command.getPayload());
+			auto const isRelease = (flags & la::avdecc::protocol::AemAcquireEntityFlags::Release) == la::avdecc::protocol::AemAcquireEntityFlags::Release;
+			auto const ser = la::avdecc::protocol::aemPayload::serializeAcquireEntityResponse(flags, _refuseAcquire ? la::avdecc::UniqueIdentifier{ OtherControllerID } : (isRelease ? la::avdecc::UniqueIdentifier{} : command.getControllerEntityID()), descriptorType, descriptorIndex);
+			aem.setStatus(_refuseAcquire ? la::avdecc::protocol::AecpStatus{ la::avdecc::protocol::AemAecpStatus::EntityAcquired } : la::avdecc::protocol::AecpStatus::Success);
+			aem.setCommandSpecificData(ser.data(), ser.size());
+			recordControlCommand(isRelease ? "RELEASE" : "ACQUIRE");
+		}
+		else if (command.getCommandType() == la::avdecc::protocol::AemCommandType::SetName)
+		{
+			auto const [descriptorType, descriptorIndex, nameIndex, configurationIndex, name] = la::avdecc::protocol::aemPayload::deserializeSetNameCommand(command.getPayload());
+			auto const ser = la::avdecc::protocol::aemPayload::serializeSetNameResponse(descriptorType, descriptorIndex, nameIndex, configurationIndex, name);
+			aem.setStatus(la::avdecc::protocol::AecpStatus::Success);
+			aem.setCommandSpecificData(ser.data(), ser.size());
+			recordControlCommand("SET_NAME");
+		}
+		else if (command.getCommandType() == la::avdecc::protocol::AemCommandType::GetStreamFormat)
+		{
+			auto const [descriptorType, descriptorIndex] = la::avdecc::protocol::aemPayload::deserializeGetStreamFormatCommand(command.getPayload());
+			auto const ser = la::avdecc::protocol::aemPayload::serializeGetStreamFormatResponse(descriptorType, descriptorIndex, _streamFormat);
+			aem.setStatus(isStreamDescriptor(descriptorType, descriptorIndex) ? la::avdecc::protocol::AecpStatus::Success : la::avdecc::protocol::AecpStatus{ la::avdecc::protocol::AemAecpStatus::NoSuchDescriptor });
+			aem.setCommandSpecificData(ser.data(), ser.size());
+		}
+		else if (command.getCommandType() == la::avdecc::protocol::AemCommandType::GetName && isStreamDescriptor(std::get<0>(la::avdecc::protocol::aemPayload::deserializeGetNameCommand(command.getPayload())), std::get<1>(la::avdecc::protocol::aemPayload::deserializeGetNameCommand(command.getPayload()))))
+		{
+			auto const [descriptorType, descriptorIndex, nameIndex, configurationIndex] = la::avdecc::protocol::aemPayload::deserializeGetNameCommand(command.getPayload());
+			auto const ser = la::avdecc::protocol::aemPayload::serializeGetNameResponse(descriptorType, descriptorIndex, nameIndex, configurationIndex, la::avdecc::entity::model::AvdeccFixedString{ "Stream " + std::to_string(descriptorIndex) });
+			aem.setStatus(la::avdecc::protocol::AecpStatus::Success);
+			aem.setCommandSpecificData(ser.data(), ser.size());
+		}
+		else
+		{
+			// Only the names of the streams can be read
+			auto const payload = command.getPayload();
+			aem.setStatus(la::avdecc::protocol::AecpStatus::NotImplemented);
+			aem.setCommandSpecificData(payload.first, payload.second);
+		}
+
+		{
+			auto const lg = std::lock_guard<decltype(_responsesLock)>{ _responsesLock };
+			// Commands are processed one after the other
+			_busyUntil = std::max(_busyUntil, std::chrono::steady_clock::now()) + ProcessingTime;
+			_responses.emplace(_busyUntil, std::move(response));
+		}
+		_condVar.notify_all();
+	}
+	void recordControlCommand(std::string const& command) noexcept
+	{
+		auto const lg = std::lock_guard<decltype(_responsesLock)>{ _responsesLock };
+		_controlCommands.push_back(command);
+	}
+	bool isStreamDescriptor(la::avdecc::entity::model::DescriptorType const descriptorType, la::avdecc::entity::model::DescriptorIndex const descriptorIndex) const noexcept
+	{
+		return (descriptorType == la::avdecc::entity::model::DescriptorType::StreamInput || descriptorType == la::avdecc::entity::model::DescriptorType::StreamOutput) && descriptorIndex < _streamsCount;
+	}
+	virtual void onAcmpSniffedCommand(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::entity::LocalEntity const& /*entity*/, la::avdecc::protocol::Acmpdu const& acmpdu) noexcept override
+	{
+		// Immediately reply to GET_RX_STATE and GET_TX_STATE commands targeting us, as unconnected streams
+		auto const messageType = acmpdu.getMessageType();
+		auto const isGetRxState = messageType == la::avdecc::protocol::AcmpMessageType::GetRxStateCommand && acmpdu.getListenerEntityID() == getEntityID();
+		auto const isGetTxState = messageType == la::avdecc::protocol::AcmpMessageType::GetTxStateCommand && acmpdu.getTalkerEntityID() == getEntityID();
+		if (!isGetRxState && !isGetTxState)
+			return;
+
+		auto response = acmpdu.copy();
+		auto& acmp = static_cast<la::avdecc::protocol::Acmpdu&>(*response);
+		acmp.setSrcAddress(_pi->getMacAddress());
+		acmp.setMessageType(isGetRxState ? la::avdecc::protocol::AcmpMessageType::GetRxStateResponse : la::avdecc::protocol::AcmpMessageType::GetTxStateResponse);
+		acmp.setStatus(la::avdecc::protocol::AcmpStatus::Success);
+		acmp.setConnectionCount(0u);
+		_pi->sendAcmpResponse(std::move(response));
+	}
+
+	std::uint16_t const _streamsCount{ 0u };
+	la::avdecc::entity::model::StreamFormat const _streamFormat{ la::avdecc::entity::model::getNullStreamFormat() };
+	std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual> _pi{ nullptr };
+	std::recursive_mutex _entityLock{};
+	mutable std::mutex _responsesLock{};
+	std::condition_variable _condVar{};
+	bool _shouldTerminate{ false };
+	std::chrono::steady_clock::time_point _busyUntil{};
+	std::multimap<std::chrono::steady_clock::time_point, la::avdecc::protocol::Aecpdu::UniquePointer> _responses{};
+	std::vector<std::string> _controlCommands{};
+	std::thread _thread{};
+
+	DECLARE_AVDECC_OBSERVER_GUARD(SimulatedEntity);
+};
+
+class LocalizedStringsObserver : public la::avdecc::controller::Controller::Observer
+{
+public:
+	std::promise<std::chrono::steady_clock::time_point> _online{};
+	std::promise<std::chrono::steady_clock::time_point> _stringsLoaded{};
+
+private:
+	virtual void onEntityOnline(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/) noexcept override
+	{
+		_online.set_value(std::chrono::steady_clock::now());
+	}
+	virtual void onEntityLocalizedStringsLoaded(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/) noexcept override
+	{
+		_stringsLoaded.set_value(std::chrono::steady_clock::now());
+	}
+
+	DECLARE_AVDECC_OBSERVER_GUARD(LocalizedStringsObserver);
+};
+
+// Enumerates a SimulatedEntity with the specified localized strings loading mode, checking the strings are correctly loaded. Returns the time it took for the entity to come online
+std::chrono::milliseconds enumerateLocalizedStrings(la::avdecc::controller::Controller::LocalizedStringsLoading const loading, std::uint64_t const runIndex)
+{
+	using LocalizedStringsLoading = la::avdecc::controller::Controller::LocalizedStringsLoading;
+	static constexpr auto StringsPerLocale = SimulatedEntity::StringsPerLocale;
+	static constexpr auto ProcessingTime = SimulatedEntity::ProcessingTime;
+
+	auto const interfaceName = std::string{ "LocalizedStringsLoadingInterface" } + std::to_string(runIndex);
+	auto const entityID = la::avdecc::UniqueIdentifier{ 0x0004000000000000 + runIndex };
+	auto observer = LocalizedStringsObserver{};
+	auto onlineFuture = observer._online.get_future();
+	auto stringsLoadedFuture = observer._stringsLoaded.get_future();
+
+	// No exact match for the prefered locale, the locale of the same language is selected
+	auto controller = la::avdecc::controller::Controller::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, interfaceName, 0x0001, la::avdecc::UniqueIdentifier{ 0x0102030405060708 }, "de-CH");
+	controller->setLocalizedStringsLoading(loading);
+	controller->registerObserver(&observer);
+	auto simulatedEntity = SimulatedEntity{ interfaceName, entityID, la::avdecc::UniqueIdentifier{ 0x0004020304050600 + runIndex } };
+
+	auto const getLocalizedString = [&controller, entityID](std::uint16_t const globalOffset)
+	{
+		auto const entity = controller->getControlledEntity(entityID);
+		return entity ? entity->getLocalizedString(makeStringReference(globalOffset)).str() : std::string{};
+	};
+
+	auto const startTime = std::chrono::steady_clock::now();
+	simulatedEntity.advertise();
+	EXPECT_EQ(std::future_status::ready, onlineFuture.wait_for(std::chrono::seconds(10)));
+	auto const enumerationTime = std::chrono::duration_cast<std::chrono::milliseconds>(onlineFuture.get() - startTime);
+	auto const stringsReadBeforeOnline = simulatedEntity._stringsReadCount.load();
+
+	if (loading == LocalizedStringsLoading::Enumeration)
+	{
+		EXPECT_EQ(StringsPerLocale, stringsReadBeforeOnline);
+	}
+	else
+	{
+		EXPECT_EQ(0u, stringsReadBeforeOnline);
+		if (loading == LocalizedStringsLoading::OnDemand)
+		{
+			std::this_thread::sleep_for(10 * ProcessingTime);
+			EXPECT_EQ(0u, simulatedEntity._stringsReadCount.load());
+			EXPECT_EQ(std::string{}, getLocalizedString(9u));
+			controller->loadLocalizedStrings(entityID);
+		}
+		EXPECT_EQ(std::future_status::ready, stringsLoadedFuture.wait_for(std::chrono::seconds(10)));
+		EXPECT_EQ(StringsPerLocale, simulatedEntity._stringsReadCount.load());
+	}
+
+	// Offsets are relative to the first STRINGS descriptor of the selected locale
+	EXPECT_EQ(std::string{ "de-DE 9" }, getLocalizedString(9u));
+	EXPECT_EQ(std::string{ "de-DE " } + std::to_string(StringsPerLocale * 7u - 1u), getLocalizedString(StringsPerLocale * 7u - 1u));
+
+	controller->unregisterObserver(&observer);
+	return enumerationTime;
+}
+} // namespace
+
+TEST(Controller, LocalizedStringsLoading)
+{
+	using LocalizedStringsLoading = la::avdecc::controller::Controller::LocalizedStringsLoading;
+
+	enumerateLocalizedStrings(LocalizedStringsLoading::Enumeration, 0u);
+	enumerateLocalizedStrings(LocalizedStringsLoading::Background, 1u);
+	enumerateLocalizedStrings(LocalizedStringsLoading::OnDemand, 2u);
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests
+TEST(Controller, DISABLED_LocalizedStringsLoadingBenchmark)
+{
+	using LocalizedStringsLoading = la::avdecc::controller::Controller::LocalizedStringsLoading;
+
+	static constexpr auto StringsPerLocale = SimulatedEntity::StringsPerLocale;
+	static constexpr auto ProcessingTime = SimulatedEntity::ProcessingTime;
+
+	auto const duringEnumeration = enumerateLocalizedStrings(LocalizedStringsLoading::Enumeration, 3u);
+	auto const background = enumerateLocalizedStrings(LocalizedStringsLoading::Background, 4u);
+	auto const onDemand = enumerateLocalizedStrings(LocalizedStringsLoading::OnDemand, 5u);
+	EXPECT_LT(background, duringEnumeration);
+	EXPECT_LT(onDemand, duringEnumeration);
+
+	std::cout << "[ BENCH    ] Enumeration of an entity with " << StringsPerLocale << " STRINGS descriptors per locale (" << ProcessingTime.count() << " msec per command): strings loaded during enumeration " << duringEnumeration.count() << " msec, in background " << background.count() << " msec, on demand " << onDemand.count() << " msec" << std::endl;
+}
+
+TEST(Controller, EntityModelCacheVerification)
+{
+	static constexpr auto StreamsCount = std::uint16_t{ 8u };
+	static constexpr auto VerifiedStreamsCount = std::uint16_t{ 2u };
+	static auto const EntityModelID = la::avdecc::UniqueIdentifier{ 0x0005020304050600 };
+	static constexpr auto StreamFormat = la::avdecc::entity::model::StreamFormat{ 0x0205022000406000 };
+	static constexpr auto OtherStreamFormat = la::avdecc::entity::model::StreamFormat{ 0x0205022001006000 };
+	static auto const InterfaceName = std::string{ "EntityModelCacheVerificationInterface" };
+
+	class Observer : public la::avdecc::controller::Controller::Observer
+	{
+	public:
+		std::future<void> expectOnline(la::avdecc::UniqueIdentifier const entityID) noexcept
+		{
+			auto const lg = std::lock_guard<decltype(_lock)>{ _lock };
+			_expectedEntityID = entityID;
+			_online = std::promise<void>{};
+			return _online.get_future();
+		}
+
+	private:
+		virtual void onEntityOnline(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const entity) noexcept override
+		{
+			auto const lg = std::lock_guard<decltype(_lock)>{ _lock };
+			if (entity->getEntity().getEntityID() == _expectedEntityID)
+			{
+				_online.set_value();
+			}
+		}
+
+		std::mutex _lock{};
+		la::avdecc::UniqueIdentifier _expectedEntityID{};
+		std::promise<void> _online{};
+
+		DECLARE_AVDECC_OBSERVER_GUARD(Observer);
+	};
+
+	auto observer = Observer{};
+	auto controller = la::avdecc::controller::Controller::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, InterfaceName, 0x0001, la::avdecc::UniqueIdentifier{ 0x0102030405060708 }, "en-US");
+	controller->registerObserver(&observer);
+	controller->enableEntityModelCache();
+	controller->enableEntityModelCacheVerification(VerifiedStreamsCount);
+
+	// Enumerates a simulated entity, returning the number of STREAM descriptors it had to read
+	auto const enumerate = [&controller, &observer](la::avdecc::UniqueIdentifier const entityID, la::avdecc::entity::model::StreamFormat const streamFormat)
+	{
+		auto simulatedEntity = SimulatedEntity{ InterfaceName, entityID, EntityModelID, StreamsCount, streamFormat };
+		auto onlineFuture = observer.expectOnline(entityID);
+		simulatedEntity.advertise();
+		EXPECT_EQ(std::future_status::ready, onlineFuture.wait_for(std::chrono::seconds(10)));
+
+		auto const entity = controller->getControlledEntity(entityID);
+		EXPECT_TRUE(!!entity);
+		if (entity)
+		{
+			EXPECT_EQ(la::avdecc::controller::model::StreamFormats{ streamFormat }, entity->getStreamInputNode(0u, 0u).staticModel->formats);
+			EXPECT_EQ(la::avdecc::controller::model::StreamFormats{ streamFormat }, entity->getStreamOutputNode(0u, StreamsCount - 1u).staticModel->formats);
+		}
+		return simulatedEntity._streamsReadCount.load();
+	};
+
+	// First entity of the model: fully enumerated then cached
+	EXPECT_EQ(2u * StreamsCount, enumerate(la::avdecc::UniqueIdentifier{ 0x0005000000000001 }, StreamFormat));
+	// Same model: only the sampled STREAM descriptors are read
+	EXPECT_EQ(2u * VerifiedStreamsCount, enumerate(la::avdecc::UniqueIdentifier{ 0x0005000000000002 }, StreamFormat));
+	// Same EntityModelID but a different model (bad firmware update): verification fails and the entity is fully enumerated
+	EXPECT_EQ(2u * VerifiedStreamsCount + 2u * StreamsCount, enumerate(la::avdecc::UniqueIdentifier{ 0x0005000000000003 }, OtherStreamFormat));
+	// Same EntityModelID but fewer streams (firmware update): a sampled STREAM descriptor does not exist, verification fails and the entity is fully enumerated without being flagged as not compliant
+	{
+		static constexpr auto FewerStreamsCount = std::uint16_t{ 2u };
+		auto const entityID = la::avdecc::UniqueIdentifier{ 0x0005000000000005 };
+		auto simulatedEntity = SimulatedEntity{ InterfaceName, entityID, EntityModelID, FewerStreamsCount, StreamFormat };
+		auto onlineFuture = observer.expectOnline(entityID);
+		simulatedEntity.advertise();
+		EXPECT_EQ(std::future_status::ready, onlineFuture.wait_for(std::chrono::seconds(10)));
+
+		auto const entity = controller->getControlledEntity(entityID);
+		ASSERT_TRUE(!!entity);
+		EXPECT_EQ(FewerStreamsCount, entity->getCurrentConfigurationNode().streamInputs.size());
+		EXPECT_NE(la::avdecc::controller::ControlledEntity::Compatibility::NotCompliant, entity->getCompatibility());
+	}
+	// Trusted cache: no STREAM descriptor read at all
+	controller->disableEntityModelCacheVerification();
+	EXPECT_EQ(0u, enumerate(la::avdecc::UniqueIdentifier{ 0x0005000000000004 }, StreamFormat));
+
+	auto const stats = controller->getEntityModelCacheStatistics();
+	EXPECT_EQ(1u, stats.misses);
+	EXPECT_EQ(1u, stats.verifiedHits);
+	EXPECT_EQ(2u, stats.verificationFailures);
+	EXPECT_EQ(1u, stats.hits);
+
+	controller->disableEntityModelCache();
+	controller->unregisterObserver(&observer);
+}
+
+TEST(Controller, ExecuteAemOperationsSimulatedEntities)
+{
+	using Operation = la::avdecc::controller::Controller::AemOperation;
+	using PreStep = la::avdecc::controller::Controller::AemOperationsPreStep;
+	using AemCommandStatus = la::avdecc::entity::ControllerEntity::AemCommandStatus;
+	static auto const InterfaceName = std::string{ "ExecuteAemOperationsSimulatedInterface" };
+
+	class Observer : public la::avdecc::controller::Controller::Observer
+	{
+	public:
+		std::atomic<size_t> _onlineCount{ 0u };
+
+	private:
+		virtual void onEntityOnline(la::avdecc::controller::Controller const* const /*controller*/, la::avdecc::controller::ControlledEntity const* const /*entity*/) noexcept override
+		{
+			++_onlineCount;
+		}
+
+		DECLARE_AVDECC_OBSERVER_GUARD(Observer);
+	};
+
+	auto observer = Observer{};
+	auto controller = la::avdecc::controller::Controller::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, InterfaceName, 0x0001, la::avdecc::UniqueIdentifier{ 0x0102030405060708 }, "en-US");
+	controller->registerObserver(&observer);
+
+	// Entity accepting to be acquired, and entity already acquired by another controller
+	auto const acceptingEntityID = la::avdecc::UniqueIdentifier{ 0x0006000000000001 };
+	auto const refusingEntityID = la::avdecc::UniqueIdentifier{ 0x0006000000000002 };
+	auto acceptingEntity = SimulatedEntity{ InterfaceName, acceptingEntityID, la::avdecc::UniqueIdentifier{ 0x0006020304050601 } };
+	auto refusingEntity = SimulatedEntity{ InterfaceName, refusingEntityID, la::avdecc::UniqueIdentifier{ 0x0006020304050602 } };
+	refusingEntity._refuseAcquire = true;
+	acceptingEntity.advertise();
+	refusingEntity.advertise();
+	for (auto i = 0; i < 1000 && observer._onlineCount != 2u; ++i)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	ASSERT_EQ(2u, observer._onlineCount);
+
+	// Ignore the acquire state queried during enumeration
+	acceptingEntity.clearControlCommands();
+	refusingEntity.clearControlCommands();
+
+	auto const operations = la::avdecc::controller::Controller::AemOperations{
+		{ acceptingEntityID, Operation::Type::SetEntityName, 0u, 0u, la::avdecc::entity::model::AvdeccFixedString{ "Accepting" } },
+		{ refusingEntityID, Operation::Type::SetEntityName, 0u, 0u, la::avdecc::entity::model::AvdeccFixedString{ "Refusing" } },
+		{ acceptingEntityID, Operation::Type::SetEntityGroupName, 0u, 0u, la::avdecc::entity::model::AvdeccFixedString{ "Group" } },
+		{ refusingEntityID, Operation::Type::SetEntityGroupName, 0u, 0u, la::avdecc::entity::model::AvdeccFixedString{ "Group" } },
+	};
+
+	auto resultsPromise = std::promise<std::pair<la::avdecc::controller::Controller::AemOperationResults, la::avdecc::controller::Controller::AemOperationsStatistics>>{};
+	controller->executeAemOperations(operations, PreStep::Acquire, 2u, nullptr,
+		[&resultsPromise](la::avdecc::controller::Controller::AemOperationResults const& results, la::avdecc::controller::Controller::AemOperationsStatistics const& statistics)
+		{
+			resultsPromise.set_value(std::make_pair(results, statistics));
+		});
+
+	auto resultsFuture = resultsPromise.get_future();
+	ASSERT_EQ(std::future_status::ready, resultsFuture.wait_for(std::chrono::seconds(10)));
+	auto const [results, statistics] = resultsFuture.get();
+	ASSERT_EQ(operations.size(), results.size());
+
+	// Successful SET commands, applied to the model
+	EXPECT_EQ(AemCommandStatus::Success, results[0].status);
+	EXPECT_EQ(AemCommandStatus::Success, results[2].status);
+	EXPECT_LE(SimulatedEntity::ProcessingTime, results[0].duration);
+	EXPECT_LE(SimulatedEntity::ProcessingTime, results[2].duration);
+	{
+		auto const entity = controller->getControlledEntity(acceptingEntityID);
+		ASSERT_TRUE(!!entity);
+		EXPECT_STREQ("Accepting", entity->getEntityNode().dynamicModel->entityName.str().c_str());
+		EXPECT_STREQ("Group", entity->getEntityNode().dynamicModel->groupName.str().c_str());
 	}
+
+	// Pre-step failure is reported for all the operations of the entity, which are not sent
+	EXPECT_EQ(AemCommandStatus::AcquiredByOther, results[1].status);
+	EXPECT_EQ(AemCommandStatus::AcquiredByOther, results[3].status);
+	EXPECT_EQ(std::chrono::milliseconds{ 0 }, results[1].duration);
+	EXPECT_EQ(std::chrono::milliseconds{ 0 }, results[3].duration);
+
+	// Acquired before its operations and released after them, nothing else sent (not even the release) when the acquisition failed
+	EXPECT_EQ((std::vector<std::string>{ "ACQUIRE", "SET_NAME", "SET_NAME", "RELEASE" }), acceptingEntity.getControlCommands());
+	EXPECT_EQ((std::vector<std::string>{ "ACQUIRE" }), refusingEntity.getControlCommands());
+
+	// Latency statistics only account for the operations that were sent
+	EXPECT_EQ(2u, statistics.succeededOperations);
+	EXPECT_EQ(2u, statistics.failedOperations);
+	EXPECT_EQ(std::min(results[0].duration, results[2].duration), statistics.minDuration);
+	EXPECT_EQ(std::max(results[0].duration, results[2].duration), statistics.maxDuration);
+	EXPECT_EQ((results[0].duration + results[2].duration) / 2, statistics.averageDuration);
+	// Acquire, both operations (sent one after the other on the same entity) and release
+	EXPECT_LE(results[0].duration + results[2].duration + 2 * SimulatedEntity::ProcessingTime, statistics.elapsed);
+
+	controller->unregisterObserver(&observer);
 }
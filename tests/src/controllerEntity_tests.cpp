@@ -28,7 +28,10 @@
 // Internal API
 #include "entity/controllerEntityImpl.hpp"
 #include "protocolInterface/protocolInterface_virtual.hpp"
+#include "stateMachine/controllerStateMachine.hpp"
+#include "protocol/protocolAemPayloads.hpp"
 #include "instrumentationObserver.hpp"
+#include "allocationCounter.hpp"
 
 #include <gtest/gtest.h>
 #include <string>
@@ -36,6 +39,7 @@
 #include <chrono>
 #include <list>
 #include <future>
+#include <iostream>
 
 TEST(ControllerEntity, DispatchWhileSending)
 {
@@ -96,3 +100,304 @@ TEST(ControllerEntity, DispatchWhileSending)
 //	auto status = commandResultPromise.get_future().wait_for(std::chrono::seconds(1));
 //	ASSERT_NE(std::future_status::timeout, status);
 //}
+
+namespace
+{
+/** ProtocolInterface not sending anything, commands going through a real ControllerStateMachine. Messages are injected by the test, from the calling thread */
+class LoopbackProtocolInterface final : public la::avdecc::protocol::ProtocolInterface, private la::avdecc::protocol::stateMachine::ControllerStateMachine::Delegate
+{
+public:
+	LoopbackProtocolInterface()
+		: ProtocolInterface("LoopbackInterface", { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } })
+		, _controllerStateMachine(this, this)
+	{
+	}
+
+	void injectAdpdu(la::avdecc::protocol::Adpdu const& adpdu) noexcept
+	{
+		_controllerStateMachine.processAdpdu(adpdu);
+	}
+
+	void injectAecpdu(la::avdecc::protocol::Aecpdu const& aecpdu) noexcept
+	{
+		_controllerStateMachine.processAecpdu(aecpdu);
+	}
+
+	/** Last AEM command sent by the state machine (copied, so it doesn't allocate) */
+	la::avdecc::protocol::AemAecpdu const& getLastAemCommand() const noexcept
+	{
+		return _lastAemCommand;
+	}
+
+private:
+	// ProtocolInterface overrides
+	virtual void destroy() noexcept override
+	{
+		delete this;
+	}
+	virtual void shutdown() noexcept override {}
+	virtual Error registerLocalEntity(la::avdecc::entity::LocalEntity& entity) noexcept override
+	{
+		return _controllerStateMachine.registerLocalEntity(entity);
+	}
+	virtual Error unregisterLocalEntity(la::avdecc::entity::LocalEntity& entity) noexcept override
+	{
+		return _controllerStateMachine.unregisterLocalEntity(entity);
+	}
+	virtual Error enableEntityAdvertising(la::avdecc::entity::LocalEntity const& /*entity*/) noexcept override
+	{
+		return Error::NoError;
+	}
+	virtual Error disableEntityAdvertising(la::avdecc::entity::LocalEntity& /*entity*/) noexcept override
+	{
+		return Error::NoError;
+	}
+	virtual Error discoverRemoteEntities() const noexcept override
+	{
+		return Error::NoError;
+	}
+	virtual Error discoverRemoteEntity(la::avdecc::UniqueIdentifier const /*entityID*/) const noexcept override
+	{
+		return Error::NoError;
+	}
+	virtual Error sendAdpMessage(la::avdecc::protocol::Adpdu::UniquePointer&& /*adpdu*/) const noexcept override
+	{
+		return Error::NoError;
+	}
+	virtual Error sendAecpMessage(la::avdecc::protocol::Aecpdu::UniquePointer&& /*aecpdu*/) const noexcept override
+	{
+		return Error::NoError;
+	}
+	virtual Error sendAcmpMessage(la::avdecc::protocol::Acmpdu::UniquePointer&& /*acmpdu*/) const noexcept override
+	{
+		return Error::NoError;
+	}
+	virtual Error sendAecpCommand(la::avdecc::protocol::Aecpdu::UniquePointer&& aecpdu, la::avdecc::networkInterface::MacAddress const& macAddress, AecpCommandResultHandler const& onResult) const noexcept override
+	{
+		return sendAecpCommand(std::move(aecpdu), macAddress, onResult, la::avdecc::protocol::AecpCommandPriority::Interactive);
+	}
+	virtual Error sendAecpCommand(la::avdecc::protocol::Aecpdu::UniquePointer&& aecpdu, la::avdecc::networkInterface::MacAddress const& /*macAddress*/, AecpCommandResultHandler const& onResult, la::avdecc::protocol::AecpCommandPriority const priority) const noexcept override
+	{
+		return _controllerStateMachine.sendAecpCommand(std::move(aecpdu), onResult, priority);
+	}
+	virtual Error sendAecpResponse(la::avdecc::protocol::Aecpdu::UniquePointer&& /*aecpdu*/, la::avdecc::networkInterface::MacAddress const& /*macAddress*/) const noexcept override
+	{
+		return Error::NoError;
+	}
+	virtual Error sendAcmpCommand(la::avdecc::protocol::Acmpdu::UniquePointer&& acmpdu, AcmpCommandResultHandler const& onResult) const noexcept override
+	{
+		return _controllerStateMachine.sendAcmpCommand(std::move(acmpdu), onResult);
+	}
+	virtual Error sendAcmpResponse(la::avdecc::protocol::Acmpdu::UniquePointer&& /*acmpdu*/) const noexcept override
+	{
+		return Error::NoError;
+	}
+	virtual void lock() noexcept override
+	{
+		_controllerStateMachine.lock();
+	}
+	virtual void unlock() noexcept override
+	{
+		_controllerStateMachine.unlock();
+	}
+
+	// ControllerStateMachine::Delegate overrides
+	virtual void onLocalEntityOnline(la::avdecc::entity::DiscoveredEntity const& /*entity*/) noexcept override {}
+	virtual void onLocalEntityOffline(la::avdecc::UniqueIdentifier const /*entityID*/) noexcept override {}
+	virtual void onLocalEntityUpdated(la::avdecc::entity::DiscoveredEntity const& /*entity*/) noexcept override {}
+	virtual void onRemoteEntityOnline(la::avdecc::entity::DiscoveredEntity const& entity) noexcept override
+	{
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityOnline, this, entity);
+	}
+	virtual void onRemoteEntityOffline(la::avdecc::UniqueIdentifier const entityID) noexcept override
+	{
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityOffline, this, entityID);
+	}
+	virtual void onRemoteEntityUpdated(la::avdecc::entity::DiscoveredEntity const& /*entity*/) noexcept override {}
+	virtual void onDeferredDiscoveryError(Error const /*error*/) noexcept override {}
+	virtual void onAecpCommand(la::avdecc::entity::LocalEntity const& /*entity*/, la::avdecc::protocol::Aecpdu const& /*aecpdu*/) noexcept override {}
+	virtual void onAecpUnsolicitedResponse(la::avdecc::entity::LocalEntity const& /*entity*/, la::avdecc::protocol::Aecpdu const& /*aecpdu*/) noexcept override {}
+	virtual void onAcmpSniffedCommand(la::avdecc::entity::LocalEntity const& /*entity*/, la::avdecc::protocol::Acmpdu const& /*acmpdu*/) noexcept override {}
+	virtual void onAcmpSniffedResponse(la::avdecc::entity::LocalEntity const& /*entity*/, la::avdecc::protocol::Acmpdu const& /*acmpdu*/) noexcept override {}
+	virtual Error sendMessage(la::avdecc::protocol::Adpdu const& /*adpdu*/) const noexcept override
+	{
+		return Error::NoError;
+	}
+	virtual Error sendMessage(la::avdecc::protocol::Aecpdu const& aecpdu) const noexcept override
+	{
+		if (aecpdu.getMessageType() == la::avdecc::protocol::AecpMessageType::AemCommand)
+		{
+			_lastAemCommand = static_cast<la::avdecc::protocol::AemAecpdu const&>(aecpdu);
+		}
+		return Error::NoError;
+	}
+	virtual Error sendMessage(la::avdecc::protocol::Acmpdu const& /*acmpdu*/) const noexcept override
+	{
+		return Error::NoError;
+	}
+
+	mutable la::avdecc::protocol::AemAecpdu _lastAemCommand{};
+	mutable la::avdecc::protocol::stateMachine::ControllerStateMachine _controllerStateMachine;
+};
+
+/** ControllerEntity sending GET_STREAM_FORMAT commands to a discovered entity through a LoopbackProtocolInterface, each command being immediately answered */
+class GetStreamFormatLoop final
+{
+public:
+	static constexpr auto TargetEntityID = std::uint64_t{ 0x001B92FFFE000001 };
+
+	GetStreamFormatLoop()
+	{
+		// Discover the target entity
+		{
+			auto adpdu = la::avdecc::protocol::Adpdu{};
+			adpdu.setSrcAddress({ 0x00, 0x1b, 0x92, 0x00, 0x00, 0x01 });
+			adpdu.setMessageType(la::avdecc::protocol::AdpMessageType::EntityAvailable);
+			adpdu.setValidTime(31);
+			adpdu.setEntityID(la::avdecc::UniqueIdentifier{ TargetEntityID });
+			adpdu.setEntityCapabilities(la::avdecc::entity::EntityCapabilities::AemSupported);
+			_pi->injectAdpdu(adpdu);
+		}
+
+		// Prepare the response (only SequenceID changes)
+		auto const ser = la::avdecc::protocol::aemPayload::serializeGetStreamFormatResponse(la::avdecc::entity::model::DescriptorType::StreamInput, 0u, la::avdecc::entity::model::StreamFormat{ 0x00A0020140000100u });
+		_response.setCommandSpecificData(ser.data(), ser.size());
+	}
+
+	void sendAndAnswer() noexcept
+	{
+		static_cast<la::avdecc::entity::ControllerEntity*>(_controllerGuard.get())->getStreamInputFormat(la::avdecc::UniqueIdentifier{ TargetEntityID }, 0u, _handler);
+
+		auto const& command = _pi->getLastAemCommand();
+		_response.setSrcAddress(command.getDestAddress());
+		_response.setDestAddress(command.getSrcAddress());
+		_response.setMessageType(la::avdecc::protocol::AecpMessageType::AemResponse);
+		_response.setStatus(la::avdecc::protocol::AecpStatus::Success);
+		_response.setTargetEntityID(command.getTargetEntityID());
+		_response.setControllerEntityID(command.getControllerEntityID());
+		_response.setSequenceID(command.getSequenceID());
+		_response.setCommandType(command.getCommandType());
+
+		// Only measure the processing of the response (state machine, dispatch and result handler)
+		auto const responseStartTime = std::chrono::steady_clock::now();
+		_pi->injectAecpdu(_response);
+		_responseDuration += std::chrono::steady_clock::now() - responseStartTime;
+	}
+
+	size_t getAnsweredCount() const noexcept
+	{
+		return _answeredCount;
+	}
+
+	std::chrono::steady_clock::duration getResponseDuration() const noexcept
+	{
+		return _responseDuration;
+	}
+
+	void resetResponseDuration() noexcept
+	{
+		_responseDuration = {};
+	}
+
+private:
+	std::unique_ptr<LoopbackProtocolInterface> _pi{ std::make_unique<LoopbackProtocolInterface>() };
+	std::unique_ptr<la::avdecc::entity::LocalEntityGuard<la::avdecc::entity::ControllerEntityImpl>> _controllerGuard{ std::make_unique<la::avdecc::entity::LocalEntityGuard<la::avdecc::entity::ControllerEntityImpl>>(_pi.get(), std::uint16_t{ 1 }, la::avdecc::UniqueIdentifier{ 0u }, nullptr) };
+	la::avdecc::protocol::AemAecpdu _response{};
+	size_t _answeredCount{ 0u };
+	std::chrono::steady_clock::duration _responseDuration{};
+	la::avdecc::entity::ControllerEntity::GetStreamInputFormatHandler const _handler{ [this](la::avdecc::entity::ControllerEntity const* const /*controller*/, la::avdecc::UniqueIdentifier const /*entityID*/, la::avdecc::entity::ControllerEntity::AemCommandStatus const status, la::avdecc::entity::model::StreamIndex const /*streamIndex*/, la::avdecc::entity::model::StreamFormat const /*streamFormat*/)
+		{
+			if (status == la::avdecc::entity::ControllerEntity::AemCommandStatus::Success)
+			{
+				++_answeredCount;
+			}
+		} };
+};
+} // namespace
+
+TEST(ControllerEntity, AemCommandsDoNotAllocate)
+{
+	static constexpr auto WarmUpCommands = 16u;
+	static constexpr auto MeasuredCommands = 1000u;
+
+	auto loop = GetStreamFormatLoop{};
+
+	// Warm up (lazily created dispatch tables and pools)
+	for (auto i = 0u; i < WarmUpCommands; ++i)
+	{
+		loop.sendAndAnswer();
+	}
+	ASSERT_EQ(WarmUpCommands, loop.getAnsweredCount());
+
+	// Only allocations made by this thread (sending the command and processing its response) are counted, not the ones of the background threads
+	auto const counter = AllocationCounter{};
+	for (auto i = 0u; i < MeasuredCommands; ++i)
+	{
+		loop.sendAndAnswer();
+	}
+	auto const statistics = counter.getStatistics();
+
+	EXPECT_EQ(WarmUpCommands + MeasuredCommands, loop.getAnsweredCount());
+	EXPECT_EQ(0u, statistics.allocations);
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests
+TEST(ControllerEntity, DISABLED_AemCommandsBenchmark)
+{
+	static constexpr auto WarmUpCommands = 16u;
+	static constexpr auto MeasuredCommands = 100000u;
+
+	auto loop = GetStreamFormatLoop{};
+
+	// Warm up (lazily created dispatch tables and pools)
+	for (auto i = 0u; i < WarmUpCommands; ++i)
+	{
+		loop.sendAndAnswer();
+	}
+	ASSERT_EQ(WarmUpCommands, loop.getAnsweredCount());
+
+	loop.resetResponseDuration();
+	auto const counter = AllocationCounter{};
+	auto const startTime = std::chrono::steady_clock::now();
+	for (auto i = 0u; i < MeasuredCommands; ++i)
+	{
+		loop.sendAndAnswer();
+	}
+	auto const duration = std::chrono::steady_clock::now() - startTime;
+	auto const statistics = counter.getStatistics();
+
+	EXPECT_EQ(WarmUpCommands + MeasuredCommands, loop.getAnsweredCount());
+
+	std::cout << "[ BENCH    ] " << MeasuredCommands << " GET_STREAM_FORMAT commands: " << static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / MeasuredCommands << " ns/command (" << static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(loop.getResponseDuration()).count()) / MeasuredCommands << " ns/response), " << statistics.allocations << " allocations" << std::endl;
+}
+
+TEST(ControllerEntity, SynchronousErrorHandlerPriority)
+{
+	using Priority = la::avdecc::protocol::AecpCommandPriority;
+
+	auto pi = std::make_unique<LoopbackProtocolInterface>();
+	auto controllerGuard = std::make_unique<la::avdecc::entity::LocalEntityGuard<la::avdecc::entity::ControllerEntityImpl>>(pi.get(), std::uint16_t{ 1 }, la::avdecc::UniqueIdentifier{ 0u }, nullptr);
+	auto* const controller = static_cast<la::avdecc::entity::ControllerEntity*>(controllerGuard.get());
+
+	auto handlerCalled = false;
+	auto handlerPriority = Priority::Background;
+	{
+		auto const priorityGuard = la::avdecc::entity::ControllerEntity::CommandPriorityGuard{ Priority::Background };
+
+		// Unknown entity: the handler is called synchronously, commands it sends must not inherit the priority of the failed one
+		controller->getStreamInputFormat(la::avdecc::UniqueIdentifier{ 0x001B92FFFE000001 }, 0u,
+			[&handlerCalled, &handlerPriority](la::avdecc::entity::ControllerEntity const* const /*controller*/, la::avdecc::UniqueIdentifier const /*entityID*/, la::avdecc::entity::ControllerEntity::AemCommandStatus const status, la::avdecc::entity::model::StreamIndex const /*streamIndex*/, la::avdecc::entity::model::StreamFormat const /*streamFormat*/)
+			{
+				EXPECT_EQ(la::avdecc::entity::ControllerEntity::AemCommandStatus::UnknownEntity, status);
+				handlerCalled = true;
+				handlerPriority = la::avdecc::entity::ControllerEntity::getThreadCommandPriority();
+			});
+
+		// Priority of the caller restored once the command is sent
+		EXPECT_EQ(Priority::Background, la::avdecc::entity::ControllerEntity::getThreadCommandPriority());
+	}
+
+	EXPECT_TRUE(handlerCalled);
+	EXPECT_EQ(Priority::Interactive, handlerPriority);
+	EXPECT_EQ(Priority::Interactive, la::avdecc::entity::ControllerEntity::getThreadCommandPriority());
+}
@@ -24,10 +24,658 @@
 
 // Internal API
 #include "stateMachine/controllerStateMachine.hpp"
+#include "protocolInterface/protocolInterface_virtual.hpp"
+#include "la/avdecc/internals/protocolAemAecpdu.hpp"
 
 #include <gtest/gtest.h>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+#include <unordered_map>
 
 TEST(ControllerStateMachine, InvalidDelegate)
 {
 	EXPECT_THROW(la::avdecc::protocol::stateMachine::ControllerStateMachine(nullptr, nullptr);, la::avdecc::Exception);
 }
+
+namespace
+{
+class CountingDelegate final : public la::avdecc::protocol::stateMachine::ControllerStateMachine::Delegate
+{
+public:
+	size_t onlineCount{ 0u };
+	size_t offlineCount{ 0u };
+	size_t updatedCount{ 0u };
+	mutable size_t aecpSentCount{ 0u };
+	mutable std::vector<la::avdecc::protocol::Aecpdu::UniquePointer> aecpSentCommands{};
+	std::vector<la::avdecc::UniqueIdentifier> offlineEntities{};
+	bool recordAecpCommands{ false };
+	mutable std::vector<la::avdecc::protocol::Adpdu> adpSentMessages{};
+	la::avdecc::protocol::ProtocolInterface::Error adpSendError{ la::avdecc::protocol::ProtocolInterface::Error::NoError };
+	std::vector<la::avdecc::protocol::ProtocolInterface::Error> deferredDiscoveryErrors{};
+
+private:
+	/* **** Discovery notifications **** */
+	virtual void onLocalEntityOnline(la::avdecc::entity::DiscoveredEntity const& /*entity*/) noexcept override {}
+	virtual void onLocalEntityOffline(la::avdecc::UniqueIdentifier const /*entityID*/) noexcept override {}
+	virtual void onLocalEntityUpdated(la::avdecc::entity::DiscoveredEntity const& /*entity*/) noexcept override {}
+	virtual void onRemoteEntityOnline(la::avdecc::entity::DiscoveredEntity const& /*entity*/) noexcept override
+	{
+		++onlineCount;
+	}
+	virtual void onRemoteEntityOffline(la::avdecc::UniqueIdentifier const entityID) noexcept override
+	{
+		++offlineCount;
+		offlineEntities.push_back(entityID);
+	}
+	virtual void onRemoteEntityUpdated(la::avdecc::entity::DiscoveredEntity const& /*entity*/) noexcept override
+	{
+		++updatedCount;
+	}
+	virtual void onDeferredDiscoveryError(la::avdecc::protocol::ProtocolInterface::Error const error) noexcept override
+	{
+		deferredDiscoveryErrors.push_back(error);
+	}
+	/* **** AECP notifications **** */
+	virtual void onAecpCommand(la::avdecc::entity::LocalEntity const& /*entity*/, la::avdecc::protocol::Aecpdu const& /*aecpdu*/) noexcept override {}
+	virtual void onAecpUnsolicitedResponse(la::avdecc::entity::LocalEntity const& /*entity*/, la::avdecc::protocol::Aecpdu const& /*aecpdu*/) noexcept override {}
+	/* **** ACMP notifications **** */
+	virtual void onAcmpSniffedCommand(la::avdecc::entity::LocalEntity const& /*entity*/, la::avdecc::protocol::Acmpdu const& /*acmpdu*/) noexcept override {}
+	virtual void onAcmpSniffedResponse(la::avdecc::entity::LocalEntity const& /*entity*/, la::avdecc::protocol::Acmpdu const& /*acmpdu*/) noexcept override {}
+	/* **** Delegate methods **** */
+	virtual la::avdecc::protocol::ProtocolInterface::Error sendMessage(la::avdecc::protocol::Adpdu const& adpdu) const noexcept override
+	{
+		adpSentMessages.push_back(adpdu);
+		return adpSendError;
+	}
+	virtual la::avdecc::protocol::ProtocolInterface::Error sendMessage(la::avdecc::protocol::Aecpdu const& aecpdu) const noexcept override
+	{
+		++aecpSentCount;
+		if (recordAecpCommands)
+			aecpSentCommands.push_back(aecpdu.copy());
+		return la::avdecc::protocol::ProtocolInterface::Error::NoError;
+	}
+	virtual la::avdecc::protocol::ProtocolInterface::Error sendMessage(la::avdecc::protocol::Acmpdu const& /*acmpdu*/) const noexcept override
+	{
+		return la::avdecc::protocol::ProtocolInterface::Error::NoError;
+	}
+};
+
+class TestControllerEntity final : public la::avdecc::entity::LocalEntity
+{
+public:
+	TestControllerEntity(la::avdecc::UniqueIdentifier const entityID, std::uint8_t const validTime = 31u) noexcept
+		: LocalEntity(entityID, { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } }, la::avdecc::UniqueIdentifier{ 0x001B92FFFF000002 }, la::avdecc::entity::EntityCapabilities::None, 0u, la::avdecc::entity::TalkerCapabilities::None, 0u, la::avdecc::entity::ListenerCapabilities::None, la::avdecc::entity::ControllerCapabilities::Implemented, 0u, 0u, la::avdecc::UniqueIdentifier::getNullUniqueIdentifier())
+	{
+		setValidTime(validTime);
+	}
+
+private:
+	virtual bool enableEntityAdvertising(std::uint32_t const /*availableDuration*/) noexcept override
+	{
+		return true;
+	}
+	virtual void disableEntityAdvertising() noexcept override {}
+	virtual bool isDirty() noexcept override
+	{
+		return false;
+	}
+	virtual void lock() noexcept override
+	{
+		_lock.lock();
+	}
+	virtual void unlock() noexcept override
+	{
+		_lock.unlock();
+	}
+
+	std::recursive_mutex _lock{};
+};
+
+la::avdecc::protocol::Adpdu makeEntityAvailable(std::uint64_t const entityID, std::uint32_t const availableIndex, std::uint64_t const grandmasterID)
+{
+	auto adpdu = la::avdecc::protocol::Adpdu{};
+	adpdu.setSrcAddress({ 0x00, 0x1b, 0x92, static_cast<std::uint8_t>(entityID >> 16), static_cast<std::uint8_t>(entityID >> 8), static_cast<std::uint8_t>(entityID) });
+	adpdu.setMessageType(la::avdecc::protocol::AdpMessageType::EntityAvailable);
+	adpdu.setValidTime(31);
+	adpdu.setEntityID(la::avdecc::UniqueIdentifier{ entityID });
+	adpdu.setEntityModelID(la::avdecc::UniqueIdentifier{ 0x001B92FFFF000001 });
+	adpdu.setEntityCapabilities(la::avdecc::entity::EntityCapabilities::AemSupported | la::avdecc::entity::EntityCapabilities::GptpSupported);
+	adpdu.setAvailableIndex(availableIndex);
+	adpdu.setGptpGrandmasterID(la::avdecc::UniqueIdentifier{ grandmasterID });
+	return adpdu;
+}
+} // namespace
+
+TEST(ControllerStateMachine, AdpAvailableIndexRegression)
+{
+	auto delegate = CountingDelegate{};
+	auto stateMachine = la::avdecc::protocol::stateMachine::ControllerStateMachine{ nullptr, &delegate };
+	static constexpr auto EntityID = std::uint64_t{ 0x001B92FFFE000001 };
+
+	stateMachine.processAdpdu(makeEntityAvailable(EntityID, 10u, 0x1111));
+	EXPECT_EQ(1u, delegate.onlineCount);
+
+	// Steady state re-advertisement
+	stateMachine.processAdpdu(makeEntityAvailable(EntityID, 11u, 0x1111));
+	EXPECT_EQ(1u, delegate.onlineCount);
+	EXPECT_EQ(0u, delegate.offlineCount);
+	EXPECT_EQ(0u, delegate.updatedCount);
+
+	// Allowed change
+	stateMachine.processAdpdu(makeEntityAvailable(EntityID, 12u, 0x2222));
+	EXPECT_EQ(1u, delegate.updatedCount);
+
+	// Same AvailableIndex means the entity rebooted, even if nothing else changed
+	stateMachine.processAdpdu(makeEntityAvailable(EntityID, 12u, 0x2222));
+	EXPECT_EQ(1u, delegate.offlineCount);
+	EXPECT_EQ(2u, delegate.onlineCount);
+
+	// AvailableIndex going backwards as well
+	stateMachine.processAdpdu(makeEntityAvailable(EntityID, 0u, 0x2222));
+	EXPECT_EQ(2u, delegate.offlineCount);
+	EXPECT_EQ(3u, delegate.onlineCount);
+	EXPECT_EQ(1u, delegate.updatedCount);
+}
+
+TEST(ControllerStateMachine, AdpSteadyState)
+{
+	static constexpr auto EntitiesCount = 4u;
+	static constexpr auto Rounds = 3u;
+
+	auto delegate = CountingDelegate{};
+	auto stateMachine = la::avdecc::protocol::stateMachine::ControllerStateMachine{ nullptr, &delegate };
+
+	// Steady state: only AvailableIndex changes, entities only go online once
+	for (auto round = 1u; round <= Rounds; ++round)
+	{
+		for (auto entity = 0u; entity < EntitiesCount; ++entity)
+		{
+			stateMachine.processAdpdu(makeEntityAvailable(0x001B92FFFE000000 + entity, round, 0u));
+		}
+	}
+	EXPECT_EQ(EntitiesCount, delegate.onlineCount);
+	EXPECT_EQ(0u, delegate.offlineCount);
+	EXPECT_EQ(0u, delegate.updatedCount);
+
+	// Changing state: gPTP grandmaster changes in every message
+	for (auto round = Rounds + 1u; round <= 2u * Rounds; ++round)
+	{
+		for (auto entity = 0u; entity < EntitiesCount; ++entity)
+		{
+			stateMachine.processAdpdu(makeEntityAvailable(0x001B92FFFE000000 + entity, round, round));
+		}
+	}
+	EXPECT_EQ(EntitiesCount, delegate.onlineCount);
+	EXPECT_EQ(0u, delegate.offlineCount);
+	EXPECT_EQ(EntitiesCount * Rounds, delegate.updatedCount);
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests
+TEST(ControllerStateMachine, DISABLED_AdpSteadyStateBenchmark)
+{
+	static constexpr auto EntitiesCount = 800u;
+	static constexpr auto Rounds = 250u;
+
+	auto delegate = CountingDelegate{};
+	auto stateMachine = la::avdecc::protocol::stateMachine::ControllerStateMachine{ nullptr, &delegate };
+
+	// Prepare all the messages beforehand, only measure the processing
+	auto const makeRounds = [](bool const changeGrandmaster)
+	{
+		auto adpdus = std::vector<la::avdecc::protocol::Adpdu>{};
+		adpdus.reserve(EntitiesCount * Rounds);
+		for (auto round = 1u; round <= Rounds; ++round)
+		{
+			for (auto entity = 0u; entity < EntitiesCount; ++entity)
+			{
+				adpdus.push_back(makeEntityAvailable(0x001B92FFFE000000 + entity, round, changeGrandmaster ? round : 0u));
+			}
+		}
+		return adpdus;
+	};
+	auto const runBenchmark = [&stateMachine](std::vector<la::avdecc::protocol::Adpdu> const& adpdus)
+	{
+		auto const startTime = std::chrono::steady_clock::now();
+		for (auto const& adpdu : adpdus)
+		{
+			stateMachine.processAdpdu(adpdu);
+		}
+		auto const duration = std::chrono::steady_clock::now() - startTime;
+		return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / adpdus.size();
+	};
+
+	// Steady state: only AvailableIndex changes
+	auto const steadyCost = runBenchmark(makeRounds(false));
+	EXPECT_EQ(EntitiesCount, delegate.onlineCount);
+	EXPECT_EQ(0u, delegate.offlineCount);
+	EXPECT_EQ(0u, delegate.updatedCount);
+
+	// Changing state: gPTP grandmaster changes in every message (continuing with increasing AvailableIndex)
+	delegate = CountingDelegate{};
+	auto changingAdpdus = makeRounds(true);
+	for (auto& adpdu : changingAdpdus)
+	{
+		adpdu.setAvailableIndex(adpdu.getAvailableIndex() + Rounds);
+	}
+	auto const changingCost = runBenchmark(changingAdpdus);
+	EXPECT_EQ(0u, delegate.onlineCount);
+	EXPECT_EQ(0u, delegate.offlineCount);
+	EXPECT_EQ(EntitiesCount * Rounds, delegate.updatedCount);
+
+	std::cout << "[ BENCH    ] " << EntitiesCount << " entities: steady state " << steadyCost << " ns/ADPDU, changing advertisement " << changingCost << " ns/ADPDU" << std::endl;
+}
+
+TEST(ControllerStateMachine, AdpDispatch)
+{
+	auto delegate = CountingDelegate{};
+	auto stateMachine = la::avdecc::protocol::stateMachine::ControllerStateMachine{ nullptr, &delegate };
+
+	// ENTITY_DISCOVER is processed (even without any local entity to answer it), an unknown message type is not
+	auto discover = la::avdecc::protocol::Adpdu{};
+	discover.setMessageType(la::avdecc::protocol::AdpMessageType::EntityDiscover);
+	discover.setEntityID(la::avdecc::UniqueIdentifier{ 0x001B92FFFE000001 });
+	EXPECT_TRUE(stateMachine.processAdpdu(discover));
+
+	auto unknown = la::avdecc::protocol::Adpdu{};
+	unknown.setMessageType(la::avdecc::protocol::AdpMessageType{ 3 });
+	EXPECT_FALSE(stateMachine.processAdpdu(unknown));
+	EXPECT_EQ(0u, delegate.onlineCount);
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests
+TEST(ControllerStateMachine, DISABLED_AdpDispatchBenchmark)
+{
+	static constexpr auto Messages = 1000000u;
+
+	auto delegate = CountingDelegate{};
+	auto stateMachine = la::avdecc::protocol::stateMachine::ControllerStateMachine{ nullptr, &delegate };
+
+	// ENTITY_DISCOVER targeting an unknown entity (no local entity registered) and an unknown message type: almost nothing but the dispatch is done
+	auto discover = la::avdecc::protocol::Adpdu{};
+	discover.setMessageType(la::avdecc::protocol::AdpMessageType::EntityDiscover);
+	discover.setEntityID(la::avdecc::UniqueIdentifier{ 0x001B92FFFE000001 });
+	auto unknown = la::avdecc::protocol::Adpdu{};
+	unknown.setMessageType(la::avdecc::protocol::AdpMessageType{ 3 });
+
+	auto const runBenchmark = [&stateMachine](la::avdecc::protocol::Adpdu const& adpdu, bool const expectedProcessed)
+	{
+		auto processedCount = size_t{ 0u };
+		auto const startTime = std::chrono::steady_clock::now();
+		for (auto i = 0u; i < Messages; ++i)
+		{
+			processedCount += stateMachine.processAdpdu(adpdu) ? 1u : 0u;
+		}
+		auto const duration = std::chrono::steady_clock::now() - startTime;
+		EXPECT_EQ(expectedProcessed ? Messages : 0u, processedCount);
+		return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / Messages;
+	};
+
+	auto const discoverCost = runBenchmark(discover, true);
+	auto const unknownCost = runBenchmark(unknown, false);
+
+	std::cout << "[ BENCH    ] ADP dispatch: ENTITY_DISCOVER " << discoverCost << " ns/ADPDU, unknown message type " << unknownCost << " ns/ADPDU" << std::endl;
+}
+
+TEST(ControllerStateMachine, AdpTimeoutManualClock)
+{
+	auto clock = la::avdecc::ManualClock{};
+	auto delegate = CountingDelegate{};
+	auto stateMachine = la::avdecc::protocol::stateMachine::ControllerStateMachine{ nullptr, &delegate, la::avdecc::protocol::Aecpdu::DefaultMaxInflightCommands, clock };
+	static constexpr auto EntityID = std::uint64_t{ 0x001B92FFFE000001 };
+
+	// Lock the state machine during the whole test, as a ProtocolInterface does when processing messages
+	std::lock_guard<decltype(stateMachine)> const lg(stateMachine);
+
+	stateMachine.processAdpdu(makeEntityAvailable(EntityID, 1u, 0x1111));
+	EXPECT_EQ(1u, delegate.onlineCount);
+
+	// Entity times out after twice its ValidTime (31 seconds), no matter how long it really takes
+	clock.advance(std::chrono::seconds(61));
+	stateMachine.checkTimers();
+	EXPECT_EQ(0u, delegate.offlineCount);
+
+	clock.advance(std::chrono::seconds(2));
+	stateMachine.checkTimers();
+	EXPECT_EQ(1u, delegate.offlineCount);
+}
+
+TEST(ControllerStateMachine, SoakManualClock)
+{
+	static constexpr auto EntitiesCount = 1000u;
+	static constexpr auto SimulatedDuration = std::chrono::hours(24);
+	static constexpr auto Step = std::chrono::seconds(1);
+	static constexpr auto AdvertisePeriod = 20u; // Each entity advertises every 20 seconds (in Step unit)
+	static constexpr auto ChurnPeriod = 10u; // An entity goes away or comes back every 10 seconds (in Step unit)
+	static constexpr auto CommandPeriod = 5u; // An AEM command (never answered) is sent every 5 seconds (in Step unit)
+	static constexpr auto EntityTimeout = std::chrono::seconds(2 * 31); // Twice the ValidTime of makeEntityAvailable
+	static constexpr auto BaseEntityID = std::uint64_t{ 0x001B92FFFE000000 };
+
+	enum class State
+	{
+		Online,
+		Departed,
+		Silent,
+	};
+	struct EntityState
+	{
+		State state{ State::Online };
+		std::uint32_t availableIndex{ 0u };
+		la::avdecc::Clock::time_point lastAdvertise{};
+	};
+
+	auto clock = la::avdecc::ManualClock{};
+	auto delegate = CountingDelegate{};
+	auto stateMachine = la::avdecc::protocol::stateMachine::ControllerStateMachine{ nullptr, &delegate, la::avdecc::protocol::Aecpdu::DefaultMaxInflightCommands, clock };
+	auto controller = TestControllerEntity{ la::avdecc::UniqueIdentifier{ 0x001B92FFFD000001 } };
+	auto entities = std::vector<EntityState>(EntitiesCount);
+	auto silentCount = size_t{ 0u };
+	auto timedOutCount = size_t{ 0u };
+	auto commandsSent = size_t{ 0u };
+	auto commandsTimedOut = size_t{ 0u };
+
+	// Lock the state machine during the whole test, as a ProtocolInterface does when processing messages
+	std::lock_guard<decltype(stateMachine)> const lg(stateMachine);
+	ASSERT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, stateMachine.registerLocalEntity(controller));
+
+	auto const advanceClock = [&]()
+	{
+		clock.advance(Step);
+		stateMachine.checkTimers();
+
+		// Silent entities must time out exactly at the first check following their timeout (no drift)
+		for (auto const& entityID : delegate.offlineEntities)
+		{
+			auto const& entity = entities[entityID.getValue() - BaseEntityID];
+			if (entity.state == State::Silent)
+			{
+				EXPECT_EQ(EntityTimeout + Step, clock.now() - entity.lastAdvertise);
+				++timedOutCount;
+			}
+		}
+		delegate.offlineEntities.clear();
+	};
+
+	auto const advertiseEntities = [&](std::uint32_t const step)
+	{
+		// Online entities advertise (spread over the period)
+		for (auto index = step % AdvertisePeriod; index < EntitiesCount; index += AdvertisePeriod)
+		{
+			auto& entity = entities[index];
+			if (entity.state == State::Online)
+			{
+				stateMachine.processAdpdu(makeEntityAvailable(BaseEntityID + index, entity.availableIndex++, 0x1111));
+				entity.lastAdvertise = clock.now();
+			}
+		}
+	};
+
+	auto const stepsCount = static_cast<std::uint32_t>(SimulatedDuration / Step);
+	for (auto step = 0u; step < stepsCount; ++step)
+	{
+		advertiseEntities(step);
+
+		// Churn: entities alternatively depart, stop advertising (power loss) or come back (reboot)
+		if (step % ChurnPeriod == 0u)
+		{
+			auto const churnIndex = step / ChurnPeriod;
+			auto const index = (churnIndex * 7u) % EntitiesCount;
+			auto& entity = entities[index];
+			if (entity.state != State::Online)
+			{
+				entity.state = State::Online;
+				entity.availableIndex = 0u;
+			}
+			else if (churnIndex % 2u == 0u)
+			{
+				auto adpdu = makeEntityAvailable(BaseEntityID + index, entity.availableIndex, 0x1111);
+				adpdu.setMessageType(la::avdecc::protocol::AdpMessageType::EntityDeparting);
+				stateMachine.processAdpdu(adpdu);
+				entity.state = State::Departed;
+			}
+			else
+			{
+				entity.state = State::Silent;
+				++silentCount;
+			}
+		}
+
+		// Commands are never answered, they must be retried once then time out
+		if (step % CommandPeriod == 0u)
+		{
+			auto frame = la::avdecc::protocol::AemAecpdu::create();
+			auto* aem = static_cast<la::avdecc::protocol::AemAecpdu*>(frame.get());
+			aem->setMessageType(la::avdecc::protocol::AecpMessageType::AemCommand);
+			aem->setTargetEntityID(la::avdecc::UniqueIdentifier{ BaseEntityID + (step / CommandPeriod) % EntitiesCount });
+			aem->setControllerEntityID(controller.getEntityID());
+			aem->setCommandType(la::avdecc::protocol::AemCommandType::EntityAvailable);
+			auto const error = stateMachine.sendAecpCommand(std::move(frame),
+				[&commandsTimedOut](la::avdecc::protocol::Aecpdu const* const /*response*/, la::avdecc::protocol::ProtocolInterface::Error const error)
+				{
+					if (error == la::avdecc::protocol::ProtocolInterface::Error::Timeout)
+						++commandsTimedOut;
+				});
+			EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, error);
+			++commandsSent;
+		}
+
+		advanceClock();
+	}
+
+	// Let the remaining silent entities and commands time out
+	for (auto step = stepsCount; step < stepsCount + static_cast<std::uint32_t>((EntityTimeout + Step) / Step); ++step)
+	{
+		advertiseEntities(step);
+		advanceClock();
+	}
+
+	// Discovery state matches the simulated network
+	auto onlineCount = size_t{ 0u };
+	for (auto const& entity : entities)
+	{
+		if (entity.state == State::Online)
+			++onlineCount;
+	}
+	EXPECT_EQ(onlineCount, delegate.onlineCount - delegate.offlineCount);
+	EXPECT_EQ(silentCount, timedOutCount);
+	EXPECT_EQ(0u, delegate.updatedCount);
+
+	// No command left inflight, each one sent twice
+	EXPECT_EQ(commandsSent, commandsTimedOut);
+	EXPECT_EQ(2u * commandsSent, delegate.aecpSentCount);
+}
+
+TEST(ControllerStateMachine, AecpPriorityLanes)
+{
+	using Priority = la::avdecc::protocol::AecpCommandPriority;
+	static constexpr auto TargetEntityID = std::uint64_t{ 0x001B92FFFE000001 };
+
+	auto clock = la::avdecc::ManualClock{};
+	auto delegate = CountingDelegate{};
+	delegate.recordAecpCommands = true;
+	auto stateMachine = la::avdecc::protocol::stateMachine::ControllerStateMachine{ nullptr, &delegate, 1u, clock };
+	auto controller = TestControllerEntity{ la::avdecc::UniqueIdentifier{ 0x001B92FFFD000001 } };
+
+	std::lock_guard<decltype(stateMachine)> const lg(stateMachine);
+	ASSERT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, stateMachine.registerLocalEntity(controller));
+
+	// Each priority is identified by the command type
+	auto const commandTypeFromPriority = [](Priority const priority)
+	{
+		switch (priority)
+		{
+			case Priority::Interactive:
+				return la::avdecc::protocol::AemCommandType::AcquireEntity;
+			case Priority::Enumeration:
+				return la::avdecc::protocol::AemCommandType::ReadDescriptor;
+			default:
+				return la::avdecc::protocol::AemCommandType::GetCounters;
+		}
+	};
+	auto const sendCommand = [&](Priority const priority)
+	{
+		auto frame = la::avdecc::protocol::AemAecpdu::create();
+		auto* aem = static_cast<la::avdecc::protocol::AemAecpdu*>(frame.get());
+		aem->setMessageType(la::avdecc::protocol::AecpMessageType::AemCommand);
+		aem->setTargetEntityID(la::avdecc::UniqueIdentifier{ TargetEntityID });
+		aem->setControllerEntityID(controller.getEntityID());
+		aem->setCommandType(commandTypeFromPriority(priority));
+		EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, stateMachine.sendAecpCommand(std::move(frame), {}, priority));
+	};
+
+	// First command is sent right away, the others are queued
+	sendCommand(Priority::Background);
+	for (auto i = 0u; i < 10u; ++i)
+		sendCommand(Priority::Enumeration);
+	sendCommand(Priority::Background);
+	for (auto i = 0u; i < 12u; ++i)
+		sendCommand(Priority::Interactive);
+
+	// Answer each command so the next one is sent
+	auto sentCommandTypes = std::vector<la::avdecc::protocol::AemCommandType>{};
+	for (auto index = size_t{ 0u }; index < delegate.aecpSentCommands.size(); ++index)
+	{
+		auto const& command = static_cast<la::avdecc::protocol::AemAecpdu const&>(*delegate.aecpSentCommands[index]);
+		sentCommandTypes.push_back(command.getCommandType());
+
+		auto response = la::avdecc::protocol::AemAecpdu{};
+		response.setMessageType(la::avdecc::protocol::AecpMessageType::AemResponse);
+		response.setTargetEntityID(command.getTargetEntityID());
+		response.setControllerEntityID(command.getControllerEntityID());
+		response.setSequenceID(command.getSequenceID());
+		response.setCommandType(command.getCommandType());
+		clock.advance(std::chrono::milliseconds(1));
+		stateMachine.processAecpdu(response);
+	}
+
+	// Higher priority first, waiting lanes promoted after MaxSkippedCommands commands
+	auto expected = std::vector<la::avdecc::protocol::AemCommandType>{};
+	auto const appendExpected = [&expected, &commandTypeFromPriority](Priority const priority, size_t const count)
+	{
+		expected.insert(expected.end(), count, commandTypeFromPriority(priority));
+	};
+	appendExpected(Priority::Background, 1u);
+	appendExpected(Priority::Interactive, 8u);
+	appendExpected(Priority::Enumeration, 1u);
+	appendExpected(Priority::Background, 1u);
+	appendExpected(Priority::Interactive, 4u);
+	appendExpected(Priority::Enumeration, 9u);
+	EXPECT_EQ(expected, sentCommandTypes);
+
+	auto const statistics = stateMachine.getAecpCommandsStatistics();
+	auto const& interactive = statistics[static_cast<size_t>(Priority::Interactive)];
+	auto const& enumeration = statistics[static_cast<size_t>(Priority::Enumeration)];
+	auto const& background = statistics[static_cast<size_t>(Priority::Background)];
+	EXPECT_EQ(12u, interactive.sentCommands);
+	EXPECT_EQ(12u, interactive.queuedCommands);
+	EXPECT_EQ(0u, interactive.promotedCommands);
+	EXPECT_EQ(10u, enumeration.sentCommands);
+	EXPECT_EQ(10u, enumeration.queuedCommands);
+	EXPECT_EQ(1u, enumeration.promotedCommands);
+	EXPECT_EQ(2u, background.sentCommands);
+	EXPECT_EQ(1u, background.queuedCommands);
+	EXPECT_EQ(1u, background.promotedCommands);
+	// Each response advances the clock by 1 msec: the Nth sent command waited N msec
+	EXPECT_EQ(std::chrono::milliseconds(14), interactive.maxQueueDuration);
+	EXPECT_EQ(std::chrono::milliseconds(23), enumeration.maxQueueDuration);
+	EXPECT_EQ(std::chrono::milliseconds(10), background.maxQueueDuration);
+}
+
+TEST(ControllerStateMachine, AdvertiseSpreading)
+{
+	using ControllerStateMachine = la::avdecc::protocol::stateMachine::ControllerStateMachine;
+	static constexpr auto EntitiesCount = 20u;
+	static constexpr auto Step = std::chrono::milliseconds(10);
+	static constexpr auto SimulatedDuration = std::chrono::seconds(30);
+
+	auto clock = la::avdecc::ManualClock{};
+	auto delegate = CountingDelegate{};
+	// Outgoing messages are built using the MacAddress of the ProtocolInterface
+	auto intfc = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual>(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual("AdvertiseSpreadingInterface", { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } }));
+	auto stateMachine = ControllerStateMachine{ intfc.get(), &delegate, la::avdecc::protocol::Aecpdu::DefaultMaxInflightCommands, clock };
+
+	// Lock the state machine during the whole test, as a ProtocolInterface does when processing messages
+	std::lock_guard<decltype(stateMachine)> const lg(stateMachine);
+
+	// Start advertising all entities at once, with the shortest valid time so they want to advertise more often than the rate limit allows
+	auto entities = std::vector<std::unique_ptr<TestControllerEntity>>{};
+	for (auto index = 0u; index < EntitiesCount; ++index)
+	{
+		entities.push_back(std::make_unique<TestControllerEntity>(la::avdecc::UniqueIdentifier{ std::uint64_t{ 0x001B92FFFD000001 } + index }, std::uint8_t{ 1u }));
+		ASSERT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, stateMachine.registerLocalEntity(*entities.back()));
+		ASSERT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, stateMachine.enableEntityAdvertising(*entities.back()));
+	}
+	auto const startTime = clock.now();
+
+	// Simulate time, recording the time each message is sent at
+	auto sentTimes = std::vector<la::avdecc::Clock::time_point>{};
+	auto sentCounts = std::unordered_map<la::avdecc::UniqueIdentifier, size_t, la::avdecc::UniqueIdentifier::hash>{};
+	auto firstAdvertiseTime = la::avdecc::Clock::time_point{};
+	while (clock.now() - startTime < SimulatedDuration)
+	{
+		clock.advance(Step);
+		stateMachine.checkTimers();
+		for (auto const& adpdu : delegate.adpSentMessages)
+		{
+			EXPECT_EQ(la::avdecc::protocol::AdpMessageType::EntityAvailable, adpdu.getMessageType());
+			sentTimes.push_back(clock.now());
+			if (++sentCounts[adpdu.getEntityID()] == 1u && sentCounts.size() == EntitiesCount)
+			{
+				firstAdvertiseTime = clock.now();
+			}
+		}
+		delegate.adpSentMessages.clear();
+	}
+
+	// No window holds more messages than the token bucket allows
+	static constexpr auto Window = std::chrono::milliseconds(200);
+	static constexpr auto MaxInWindow = ControllerStateMachine::AdpMaxSendBurst + ControllerStateMachine::AdpMaxSendRate * Window.count() / 1000u;
+	for (auto it = sentTimes.begin(); it != sentTimes.end(); ++it)
+	{
+		auto const windowEnd = std::upper_bound(it, sentTimes.end(), *it + Window);
+		EXPECT_GE(MaxInWindow, static_cast<size_t>(std::distance(it, windowEnd)));
+	}
+
+	// Messages exceeding the burst are sent at the sustained rate
+	ASSERT_EQ(EntitiesCount, sentCounts.size());
+	EXPECT_LE(std::chrono::milliseconds((EntitiesCount - ControllerStateMachine::AdpMaxSendBurst) * 1000u / ControllerStateMachine::AdpMaxSendRate), firstAdvertiseTime - startTime);
+
+	// The rate limit is shared fairly, no entity is starved
+	auto const fairShare = SimulatedDuration.count() * ControllerStateMachine::AdpMaxSendRate / EntitiesCount;
+	for (auto const& countKV : sentCounts)
+	{
+		EXPECT_LE(fairShare / 2u, countKV.second) << "Entity " << la::avdecc::toHexString(countKV.first, true) << " starved";
+	}
+
+	for (auto const& entity : entities)
+	{
+		stateMachine.unregisterLocalEntity(*entity);
+	}
+}
+
+TEST(ControllerStateMachine, DeferredDiscoveryError)
+{
+	auto clock = la::avdecc::ManualClock{};
+	auto delegate = CountingDelegate{};
+	// Outgoing messages are built using the MacAddress of the ProtocolInterface
+	auto intfc = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual>(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual("DeferredDiscoveryErrorInterface", { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } }));
+	auto stateMachine = la::avdecc::protocol::stateMachine::ControllerStateMachine{ intfc.get(), &delegate, la::avdecc::protocol::Aecpdu::DefaultMaxInflightCommands, clock };
+
+	// Lock the state machine during the whole test, as a ProtocolInterface does when processing messages
+	std::lock_guard<decltype(stateMachine)> const lg(stateMachine);
+
+	// The message is only sent after a random delay, the error cannot be returned by discoverRemoteEntities
+	delegate.adpSendError = la::avdecc::protocol::ProtocolInterface::Error::TransportError;
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, stateMachine.discoverRemoteEntities());
+	EXPECT_TRUE(delegate.deferredDiscoveryErrors.empty());
+
+	clock.advance(std::chrono::milliseconds(200));
+	stateMachine.checkTimers();
+	ASSERT_EQ(1u, delegate.adpSentMessages.size());
+	EXPECT_EQ(la::avdecc::protocol::AdpMessageType::EntityDiscover, delegate.adpSentMessages[0].getMessageType());
+	ASSERT_EQ(1u, delegate.deferredDiscoveryErrors.size());
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::TransportError, delegate.deferredDiscoveryErrors[0]);
+}
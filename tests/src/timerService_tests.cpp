@@ -0,0 +1,163 @@
+/*
+* Copyright (C) 2016-2018, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be usefu_state,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file timerService_tests.cpp
+* @author Christophe Calmejane
+*/
+
+// Internal API
+#include "timerService.hpp"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+TEST(TimerService, Periodic)
+{
+	auto& timerService = la::avdecc::TimerService::getInstance();
+	std::atomic_int count{ 0 };
+
+	auto const timerID = timerService.addTimer(std::chrono::milliseconds{ 50 }, timerService.getClock().now(),
+		[&count]
+		{
+			++count;
+		});
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 275 });
+	timerService.removeTimer(timerID);
+
+	// Expired at 0, 50, 100, 150, 200 and 250 msec
+	auto const expiredCount = count.load();
+	EXPECT_GE(expiredCount, 5);
+	EXPECT_LE(expiredCount, 7);
+
+	// Removed timer never expires again
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 100 });
+	EXPECT_EQ(expiredCount, count.load());
+}
+
+TEST(TimerService, TriggerAndPeriodChange)
+{
+	auto& timerService = la::avdecc::TimerService::getInstance();
+	std::atomic_int count{ 0 };
+
+	// A period of 0 only expires when triggered
+	auto const timerID = timerService.addTimer(std::chrono::milliseconds{ 0 }, la::avdecc::TimerService::Clock::time_point::max(),
+		[&count]
+		{
+			++count;
+		});
+	timerService.setTimerPeriod(timerID, std::chrono::milliseconds{ 0 });
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 50 });
+	EXPECT_EQ(0, count.load());
+
+	timerService.triggerTimer(timerID);
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 50 });
+	EXPECT_EQ(1, count.load());
+
+	// Long period, trigger restarts it
+	timerService.setTimerPeriod(timerID, std::chrono::seconds{ 10 });
+	timerService.triggerTimer(timerID);
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 50 });
+	EXPECT_EQ(2, count.load());
+
+	timerService.removeTimer(timerID);
+}
+
+TEST(TimerService, RemoveWaitsForHandler)
+{
+	auto& timerService = la::avdecc::TimerService::getInstance();
+	std::atomic_bool isRunning{ false };
+	std::atomic_bool wasRunningWhenRemoved{ false };
+
+	auto const timerID = timerService.addTimer(std::chrono::milliseconds{ 0 }, timerService.getClock().now(),
+		[&isRunning]
+		{
+			isRunning = true;
+			std::this_thread::sleep_for(std::chrono::milliseconds{ 100 });
+			isRunning = false;
+		});
+
+	// Wait for the handler to start, then remove the timer
+	while (!isRunning)
+	{
+		std::this_thread::yield();
+	}
+	timerService.removeTimer(timerID);
+	wasRunningWhenRemoved = isRunning.load();
+
+	EXPECT_FALSE(wasRunningWhenRemoved);
+}
+
+TEST(TimerService, ManualClock)
+{
+	auto clock = la::avdecc::ManualClock{};
+	auto const timerService = la::avdecc::TimerService::create(clock);
+	auto count = 0;
+
+	auto const timerID = timerService->addTimer(std::chrono::milliseconds{ 50 }, clock.now() + std::chrono::milliseconds{ 50 },
+		[&count]
+		{
+			++count;
+		});
+
+	// Nothing expires until the clock is advanced and timers are checked
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 100 });
+	timerService->checkTimers();
+	EXPECT_EQ(0, count);
+
+	clock.advance(std::chrono::milliseconds{ 49 });
+	timerService->checkTimers();
+	EXPECT_EQ(0, count);
+
+	clock.advance(std::chrono::milliseconds{ 1 });
+	EXPECT_EQ(0, count);
+	timerService->checkTimers();
+	EXPECT_EQ(1, count);
+
+	// Late check does not cause a burst to catch up
+	clock.advance(std::chrono::milliseconds{ 500 });
+	timerService->checkTimers();
+	EXPECT_EQ(2, count);
+
+	// Trigger runs at the next check, restarting the period
+	timerService->triggerTimer(timerID);
+	timerService->checkTimers();
+	EXPECT_EQ(3, count);
+	clock.advance(std::chrono::milliseconds{ 49 });
+	timerService->checkTimers();
+	EXPECT_EQ(3, count);
+
+	// Removing from the handler
+	timerService->setTimerPeriod(timerID, std::chrono::milliseconds{ 0 });
+	auto removingTimerID = la::avdecc::TimerService::InvalidTimerID;
+	removingTimerID = timerService->addTimer(std::chrono::milliseconds{ 10 }, clock.now(),
+		[&count, &timerService, &removingTimerID]
+		{
+			++count;
+			timerService->removeTimer(removingTimerID);
+		});
+	timerService->checkTimers();
+	clock.advance(std::chrono::milliseconds{ 100 });
+	timerService->checkTimers();
+	EXPECT_EQ(4, count);
+
+	timerService->removeTimer(timerID);
+}
@@ -0,0 +1,337 @@
+/*
+* Copyright (C) 2016-2018, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be usefu_state,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file utils_tests.cpp
+* @author Christophe Calmejane
+*/
+
+// Public API
+#include <la/avdecc/utils.hpp>
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <iostream>
+#include <algorithm>
+
+namespace
+{
+using LockedSubject = la::avdecc::TypedSubject<struct LockedSubjectTag, std::recursive_mutex>;
+using LockFreeSubject = la::avdecc::TypedCopyOnWriteSubject<struct LockFreeSubjectTag, std::mutex>;
+
+template<class SubjectType>
+class CountingObserver : public la::avdecc::Observer<SubjectType>
+{
+public:
+	using Handler = std::function<void(CountingObserver* const obs)>;
+
+	CountingObserver(Handler const& handler = {}) noexcept
+		: _handler(handler)
+	{
+	}
+
+	void onEvent() noexcept
+	{
+		++_count;
+		if (_handler)
+		{
+			_handler(this);
+		}
+	}
+
+	size_t getCount() const noexcept
+	{
+		return _count;
+	}
+
+private:
+	Handler _handler{};
+	std::atomic<size_t> _count{ 0u };
+	DECLARE_AVDECC_OBSERVER_GUARD(CountingObserver);
+};
+using LockFreeObserver = CountingObserver<LockFreeSubject>;
+
+void notify(LockFreeSubject const& subject)
+{
+	subject.notifyObserversMethod<LockFreeObserver>(&LockFreeObserver::onEvent);
+}
+
+} // namespace
+
+TEST(CopyOnWriteSubject, Notify)
+{
+	auto subject = LockFreeSubject{};
+	auto obs1 = LockFreeObserver{};
+	auto obs2 = LockFreeObserver{};
+
+	subject.registerObserver(&obs1);
+	subject.registerObserver(&obs2);
+	EXPECT_EQ(2u, subject.countObservers());
+	EXPECT_THROW(subject.registerObserver(&obs1), std::invalid_argument);
+
+	notify(subject);
+	EXPECT_EQ(1u, obs1.getCount());
+	EXPECT_EQ(1u, obs2.getCount());
+
+	subject.unregisterObserver(&obs1);
+	EXPECT_FALSE(subject.isObserverRegistered(&obs1));
+	EXPECT_TRUE(subject.isObserverRegistered(&obs2));
+	EXPECT_THROW(subject.unregisterObserver(&obs1), std::invalid_argument);
+
+	notify(subject);
+	EXPECT_EQ(1u, obs1.getCount());
+	EXPECT_EQ(2u, obs2.getCount());
+
+	subject.removeAllObservers();
+	EXPECT_EQ(0u, subject.countObservers());
+
+	notify(subject);
+	EXPECT_EQ(2u, obs2.getCount());
+}
+
+TEST(CopyOnWriteSubject, RemoveDuringNotification)
+{
+	auto subject = LockFreeSubject{};
+	auto obs2 = LockFreeObserver{};
+	// First observer removes itself and the second one
+	auto obs1 = LockFreeObserver{ [&subject, &obs2](LockFreeObserver* const obs)
+		{
+			subject.unregisterObserver(obs);
+			subject.unregisterObserver(&obs2);
+		} };
+
+	subject.registerObserver(&obs1);
+	subject.registerObserver(&obs2);
+
+	notify(subject);
+	EXPECT_EQ(1u, obs1.getCount());
+	EXPECT_EQ(0u, obs2.getCount()); // Removed during the notification, must not be called
+	EXPECT_EQ(0u, subject.countObservers());
+
+	// Registering during a notification is allowed as well
+	auto obs3 = LockFreeObserver{};
+	auto obs4 = LockFreeObserver{ [&subject, &obs3](LockFreeObserver* const)
+		{
+			if (!subject.isObserverRegistered(&obs3))
+			{
+				subject.registerObserver(&obs3);
+			}
+		} };
+	subject.registerObserver(&obs4);
+
+	notify(subject);
+	EXPECT_EQ(1u, obs4.getCount());
+	EXPECT_EQ(0u, obs3.getCount()); // Not part of the notification in progress
+	notify(subject);
+	EXPECT_EQ(2u, obs4.getCount());
+	EXPECT_EQ(1u, obs3.getCount());
+}
+
+TEST(CopyOnWriteSubject, UnregisterWaitsForNotification)
+{
+	auto subject = LockFreeSubject{};
+	auto inHandler = std::atomic_bool{ false };
+	auto handlerDone = std::atomic_bool{ false };
+	auto obs = LockFreeObserver{ [&inHandler, &handlerDone](LockFreeObserver* const)
+		{
+			inHandler = true;
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			handlerDone = true;
+		} };
+
+	subject.registerObserver(&obs);
+
+	auto notifyThread = std::thread(
+		[&subject]
+		{
+			notify(subject);
+		});
+
+	while (!inHandler)
+	{
+		std::this_thread::yield();
+	}
+
+	// The notification in progress on the other thread is still calling the observer, unregister must wait for it to complete
+	subject.unregisterObserver(&obs);
+	EXPECT_TRUE(handlerDone);
+
+	notifyThread.join();
+
+	notify(subject);
+	EXPECT_EQ(1u, obs.getCount());
+}
+
+TEST(CopyOnWriteSubject, ConcurrentNotifications)
+{
+	static constexpr auto ObserversCount = 8u;
+	static constexpr auto NotificationsPerThread = 20000u;
+	static constexpr auto ThreadsCount = 4u;
+
+	auto subject = LockFreeSubject{};
+	auto observers = std::vector<std::unique_ptr<LockFreeObserver>>{};
+	for (auto i = 0u; i < ObserversCount; ++i)
+	{
+		observers.push_back(std::make_unique<LockFreeObserver>());
+		subject.registerObserver(observers.back().get());
+	}
+
+	// Observers list changes in the background while notifying
+	auto shouldStop = std::atomic_bool{ false };
+	auto churnObs = LockFreeObserver{};
+	auto churnThread = std::thread(
+		[&subject, &shouldStop, &churnObs]
+		{
+			while (!shouldStop)
+			{
+				subject.registerObserver(&churnObs);
+				subject.unregisterObserver(&churnObs);
+			}
+		});
+
+	auto notifyThreads = std::vector<std::thread>{};
+	for (auto t = 0u; t < ThreadsCount; ++t)
+	{
+		notifyThreads.emplace_back(
+			[&subject]
+			{
+				for (auto i = 0u; i < NotificationsPerThread; ++i)
+				{
+					notify(subject);
+				}
+			});
+	}
+	for (auto& thread : notifyThreads)
+	{
+		thread.join();
+	}
+	shouldStop = true;
+	churnThread.join();
+
+	// Registered observers must have been notified every time
+	for (auto const& obs : observers)
+	{
+		EXPECT_EQ(ThreadsCount * NotificationsPerThread, obs->getCount());
+		subject.unregisterObserver(obs.get());
+	}
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests
+TEST(CopyOnWriteSubject, DISABLED_Benchmark)
+{
+	static constexpr auto ObserversCount = 8u;
+	static constexpr auto NotificationsPerThread = 200000u;
+	auto const threadsCount = std::max(2u, std::thread::hardware_concurrency());
+
+	auto const runBenchmark = [threadsCount](auto& subject, auto const& notify, auto const& churn)
+	{
+		using Subject = std::decay_t<decltype(subject)>;
+		auto observers = std::vector<std::unique_ptr<CountingObserver<Subject>>>{};
+		for (auto i = 0u; i < ObserversCount; ++i)
+		{
+			observers.push_back(std::make_unique<CountingObserver<Subject>>());
+			subject.registerObserver(observers.back().get());
+		}
+
+		// Observers list changes in the background, much less often than notifications
+		auto shouldStop = std::atomic_bool{ false };
+		auto churnThread = std::thread(
+			[&subject, &shouldStop, &churn]
+			{
+				while (!shouldStop)
+				{
+					churn(subject);
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+			});
+
+		auto const startTime = std::chrono::steady_clock::now();
+		auto notifyThreads = std::vector<std::thread>{};
+		for (auto t = 0u; t < threadsCount; ++t)
+		{
+			notifyThreads.emplace_back(
+				[&subject, &notify]
+				{
+					for (auto i = 0u; i < NotificationsPerThread; ++i)
+					{
+						notify(subject);
+					}
+				});
+		}
+		for (auto& thread : notifyThreads)
+		{
+			thread.join();
+		}
+		auto const duration = std::chrono::steady_clock::now() - startTime;
+
+		shouldStop = true;
+		churnThread.join();
+
+		// Registered observers must have been notified every time
+		for (auto const& obs : observers)
+		{
+			EXPECT_EQ(static_cast<size_t>(threadsCount) * NotificationsPerThread, obs->getCount());
+			subject.unregisterObserver(obs.get());
+		}
+
+		return std::chrono::duration_cast<std::chrono::microseconds>(duration);
+	};
+
+	// Subject: the whole notification is protected by the mutex
+	auto lockedDuration = std::chrono::microseconds{};
+	{
+		auto subject = LockedSubject{};
+		auto churnObs = CountingObserver<LockedSubject>{};
+		lockedDuration = runBenchmark(subject,
+			[](LockedSubject const& subject)
+			{
+				subject.notifyObserversMethod<CountingObserver<LockedSubject>>(&CountingObserver<LockedSubject>::onEvent);
+			},
+			[&churnObs](LockedSubject& subject)
+			{
+				subject.registerObserver(&churnObs);
+				subject.unregisterObserver(&churnObs);
+			});
+	}
+
+	// CopyOnWriteSubject
+	auto lockFreeDuration = std::chrono::microseconds{};
+	{
+		auto subject = LockFreeSubject{};
+		auto churnObs = LockFreeObserver{};
+		lockFreeDuration = runBenchmark(subject,
+			[](LockFreeSubject const& subject)
+			{
+				notify(subject);
+			},
+			[&churnObs](LockFreeSubject& subject)
+			{
+				subject.registerObserver(&churnObs);
+				subject.unregisterObserver(&churnObs);
+			});
+	}
+
+	auto const totalNotifications = static_cast<double>(threadsCount) * NotificationsPerThread;
+	std::cout << "[ BENCH    ] " << threadsCount << " threads, " << ObserversCount << " observers: Subject " << (totalNotifications / lockedDuration.count()) << " notifications/us, CopyOnWriteSubject " << (totalNotifications / lockFreeDuration.count()) << " notifications/us" << std::endl;
+}